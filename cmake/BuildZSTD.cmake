@@ -17,7 +17,13 @@ macro(zstd_build)
         third_party/zstd/lib/compress/zstdmt_compress.c
         third_party/zstd/lib/compress/huf_compress.c
         third_party/zstd/lib/compress/fse_compress.c
+        third_party/zstd/lib/dictBuilder/zdict.c
+        third_party/zstd/lib/dictBuilder/cover.c
+        third_party/zstd/lib/dictBuilder/divsufsort.c
     )
+    if (EXISTS ${CMAKE_CURRENT_SOURCE_DIR}/third_party/zstd/lib/dictBuilder/fastcover.c)
+        list(APPEND zstd_src third_party/zstd/lib/dictBuilder/fastcover.c)
+    endif()
 
     if (CC_HAS_WNO_IMPLICIT_FALLTHROUGH)
         set_source_files_properties(${zstd_src}
@@ -30,7 +36,8 @@ macro(zstd_build)
     set(ZSTD_LIBRARIES zstd)
     set(ZSTD_INCLUDE_DIRS
             ${CMAKE_CURRENT_SOURCE_DIR}/third_party/zstd/lib
-            ${CMAKE_CURRENT_SOURCE_DIR}/third_party/zstd/lib/common)
+            ${CMAKE_CURRENT_SOURCE_DIR}/third_party/zstd/lib/common
+            ${CMAKE_CURRENT_SOURCE_DIR}/third_party/zstd/lib/dictBuilder)
     include_directories(${ZSTD_INCLUDE_DIRS})
     find_package_message(ZSTD "Using bundled ZSTD"
         "${ZSTD_LIBRARIES}:${ZSTD_INCLUDE_DIRS}")
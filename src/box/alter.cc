@@ -234,6 +234,12 @@ index_opts_decode(struct index_opts *opts, const char *map,
 			 "run_size_ratio must be greater than 1");
 		return -1;
 	}
+	if (opts->compaction_policy == index_compaction_policy_MAX) {
+		diag_set(ClientError, ER_WRONG_INDEX_OPTIONS,
+			 BOX_INDEX_FIELD_OPTS, "compaction_policy must be "
+			 "either 'tiered' or 'leveled'");
+		return -1;
+	}
 	if (opts->bloom_fpr <= 0 || opts->bloom_fpr > 1) {
 		diag_set(ClientError, ER_WRONG_INDEX_OPTIONS,
 			 BOX_INDEX_FIELD_OPTS,
@@ -241,6 +247,11 @@ index_opts_decode(struct index_opts *opts, const char *map,
 			 "less than or equal to 1");
 		return -1;
 	}
+	if (opts->ttl < 0) {
+		diag_set(ClientError, ER_WRONG_INDEX_OPTIONS,
+			 BOX_INDEX_FIELD_OPTS, "ttl must not be negative");
+		return -1;
+	}
 	return 0;
 }
 
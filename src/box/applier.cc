@@ -388,11 +388,30 @@ done:
 	applier_set_state(applier, APPLIER_READY);
 }
 
+/**
+ * Read the next row sent by the master. If the master
+ * compresses the stream, rows are taken from the last received
+ * chunk until it's exhausted, see xrow_compress.h.
+ */
+static void
+applier_read_row(struct applier *applier, struct xrow_header *row,
+		 double timeout)
+{
+	while (!xrow_decompressor_next_xc(&applier->decompressor, row)) {
+		if (timeout == TIMEOUT_INFINITY)
+			coio_read_xrow(&applier->io, &applier->ibuf, row);
+		else
+			coio_read_xrow_timeout_xc(&applier->io, &applier->ibuf,
+						  row, timeout);
+		if (row->type != IPROTO_COMPRESSED_ROWS)
+			return;
+		xrow_decompressor_feed_xc(&applier->decompressor, row);
+	}
+}
+
 static uint64_t
 applier_wait_snapshot(struct applier *applier)
 {
-	struct ev_io *coio = &applier->io;
-	struct ibuf *ibuf = &applier->ibuf;
 	struct xrow_header row;
 
 	/**
@@ -401,7 +420,7 @@ applier_wait_snapshot(struct applier *applier)
 	 */
 	if (applier->version_id >= version_id(1, 7, 0)) {
 		/* Decode JOIN/FETCH_SNAPSHOT response */
-		coio_read_xrow(coio, ibuf, &row);
+		applier_read_row(applier, &row, TIMEOUT_INFINITY);
 		if (iproto_type_is_error(row.type)) {
 			xrow_decode_error_xc(&row); /* re-throw error */
 		} else if (row.type != IPROTO_OK) {
@@ -422,7 +441,7 @@ applier_wait_snapshot(struct applier *applier)
 	 */
 	uint64_t row_count = 0;
 	while (true) {
-		coio_read_xrow(coio, ibuf, &row);
+		applier_read_row(applier, &row, TIMEOUT_INFINITY);
 		applier->last_row_time = ev_monotonic_now(loop());
 		if (iproto_type_is_dml(row.type)) {
 			if (apply_snapshot_row(&row) != 0)
@@ -459,8 +478,7 @@ applier_fetch_snapshot(struct applier *applier)
 	struct ev_io *coio = &applier->io;
 	struct xrow_header row;
 
-	memset(&row, 0, sizeof(row));
-	row.type = IPROTO_FETCH_SNAPSHOT;
+	xrow_encode_fetch_snapshot_xc(&row, true);
 	coio_write_xrow(coio, &row);
 
 	applier_set_state(applier, APPLIER_FETCH_SNAPSHOT);
@@ -472,8 +490,6 @@ applier_fetch_snapshot(struct applier *applier)
 static uint64_t
 applier_wait_register(struct applier *applier, uint64_t row_count)
 {
-	struct ev_io *coio = &applier->io;
-	struct ibuf *ibuf = &applier->ibuf;
 	struct xrow_header row;
 
 	/*
@@ -488,7 +504,7 @@ applier_wait_register(struct applier *applier, uint64_t row_count)
 	 * Receive final data.
 	 */
 	while (true) {
-		coio_read_xrow(coio, ibuf, &row);
+		applier_read_row(applier, &row, TIMEOUT_INFINITY);
 		applier->last_row_time = ev_monotonic_now(loop());
 		if (iproto_type_is_dml(row.type)) {
 			vclock_follow_xrow(&replicaset.vclock, &row);
@@ -526,7 +542,7 @@ applier_register(struct applier *applier)
 	 * Send this instance's current vclock together
 	 * with REGISTER request.
 	 */
-	xrow_encode_register(&row, &INSTANCE_UUID, box_vclock);
+	xrow_encode_register(&row, &INSTANCE_UUID, box_vclock, true);
 	row.type = IPROTO_REGISTER;
 	coio_write_xrow(coio, &row);
 
@@ -547,7 +563,7 @@ applier_join(struct applier *applier)
 	struct xrow_header row;
 	uint64_t row_count;
 
-	xrow_encode_join_xc(&row, &INSTANCE_UUID);
+	xrow_encode_join_xc(&row, &INSTANCE_UUID, true);
 	coio_write_xrow(coio, &row);
 
 	applier_set_state(applier, APPLIER_INITIAL_JOIN);
@@ -583,11 +599,37 @@ struct applier_tx_row {
 	struct xrow_header row;
 };
 
+enum {
+	/**
+	 * Max number of transactions the applier reads from
+	 * the input buffer before applying them, see
+	 * applier_read_batch().
+	 */
+	APPLIER_BATCH_TX_MAX = 64,
+};
+
+/**
+ * Copy the row body from the input buffer to the fiber gc
+ * region so that it stays valid after the next row is read.
+ */
+static void
+applier_save_row_body(struct xrow_header *row)
+{
+	assert(row->bodycnt <= 1);
+	if (row->bodycnt == 0)
+		return;
+	void *new_base = region_alloc(&fiber()->gc, row->body->iov_len);
+	if (new_base == NULL)
+		tnt_raise(OutOfMemory, row->body->iov_len,
+			  "region", "xrow body");
+	memcpy(new_base, row->body->iov_base, row->body->iov_len);
+	/* Adjust row body pointers. */
+	row->body->iov_base = new_base;
+}
+
 static struct applier_tx_row *
 applier_read_tx_row(struct applier *applier)
 {
-	struct ev_io *coio = &applier->io;
-	struct ibuf *ibuf = &applier->ibuf;
 	size_t size;
 	struct applier_tx_row *tx_row =
 		region_alloc_object(&fiber()->gc, typeof(*tx_row), &size);
@@ -605,9 +647,8 @@ applier_read_tx_row(struct applier *applier)
 	 * broken - the master might just be idle.
 	 */
 	if (applier->version_id < version_id(1, 7, 7))
-		coio_read_xrow(coio, ibuf, row);
-	else
-		coio_read_xrow_timeout_xc(coio, ibuf, row, timeout);
+		timeout = TIMEOUT_INFINITY;
+	applier_read_row(applier, row, timeout);
 
 	applier->lag = ev_now(loop()) - row->tm;
 	applier->last_row_time = ev_monotonic_now(loop());
@@ -663,25 +704,16 @@ applier_read_tx(struct applier *applier, struct stailq *rows)
 				  "replication",
 				  "interleaving transactions");
 
-		assert(row->bodycnt <= 1);
-		if (row->bodycnt == 1 && !row->is_commit) {
-			/*
-			 * Save row body to gc region.
-			 * Not done for single-statement
-			 * transactions knowing that the input
-			 * buffer will not be used while the
-			 * transaction is applied.
-			 */
-			void *new_base = region_alloc(&fiber()->gc,
-						      row->body->iov_len);
-			if (new_base == NULL)
-				tnt_raise(OutOfMemory, row->body->iov_len,
-					  "region", "xrow body");
-			memcpy(new_base, row->body->iov_base,
-			       row->body->iov_len);
-			/* Adjust row body pointers. */
-			row->body->iov_base = new_base;
-		}
+		/*
+		 * Save row body to gc region.
+		 * Not done for the last row of a transaction
+		 * knowing that the input buffer will not be
+		 * used while the transaction is applied, unless
+		 * the transaction is batched, see
+		 * applier_read_batch().
+		 */
+		if (!row->is_commit)
+			applier_save_row_body(row);
 		stailq_add_tail(rows, &tx_row->next);
 
 	} while (!stailq_last_entry(rows, struct applier_tx_row,
@@ -726,6 +758,72 @@ applier_txn_commit_cb(struct trigger *trigger, void *event)
 	return 0;
 }
 
+/**
+ * Return true if the next row sent by the master has already
+ * been received and so can be read without yielding.
+ */
+static bool
+applier_has_buffered_row(struct applier *applier)
+{
+	if (ibuf_used(&applier->decompressor.ibuf) > 0)
+		return true;
+	struct ibuf *in = &applier->ibuf;
+	const char *pos = in->rpos;
+	if (ibuf_used(in) == 0 || mp_typeof(*pos) != MP_UINT ||
+	    mp_check_uint(pos, in->wpos) > 0)
+		return false;
+	uint64_t len = mp_decode_uint(&pos);
+	return len <= (uint64_t)(in->wpos - pos);
+}
+
+/**
+ * Read a batch of transactions, at least one, stopping as soon
+ * as the next transaction hasn't been received yet, so as not
+ * to delay the transactions read so far, or the batch is full.
+ * Applying the whole batch at once allows the WAL to write the
+ * transactions in one go, which greatly reduces the overhead
+ * per transaction when the master sends lots of small ones,
+ * while preserving their boundaries.
+ *
+ * Heartbeats are handled right away and aren't included in the
+ * batch. Returns the number of transactions stored in @batch,
+ * which may be 0 if only heartbeats were received.
+ */
+static int
+applier_read_batch(struct applier *applier, struct stailq *batch)
+{
+	int count = 0;
+	while (true) {
+		struct stailq *rows = &batch[count];
+		applier_read_tx(applier, rows);
+		applier->last_row_time = ev_monotonic_now(loop());
+		struct xrow_header *last_row =
+			&stailq_last_entry(rows, struct applier_tx_row,
+					   next)->row;
+		if (stailq_first_entry(rows, struct applier_tx_row,
+				       next)->row.lsn == 0) {
+			/*
+			 * In case of an heartbeat message wake
+			 * a writer up and check applier state.
+			 */
+			fiber_cond_signal(&applier->writer_cond);
+			last_row = NULL;
+		} else {
+			count++;
+		}
+		if (count == APPLIER_BATCH_TX_MAX ||
+		    !applier_has_buffered_row(applier))
+			break;
+		/*
+		 * The body of the last row still points to the
+		 * input buffer, which is about to be reused.
+		 */
+		if (last_row != NULL)
+			applier_save_row_body(last_row);
+	}
+	return count;
+}
+
 /**
  * Apply all rows in the rows queue as a single transaction.
  *
@@ -886,7 +984,6 @@ applier_subscribe(struct applier *applier)
 {
 	/* Send SUBSCRIBE request */
 	struct ev_io *coio = &applier->io;
-	struct ibuf *ibuf = &applier->ibuf;
 	struct xrow_header row;
 	struct tt_uuid cluster_id = uuid_nil;
 
@@ -899,12 +996,12 @@ applier_subscribe(struct applier *applier)
 	 */
 	uint32_t id_filter = box_is_orphan() ? 0 : 1 << instance_id;
 	xrow_encode_subscribe_xc(&row, &REPLICASET_UUID, &INSTANCE_UUID,
-				 &vclock, replication_anon, id_filter);
+				 &vclock, replication_anon, id_filter, true);
 	coio_write_xrow(coio, &row);
 
 	/* Read SUBSCRIBE response */
 	if (applier->version_id >= version_id(1, 6, 7)) {
-		coio_read_xrow(coio, ibuf, &row);
+		applier_read_row(applier, &row, TIMEOUT_INFINITY);
 		if (iproto_type_is_error(row.type)) {
 			xrow_decode_error_xc(&row);  /* error */
 		} else if (row.type != IPROTO_OK) {
@@ -1011,22 +1108,22 @@ applier_subscribe(struct applier *applier)
 			applier_set_state(applier, APPLIER_FOLLOW);
 		}
 
-		struct stailq rows;
-		applier_read_tx(applier, &rows);
-
-		applier->last_row_time = ev_monotonic_now(loop());
+		struct stailq batch[APPLIER_BATCH_TX_MAX];
+		int count = applier_read_batch(applier, batch);
 		/*
-		 * In case of an heartbeat message wake a writer up
-		 * and check applier state.
+		 * Each transaction is applied and committed
+		 * separately. Unless the applier yields, their
+		 * journal entries are staged in the same WAL
+		 * message, up to the WAL pipe input limit.
 		 */
-		if (stailq_first_entry(&rows, struct applier_tx_row,
-				       next)->row.lsn == 0)
-			fiber_cond_signal(&applier->writer_cond);
-		else if (applier_apply_tx(&rows) != 0)
+		int rc = 0;
+		for (int i = 0; i < count && rc == 0; i++)
+			rc = applier_apply_tx(&batch[i]);
+		if (rc != 0)
 			diag_raise();
 
-		if (ibuf_used(ibuf) == 0)
-			ibuf_reset(ibuf);
+		if (ibuf_used(&applier->ibuf) == 0)
+			ibuf_reset(&applier->ibuf);
 		fiber_gc();
 	}
 }
@@ -1044,6 +1141,7 @@ applier_disconnect(struct applier *applier, enum applier_state state)
 	coio_close_io(loop(), &applier->io);
 	/* Clear all unparsed input. */
 	ibuf_reinit(&applier->ibuf);
+	xrow_decompressor_reset(&applier->decompressor);
 	fiber_gc();
 }
 
@@ -1206,6 +1304,7 @@ applier_new(const char *uri)
 	}
 	coio_create(&applier->io, -1);
 	ibuf_create(&applier->ibuf, &cord()->slabc, 1024);
+	xrow_decompressor_create(&applier->decompressor);
 
 	/* uri_parse() sets pointers to applier->source buffer */
 	snprintf(applier->source, sizeof(applier->source), "%s", uri);
@@ -1228,6 +1327,7 @@ applier_delete(struct applier *applier)
 {
 	assert(applier->reader == NULL && applier->writer == NULL);
 	ibuf_destroy(&applier->ibuf);
+	xrow_decompressor_destroy(&applier->decompressor);
 	assert(applier->io.fd == -1);
 	trigger_destroy(&applier->on_state);
 	diag_destroy(&applier->diag);
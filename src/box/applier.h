@@ -44,6 +44,7 @@
 #include "uri/uri.h"
 
 #include "xrow.h"
+#include "xrow_compress.h"
 
 enum { APPLIER_SOURCE_MAXLEN = 1024 }; /* enough to fit URI with passwords */
 
@@ -109,6 +110,8 @@ struct applier {
 	struct ev_io io;
 	/** Input buffer */
 	struct ibuf ibuf;
+	/** Decompressor of the stream received from the master. */
+	struct xrow_decompressor decompressor;
 	/** Triggers invoked on state change */
 	struct rlist on_state;
 	/**
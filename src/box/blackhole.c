@@ -96,6 +96,17 @@ blackhole_space_execute_upsert(struct space *space, struct txn *txn,
 	return -1;
 }
 
+static int
+blackhole_space_execute_delete_range(struct space *space, struct txn *txn,
+				     struct request *request)
+{
+	(void)space;
+	(void)txn;
+	(void)request;
+	diag_set(ClientError, ER_UNSUPPORTED, "Blackhole", "delete_range()");
+	return -1;
+}
+
 static struct index *
 blackhole_space_create_index(struct space *space, struct index_def *def)
 {
@@ -113,6 +124,7 @@ static const struct space_vtab blackhole_space_vtab = {
 	/* .execute_delete = */ blackhole_space_execute_delete,
 	/* .execute_update = */ blackhole_space_execute_update,
 	/* .execute_upsert = */ blackhole_space_execute_upsert,
+	/* .execute_delete_range = */ blackhole_space_execute_delete_range,
 	/* .ephemeral_replace = */ generic_space_ephemeral_replace,
 	/* .ephemeral_delete = */ generic_space_ephemeral_delete,
 	/* .ephemeral_rowid_next = */ generic_space_ephemeral_rowid_next,
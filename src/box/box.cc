@@ -44,6 +44,7 @@
 #include "relay.h"
 #include "applier.h"
 #include <rmean.h>
+#include <zstd.h>
 #include "main.h"
 #include "tuple.h"
 #include "tuple_format.h"
@@ -62,6 +63,7 @@
 #include "user.h"
 #include "cfg.h"
 #include "coio.h"
+#include "coio_task.h"
 #include "replication.h" /* replica */
 #include "title.h"
 #include "xrow.h"
@@ -487,6 +489,30 @@ box_check_replication_sync_timeout(void)
 	return timeout;
 }
 
+static int
+box_check_replication_compression(void)
+{
+	int level = cfg_geti("replication_compression");
+	if (level < 0 || level > ZSTD_maxCLevel()) {
+		tnt_raise(ClientError, ER_CFG, "replication_compression",
+			  tt_sprintf("the value must be between 0 and %d",
+				     ZSTD_maxCLevel()));
+	}
+	return level;
+}
+
+static int
+box_check_replication_join_workers(void)
+{
+	int workers = cfg_geti("replication_join_workers");
+	if (workers < 1 || workers > REPLICATION_JOIN_WORKERS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "replication_join_workers",
+			  tt_sprintf("the value must be between 1 and %d",
+				     REPLICATION_JOIN_WORKERS_MAX));
+	}
+	return workers;
+}
+
 static inline void
 box_check_uuid(struct tt_uuid *uuid, const char *name)
 {
@@ -570,6 +596,15 @@ box_check_checkpoint_count(int checkpoint_count)
 	}
 }
 
+static void
+box_check_worker_pool_bulk_threads(int bulk_threads)
+{
+	if (bulk_threads < 1) {
+		tnt_raise(ClientError, ER_CFG, "worker_pool_bulk_threads",
+			  "the value must not be less than one");
+	}
+}
+
 static int64_t
 box_check_wal_max_size(int64_t wal_max_size)
 {
@@ -581,6 +616,16 @@ box_check_wal_max_size(int64_t wal_max_size)
 	return wal_max_size;
 }
 
+static int64_t
+box_check_wal_queue_max_len(int64_t wal_queue_max_len)
+{
+	if (wal_queue_max_len < 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_queue_max_len",
+			  "the value must be >= 0");
+	}
+	return wal_queue_max_len;
+}
+
 static ssize_t
 box_check_memory_quota(const char *quota_name)
 {
@@ -659,10 +704,15 @@ box_check_config()
 	box_check_replication_connect_quorum();
 	box_check_replication_sync_lag();
 	box_check_replication_sync_timeout();
+	box_check_replication_compression();
+	box_check_replication_join_workers();
 	box_check_readahead(cfg_geti("readahead"));
 	box_check_checkpoint_count(cfg_geti("checkpoint_count"));
+	box_check_worker_pool_bulk_threads(
+		cfg_geti("worker_pool_bulk_threads"));
 	box_check_wal_max_size(cfg_geti64("wal_max_size"));
 	box_check_wal_mode(cfg_gets("wal_mode"));
+	box_check_wal_queue_max_len(cfg_geti64("wal_queue_max_len"));
 	if (box_check_memory_quota("memtx_memory") < 0)
 		diag_raise();
 	box_check_memtx_min_tuple_size(cfg_geti64("memtx_min_tuple_size"));
@@ -783,6 +833,19 @@ box_set_replication_sync_timeout(void)
 	replication_sync_timeout = box_check_replication_sync_timeout();
 }
 
+void
+box_set_replication_compression(void)
+{
+	/* Takes effect on the next replica (re)connect. */
+	replication_compression = box_check_replication_compression();
+}
+
+void
+box_set_replication_join_workers(void)
+{
+	replication_join_workers = box_check_replication_join_workers();
+}
+
 void
 box_set_replication_skip_conflict(void)
 {
@@ -935,6 +998,14 @@ box_set_checkpoint_count(void)
 	gc_set_min_checkpoint_count(checkpoint_count);
 }
 
+void
+box_set_worker_pool_bulk_threads(void)
+{
+	int bulk_threads = cfg_geti("worker_pool_bulk_threads");
+	box_check_worker_pool_bulk_threads(bulk_threads);
+	coio_set_bulk_threads(bulk_threads);
+}
+
 void
 box_set_checkpoint_interval(void)
 {
@@ -949,6 +1020,14 @@ box_set_checkpoint_wal_threshold(void)
 	wal_set_checkpoint_threshold(threshold);
 }
 
+void
+box_set_wal_queue_max_len(void)
+{
+	int64_t max_len = box_check_wal_queue_max_len(
+		cfg_geti64("wal_queue_max_len"));
+	wal_set_queue_max_len(max_len);
+}
+
 void
 box_set_vinyl_memory(void)
 {
@@ -977,6 +1056,27 @@ box_set_vinyl_cache(void)
 	vinyl_engine_set_cache(vinyl, cfg_geti64("vinyl_cache"));
 }
 
+void
+box_set_vinyl_page_cache(void)
+{
+	struct engine *vinyl = engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	vinyl_engine_set_page_cache(vinyl, cfg_geti64("vinyl_page_cache"));
+}
+
+void
+box_set_vinyl_read_latency_slo(void)
+{
+	struct engine *vinyl = engine_by_name("vinyl");
+	assert(vinyl != NULL);
+	double slo = cfg_getd("vinyl_read_latency_slo");
+	if (slo < 0) {
+		tnt_raise(ClientError, ER_CFG, "vinyl_read_latency_slo",
+			  "the value must not be negative");
+	}
+	vinyl_engine_set_read_latency_slo(vinyl, slo);
+}
+
 void
 box_set_vinyl_timeout(void)
 {
@@ -1155,6 +1255,16 @@ box_select(uint32_t space_id, uint32_t index_id,
 	   int iterator, uint32_t offset, uint32_t limit,
 	   const char *key, const char *key_end,
 	   struct port *port)
+{
+	return box_select_ex(space_id, index_id, iterator, offset, limit,
+			     key, key_end, false, port);
+}
+
+int
+box_select_ex(uint32_t space_id, uint32_t index_id,
+	      int iterator, uint32_t offset, uint32_t limit,
+	      const char *key, const char *key_end, bool skip_cache,
+	      struct port *port)
 {
 	(void)key_end;
 
@@ -1196,6 +1306,7 @@ box_select(uint32_t space_id, uint32_t index_id,
 		txn_rollback_stmt(txn);
 		return -1;
 	}
+	it->skip_cache = skip_cache;
 
 	int rc = 0;
 	uint32_t found = 0;
@@ -1268,6 +1379,25 @@ box_delete(uint32_t space_id, uint32_t index_id, const char *key,
 	return box_process1(&request, result);
 }
 
+API_EXPORT int
+box_delete_range(uint32_t space_id, uint32_t index_id, const char *begin,
+		 const char *begin_end, const char *end, const char *end_end)
+{
+	mp_tuple_assert(begin, begin_end);
+	mp_tuple_assert(end, end_end);
+	struct request request;
+	memset(&request, 0, sizeof(request));
+	request.type = IPROTO_DELETE_RANGE;
+	request.space_id = space_id;
+	request.index_id = index_id;
+	request.key = begin;
+	request.key_end = begin_end;
+	/* Like UPDATE, reuse the tuple for the second argument. */
+	request.tuple = end;
+	request.tuple_end = end_end;
+	return box_process1(&request, NULL);
+}
+
 API_EXPORT int
 box_update(uint32_t space_id, uint32_t index_id, const char *key,
 	   const char *key_end, const char *ops, const char *ops_end,
@@ -1538,6 +1668,9 @@ box_process_fetch_snapshot(struct ev_io *io, struct xrow_header *header)
 {
 	assert(header->type == IPROTO_FETCH_SNAPSHOT);
 
+	bool compression;
+	xrow_decode_fetch_snapshot_xc(header, &compression);
+
 	/* Check that bootstrap has been finished */
 	if (!is_box_configured)
 		tnt_raise(ClientError, ER_LOADING);
@@ -1555,7 +1688,7 @@ box_process_fetch_snapshot(struct ev_io *io, struct xrow_header *header)
 
 	/* Send the snapshot data to the instance. */
 	struct vclock start_vclock;
-	relay_initial_join(io->fd, header->sync, &start_vclock);
+	relay_initial_join(io->fd, header->sync, &start_vclock, compression);
 	say_info("read-view sent.");
 
 	/* Remember master's vclock after the last request */
@@ -1576,7 +1709,8 @@ box_process_register(struct ev_io *io, struct xrow_header *header)
 
 	struct tt_uuid instance_uuid = uuid_nil;
 	struct vclock vclock;
-	xrow_decode_register_xc(header, &instance_uuid, &vclock);
+	bool compression;
+	xrow_decode_register_xc(header, &instance_uuid, &vclock, &compression);
 
 	if (!is_box_configured)
 		tnt_raise(ClientError, ER_LOADING);
@@ -1631,7 +1765,8 @@ box_process_register(struct ev_io *io, struct xrow_header *header)
 	 * (start_vclock, stop_vclock) so that it gets its
 	 * registration.
 	 */
-	relay_final_join(io->fd, header->sync, &start_vclock, &stop_vclock);
+	relay_final_join(io->fd, header->sync, &start_vclock, &stop_vclock,
+			 compression);
 	say_info("final data sent.");
 
 	struct xrow_header row;
@@ -1702,7 +1837,8 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 
 	/* Decode JOIN request */
 	struct tt_uuid instance_uuid = uuid_nil;
-	xrow_decode_join_xc(header, &instance_uuid);
+	bool compression;
+	xrow_decode_join_xc(header, &instance_uuid, &compression);
 
 	/* Check that bootstrap has been finished */
 	if (!is_box_configured)
@@ -1751,7 +1887,7 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	 * Initial stream: feed replica with dirty data from engines.
 	 */
 	struct vclock start_vclock;
-	relay_initial_join(io->fd, header->sync, &start_vclock);
+	relay_initial_join(io->fd, header->sync, &start_vclock, compression);
 	say_info("initial data sent.");
 
 	/**
@@ -1778,7 +1914,8 @@ box_process_join(struct ev_io *io, struct xrow_header *header)
 	 * Final stage: feed replica with WALs in range
 	 * (start_vclock, stop_vclock).
 	 */
-	relay_final_join(io->fd, header->sync, &start_vclock, &stop_vclock);
+	relay_final_join(io->fd, header->sync, &start_vclock, &stop_vclock,
+			 compression);
 	say_info("final data sent.");
 
 	/* Send end of WAL stream marker */
@@ -1813,8 +1950,10 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 	vclock_create(&replica_clock);
 	bool anon;
 	uint32_t id_filter;
+	bool compression;
 	xrow_decode_subscribe_xc(header, NULL, &replica_uuid, &replica_clock,
-				 &replica_version_id, &anon, &id_filter);
+				 &replica_version_id, &anon, &id_filter,
+				 &compression);
 
 	/* Forbid connection to itself */
 	if (tt_uuid_is_equal(&replica_uuid, &INSTANCE_UUID))
@@ -1917,7 +2056,7 @@ box_process_subscribe(struct ev_io *io, struct xrow_header *header)
 	 * indefinitely).
 	 */
 	relay_subscribe(replica, io->fd, header->sync, &replica_clock,
-			replica_version_id, id_filter);
+			replica_version_id, id_filter, compression);
 }
 
 void
@@ -2014,6 +2153,8 @@ engine_init()
 	engine_register((struct engine *)vinyl);
 	box_set_vinyl_max_tuple_size();
 	box_set_vinyl_cache();
+	box_set_vinyl_page_cache();
+	box_set_vinyl_read_latency_slo();
 	box_set_vinyl_timeout();
 }
 
@@ -2420,6 +2561,8 @@ box_cfg_xc(void)
 	box_set_replication_sync_timeout();
 	box_set_replication_skip_conflict();
 	box_set_replication_anon();
+	box_set_replication_compression();
+	box_set_replication_join_workers();
 
 	struct gc_checkpoint *checkpoint = gc_last_checkpoint();
 
@@ -231,13 +231,17 @@ void box_set_snap_io_rate_limit(void);
 void box_set_too_long_threshold(void);
 void box_set_readahead(void);
 void box_set_checkpoint_count(void);
+void box_set_worker_pool_bulk_threads(void);
 void box_set_checkpoint_interval(void);
 void box_set_checkpoint_wal_threshold(void);
+void box_set_wal_queue_max_len(void);
 void box_set_memtx_memory(void);
 void box_set_memtx_max_tuple_size(void);
 void box_set_vinyl_memory(void);
 void box_set_vinyl_max_tuple_size(void);
 void box_set_vinyl_cache(void);
+void box_set_vinyl_page_cache(void);
+void box_set_vinyl_read_latency_slo(void);
 void box_set_vinyl_timeout(void);
 void box_set_replication_timeout(void);
 void box_set_replication_connect_timeout(void);
@@ -246,6 +250,8 @@ void box_set_replication_sync_lag(void);
 void box_set_replication_sync_timeout(void);
 void box_set_replication_skip_conflict(void);
 void box_set_replication_anon(void);
+void box_set_replication_compression(void);
+void box_set_replication_join_workers(void);
 void box_set_net_msg_max(void);
 
 int
@@ -263,6 +269,17 @@ box_select(uint32_t space_id, uint32_t index_id,
 	   const char *key, const char *key_end,
 	   struct port *port);
 
+/**
+ * Same as box_select(), but if @skip_cache is set, selected
+ * tuples aren't added to engine caches, see index:select()
+ * 'cache' option.
+ */
+int
+box_select_ex(uint32_t space_id, uint32_t index_id,
+	      int iterator, uint32_t offset, uint32_t limit,
+	      const char *key, const char *key_end, bool skip_cache,
+	      struct port *port);
+
 /** \cond public */
 
 /*
@@ -376,6 +393,30 @@ API_EXPORT int
 box_delete(uint32_t space_id, uint32_t index_id, const char *key,
 	   const char *key_end, box_tuple_t **result);
 
+/**
+ * Execute a DELETE_RANGE request: delete all tuples whose keys
+ * lie in the half-open interval [begin, end). The deletion is
+ * written to WAL as a single row.
+ *
+ * \param space_id space identifier
+ * \param index_id index identifier, must be the primary index
+ * \param begin encoded lower bound of the range (inclusive) in
+ *        MsgPack Array format ([part1, part2, ...]), an empty
+ *        array means the range is unbounded below.
+ * \param begin_end the end of encoded \a begin.
+ * \param end encoded upper bound of the range (exclusive) in
+ *        MsgPack Array format, an empty array means the range
+ *        is unbounded above.
+ * \param end_end the end of encoded \a end.
+ * \retval -1 on error (check box_error_last())
+ * \retval 0 on success
+ * \sa \code box.space[space_id].index[index_id]:delete_range(begin, end)
+ * \endcode
+ */
+API_EXPORT int
+box_delete_range(uint32_t space_id, uint32_t index_id, const char *begin,
+		 const char *begin_end, const char *end, const char *end_end);
+
 /**
  * Execute an UPDATE request.
  *
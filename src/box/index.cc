@@ -356,6 +356,14 @@ box_index_count(uint32_t space_id, uint32_t index_id, int type,
 box_iterator_t *
 box_index_iterator(uint32_t space_id, uint32_t index_id, int type,
                    const char *key, const char *key_end)
+{
+	return box_index_iterator_ex(space_id, index_id, type,
+				     key, key_end, false);
+}
+
+box_iterator_t *
+box_index_iterator_ex(uint32_t space_id, uint32_t index_id, int type,
+		      const char *key, const char *key_end, bool skip_cache)
 {
 	assert(key != NULL && key_end != NULL);
 	mp_tuple_assert(key, key_end);
@@ -382,6 +390,7 @@ box_index_iterator(uint32_t space_id, uint32_t index_id, int type,
 		txn_rollback_stmt(txn);
 		return NULL;
 	}
+	it->skip_cache = skip_cache;
 	txn_commit_ro_stmt(txn);
 	rmean_collect(rmean_box, IPROTO_SELECT, 1);
 	return it;
@@ -408,6 +417,39 @@ box_iterator_free(box_iterator_t *it)
 
 /* {{{ Other index functions */
 
+int
+box_index_get_many(uint32_t space_id, uint32_t index_id,
+		   const char **keys, uint32_t key_count,
+		   struct tuple **result)
+{
+	struct space *space;
+	struct index *index;
+	if (check_index(space_id, index_id, &space, &index) != 0)
+		return -1;
+	if (!index->def->opts.is_unique) {
+		diag_set(ClientError, ER_MORE_THAN_ONE_TUPLE);
+		return -1;
+	}
+	for (uint32_t i = 0; i < key_count; i++) {
+		const char *key = keys[i];
+		uint32_t part_count = mp_decode_array(&key);
+		if (exact_key_validate(index->def->key_def, key, part_count))
+			return -1;
+	}
+	/* Start transaction in the engine. */
+	struct txn *txn;
+	if (txn_begin_ro_stmt(space, &txn) != 0)
+		return -1;
+	if (index_get_many(index, keys, key_count, result) != 0) {
+		txn_rollback_stmt(txn);
+		return -1;
+	}
+	txn_commit_ro_stmt(txn);
+	/* Count statistics. */
+	rmean_collect(rmean_box, IPROTO_SELECT, key_count);
+	return 0;
+}
+
 int
 box_index_stat(uint32_t space_id, uint32_t index_id,
 	       struct info_handler *info)
@@ -444,6 +486,7 @@ iterator_create(struct iterator *it, struct index *index)
 	it->space_id = index->def->space_id;
 	it->index_id = index->def->iid;
 	it->index = index;
+	it->skip_cache = false;
 }
 
 int
@@ -549,6 +592,66 @@ index_build(struct index *index, struct index *pk)
 	return 0;
 }
 
+int
+index_collect_range(struct index *index, const char *begin,
+		    const char *end, struct tuple ***tuples, uint32_t *count)
+{
+	struct key_def *key_def = index->def->key_def;
+	assert(index->def->type == TREE);
+	assert(!key_def->is_multikey && !key_def->for_func_index);
+	uint32_t begin_part_count = mp_decode_array(&begin);
+	if (key_validate(index->def, ITER_GE, begin, begin_part_count) != 0)
+		return -1;
+	uint32_t end_part_count = mp_decode_array(&end);
+	if (key_validate(index->def, ITER_LT, end, end_part_count) != 0)
+		return -1;
+
+	*tuples = NULL;
+	*count = 0;
+	uint32_t capacity = 0;
+	struct iterator *it = index_create_iterator(index, ITER_GE, begin,
+						    begin_part_count);
+	if (it == NULL)
+		return -1;
+	struct tuple *tuple;
+	while (true) {
+		if (iterator_next(it, &tuple) != 0)
+			goto fail;
+		if (tuple == NULL)
+			break;
+		if (end_part_count > 0 &&
+		    tuple_compare_with_key(tuple, HINT_NONE, end,
+					   end_part_count, HINT_NONE,
+					   key_def) >= 0)
+			break;
+		if (*count == capacity) {
+			uint32_t new_capacity = MAX(capacity * 2, 16U);
+			size_t size = new_capacity * sizeof(**tuples);
+			struct tuple **new_tuples =
+				(struct tuple **)realloc(*tuples, size);
+			if (new_tuples == NULL) {
+				diag_set(OutOfMemory, size, "realloc",
+					 "tuples");
+				goto fail;
+			}
+			*tuples = new_tuples;
+			capacity = new_capacity;
+		}
+		tuple_ref(tuple);
+		(*tuples)[(*count)++] = tuple;
+	}
+	iterator_delete(it);
+	return 0;
+fail:
+	iterator_delete(it);
+	for (uint32_t i = 0; i < *count; i++)
+		tuple_unref((*tuples)[i]);
+	free(*tuples);
+	*tuples = NULL;
+	*count = 0;
+	return -1;
+}
+
 /* }}} */
 
 /* {{{ Virtual method stubs */
@@ -668,6 +771,26 @@ generic_index_get(struct index *index, const char *key,
 	return -1;
 }
 
+int
+generic_index_get_many(struct index *index, const char **keys,
+		       uint32_t key_count, struct tuple **result)
+{
+	for (uint32_t i = 0; i < key_count; i++) {
+		const char *key = keys[i];
+		uint32_t part_count = mp_decode_array(&key);
+		if (index_get(index, key, part_count, &result[i]) != 0) {
+			while (i-- > 0) {
+				if (result[i] != NULL)
+					tuple_unref(result[i]);
+			}
+			return -1;
+		}
+		if (result[i] != NULL)
+			tuple_ref(result[i]);
+	}
+	return 0;
+}
+
 int
 generic_index_replace(struct index *index, struct tuple *old_tuple,
 		      struct tuple *new_tuple, enum dup_replace_mode mode,
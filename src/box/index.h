@@ -211,6 +211,32 @@ box_tuple_extract_key(box_tuple_t *tuple, uint32_t space_id,
 
 /** \endcond public */
 
+/**
+ * Same as box_index_iterator(), but if @skip_cache is set, tuples
+ * read by the iterator aren't added to engine caches, see
+ * index:pairs() 'cache' option.
+ */
+box_iterator_t *
+box_index_iterator_ex(uint32_t space_id, uint32_t index_id, int type,
+		      const char *key, const char *key_end, bool skip_cache);
+
+/**
+ * Get tuples by an array of keys (index:get_many()).
+ *
+ * \param space_id space identifier
+ * \param index_id index identifier
+ * \param keys encoded keys in MsgPack Array format
+ * \param key_count number of keys
+ * \param[out] result found tuples with reference counters elevated
+ *             or NULLs, one per key
+ * \retval -1 on error (check box_error_last())
+ * \retval 0 on success
+ */
+int
+box_index_get_many(uint32_t space_id, uint32_t index_id,
+		   const char **keys, uint32_t key_count,
+		   struct tuple **result);
+
 /**
  * Index statistics (index:stat())
  *
@@ -256,6 +282,13 @@ struct iterator {
 	 * state has not changed since the last lookup.
 	 */
 	struct index *index;
+	/**
+	 * Set if tuples read by the iterator must not be added
+	 * to engine caches, e.g. by a one-off scan. May be set
+	 * by the caller after the iterator is created, but
+	 * before it is used.
+	 */
+	bool skip_cache;
 };
 
 /**
@@ -412,6 +445,14 @@ struct index_vtab {
 			 const char *key, uint32_t part_count);
 	int (*get)(struct index *index, const char *key,
 		   uint32_t part_count, struct tuple **result);
+	/**
+	 * Look up tuples by an array of full keys, each encoded
+	 * as a MsgPack array. Found tuples are returned in the
+	 * corresponding slots of @result with reference counters
+	 * elevated, NULL is returned for keys that aren't found.
+	 */
+	int (*get_many)(struct index *index, const char **keys,
+			uint32_t key_count, struct tuple **result);
 	int (*replace)(struct index *index, struct tuple *old_tuple,
 		       struct tuple *new_tuple, enum dup_replace_mode mode,
 		       struct tuple **result);
@@ -533,6 +574,18 @@ index_unref(struct index *index)
 int
 index_build(struct index *index, struct index *pk);
 
+/**
+ * Collect all tuples of a TREE index whose keys lie in the
+ * half-open interval [begin, end). Both keys are MsgPack arrays,
+ * an empty array stands for an unbounded side of the interval.
+ * The tuples are returned in the index order, referenced, in
+ * an array allocated with malloc(), which is to be freed by the
+ * caller.
+ */
+int
+index_collect_range(struct index *index, const char *begin,
+		    const char *end, struct tuple ***tuples, uint32_t *count);
+
 static inline void
 index_commit_create(struct index *index, int64_t signature)
 {
@@ -622,6 +675,13 @@ index_get(struct index *index, const char *key,
 	return index->vtab->get(index, key, part_count, result);
 }
 
+static inline int
+index_get_many(struct index *index, const char **keys,
+	       uint32_t key_count, struct tuple **result)
+{
+	return index->vtab->get_many(index, keys, key_count, result);
+}
+
 static inline int
 index_replace(struct index *index, struct tuple *old_tuple,
 	      struct tuple *new_tuple, enum dup_replace_mode mode,
@@ -704,6 +764,8 @@ int generic_index_random(struct index *, uint32_t, struct tuple **);
 ssize_t generic_index_count(struct index *, enum iterator_type,
 			    const char *, uint32_t);
 int generic_index_get(struct index *, const char *, uint32_t, struct tuple **);
+int generic_index_get_many(struct index *, const char **, uint32_t,
+			   struct tuple **);
 int generic_index_replace(struct index *, struct tuple *, struct tuple *,
 			  enum dup_replace_mode, struct tuple **);
 struct snapshot_iterator *generic_index_create_snapshot_iterator(struct index *);
@@ -39,6 +39,8 @@ const char *index_type_strs[] = { "HASH", "TREE", "BITSET", "RTREE" };
 
 const char *rtree_index_distance_type_strs[] = { "EUCLID", "MANHATTAN" };
 
+const char *index_compaction_policy_strs[] = { "tiered", "leveled" };
+
 const struct index_opts index_opts_default = {
 	/* .unique              = */ true,
 	/* .dimension           = */ 2,
@@ -47,7 +49,14 @@ const struct index_opts index_opts_default = {
 	/* .page_size           = */ 8192,
 	/* .run_count_per_level = */ 2,
 	/* .run_size_ratio      = */ 3.5,
+	/* .compaction_policy   = */ INDEX_COMPACTION_TIERED,
 	/* .bloom_fpr           = */ 0.05,
+	/* .blob_threshold      = */ 0,
+	/* .compression_dict_size = */ 0,
+	/* .ttl                 = */ 0,
+	/* .ttl_field           = */ 0,
+	/* .range_filter        = */ false,
+	/* .covering            = */ false,
 	/* .lsn                 = */ 0,
 	/* .stat                = */ NULL,
 	/* .func                = */ 0,
@@ -62,7 +71,16 @@ const struct opt_def index_opts_reg[] = {
 	OPT_DEF("page_size", OPT_INT64, struct index_opts, page_size),
 	OPT_DEF("run_count_per_level", OPT_INT64, struct index_opts, run_count_per_level),
 	OPT_DEF("run_size_ratio", OPT_FLOAT, struct index_opts, run_size_ratio),
+	OPT_DEF_ENUM("compaction_policy", index_compaction_policy,
+		     struct index_opts, compaction_policy, NULL),
 	OPT_DEF("bloom_fpr", OPT_FLOAT, struct index_opts, bloom_fpr),
+	OPT_DEF("blob_threshold", OPT_UINT32, struct index_opts, blob_threshold),
+	OPT_DEF("compression_dict_size", OPT_UINT32, struct index_opts,
+		compression_dict_size),
+	OPT_DEF("ttl", OPT_FLOAT, struct index_opts, ttl),
+	OPT_DEF("ttl_field", OPT_UINT32, struct index_opts, ttl_field),
+	OPT_DEF("range_filter", OPT_BOOL, struct index_opts, range_filter),
+	OPT_DEF("covering", OPT_BOOL, struct index_opts, covering),
 	OPT_DEF("lsn", OPT_INT64, struct index_opts, lsn),
 	OPT_DEF("func", OPT_UINT32, struct index_opts, func_id),
 	OPT_DEF_LEGACY("sql"),
@@ -58,6 +58,22 @@ enum rtree_index_distance_type {
 };
 extern const char *rtree_index_distance_type_strs[];
 
+/** Vinyl compaction policy, see vy_range_update_compaction_priority(). */
+enum index_compaction_policy {
+	/**
+	 * Up to run_count_per_level runs per LSM tree level,
+	 * one run at the last level.
+	 */
+	INDEX_COMPACTION_TIERED,
+	/**
+	 * Up to run_count_per_level runs at the first level,
+	 * one run at each subsequent level.
+	 */
+	INDEX_COMPACTION_LEVELED,
+	index_compaction_policy_MAX
+};
+extern const char *index_compaction_policy_strs[];
+
 /** Simple alias to represent logarithm metrics. */
 typedef int16_t log_est_t;
 
@@ -151,8 +167,43 @@ struct index_opts {
 	 * previous one.
 	 */
 	double run_size_ratio;
+	/** Vinyl compaction policy. */
+	enum index_compaction_policy compaction_policy;
 	/* Bloom filter false positive rate. */
 	double bloom_fpr;
+	/**
+	 * Min size of a vinyl primary index statement to store
+	 * its big non-indexed fields in a separate blob file
+	 * (see vy_blob.h). 0 disables key-value separation.
+	 */
+	uint32_t blob_threshold;
+	/**
+	 * Max size of a zstd dictionary trained for compressing
+	 * pages of each vinyl run written by compaction. The
+	 * dictionary is stored in the run index file. 0 disables
+	 * dictionary compression.
+	 */
+	uint32_t compression_dict_size;
+	/**
+	 * Time to live of tuples stored in a vinyl space, in
+	 * seconds. A tuple expires when the timestamp stored in
+	 * field @ttl_field plus @ttl is in the past. Expired tuples
+	 * are dropped by major compaction. 0 disables expiration.
+	 */
+	double ttl;
+	/** Number of the field storing tuple timestamp for @ttl. */
+	uint32_t ttl_field;
+	/**
+	 * Build a range filter for each vinyl run so that short
+	 * range scans can skip runs having no keys in the scanned
+	 * interval (see vy_range_filter.h).
+	 */
+	bool range_filter;
+	/**
+	 * Store full tuples in a vinyl secondary index so that
+	 * reads from it don't need to look up the primary index.
+	 */
+	bool covering;
 	/**
 	 * LSN from the time of index creation.
 	 */
@@ -207,8 +258,23 @@ index_opts_cmp(const struct index_opts *o1, const struct index_opts *o2)
 		       -1 : 1;
 	if (o1->run_size_ratio != o2->run_size_ratio)
 		return o1->run_size_ratio < o2->run_size_ratio ? -1 : 1;
+	if (o1->compaction_policy != o2->compaction_policy)
+		return o1->compaction_policy < o2->compaction_policy ? -1 : 1;
 	if (o1->bloom_fpr != o2->bloom_fpr)
 		return o1->bloom_fpr < o2->bloom_fpr ? -1 : 1;
+	if (o1->blob_threshold != o2->blob_threshold)
+		return o1->blob_threshold < o2->blob_threshold ? -1 : 1;
+	if (o1->compression_dict_size != o2->compression_dict_size)
+		return o1->compression_dict_size <
+		       o2->compression_dict_size ? -1 : 1;
+	if (o1->ttl != o2->ttl)
+		return o1->ttl < o2->ttl ? -1 : 1;
+	if (o1->ttl_field != o2->ttl_field)
+		return o1->ttl_field < o2->ttl_field ? -1 : 1;
+	if (o1->range_filter != o2->range_filter)
+		return o1->range_filter < o2->range_filter ? -1 : 1;
+	if (o1->covering != o2->covering)
+		return o1->covering < o2->covering ? -1 : 1;
 	if (o1->func_id != o2->func_id)
 		return o1->func_id - o2->func_id;
 	return 0;
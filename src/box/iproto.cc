@@ -1227,6 +1227,7 @@ static const struct cmsg_hop *dml_route[IPROTO_TYPE_STAT_MAX] = {
 	sql_route,                              /* IPROTO_EXECUTE */
 	NULL,                                   /* IPROTO_NOP */
 	sql_route,                              /* IPROTO_PREPARE */
+	process1_route,                         /* IPROTO_DELETE_RANGE */
 };
 
 static const struct cmsg_hop join_route[] = {
@@ -1268,6 +1269,7 @@ iproto_msg_decode(struct iproto_msg *msg, const char **pos, const char *reqend,
 	case IPROTO_UPDATE:
 	case IPROTO_DELETE:
 	case IPROTO_UPSERT:
+	case IPROTO_DELETE_RANGE:
 		if (xrow_decode_dml(&msg->header, &msg->dml,
 				    dml_request_key_map(type)))
 			goto error;
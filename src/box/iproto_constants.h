@@ -127,6 +127,14 @@ enum iproto_key {
 	IPROTO_REPLICA_ANON = 0x50,
 	IPROTO_ID_FILTER = 0x51,
 	IPROTO_ERROR = 0x52,
+	/**
+	 * Set by a replica in JOIN, FETCH_SNAPSHOT, REGISTER and
+	 * SUBSCRIBE requests to let the master know that it can
+	 * decode IPROTO_COMPRESSED_ROWS packets.
+	 */
+	IPROTO_COMPRESSION = 0x53,
+	/** Size of IPROTO_COMPRESSED_ROWS data after decompression. */
+	IPROTO_RAW_LEN = 0x54,
 	IPROTO_KEY_MAX
 };
 
@@ -216,6 +224,11 @@ enum iproto_type {
 	IPROTO_NOP = 12,
 	/** Prepare SQL statement. */
 	IPROTO_PREPARE = 13,
+	/**
+	 * Delete all tuples whose key lies in [KEY, TUPLE) of
+	 * the given index. Logged as a single row.
+	 */
+	IPROTO_DELETE_RANGE = 14,
 	/** The maximum typecode used for box.stat() */
 	IPROTO_TYPE_STAT_MAX,
 
@@ -233,6 +246,8 @@ enum iproto_type {
 	IPROTO_FETCH_SNAPSHOT = 69,
 	/** REGISTER request to leave anonymous replication. */
 	IPROTO_REGISTER = 70,
+	/** A chunk of compressed replication stream. */
+	IPROTO_COMPRESSED_ROWS = 71,
 
 	/** Vinyl run info stored in .index file */
 	VY_INDEX_RUN_INFO = 100,
@@ -261,11 +276,14 @@ static inline const char *
 iproto_type_name(uint32_t type)
 {
 	/*
-	 * Sic: iptoto_type_strs[IPROTO_NOP] is NULL
+	 * Sic: iptoto_type_strs[IPROTO_NOP] and
+	 * iproto_type_strs[IPROTO_DELETE_RANGE] are NULL
 	 * to suppress box.stat() output.
 	 */
 	if (type == IPROTO_NOP)
 		return "NOP";
+	if (type == IPROTO_DELETE_RANGE)
+		return "DELETE_RANGE";
 
 	if (type < IPROTO_TYPE_STAT_MAX)
 		return iproto_type_strs[type];
@@ -300,7 +318,8 @@ static inline bool
 iproto_type_is_dml(uint32_t type)
 {
 	return (type >= IPROTO_SELECT && type <= IPROTO_DELETE) ||
-		type == IPROTO_UPSERT || type == IPROTO_NOP;
+		type == IPROTO_UPSERT || type == IPROTO_NOP ||
+		type == IPROTO_DELETE_RANGE;
 }
 
 /**
@@ -364,6 +383,10 @@ enum vy_run_info_key {
 	VY_RUN_INFO_BLOOM = 7,
 	/** Number of statements of each type (map). */
 	VY_RUN_INFO_STMT_STAT = 8,
+	/** Zstd dictionary used for compressing pages (binary). */
+	VY_RUN_INFO_DICT = 9,
+	/** Range filter of the first key part. */
+	VY_RUN_INFO_RANGE_FILTER = 10,
 	/** The last key in this enum + 1 */
 	VY_RUN_INFO_KEY_MAX
 };
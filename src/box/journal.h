@@ -102,6 +102,12 @@ struct journal {
 	/** Synchronous write */
 	int (*write)(struct journal *journal,
 		     struct journal_entry *entry);
+
+	/**
+	 * Wait until the journal is ready to accept a new entry.
+	 * Optional, NULL if the journal never blocks writers.
+	 */
+	int (*wait_room)(struct journal *journal);
 };
 
 /**
@@ -142,6 +148,21 @@ journal_write_async(struct journal_entry *entry)
 	return current_journal->write_async(current_journal, entry);
 }
 
+/**
+ * Block the current fiber until the journal has room for a new
+ * entry. Must be called before a transaction modifies any data,
+ * because a transaction may not be allowed to yield after that.
+ *
+ * @return 0 on success, -1 on error (diag is set).
+ */
+static inline int
+journal_wait_room(void)
+{
+	if (current_journal->wait_room == NULL)
+		return 0;
+	return current_journal->wait_room(current_journal);
+}
+
 /**
  * Change the current implementation of the journaling API.
  * Happens during life cycle of an instance:
@@ -180,6 +201,7 @@ journal_create(struct journal *journal,
 	journal->write_async	= write_async;
 	journal->write_async_cb	= write_async_cb;
 	journal->write		= write;
+	journal->wait_room	= NULL;
 }
 
 /**
@@ -164,6 +164,17 @@ lbox_cfg_set_checkpoint_wal_threshold(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_wal_queue_max_len(struct lua_State *L)
+{
+	try {
+		box_set_wal_queue_max_len();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_read_only(struct lua_State *L)
 {
@@ -230,6 +241,28 @@ lbox_cfg_set_vinyl_cache(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_vinyl_page_cache(struct lua_State *L)
+{
+	try {
+		box_set_vinyl_page_cache();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_vinyl_read_latency_slo(struct lua_State *L)
+{
+	try {
+		box_set_vinyl_read_latency_slo();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_vinyl_timeout(struct lua_State *L)
 {
@@ -269,6 +302,17 @@ lbox_cfg_set_worker_pool_threads(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_worker_pool_bulk_threads(struct lua_State *L)
+{
+	try {
+		box_set_worker_pool_bulk_threads();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_replication_timeout(struct lua_State *L)
 {
@@ -335,6 +379,28 @@ lbox_cfg_set_replication_anon(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_replication_compression(struct lua_State *L)
+{
+	try {
+		box_set_replication_compression();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
+static int
+lbox_cfg_set_replication_join_workers(struct lua_State *L)
+{
+	try {
+		box_set_replication_join_workers();
+	} catch (Exception *) {
+		luaT_error(L);
+	}
+	return 0;
+}
+
 static int
 lbox_cfg_set_replication_skip_conflict(struct lua_State *L)
 {
@@ -352,6 +418,8 @@ box_lua_cfg_init(struct lua_State *L)
 		{"cfg_set_listen", lbox_cfg_set_listen},
 		{"cfg_set_replication", lbox_cfg_set_replication},
 		{"cfg_set_worker_pool_threads", lbox_cfg_set_worker_pool_threads},
+		{"cfg_set_worker_pool_bulk_threads",
+			lbox_cfg_set_worker_pool_bulk_threads},
 		{"cfg_set_readahead", lbox_cfg_set_readahead},
 		{"cfg_set_io_collect_interval", lbox_cfg_set_io_collect_interval},
 		{"cfg_set_too_long_threshold", lbox_cfg_set_too_long_threshold},
@@ -359,12 +427,15 @@ box_lua_cfg_init(struct lua_State *L)
 		{"cfg_set_checkpoint_count", lbox_cfg_set_checkpoint_count},
 		{"cfg_set_checkpoint_interval", lbox_cfg_set_checkpoint_interval},
 		{"cfg_set_checkpoint_wal_threshold", lbox_cfg_set_checkpoint_wal_threshold},
+		{"cfg_set_wal_queue_max_len", lbox_cfg_set_wal_queue_max_len},
 		{"cfg_set_read_only", lbox_cfg_set_read_only},
 		{"cfg_set_memtx_memory", lbox_cfg_set_memtx_memory},
 		{"cfg_set_memtx_max_tuple_size", lbox_cfg_set_memtx_max_tuple_size},
 		{"cfg_set_vinyl_memory", lbox_cfg_set_vinyl_memory},
 		{"cfg_set_vinyl_max_tuple_size", lbox_cfg_set_vinyl_max_tuple_size},
 		{"cfg_set_vinyl_cache", lbox_cfg_set_vinyl_cache},
+		{"cfg_set_vinyl_page_cache", lbox_cfg_set_vinyl_page_cache},
+		{"cfg_set_vinyl_read_latency_slo", lbox_cfg_set_vinyl_read_latency_slo},
 		{"cfg_set_vinyl_timeout", lbox_cfg_set_vinyl_timeout},
 		{"cfg_set_replication_timeout", lbox_cfg_set_replication_timeout},
 		{"cfg_set_replication_connect_quorum", lbox_cfg_set_replication_connect_quorum},
@@ -373,6 +444,8 @@ box_lua_cfg_init(struct lua_State *L)
 		{"cfg_set_replication_sync_timeout", lbox_cfg_set_replication_sync_timeout},
 		{"cfg_set_replication_skip_conflict", lbox_cfg_set_replication_skip_conflict},
 		{"cfg_set_replication_anon", lbox_cfg_set_replication_anon},
+		{"cfg_set_replication_compression", lbox_cfg_set_replication_compression},
+		{"cfg_set_replication_join_workers", lbox_cfg_set_replication_join_workers},
 		{"cfg_set_net_msg_max", lbox_cfg_set_net_msg_max},
 		{"cfg_set_sql_cache_size", lbox_set_prepared_stmt_cache_size},
 		{NULL, NULL}
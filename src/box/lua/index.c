@@ -34,8 +34,11 @@
 #include "info/info.h"
 #include "box/box.h"
 #include "box/index.h"
+#include "box/error.h"
+#include "box/tuple.h"
 #include "box/lua/tuple.h"
 #include "box/lua/misc.h" /* lbox_encode_tuple_on_gc() */
+#include "fiber.h"
 
 /** {{{ box.index Lua library: access to spaces and indexes
  */
@@ -135,6 +138,27 @@ lbox_index_delete(lua_State *L)
 	return luaT_pushtupleornil(L, result);
 }
 
+static int
+lbox_index_delete_range(lua_State *L)
+{
+	if (lua_gettop(L) != 4 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2) ||
+	    (lua_type(L, 3) != LUA_TTABLE && luaT_istuple(L, 3) == NULL) ||
+	    (lua_type(L, 4) != LUA_TTABLE && luaT_istuple(L, 4) == NULL))
+		return luaL_error(L, "Usage index:delete_range(begin, end)");
+
+	uint32_t space_id = lua_tonumber(L, 1);
+	uint32_t index_id = lua_tonumber(L, 2);
+	size_t begin_len;
+	const char *begin = lbox_encode_tuple_on_gc(L, 3, &begin_len);
+	size_t end_len;
+	const char *end = lbox_encode_tuple_on_gc(L, 4, &end_len);
+
+	if (box_delete_range(space_id, index_id, begin, begin + begin_len,
+			     end, end + end_len) != 0)
+		return luaT_error(L);
+	return 0;
+}
+
 static int
 lbox_index_random(lua_State *L)
 {
@@ -169,6 +193,57 @@ lbox_index_get(lua_State *L)
 	return luaT_pushtupleornil(L, tuple);
 }
 
+static int
+lbox_index_get_many(lua_State *L)
+{
+	if (lua_gettop(L) != 3 || !lua_isnumber(L, 1) ||
+	    !lua_isnumber(L, 2) || !lua_istable(L, 3))
+		return luaL_error(L, "Usage index.get_many(space_id, "
+				  "index_id, keys)");
+
+	uint32_t space_id = lua_tonumber(L, 1);
+	uint32_t index_id = lua_tonumber(L, 2);
+	uint32_t key_count = lua_objlen(L, 3);
+
+	struct region *gc = &fiber()->gc;
+	size_t used = region_used(gc);
+	size_t size;
+	const char **keys = region_alloc_array(gc, typeof(keys[0]),
+					       key_count, &size);
+	if (keys == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc_array", "keys");
+		return luaT_error(L);
+	}
+	struct tuple **result = region_alloc_array(gc, typeof(result[0]),
+						   key_count, &size);
+	if (result == NULL) {
+		region_truncate(gc, used);
+		diag_set(OutOfMemory, size, "region_alloc_array", "result");
+		return luaT_error(L);
+	}
+	for (uint32_t i = 0; i < key_count; i++) {
+		lua_rawgeti(L, 3, i + 1);
+		size_t key_len;
+		keys[i] = lbox_encode_tuple_on_gc(L, lua_gettop(L), &key_len);
+		lua_pop(L, 1);
+	}
+	if (box_index_get_many(space_id, index_id, keys,
+			       key_count, result) != 0) {
+		region_truncate(gc, used);
+		return luaT_error(L);
+	}
+	lua_createtable(L, key_count, 0);
+	for (uint32_t i = 0; i < key_count; i++) {
+		if (result[i] == NULL)
+			continue;
+		luaT_pushtuple(L, result[i]);
+		tuple_unref(result[i]);
+		lua_rawseti(L, -2, i + 1);
+	}
+	region_truncate(gc, used);
+	return 1;
+}
+
 static int
 lbox_index_min(lua_State *L)
 {
@@ -242,9 +317,9 @@ box_index_init_iterator_types(struct lua_State *L, int idx)
 static int
 lbox_index_iterator(lua_State *L)
 {
-	if (lua_gettop(L) != 4 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2) ||
-	    !lua_isnumber(L, 3))
-		return luaL_error(L, "usage index.iterator(space_id, index_id, type, key)");
+	if (lua_gettop(L) < 4 || lua_gettop(L) > 5 || !lua_isnumber(L, 1) ||
+	    !lua_isnumber(L, 2) || !lua_isnumber(L, 3))
+		return luaL_error(L, "usage index.iterator(space_id, index_id, type, key[, skip_cache])");
 
 	uint32_t space_id = lua_tonumber(L, 1);
 	uint32_t index_id = lua_tonumber(L, 2);
@@ -252,8 +327,11 @@ lbox_index_iterator(lua_State *L)
 	size_t mpkey_len;
 	const char *mpkey = lua_tolstring(L, 4, &mpkey_len); /* Key encoded by Lua */
 	/* const char *key = lbox_encode_tuple_on_gc(L, 4, key_len); */
-	struct iterator *it = box_index_iterator(space_id, index_id, iterator,
-						 mpkey, mpkey + mpkey_len);
+	bool skip_cache = lua_toboolean(L, 5);
+	struct iterator *it = box_index_iterator_ex(space_id, index_id,
+						    iterator, mpkey,
+						    mpkey + mpkey_len,
+						    skip_cache);
 	if (it == NULL)
 		return luaT_error(L);
 
@@ -355,8 +433,10 @@ box_lua_index_init(struct lua_State *L)
 		{"update", lbox_index_update},
 		{"upsert",  lbox_upsert},
 		{"delete",  lbox_index_delete},
+		{"delete_range", lbox_index_delete_range},
 		{"random", lbox_index_random},
 		{"get",  lbox_index_get},
+		{"get_many", lbox_index_get_many},
 		{"min", lbox_index_min},
 		{"max", lbox_index_max},
 		{"count", lbox_index_count},
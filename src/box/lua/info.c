@@ -81,6 +81,21 @@ lbox_push_replication_error_message(struct lua_State *L, struct error *e,
 	lua_settable(L, idx - 2);
 }
 
+static void
+lbox_pushcompression(lua_State *L, uint64_t raw_bytes,
+		     uint64_t compressed_bytes)
+{
+	lua_pushstring(L, "compression");
+	lua_createtable(L, 0, 2);
+	lua_pushstring(L, "raw_bytes");
+	luaL_pushuint64(L, raw_bytes);
+	lua_settable(L, -3);
+	lua_pushstring(L, "compressed_bytes");
+	luaL_pushuint64(L, compressed_bytes);
+	lua_settable(L, -3);
+	lua_settable(L, -3);
+}
+
 static void
 lbox_pushapplier(lua_State *L, struct applier *applier)
 {
@@ -118,6 +133,12 @@ lbox_pushapplier(lua_State *L, struct applier *applier)
 		lua_pushlstring(L, name, total);
 		lua_settable(L, -3);
 
+		struct xrow_decompressor *d = &applier->decompressor;
+		if (d->compressed_bytes > 0) {
+			lbox_pushcompression(L, d->raw_bytes,
+					     d->compressed_bytes);
+		}
+
 		struct error *e = diag_last_error(&applier->reader->diag);
 		if (e != NULL)
 			lbox_push_replication_error_message(L, e, -1);
@@ -141,6 +162,10 @@ lbox_pushrelay(lua_State *L, struct relay *relay)
 		lua_pushnumber(L, ev_monotonic_now(loop()) -
 			       relay_last_row_time(relay));
 		lua_settable(L, -3);
+		uint64_t raw_bytes, compressed_bytes;
+		if (relay_compression_stat(relay, &raw_bytes,
+					   &compressed_bytes))
+			lbox_pushcompression(L, raw_bytes, compressed_bytes);
 		break;
 	case RELAY_STOPPED:
 	{
@@ -50,6 +50,8 @@ local default_cfg = {
     vinyl_dir           = '.',
     vinyl_memory        = 128 * 1024 * 1024,
     vinyl_cache         = 128 * 1024 * 1024,
+    vinyl_page_cache    = 0,
+    vinyl_read_latency_slo = 0,
     vinyl_max_tuple_size = 1024 * 1024,
     vinyl_read_threads  = 1,
     vinyl_write_threads = 4,
@@ -70,6 +72,7 @@ local default_cfg = {
     too_long_threshold  = 0.5,
     wal_mode            = "write",
     wal_max_size        = 256 * 1024 * 1024,
+    wal_queue_max_len   = 0, -- unbounded
     wal_dir_rescan_delay= 2,
     force_recovery      = false,
     replication         = nil,
@@ -86,6 +89,7 @@ local default_cfg = {
     checkpoint_wal_threshold = 1e18,
     checkpoint_count    = 2,
     worker_pool_threads = 4,
+    worker_pool_bulk_threads = 2,
     replication_timeout = 1,
     replication_sync_lag = 10,
     replication_sync_timeout = 300,
@@ -93,6 +97,8 @@ local default_cfg = {
     replication_connect_quorum = nil, -- connect all
     replication_skip_conflict = false,
     replication_anon      = false,
+    replication_compression = 0,
+    replication_join_workers = 1,
     feedback_enabled      = true,
     feedback_host         = "https://feedback.tarantool.io",
     feedback_interval     = 3600,
@@ -124,6 +130,8 @@ local template_cfg = {
     vinyl_dir           = 'string',
     vinyl_memory        = 'number',
     vinyl_cache               = 'number',
+    vinyl_page_cache          = 'number',
+    vinyl_read_latency_slo    = 'number',
     vinyl_max_tuple_size      = 'number',
     vinyl_read_threads        = 'number',
     vinyl_write_threads       = 'number',
@@ -145,6 +153,7 @@ local template_cfg = {
     too_long_threshold  = 'number',
     wal_mode            = 'string',
     wal_max_size        = 'number',
+    wal_queue_max_len   = 'number',
     wal_dir_rescan_delay= 'number',
     force_recovery      = 'boolean',
     replication         = 'string, number, table',
@@ -161,6 +170,7 @@ local template_cfg = {
     read_only           = 'boolean',
     hot_standby         = 'boolean',
     worker_pool_threads = 'number',
+    worker_pool_bulk_threads = 'number',
     replication_timeout = 'number',
     replication_sync_lag = 'number',
     replication_sync_timeout = 'number',
@@ -168,6 +178,8 @@ local template_cfg = {
     replication_connect_quorum = 'number',
     replication_skip_conflict = 'boolean',
     replication_anon      = 'boolean',
+    replication_compression = 'number',
+    replication_join_workers = 'number',
     feedback_enabled      = ifdef_feedback('boolean'),
     feedback_host         = ifdef_feedback('string'),
     feedback_interval     = ifdef_feedback('number'),
@@ -261,11 +273,15 @@ local dynamic_cfg = {
     vinyl_memory            = private.cfg_set_vinyl_memory,
     vinyl_max_tuple_size    = private.cfg_set_vinyl_max_tuple_size,
     vinyl_cache             = private.cfg_set_vinyl_cache,
+    vinyl_page_cache        = private.cfg_set_vinyl_page_cache,
+    vinyl_read_latency_slo  = private.cfg_set_vinyl_read_latency_slo,
     vinyl_timeout           = private.cfg_set_vinyl_timeout,
     checkpoint_count        = private.cfg_set_checkpoint_count,
     checkpoint_interval     = private.cfg_set_checkpoint_interval,
     checkpoint_wal_threshold = private.cfg_set_checkpoint_wal_threshold,
+    wal_queue_max_len       = private.cfg_set_wal_queue_max_len,
     worker_pool_threads     = private.cfg_set_worker_pool_threads,
+    worker_pool_bulk_threads = private.cfg_set_worker_pool_bulk_threads,
     feedback_enabled        = ifdef_feedback_set_params,
     feedback_host           = ifdef_feedback_set_params,
     feedback_interval       = ifdef_feedback_set_params,
@@ -282,6 +298,8 @@ local dynamic_cfg = {
     replication_sync_timeout = private.cfg_set_replication_sync_timeout,
     replication_skip_conflict = private.cfg_set_replication_skip_conflict,
     replication_anon        = private.cfg_set_replication_anon,
+    replication_compression = private.cfg_set_replication_compression,
+    replication_join_workers = private.cfg_set_replication_join_workers,
     instance_uuid           = check_instance_uuid,
     replicaset_uuid         = check_replicaset_uuid,
     net_msg_max             = private.cfg_set_net_msg_max,
@@ -340,6 +358,8 @@ local dynamic_cfg_skip_at_load = {
     vinyl_memory            = true,
     vinyl_max_tuple_size    = true,
     vinyl_cache             = true,
+    vinyl_page_cache        = true,
+    vinyl_read_latency_slo  = true,
     vinyl_timeout           = true,
     too_long_threshold      = true,
     replication             = true,
@@ -350,6 +370,8 @@ local dynamic_cfg_skip_at_load = {
     replication_sync_timeout = true,
     replication_skip_conflict = true,
     replication_anon        = true,
+    replication_compression = true,
+    replication_join_workers = true,
     wal_dir_rescan_delay    = true,
     custom_proc_title       = true,
     force_recovery          = true,
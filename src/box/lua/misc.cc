@@ -100,10 +100,11 @@ port_msgpack_dump_lua(struct port *base, struct lua_State *L, bool is_flat)
 static int
 lbox_select(lua_State *L)
 {
-	if (lua_gettop(L) != 6 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2) ||
-		!lua_isnumber(L, 3) || !lua_isnumber(L, 4) || !lua_isnumber(L, 5)) {
+	if (lua_gettop(L) < 6 || lua_gettop(L) > 7 || !lua_isnumber(L, 1) ||
+		!lua_isnumber(L, 2) || !lua_isnumber(L, 3) ||
+		!lua_isnumber(L, 4) || !lua_isnumber(L, 5)) {
 		return luaL_error(L, "Usage index:select(iterator, offset, "
-				  "limit, key)");
+				  "limit, key[, skip_cache])");
 	}
 
 	uint32_t space_id = lua_tonumber(L, 1);
@@ -115,11 +116,12 @@ lbox_select(lua_State *L)
 	size_t key_len;
 	const char *key = lbox_encode_tuple_on_gc(L, 6, &key_len);
 
+	bool skip_cache = lua_toboolean(L, 7);
 	struct port port;
-	if (box_select(space_id, index_id, iterator, offset, limit,
-		       key, key + key_len, &port) != 0) {
+	int rc = box_select_ex(space_id, index_id, iterator, offset, limit,
+			       key, key + key_len, skip_cache, &port);
+	if (rc != 0)
 		return luaT_error(L);
-	}
 
 	/*
 	 * Lua may raise an exception during allocating table or pushing
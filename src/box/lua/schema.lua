@@ -938,9 +938,16 @@ local index_options = {
     distance = 'string',
     run_count_per_level = 'number',
     run_size_ratio = 'number',
+    compaction_policy = 'string',
     range_size = 'number',
     page_size = 'number',
     bloom_fpr = 'number',
+    blob_threshold = 'number',
+    compression_dict_size = 'number',
+    ttl = 'number',
+    ttl_field = 'number, string',
+    range_filter = 'boolean',
+    covering = 'boolean',
     func = 'number, string',
 }
 
@@ -975,6 +982,18 @@ local function func_id_by_name(func_name)
     return func.id
 end
 
+-- Resolve the field storing tuple timestamp for TTL
+-- to its 0-based number.
+local function ttl_field_resolve(format, field)
+    local fieldno, path = format_field_resolve(format, field,
+                                               "options.ttl_field")
+    if path ~= nil then
+        box.error(box.error.ILLEGAL_PARAMS,
+                  "options.ttl_field: JSON path is not supported")
+    end
+    return fieldno
+end
+
 box.schema.index.create = function(space_id, name, options)
     check_param(space_id, 'space_id', 'number')
     check_param(name, 'name', 'string')
@@ -1055,9 +1074,18 @@ box.schema.index.create = function(space_id, name, options)
             range_size = options.range_size,
             run_count_per_level = options.run_count_per_level,
             run_size_ratio = options.run_size_ratio,
+            compaction_policy = options.compaction_policy,
             bloom_fpr = options.bloom_fpr,
+            blob_threshold = options.blob_threshold,
+            compression_dict_size = options.compression_dict_size,
+            ttl = options.ttl,
+            range_filter = options.range_filter,
+            covering = options.covering,
             func = options.func,
     }
+    if options.ttl_field ~= nil then
+        index_opts.ttl_field = ttl_field_resolve(format, options.ttl_field)
+    end
     local field_type_aliases = {
         num = 'unsigned'; -- Deprecated since 1.7.2
         uint = 'unsigned';
@@ -1195,6 +1223,9 @@ box.schema.index.alter = function(space_id, index_id, options)
             index_opts[k] = options[k]
         end
     end
+    if options.ttl_field ~= nil then
+        index_opts.ttl_field = ttl_field_resolve(format, options.ttl_field)
+    end
     if options.parts then
         local parts_can_be_simplified
         parts, parts_can_be_simplified =
@@ -1360,6 +1391,12 @@ end
 
 internal.check_iterator_type = check_iterator_type -- export for net.box
 
+-- Check if tuples read by a request must not be added to engine
+-- caches, e.g. because it's a one-off scan.
+local function check_skip_cache(opts)
+    return type(opts) == 'table' and opts.cache == false
+end
+
 local base_index_mt = {}
 base_index_mt.__index = base_index_mt
 --
@@ -1474,7 +1511,8 @@ base_index_mt.pairs_luac = function(index, key, opts)
     local itype = check_iterator_type(opts, #key == 0);
     local keymp = msgpack.encode(key)
     local keybuf = ffi.string(keymp, #keymp)
-    local cdata = internal.iterator(index.space_id, index.id, itype, keymp);
+    local cdata = internal.iterator(index.space_id, index.id, itype, keymp,
+                                    check_skip_cache(opts));
     return fun.wrap(iterator_gen_luac, keybuf,
         ffi.gc(cdata, builtin.box_iterator_free))
 end
@@ -1516,6 +1554,18 @@ base_index_mt.get_luac = function(index, key)
     return internal.get(index.space_id, index.id, key)
 end
 
+base_index_mt.get_many = function(index, keys)
+    check_index_arg(index, 'get_many')
+    if type(keys) ~= 'table' then
+        box.error(box.error.ILLEGAL_PARAMS, "keys must be a table")
+    end
+    local k = {}
+    for i, key in ipairs(keys) do
+        k[i] = keify(key)
+    end
+    return internal.get_many(index.space_id, index.id, k)
+end
+
 local function check_select_opts(opts, key_is_nil)
     local offset = 0
     local limit = 4294967295
@@ -1558,7 +1608,7 @@ base_index_mt.select_luac = function(index, key, opts)
     local key = keify(key)
     local iterator, offset, limit = check_select_opts(opts, #key == 0)
     return internal.select(index.space_id, index.id, iterator,
-        offset, limit, key)
+        offset, limit, key, check_skip_cache(opts))
 end
 
 base_index_mt.update = function(index, key, ops)
@@ -1569,6 +1619,11 @@ base_index_mt.delete = function(index, key)
     check_index_arg(index, 'delete')
     return internal.delete(index.space_id, index.id, keify(key));
 end
+base_index_mt.delete_range = function(index, from, to)
+    check_index_arg(index, 'delete_range')
+    return internal.delete_range(index.space_id, index.id,
+                                 keify(from), keify(to))
+end
 
 base_index_mt.stat = function(index)
     return internal.stat(index.space_id, index.id);
@@ -424,9 +424,45 @@ lbox_fillspace(struct lua_State *L, struct space *space, int i)
 			lua_pushnumber(L, index_opts->run_size_ratio);
 			lua_setfield(L, -2, "run_size_ratio");
 
+			if (index_opts->compaction_policy !=
+			    INDEX_COMPACTION_TIERED) {
+				lua_pushstring(L, index_compaction_policy_strs[
+						index_opts->compaction_policy]);
+				lua_setfield(L, -2, "compaction_policy");
+			}
+
 			lua_pushnumber(L, index_opts->bloom_fpr);
 			lua_setfield(L, -2, "bloom_fpr");
 
+			if (index_opts->blob_threshold > 0) {
+				lua_pushnumber(L, index_opts->blob_threshold);
+				lua_setfield(L, -2, "blob_threshold");
+			}
+
+			if (index_opts->compression_dict_size > 0) {
+				lua_pushnumber(L,
+					index_opts->compression_dict_size);
+				lua_setfield(L, -2, "compression_dict_size");
+			}
+
+			if (index_opts->ttl > 0) {
+				lua_pushnumber(L, index_opts->ttl);
+				lua_setfield(L, -2, "ttl");
+				lua_pushnumber(L, index_opts->ttl_field +
+					       TUPLE_INDEX_BASE);
+				lua_setfield(L, -2, "ttl_field");
+			}
+
+			if (index_opts->range_filter) {
+				lua_pushboolean(L, true);
+				lua_setfield(L, -2, "range_filter");
+			}
+
+			if (index_opts->covering) {
+				lua_pushboolean(L, true);
+				lua_setfield(L, -2, "covering");
+			}
+
 			lua_settable(L, -3);
 		}
 		lua_setfield(L, -2, index_def->name);
@@ -43,6 +43,8 @@
 #include "box/engine.h"
 #include "box/vinyl.h"
 #include "box/sql.h"
+#include "cbus.h"
+#include "coio_task.h"
 #include "info/info.h"
 #include "lua/info.h"
 #include "lua/utils.h"
@@ -211,6 +213,86 @@ lbox_stat_sql(struct lua_State *L)
 	return 1;
 }
 
+/**
+ * Push a table with statistics of cbus pipes to a Lua stack.
+ * Pipes are named "<producer thread>-><consumer endpoint>",
+ * e.g. "main->wal". Latencies are given in seconds.
+ */
+static int
+lbox_stat_cbus(struct lua_State *L)
+{
+	int count;
+	struct cpipe_stat *stats = cbus_pipe_stat(&count);
+	if (stats == NULL)
+		return luaT_error(L);
+	struct info_handler h;
+	luaT_info_handler_create(&h, L);
+	info_begin(&h);
+	for (int i = 0; i < count; i++) {
+		struct cpipe_stat *stat = &stats[i];
+		info_table_begin(&h, stat->name);
+		info_append_int(&h, "queue",
+				MAX(stat->pushed - stat->delivered, 0));
+		info_append_int(&h, "pushed", stat->pushed);
+		info_append_int(&h, "delivered", stat->delivered);
+		info_append_int(&h, "waits", stat->waits);
+		info_table_begin(&h, "latency");
+		info_append_double(&h, "p50",
+			cpipe_stat_percentile(stat->latency, 50) / 1e6);
+		info_append_double(&h, "p90",
+			cpipe_stat_percentile(stat->latency, 90) / 1e6);
+		info_append_double(&h, "p99",
+			cpipe_stat_percentile(stat->latency, 99) / 1e6);
+		info_table_end(&h);
+		info_table_begin(&h, "batch");
+		info_append_int(&h, "p50",
+				cpipe_stat_percentile(stat->batch, 50));
+		info_append_int(&h, "p99",
+				cpipe_stat_percentile(stat->batch, 99));
+		info_table_end(&h);
+		info_table_end(&h);
+	}
+	info_end(&h);
+	free(stats);
+	return 1;
+}
+
+/**
+ * Push a table with statistics of coio tasks to a Lua stack.
+ */
+static int
+lbox_stat_coio(struct lua_State *L)
+{
+	struct info_handler h;
+	luaT_info_handler_create(&h, L);
+	info_begin(&h);
+	for (int type = 0; type < coio_task_type_MAX; type++) {
+		struct coio_task_stat stat;
+		coio_task_stat_get(type, &stat);
+		info_table_begin(&h, coio_task_type_strs[type]);
+		info_append_int(&h, "count", stat.count);
+		info_table_begin(&h, "wait");
+		info_append_double(&h, "p50",
+			coio_task_stat_percentile(stat.wait, 50) / 1e6);
+		info_append_double(&h, "p90",
+			coio_task_stat_percentile(stat.wait, 90) / 1e6);
+		info_append_double(&h, "p99",
+			coio_task_stat_percentile(stat.wait, 99) / 1e6);
+		info_table_end(&h);
+		info_table_begin(&h, "exec");
+		info_append_double(&h, "p50",
+			coio_task_stat_percentile(stat.exec, 50) / 1e6);
+		info_append_double(&h, "p90",
+			coio_task_stat_percentile(stat.exec, 90) / 1e6);
+		info_append_double(&h, "p99",
+			coio_task_stat_percentile(stat.exec, 99) / 1e6);
+		info_table_end(&h);
+		info_table_end(&h);
+	}
+	info_end(&h);
+	return 1;
+}
+
 static const struct luaL_Reg lbox_stat_meta [] = {
 	{"__index", lbox_stat_index},
 	{"__call",  lbox_stat_call},
@@ -231,6 +313,8 @@ box_lua_stat_init(struct lua_State *L)
 		{"vinyl", lbox_stat_vinyl},
 		{"reset", lbox_stat_reset},
 		{"sql", lbox_stat_sql},
+		{"cbus", lbox_stat_cbus},
+		{"coio", lbox_stat_coio},
 		{NULL, NULL}
 	};
 
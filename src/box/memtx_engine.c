@@ -56,7 +56,7 @@ static void
 checkpoint_cancel(struct checkpoint *ckpt);
 
 static void
-replica_join_cancel(struct cord *replica_join_cord);
+replica_join_cancel(struct cord *cords, int cord_count);
 
 struct PACKED memtx_tuple {
 	/*
@@ -132,8 +132,10 @@ memtx_engine_shutdown(struct engine *engine)
 	struct memtx_engine *memtx = (struct memtx_engine *)engine;
 	if (memtx->checkpoint != NULL)
 		checkpoint_cancel(memtx->checkpoint);
-	if (memtx->replica_join_cord != NULL)
-		replica_join_cancel(memtx->replica_join_cord);
+	if (memtx->replica_join_cords != NULL) {
+		replica_join_cancel(memtx->replica_join_cords,
+				    memtx->replica_join_cord_count);
+	}
 	mempool_destroy(&memtx->iterator_pool);
 	if (mempool_is_initialized(&memtx->rtree_iterator_pool))
 		mempool_destroy(&memtx->rtree_iterator_pool);
@@ -533,15 +535,17 @@ checkpoint_cancel(struct checkpoint *ckpt)
 }
 
 static void
-replica_join_cancel(struct cord *replica_join_cord)
+replica_join_cancel(struct cord *cords, int cord_count)
 {
 	/*
-	 * Cancel the thread being used to join replica if it's
-	 * running and wait for it to terminate so as to
-	 * eliminate the possibility of use-after-free.
+	 * Cancel the threads being used to join replica if
+	 * they're running and wait for them to terminate so as
+	 * to eliminate the possibility of use-after-free.
 	 */
-	tt_pthread_cancel(replica_join_cord->id);
-	tt_pthread_join(replica_join_cord->id, NULL);
+	for (int i = 0; i < cord_count; i++)
+		tt_pthread_cancel(cords[i].id);
+	for (int i = 0; i < cord_count; i++)
+		tt_pthread_join(cords[i].id, NULL);
 }
 
 static int
@@ -755,12 +759,29 @@ memtx_engine_backup(struct engine *engine, const struct vclock *vclock,
 struct memtx_join_entry {
 	struct rlist in_ctx;
 	uint32_t space_id;
+	/** Set if the entry is for a system space. */
+	bool is_system;
 	struct snapshot_iterator *iterator;
 };
 
 struct memtx_join_ctx {
 	struct rlist entries;
 	struct xstream *stream;
+	/**
+	 * Link of the next entry to be sent, or the list head
+	 * if all entries have been taken by join threads.
+	 */
+	struct rlist *next;
+	/** Kind of entries join threads are sending now. */
+	bool is_system;
+	/**
+	 * Serializes access to the list of entries among join
+	 * threads. Also serializes writes to the stream unless
+	 * it supports concurrent batch writes, see xstream.h.
+	 */
+	pthread_mutex_t mutex;
+	/** Set if a join thread failed. Tells others to stop. */
+	bool is_aborted;
 };
 
 static int
@@ -783,6 +804,7 @@ memtx_join_add_space(struct space *space, void *arg)
 		return -1;
 	}
 	entry->space_id = space_id(space);
+	entry->is_system = space_is_system(space);
 	entry->iterator = index_create_snapshot_iterator(pk);
 	if (entry->iterator == NULL) {
 		free(entry);
@@ -807,70 +829,239 @@ memtx_engine_prepare_join(struct engine *engine, void **arg)
 		free(ctx);
 		return -1;
 	}
+	tt_pthread_mutex_init(&ctx->mutex, NULL);
 	*arg = ctx;
 	return 0;
 }
 
-static int
-memtx_join_send_tuple(struct xstream *stream, uint32_t space_id,
-		      const char *data, size_t size)
+enum {
+	/** Max number of rows in a batch sent by a join thread. */
+	MEMTX_JOIN_BATCH_ROWS = 256,
+	/** Max size of tuples in a batch sent by a join thread. */
+	MEMTX_JOIN_BATCH_SIZE = 64 * 1024,
+};
+
+/**
+ * Rows accumulated by a join thread before being written to
+ * the stream. The rows refer to tuple data directly: tuples
+ * stay pinned by the read view until the join is complete.
+ */
+struct memtx_join_batch {
+	/** Number of rows in the batch. */
+	int count;
+	/** Size of tuple data referenced by the batch. */
+	size_t size;
+	struct request_replace_body bodies[MEMTX_JOIN_BATCH_ROWS];
+	struct xrow_header rows[MEMTX_JOIN_BATCH_ROWS];
+};
+
+static void
+memtx_join_batch_add(struct memtx_join_batch *batch, uint32_t space_id,
+		     const char *data, size_t size)
 {
-	struct request_replace_body body;
-	request_replace_body_create(&body, space_id);
+	assert(batch->count < MEMTX_JOIN_BATCH_ROWS);
+	struct request_replace_body *body = &batch->bodies[batch->count];
+	request_replace_body_create(body, space_id);
+
+	struct xrow_header *row = &batch->rows[batch->count];
+	memset(row, 0, sizeof(*row));
+	row->type = IPROTO_INSERT;
+
+	row->bodycnt = 2;
+	row->body[0].iov_base = body;
+	row->body[0].iov_len = sizeof(*body);
+	row->body[1].iov_base = (char *)data;
+	row->body[1].iov_len = size;
+
+	batch->count++;
+	batch->size += size;
+}
 
-	struct xrow_header row;
-	memset(&row, 0, sizeof(row));
-	row.type = IPROTO_INSERT;
+static bool
+memtx_join_batch_is_full(struct memtx_join_batch *batch)
+{
+	return batch->count >= MEMTX_JOIN_BATCH_ROWS ||
+	       batch->size >= MEMTX_JOIN_BATCH_SIZE;
+}
 
-	row.bodycnt = 2;
-	row.body[0].iov_base = &body;
-	row.body[0].iov_len = sizeof(body);
-	row.body[1].iov_base = (char *)data;
-	row.body[1].iov_len = size;
+static void
+memtx_join_unlock(void *arg)
+{
+	tt_pthread_mutex_unlock((pthread_mutex_t *)arg);
+}
+
+static void
+memtx_join_abort(struct memtx_join_ctx *ctx)
+{
+	tt_pthread_mutex_lock(&ctx->mutex);
+	ctx->is_aborted = true;
+	tt_pthread_mutex_unlock(&ctx->mutex);
+}
+
+/**
+ * Write a batch of rows to the stream shared by join threads
+ * and empty the batch. Returns 1 if the join was aborted by
+ * another thread.
+ */
+static int
+memtx_join_send_batch(struct memtx_join_ctx *ctx,
+		      struct memtx_join_batch *batch)
+{
+	if (batch->count == 0)
+		return 0;
+	int rc;
+	if (ctx->stream->write_batch != NULL) {
+		/*
+		 * The stream serializes writes itself, so that
+		 * threads may encode their batches in parallel.
+		 */
+		tt_pthread_mutex_lock(&ctx->mutex);
+		rc = ctx->is_aborted ? 1 : 0;
+		tt_pthread_mutex_unlock(&ctx->mutex);
+		if (rc == 0)
+			rc = xstream_write_batch(ctx->stream, batch->rows,
+						 batch->count);
+	} else {
+		tt_pthread_mutex_lock(&ctx->mutex);
+		/*
+		 * Writing to the stream may block the thread on
+		 * a socket. Make sure the mutex is released if the
+		 * thread is cancelled meanwhile, see
+		 * replica_join_cancel().
+		 */
+		pthread_cleanup_push(memtx_join_unlock, &ctx->mutex);
+		rc = 1;
+		if (!ctx->is_aborted)
+			rc = xstream_write_batch(ctx->stream, batch->rows,
+						 batch->count);
+		pthread_cleanup_pop(1);
+	}
+	batch->count = 0;
+	batch->size = 0;
+	return rc;
+}
 
-	return xstream_write(stream, &row);
+/**
+ * Take the next entry to be sent. Returns NULL if there are
+ * no more entries of the kind being sent now or the join was
+ * aborted.
+ */
+static struct memtx_join_entry *
+memtx_join_next_entry(struct memtx_join_ctx *ctx)
+{
+	struct memtx_join_entry *entry = NULL;
+	tt_pthread_mutex_lock(&ctx->mutex);
+	if (!ctx->is_aborted && ctx->next != &ctx->entries) {
+		entry = rlist_entry(ctx->next, struct memtx_join_entry,
+				    in_ctx);
+		if (entry->is_system == ctx->is_system)
+			ctx->next = ctx->next->next;
+		else
+			entry = NULL;
+	}
+	tt_pthread_mutex_unlock(&ctx->mutex);
+	return entry;
 }
 
 static int
 memtx_join_f(va_list ap)
 {
 	struct memtx_join_ctx *ctx = va_arg(ap, struct memtx_join_ctx *);
+	struct memtx_join_batch *batch = malloc(sizeof(*batch));
+	if (batch == NULL) {
+		diag_set(OutOfMemory, sizeof(*batch),
+			 "malloc", "struct memtx_join_batch");
+		memtx_join_abort(ctx);
+		return -1;
+	}
+	batch->count = 0;
+	batch->size = 0;
+	int rc = 0;
 	struct memtx_join_entry *entry;
-	rlist_foreach_entry(entry, &ctx->entries, in_ctx) {
+	while ((entry = memtx_join_next_entry(ctx)) != NULL) {
 		struct snapshot_iterator *it = entry->iterator;
-		int rc;
 		uint32_t size;
 		const char *data;
 		while ((rc = it->next(it, &data, &size)) == 0 && data != NULL) {
-			if (memtx_join_send_tuple(ctx->stream, entry->space_id,
-						  data, size) != 0)
-				return -1;
+			memtx_join_batch_add(batch, entry->space_id,
+					     data, size);
+			if (memtx_join_batch_is_full(batch) &&
+			    (rc = memtx_join_send_batch(ctx, batch)) != 0)
+				break;
 		}
 		if (rc != 0)
-			return -1;
+			break;
 	}
-	return 0;
+	if (rc == 0)
+		rc = memtx_join_send_batch(ctx, batch);
+	free(batch);
+	if (rc < 0) {
+		memtx_join_abort(ctx);
+		return -1;
+	}
+	return 0; /* done or aborted by another thread */
+}
+
+/**
+ * Send all join entries of the given kind using the given
+ * number of threads and wait for them to complete.
+ */
+static int
+memtx_join_run(struct memtx_engine *memtx, struct memtx_join_ctx *ctx,
+	       bool is_system, int cord_count)
+{
+	struct cord *cords = calloc(cord_count, sizeof(*cords));
+	if (cords == NULL) {
+		diag_set(OutOfMemory, cord_count * sizeof(*cords),
+			 "malloc", "struct cord");
+		return -1;
+	}
+	ctx->is_system = is_system;
+	int rc = 0;
+	int started;
+	for (started = 0; started < cord_count; started++) {
+		if (cord_costart(&cords[started], "initial_join",
+				 memtx_join_f, ctx) != 0) {
+			memtx_join_abort(ctx);
+			rc = -1;
+			break;
+		}
+	}
+	memtx->replica_join_cords = cords;
+	memtx->replica_join_cord_count = started;
+	for (int i = 0; i < started; i++) {
+		if (cord_cojoin(&cords[i]) != 0)
+			rc = -1;
+	}
+	memtx->replica_join_cords = NULL;
+	memtx->replica_join_cord_count = 0;
+	free(cords);
+	return rc;
 }
 
 static int
 memtx_engine_join(struct engine *engine, void *arg, struct xstream *stream)
 {
-	(void)engine;
+	struct memtx_engine *memtx = (struct memtx_engine *)engine;
 	struct memtx_join_ctx *ctx = arg;
 	ctx->stream = stream;
+	ctx->next = rlist_first(&ctx->entries);
+	ctx->is_aborted = false;
 	/*
 	 * Memtx snapshot iterators are safe to use from another
 	 * thread and so we do so as not to consume too much of
 	 * precious tx cpu time while a new replica is joining.
+	 *
+	 * System spaces go first and in order, because the
+	 * replica needs them to create user spaces. User spaces
+	 * don't depend on each other so they are distributed
+	 * among several threads, which send them in parallel.
+	 * The replica builds indexes after having received all
+	 * data so it doesn't care about the order of rows.
 	 */
-	struct cord cord;
-	if (cord_costart(&cord, "initial_join", memtx_join_f, ctx) != 0)
+	if (memtx_join_run(memtx, ctx, true, 1) != 0)
 		return -1;
-	struct memtx_engine *memtx = (struct memtx_engine *)engine;
-	memtx->replica_join_cord = &cord;
-	int res = cord_cojoin(&cord);
-	memtx->replica_join_cord = NULL;
-	return res;
+	return memtx_join_run(memtx, ctx, false, replication_join_workers);
 }
 
 static void
@@ -883,6 +1074,7 @@ memtx_engine_complete_join(struct engine *engine, void *arg)
 		entry->iterator->free(entry->iterator);
 		free(entry);
 	}
+	tt_pthread_mutex_destroy(&ctx->mutex);
 	free(ctx);
 }
 
@@ -1052,7 +1244,8 @@ memtx_engine_new(const char *snap_dirname, bool force_recovery,
 	memtx->max_tuple_size = MAX_TUPLE_SIZE;
 	memtx->force_recovery = force_recovery;
 
-	memtx->replica_join_cord = NULL;
+	memtx->replica_join_cords = NULL;
+	memtx->replica_join_cord_count = 0;
 
 	memtx->base.vtab = &memtx_engine_vtab;
 	memtx->base.name = "memtx";
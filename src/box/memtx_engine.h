@@ -120,10 +120,12 @@ struct memtx_engine {
 	/** Skip invalid snapshot records if this flag is set. */
 	bool force_recovery;
 	/**
-	 * Cord being currently used to join replica. It is only
-	 * needed to be able to cancel it on shutdown.
+	 * Cords being currently used to join replica. They are
+	 * only needed to be able to cancel them on shutdown.
 	 */
-	struct cord *replica_join_cord;
+	struct cord *replica_join_cords;
+	/** Number of cords in replica_join_cords array. */
+	int replica_join_cord_count;
 	/** Common quota for tuples and indexes. */
 	struct quota quota;
 	/**
@@ -488,6 +488,7 @@ static const struct index_vtab memtx_hash_index_vtab = {
 	/* .random = */ memtx_hash_index_random,
 	/* .count = */ memtx_hash_index_count,
 	/* .get = */ memtx_hash_index_get,
+	/* .get_many = */ generic_index_get_many,
 	/* .replace = */ memtx_hash_index_replace,
 	/* .create_iterator = */ memtx_hash_index_create_iterator,
 	/* .create_snapshot_iterator = */
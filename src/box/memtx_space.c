@@ -511,6 +511,217 @@ memtx_space_execute_upsert(struct space *space, struct txn *txn,
 	return 0;
 }
 
+/**
+ * Tuples removed from a space by a range deletion. They are
+ * kept referenced until the statement is committed so that
+ * they can be reinserted on rollback. On commit, the references
+ * are dropped by the memtx garbage collector in background, so
+ * that freeing a big range doesn't stall the tx thread.
+ */
+struct memtx_delete_range {
+	/** Space the tuples were removed from. */
+	struct space *space;
+	/** Removed tuples, in the primary index order. */
+	struct tuple **tuples;
+	/** Number of removed tuples. */
+	uint32_t count;
+	/** Number of tuples released by the garbage collector. */
+	uint32_t gc_count;
+	/** Task releasing the tuples after commit. */
+	struct memtx_gc_task gc_task;
+	/** Trigger scheduling the release of the tuples on commit. */
+	struct trigger on_commit;
+	/** Trigger reinserting the tuples on rollback. */
+	struct trigger on_rollback;
+};
+
+static void
+memtx_delete_range_delete(struct memtx_delete_range *range)
+{
+	free(range->tuples);
+	free(range);
+}
+
+static void
+memtx_delete_range_gc_run(struct memtx_gc_task *task, bool *done)
+{
+	/*
+	 * Yield every 1K tuples to keep latency < 0.1 ms.
+	 * Yield more often in debug mode.
+	 */
+#ifdef NDEBUG
+	enum { YIELD_LOOPS = 1000 };
+#else
+	enum { YIELD_LOOPS = 10 };
+#endif
+	struct memtx_delete_range *range = container_of(task,
+			struct memtx_delete_range, gc_task);
+	unsigned int loops = 0;
+	while (range->gc_count < range->count) {
+		/*
+		 * The last reference to a tuple is dropped here,
+		 * so the tuple is freed or, if a checkpoint is in
+		 * progress, queued for freeing after it ends.
+		 */
+		tuple_unref(range->tuples[range->gc_count++]);
+		if (++loops >= YIELD_LOOPS) {
+			*done = false;
+			return;
+		}
+	}
+	*done = true;
+}
+
+static void
+memtx_delete_range_gc_free(struct memtx_gc_task *task)
+{
+	struct memtx_delete_range *range = container_of(task,
+			struct memtx_delete_range, gc_task);
+	memtx_delete_range_delete(range);
+}
+
+static const struct memtx_gc_task_vtab memtx_delete_range_gc_vtab = {
+	.run = memtx_delete_range_gc_run,
+	.free = memtx_delete_range_gc_free,
+};
+
+static int
+memtx_delete_range_on_commit(struct trigger *trigger, void *event)
+{
+	(void)event;
+	struct memtx_delete_range *range =
+		(struct memtx_delete_range *)trigger->data;
+	struct memtx_engine *memtx =
+		(struct memtx_engine *)range->space->engine;
+	range->gc_count = 0;
+	range->gc_task.vtab = &memtx_delete_range_gc_vtab;
+	memtx_engine_schedule_gc(memtx, &range->gc_task);
+	return 0;
+}
+
+static int
+memtx_delete_range_on_rollback(struct trigger *trigger, void *event)
+{
+	(void)event;
+	struct memtx_delete_range *range =
+		(struct memtx_delete_range *)trigger->data;
+	struct memtx_space *memtx_space = (struct memtx_space *)range->space;
+	for (uint32_t i = 0; i < range->count; i++) {
+		struct tuple *tuple = range->tuples[i];
+		struct tuple *unused;
+		/* Rollback must not fail. */
+		if (memtx_space->replace(range->space, NULL, tuple,
+					 DUP_INSERT, &unused) != 0) {
+			diag_log();
+			unreachable();
+			panic("failed to rollback change");
+		}
+		tuple_unref(tuple);
+	}
+	memtx_delete_range_delete(range);
+	return 0;
+}
+
+/**
+ * Delete the tuples of a range deletion from all secondary
+ * indexes of a space. On failure, the tuples are reinserted
+ * into the indexes they have been deleted from.
+ */
+static int
+memtx_delete_range_from_secondary_keys(struct space *space,
+				       struct memtx_delete_range *range)
+{
+	struct tuple *unused;
+	uint32_t iid, i;
+	for (iid = 1; iid < space->index_count; iid++) {
+		struct index *index = space->index[iid];
+		for (i = 0; i < range->count; i++) {
+			if (index_replace(index, range->tuples[i], NULL,
+					  DUP_REPLACE_OR_INSERT,
+					  &unused) != 0)
+				goto rollback;
+		}
+	}
+	return 0;
+rollback:
+	while (true) {
+		struct index *index = space->index[iid];
+		while (i-- > 0) {
+			if (index_replace(index, NULL, range->tuples[i],
+					  DUP_INSERT, &unused) != 0) {
+				panic("failed to rollback change");
+			}
+		}
+		if (--iid == 0)
+			break;
+		i = range->count;
+	}
+	return -1;
+}
+
+static int
+memtx_space_execute_delete_range(struct space *space, struct txn *txn,
+				 struct request *request)
+{
+	struct memtx_space *memtx_space = (struct memtx_space *)space;
+	struct memtx_engine *memtx = (struct memtx_engine *)space->engine;
+	struct txn_stmt *stmt = txn_current_stmt(txn);
+	struct index *pk = space_index(space, 0);
+	assert(pk != NULL && pk->def->type == TREE);
+	struct memtx_delete_range *range = malloc(sizeof(*range));
+	if (range == NULL) {
+		diag_set(OutOfMemory, sizeof(*range), "malloc", "range");
+		return -1;
+	}
+	if (index_collect_range(pk, request->key, request->tuple,
+				&range->tuples, &range->count) != 0) {
+		free(range);
+		return -1;
+	}
+	if (range->count == 0) {
+		memtx_delete_range_delete(range);
+		return 0;
+	}
+	/*
+	 * Secondary indexes aren't built yet when WAL is replayed
+	 * on recovery, in which case we must only touch the primary
+	 * index, see memtx_space_replace_primary_key().
+	 */
+	if (memtx_index_extent_reserve(memtx,
+				       RESERVE_EXTENTS_BEFORE_DELETE) != 0 ||
+	    (memtx_space->replace == memtx_space_replace_all_keys &&
+	     memtx_delete_range_from_secondary_keys(space, range) != 0)) {
+		for (uint32_t i = 0; i < range->count; i++)
+			tuple_unref(range->tuples[i]);
+		memtx_delete_range_delete(range);
+		return -1;
+	}
+	/*
+	 * The removed tuples form a contiguous range in the primary
+	 * index, so we can cut it out of the tree in bulk.
+	 */
+	MAYBE_UNUSED size_t deleted = memtx_tree_index_delete_range(pk,
+			range->tuples[0], range->tuples[range->count - 1]);
+	assert(deleted == range->count);
+	/*
+	 * Each removed tuple is pinned by the reference taken
+	 * by index_collect_range(), so we can drop the one that
+	 * used to be held by the primary index right away.
+	 */
+	for (uint32_t i = 0; i < range->count; i++) {
+		memtx_space_update_bsize(space, range->tuples[i], NULL);
+		tuple_unref(range->tuples[i]);
+	}
+	range->space = space;
+	trigger_create(&range->on_commit, memtx_delete_range_on_commit,
+		       range, NULL);
+	trigger_create(&range->on_rollback, memtx_delete_range_on_rollback,
+		       range, NULL);
+	txn_stmt_on_commit(stmt, &range->on_commit);
+	txn_stmt_on_rollback(stmt, &range->on_rollback);
+	return 0;
+}
+
 /**
  * This function simply creates new memtx tuple, refs it and calls space's
  * replace function. In constrast to original memtx_space_execute_replace(), it
@@ -1136,6 +1347,7 @@ static const struct space_vtab memtx_space_vtab = {
 	/* .execute_delete = */ memtx_space_execute_delete,
 	/* .execute_update = */ memtx_space_execute_update,
 	/* .execute_upsert = */ memtx_space_execute_upsert,
+	/* .execute_delete_range = */ memtx_space_execute_delete_range,
 	/* .ephemeral_replace = */ memtx_space_ephemeral_replace,
 	/* .ephemeral_delete = */ memtx_space_ephemeral_delete,
 	/* .ephemeral_rowid_next = */ memtx_space_ephemeral_rowid_next,
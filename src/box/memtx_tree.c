@@ -593,6 +593,21 @@ memtx_tree_index_replace(struct index *base, struct tuple *old_tuple,
 	return 0;
 }
 
+size_t
+memtx_tree_index_delete_range(struct index *base, struct tuple *first,
+			      struct tuple *last)
+{
+	struct memtx_tree_index *index = (struct memtx_tree_index *)base;
+	struct key_def *cmp_def = memtx_tree_cmp_def(&index->tree);
+	assert(!cmp_def->is_multikey && !cmp_def->for_func_index);
+	struct memtx_tree_data first_data, last_data;
+	first_data.tuple = first;
+	first_data.hint = tuple_hint(first, cmp_def);
+	last_data.tuple = last;
+	last_data.hint = tuple_hint(last, cmp_def);
+	return memtx_tree_delete_range(&index->tree, first_data, last_data);
+}
+
 /**
  * Perform tuple insertion by given multikey index.
  * In case of replacement, all old tuple entries are deleted
@@ -1286,6 +1301,7 @@ static const struct index_vtab memtx_tree_index_vtab = {
 	/* .random = */ memtx_tree_index_random,
 	/* .count = */ memtx_tree_index_count,
 	/* .get = */ memtx_tree_index_get,
+	/* .get_many = */ generic_index_get_many,
 	/* .replace = */ memtx_tree_index_replace,
 	/* .create_iterator = */ memtx_tree_index_create_iterator,
 	/* .create_snapshot_iterator = */
@@ -1316,6 +1332,7 @@ static const struct index_vtab memtx_tree_index_multikey_vtab = {
 	/* .random = */ memtx_tree_index_random,
 	/* .count = */ memtx_tree_index_count,
 	/* .get = */ memtx_tree_index_get,
+	/* .get_many = */ generic_index_get_many,
 	/* .replace = */ memtx_tree_index_replace_multikey,
 	/* .create_iterator = */ memtx_tree_index_create_iterator,
 	/* .create_snapshot_iterator = */
@@ -1346,6 +1363,7 @@ static const struct index_vtab memtx_tree_func_index_vtab = {
 	/* .random = */ memtx_tree_index_random,
 	/* .count = */ memtx_tree_index_count,
 	/* .get = */ memtx_tree_index_get,
+	/* .get_many = */ generic_index_get_many,
 	/* .replace = */ memtx_tree_func_index_replace,
 	/* .create_iterator = */ memtx_tree_index_create_iterator,
 	/* .create_snapshot_iterator = */
@@ -1382,6 +1400,7 @@ static const struct index_vtab memtx_tree_disabled_index_vtab = {
 	/* .random = */ generic_index_random,
 	/* .count = */ generic_index_count,
 	/* .get = */ generic_index_get,
+	/* .get_many = */ generic_index_get_many,
 	/* .replace = */ disabled_index_replace,
 	/* .create_iterator = */ generic_index_create_iterator,
 	/* .create_snapshot_iterator = */
@@ -30,6 +30,7 @@
  * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
  * SUCH DAMAGE.
  */
+#include <stddef.h>
 
 #if defined(__cplusplus)
 extern "C" {
@@ -38,10 +39,21 @@ extern "C" {
 struct index;
 struct index_def;
 struct memtx_engine;
+struct tuple;
 
 struct index *
 memtx_tree_index_new(struct memtx_engine *memtx, struct index_def *def);
 
+/**
+ * Delete all tuples from @a first to @a last inclusive from
+ * a tree index. Blocks of the tree lying entirely within the
+ * range are unlinked as a whole rather than element by element.
+ * Returns the number of deleted tuples.
+ */
+size_t
+memtx_tree_index_delete_range(struct index *index, struct tuple *first,
+			      struct tuple *last);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -201,6 +201,11 @@ out:
 	 */
 	if (vclock_compare(&r->vclock, vclock) < 0)
 		vclock_copy(&r->vclock, vclock);
+	/*
+	 * Rows covered by the recovery clock are skipped anyway
+	 * so don't waste time reading them if the WAL has an index.
+	 */
+	xlog_cursor_skip_to(&r->cursor, &r->vclock);
 	return;
 
 gap_error:
@@ -35,9 +35,11 @@
 #include "scoped_guard.h"
 #include "cbus.h"
 #include "cfg.h"
+#include "clock.h"
 #include "errinj.h"
 #include "fiber.h"
 #include "say.h"
+#include "tt_pthread.h"
 
 #include "coio.h"
 #include "coio_task.h"
@@ -50,6 +52,7 @@
 #include "vclock.h"
 #include "version.h"
 #include "xrow.h"
+#include "xrow_compress.h"
 #include "xrow_io.h"
 #include "xstream.h"
 #include "wal.h"
@@ -64,6 +67,10 @@ struct relay_status_msg {
 	struct relay *relay;
 	/** Replica vclock. */
 	struct vclock vclock;
+	/** Number of bytes fed to the stream compressor. */
+	uint64_t raw_bytes;
+	/** Number of bytes produced by the stream compressor. */
+	uint64_t compressed_bytes;
 };
 
 /**
@@ -139,12 +146,28 @@ struct relay {
 	double last_row_time;
 	/** Relay sync state. */
 	enum relay_state state;
+	/**
+	 * Compressor of the stream sent to the replica or NULL
+	 * if the stream isn't compressed, see xrow_compress.h.
+	 */
+	struct xrow_compressor *compressor;
+	/**
+	 * Serializes writes of initial join rows sent by several
+	 * threads, see relay_send_initial_join_batch().
+	 */
+	pthread_mutex_t join_mutex;
+	/** Number of rows sent on initial join. */
+	int64_t join_row_count;
 
 	struct {
 		/* Align to prevent false-sharing with tx thread */
 		alignas(CACHELINE_SIZE)
 		/** Known relay vclock. */
 		struct vclock vclock;
+		/** Known number of bytes fed to the compressor. */
+		uint64_t raw_bytes;
+		/** Known number of bytes produced by the compressor. */
+		uint64_t compressed_bytes;
 	} tx;
 };
 
@@ -172,11 +195,25 @@ relay_last_row_time(const struct relay *relay)
 	return relay->last_row_time;
 }
 
+bool
+relay_compression_stat(const struct relay *relay, uint64_t *raw_bytes,
+		       uint64_t *compressed_bytes)
+{
+	*raw_bytes = relay->tx.raw_bytes;
+	*compressed_bytes = relay->tx.compressed_bytes;
+	return relay->compressor != NULL;
+}
+
 static void
 relay_send(struct relay *relay, struct xrow_header *packet);
 static void
+relay_flush(struct relay *relay);
+static void
 relay_send_initial_join_row(struct xstream *stream, struct xrow_header *row);
 static void
+relay_send_initial_join_batch(struct xstream *stream,
+			      struct xrow_header *rows, int count);
+static void
 relay_send_row(struct xstream *stream, struct xrow_header *row);
 
 struct relay *
@@ -193,15 +230,37 @@ relay_new(struct replica *replica)
 	fiber_cond_create(&relay->reader_cond);
 	diag_create(&relay->diag);
 	stailq_create(&relay->pending_gc);
+	tt_pthread_mutex_init(&relay->join_mutex, NULL);
 	relay->state = RELAY_OFF;
 	return relay;
 }
 
 static void
-relay_start(struct relay *relay, int fd, uint64_t sync,
+relay_start(struct relay *relay, int fd, uint64_t sync, bool compression,
 	     void (*stream_write)(struct xstream *, struct xrow_header *))
 {
 	xstream_create(&relay->stream, stream_write);
+	/*
+	 * Compress the stream if the replica supports it and
+	 * compression is enabled on our side. Failure to create
+	 * the compression context isn't critical - the rows can
+	 * still be sent as is.
+	 */
+	assert(relay->compressor == NULL);
+	relay->tx.raw_bytes = 0;
+	relay->tx.compressed_bytes = 0;
+	if (compression && replication_compression > 0) {
+		relay->compressor = (struct xrow_compressor *)
+			malloc(sizeof(*relay->compressor));
+		if (relay->compressor == NULL ||
+		    xrow_compressor_create(relay->compressor,
+					   replication_compression) != 0) {
+			free(relay->compressor);
+			relay->compressor = NULL;
+			say_warn("failed to create replication stream "
+				 "compressor, sending rows uncompressed");
+		}
+	}
 	/*
 	 * Clear the diagnostics at start, in case it has the old
 	 * error message which we keep around to display in
@@ -257,6 +316,14 @@ relay_stop(struct relay *relay)
 	if (relay->r != NULL)
 		recovery_delete(relay->r);
 	relay->r = NULL;
+	if (relay->compressor != NULL) {
+		relay->tx.raw_bytes = relay->compressor->raw_bytes;
+		relay->tx.compressed_bytes =
+			relay->compressor->compressed_bytes;
+		xrow_compressor_destroy(relay->compressor);
+		free(relay->compressor);
+		relay->compressor = NULL;
+	}
 	relay->state = RELAY_STOPPED;
 	/*
 	 * Needed to track whether relay thread is running or not
@@ -273,6 +340,7 @@ relay_delete(struct relay *relay)
 		relay_stop(relay);
 	fiber_cond_destroy(&relay->reader_cond);
 	diag_destroy(&relay->diag);
+	tt_pthread_mutex_destroy(&relay->join_mutex);
 	TRASH(relay);
 	free(relay);
 }
@@ -293,13 +361,16 @@ relay_set_cord_name(int fd)
 }
 
 void
-relay_initial_join(int fd, uint64_t sync, struct vclock *vclock)
+relay_initial_join(int fd, uint64_t sync, struct vclock *vclock,
+		   bool compression)
 {
 	struct relay *relay = relay_new(NULL);
 	if (relay == NULL)
 		diag_raise();
 
-	relay_start(relay, fd, sync, relay_send_initial_join_row);
+	relay_start(relay, fd, sync, compression, relay_send_initial_join_row);
+	relay->stream.write_batch = relay_send_initial_join_batch;
+	relay->join_row_count = 0;
 	auto relay_guard = make_scoped_guard([=] {
 		relay_stop(relay);
 		relay_delete(relay);
@@ -326,8 +397,24 @@ relay_initial_join(int fd, uint64_t sync, struct vclock *vclock)
 	row.sync = sync;
 	coio_write_xrow(&relay->io, &row);
 
-	/* Send read view to the replica. */
+	/*
+	 * Send read view to the replica. Engines read it with
+	 * replication_join_workers threads, but all of them write
+	 * to this single connection and the replica applies rows
+	 * one by one, so the gain is limited to reading and
+	 * encoding the data on the master.
+	 */
+	double start = clock_monotonic();
 	engine_join_xc(&ctx, &relay->stream);
+	relay_flush(relay);
+	say_info("initial data sent: %lld rows in %.3f sec",
+		 (long long)relay->join_row_count,
+		 clock_monotonic() - start);
+	if (relay->compressor != NULL) {
+		say_info("initial data compressed from %llu to %llu bytes",
+			 (long long)relay->compressor->raw_bytes,
+			 (long long)relay->compressor->compressed_bytes);
+	}
 }
 
 int
@@ -344,18 +431,19 @@ relay_final_join_f(va_list ap)
 	recover_remaining_wals(relay->r, &relay->stream,
 			       &relay->stop_vclock, true);
 	assert(vclock_compare(&relay->r->vclock, &relay->stop_vclock) == 0);
+	relay_flush(relay);
 	return 0;
 }
 
 void
 relay_final_join(int fd, uint64_t sync, struct vclock *start_vclock,
-		 struct vclock *stop_vclock)
+		 struct vclock *stop_vclock, bool compression)
 {
 	struct relay *relay = relay_new(NULL);
 	if (relay == NULL)
 		diag_raise();
 
-	relay_start(relay, fd, sync, relay_send_row);
+	relay_start(relay, fd, sync, compression, relay_send_row);
 	auto relay_guard = make_scoped_guard([=] {
 		relay_stop(relay);
 		relay_delete(relay);
@@ -399,6 +487,8 @@ tx_status_update(struct cmsg *msg)
 {
 	struct relay_status_msg *status = (struct relay_status_msg *)msg;
 	vclock_copy(&status->relay->tx.vclock, &status->vclock);
+	status->relay->tx.raw_bytes = status->raw_bytes;
+	status->relay->tx.compressed_bytes = status->compressed_bytes;
 	static const struct cmsg_hop route[] = {
 		{relay_status_update, NULL}
 	};
@@ -501,6 +591,7 @@ relay_process_wal_event(struct wal_watcher *watcher, unsigned events)
 	try {
 		recover_remaining_wals(relay->r, &relay->stream, NULL,
 				       (events & WAL_EVENT_ROTATE) != 0);
+		relay_flush(relay);
 	} catch (Exception *e) {
 		relay_set_error(relay, e);
 		fiber_cancel(fiber());
@@ -549,6 +640,7 @@ relay_send_heartbeat(struct relay *relay)
 	xrow_encode_timestamp(&row, instance_id, ev_now(loop()));
 	try {
 		relay_send(relay, &row);
+		relay_flush(relay);
 	} catch (Exception *e) {
 		relay_set_error(relay, e);
 		fiber_cancel(fiber());
@@ -650,6 +742,12 @@ relay_subscribe_f(va_list ap)
 		};
 		cmsg_init(&relay->status_msg.msg, route);
 		vclock_copy(&relay->status_msg.vclock, send_vclock);
+		if (relay->compressor != NULL) {
+			relay->status_msg.raw_bytes =
+				relay->compressor->raw_bytes;
+			relay->status_msg.compressed_bytes =
+				relay->compressor->compressed_bytes;
+		}
 		relay->status_msg.relay = relay;
 		cpipe_push(&relay->tx_pipe, &relay->status_msg.msg);
 	}
@@ -688,7 +786,7 @@ relay_subscribe_f(va_list ap)
 void
 relay_subscribe(struct replica *replica, int fd, uint64_t sync,
 		struct vclock *replica_clock, uint32_t replica_version_id,
-		uint32_t replica_id_filter)
+		uint32_t replica_id_filter, bool compression)
 {
 	assert(replica->anon || replica->id != REPLICA_ID_NIL);
 	struct relay *relay = replica->relay;
@@ -705,7 +803,7 @@ relay_subscribe(struct replica *replica, int fd, uint64_t sync,
 			diag_raise();
 	}
 
-	relay_start(relay, fd, sync, relay_send_row);
+	relay_start(relay, fd, sync, compression, relay_send_row);
 	auto relay_guard = make_scoped_guard([=] {
 		relay_stop(relay);
 		replica_on_relay_stop(replica);
@@ -734,7 +832,19 @@ relay_send(struct relay *relay, struct xrow_header *packet)
 
 	packet->sync = relay->sync;
 	relay->last_row_time = ev_monotonic_now(loop());
-	coio_write_xrow(&relay->io, packet);
+	if (relay->compressor != NULL) {
+		/*
+		 * Let rows accumulate in the compressor until
+		 * the caller flushes it, but don't let the output
+		 * chunk grow too big.
+		 */
+		if (xrow_compressor_add(relay->compressor, packet) != 0)
+			diag_raise();
+		if (relay->compressor->pending >= XROW_COMPRESS_CHUNK_SIZE)
+			relay_flush(relay);
+	} else {
+		coio_write_xrow(&relay->io, packet);
+	}
 	fiber_gc();
 
 	struct errinj *inj = errinj(ERRINJ_RELAY_TIMEOUT, ERRINJ_DOUBLE);
@@ -742,6 +852,23 @@ relay_send(struct relay *relay, struct xrow_header *packet)
 		fiber_sleep(inj->dparam);
 }
 
+/**
+ * Send rows accumulated by the stream compressor, if any,
+ * to the replica.
+ */
+static void
+relay_flush(struct relay *relay)
+{
+	if (relay->compressor == NULL ||
+	    xrow_compressor_is_empty(relay->compressor))
+		return;
+	struct xrow_header packet;
+	if (xrow_compressor_flush(relay->compressor, &packet) != 0)
+		diag_raise();
+	packet.sync = relay->sync;
+	coio_write_xrow(&relay->io, &packet);
+}
+
 static void
 relay_send_initial_join_row(struct xstream *stream, struct xrow_header *row)
 {
@@ -750,8 +877,72 @@ relay_send_initial_join_row(struct xstream *stream, struct xrow_header *row)
 	 * Ignore replica local requests as we don't need to promote
 	 * vclock while sending a snapshot.
 	 */
-	if (row->group_id != GROUP_LOCAL)
+	if (row->group_id != GROUP_LOCAL) {
 		relay_send(relay, row);
+		relay->join_row_count++;
+	}
+}
+
+static void
+relay_join_unlock(void *arg)
+{
+	tt_pthread_mutex_unlock((pthread_mutex_t *)arg);
+}
+
+/**
+ * Send a batch of initial join rows. Called concurrently by
+ * the threads sending memtx spaces. The rows are encoded by
+ * the calling thread, only writing the encoded batch to the
+ * compressor or to the socket is serialized.
+ */
+static void
+relay_send_initial_join_batch(struct xstream *stream,
+			      struct xrow_header *rows, int count)
+{
+	struct relay *relay = container_of(stream, struct relay, stream);
+	size_t size = count * XROW_IOVMAX * sizeof(struct iovec);
+	struct iovec *iov = (struct iovec *)
+		region_alloc(&fiber()->gc, size);
+	if (iov == NULL)
+		tnt_raise(OutOfMemory, size, "region", "struct iovec");
+	int iovcnt = 0;
+	int row_count = 0;
+	for (int i = 0; i < count; i++) {
+		/* See relay_send_initial_join_row(). */
+		if (rows[i].group_id == GROUP_LOCAL)
+			continue;
+		rows[i].sync = relay->sync;
+		iovcnt += xrow_to_iovec_xc(&rows[i], iov + iovcnt);
+		row_count++;
+	}
+	bool is_ok = true;
+	tt_pthread_mutex_lock(&relay->join_mutex);
+	/*
+	 * Writing to the socket may block the thread. Make sure
+	 * the mutex is released if the thread is cancelled
+	 * meanwhile, see replica_join_cancel().
+	 */
+	pthread_cleanup_push(relay_join_unlock, &relay->join_mutex);
+	try {
+		relay->last_row_time = ev_monotonic_now(loop());
+		relay->join_row_count += row_count;
+		if (relay->compressor != NULL) {
+			if (xrow_compressor_add_iov(relay->compressor,
+						    iov, iovcnt) != 0)
+				diag_raise();
+			if (relay->compressor->pending >=
+			    XROW_COMPRESS_CHUNK_SIZE)
+				relay_flush(relay);
+		} else {
+			coio_writev(&relay->io, iov, iovcnt, 0);
+		}
+	} catch (Exception *e) {
+		is_ok = false;
+	}
+	pthread_cleanup_pop(1);
+	fiber_gc();
+	if (!is_ok)
+		diag_raise();
 }
 
 /** Send a single row to the client. */
@@ -31,6 +31,7 @@
  * SUCH DAMAGE.
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #if defined(__cplusplus)
@@ -93,6 +94,17 @@ relay_vclock(const struct relay *relay);
 double
 relay_last_row_time(const struct relay *relay);
 
+/**
+ * Returns statistics of the replication stream compressor:
+ * the number of bytes fed to it and the number of bytes it
+ * produced.
+ * @param relay relay
+ * @returns true if the stream sent by the relay is compressed
+ */
+bool
+relay_compression_stat(const struct relay *relay, uint64_t *raw_bytes,
+		       uint64_t *compressed_bytes);
+
 #if defined(__cplusplus)
 } /* extern "C" */
 #endif /* defined(__cplusplus) */
@@ -103,19 +115,22 @@ relay_last_row_time(const struct relay *relay);
  * @param fd        client connection
  * @param sync      sync from incoming JOIN request
  * @param vclock[out] vclock of the read view sent to the replica
+ * @param compression whether the replica accepts compressed rows
  */
 void
-relay_initial_join(int fd, uint64_t sync, struct vclock *vclock);
+relay_initial_join(int fd, uint64_t sync, struct vclock *vclock,
+		   bool compression);
 
 /**
  * Send final JOIN rows to the replica.
  *
  * @param fd        client connection
  * @param sync      sync from incoming JOIN request
+ * @param compression whether the replica accepts compressed rows
  */
 void
 relay_final_join(int fd, uint64_t sync, struct vclock *start_vclock,
-		 struct vclock *stop_vclock);
+		 struct vclock *stop_vclock, bool compression);
 
 /**
  * Subscribe a replica to updates.
@@ -125,6 +140,6 @@ relay_final_join(int fd, uint64_t sync, struct vclock *start_vclock,
 void
 relay_subscribe(struct replica *replica, int fd, uint64_t sync,
 		struct vclock *replica_vclock, uint32_t replica_version_id,
-		uint32_t replica_id_filter);
+		uint32_t replica_id_filter, bool compression);
 
 #endif /* TARANTOOL_REPLICATION_RELAY_H_INCLUDED */
@@ -54,6 +54,8 @@ double replication_sync_lag = 10.0; /* seconds */
 double replication_sync_timeout = 300.0; /* seconds */
 bool replication_skip_conflict = false;
 bool replication_anon = false;
+int replication_compression = 0;
+int replication_join_workers = 1;
 
 struct replicaset replicaset;
 
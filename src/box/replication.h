@@ -143,6 +143,21 @@ extern bool replication_skip_conflict;
  */
 extern bool replication_anon;
 
+/**
+ * zstd level used to compress the stream sent to replicas
+ * that support it. 0 means the stream isn't compressed.
+ */
+extern int replication_compression;
+
+/** Max value of box.cfg.replication_join_workers. */
+enum { REPLICATION_JOIN_WORKERS_MAX = 64 };
+
+/**
+ * Number of workers sending the initial data to a joining
+ * replica in parallel.
+ */
+extern int replication_join_workers;
+
 /**
  * Wait for the given period of time before trying to reconnect
  * to a master.
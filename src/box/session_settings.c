@@ -273,6 +273,7 @@ static const struct index_vtab session_settings_index_vtab = {
 	/* .random = */ generic_index_random,
 	/* .count = */ generic_index_count,
 	/* .get = */ session_settings_index_get,
+	/* .get_many = */ generic_index_get_many,
 	/* .replace = */ generic_index_replace,
 	/* .create_iterator = */ session_settings_index_create_iterator,
 	/* .create_snapshot_iterator = */
@@ -393,6 +394,19 @@ session_settings_space_execute_upsert(struct space *space, struct txn *txn,
 	return -1;
 }
 
+static int
+session_settings_space_execute_delete_range(struct space *space,
+					    struct txn *txn,
+					    struct request *request)
+{
+	(void)space;
+	(void)txn;
+	(void)request;
+	diag_set(ClientError, ER_UNSUPPORTED, "Session_settings space",
+		 "delete_range()");
+	return -1;
+}
+
 static struct index *
 session_settings_space_create_index(struct space *space, struct index_def *def)
 {
@@ -426,6 +440,8 @@ const struct space_vtab session_settings_space_vtab = {
 	/* .execute_delete = */ session_settings_space_execute_delete,
 	/* .execute_update = */ session_settings_space_execute_update,
 	/* .execute_upsert = */ session_settings_space_execute_upsert,
+	/* .execute_delete_range = */
+		session_settings_space_execute_delete_range,
 	/* .ephemeral_replace = */ generic_space_ephemeral_replace,
 	/* .ephemeral_delete = */ generic_space_ephemeral_delete,
 	/* .ephemeral_rowid_next = */ generic_space_ephemeral_rowid_next,
@@ -530,6 +530,47 @@ out:
 	return rc;
 }
 
+/**
+ * Check if a range deletion can be executed on the given space.
+ *
+ * A range deletion doesn't produce old tuples, so we can't run
+ * space triggers for it. Since system spaces rely on triggers,
+ * this also rules them out. Triggers are only checked for local
+ * requests: a request that is recovered from WAL or received
+ * from a replication master has already been executed and must
+ * be applied regardless of triggers installed on this instance.
+ * The range is only allowed to be specified in the primary index,
+ * because secondary indexes may not be built yet when the request
+ * is replayed from WAL.
+ */
+static int
+space_check_delete_range(struct space *space, struct request *request)
+{
+	struct index *index = index_find(space, request->index_id);
+	if (index == NULL)
+		return -1;
+	bool is_local = request->header == NULL ||
+			request->header->replica_id == 0;
+	if (space_is_system(space) ||
+	    (is_local && (!rlist_empty(&space->before_replace) ||
+			  !rlist_empty(&space->on_replace)))) {
+		diag_set(ClientError, ER_UNSUPPORTED,
+			 "Space with triggers", "delete_range()");
+		return -1;
+	}
+	if (index->def->iid != 0) {
+		diag_set(ClientError, ER_UNSUPPORTED,
+			 "Secondary index", "delete_range()");
+		return -1;
+	}
+	if (index->def->type != TREE) {
+		diag_set(UnsupportedIndexFeature, index->def,
+			 "delete_range()");
+		return -1;
+	}
+	return 0;
+}
+
 int
 space_execute_dml(struct space *space, struct txn *txn,
 		  struct request *request, struct tuple **result)
@@ -590,6 +631,14 @@ space_execute_dml(struct space *space, struct txn *txn,
 		if (space->vtab->execute_upsert(space, txn, request) != 0)
 			return -1;
 		break;
+	case IPROTO_DELETE_RANGE:
+		*result = NULL;
+		if (space_check_delete_range(space, request) != 0)
+			return -1;
+		if (space->vtab->execute_delete_range(space, txn,
+						      request) != 0)
+			return -1;
+		break;
 	default:
 		*result = NULL;
 	}
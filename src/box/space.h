@@ -67,6 +67,12 @@ struct space_vtab {
 	int (*execute_update)(struct space *, struct txn *,
 			      struct request *, struct tuple **result);
 	int (*execute_upsert)(struct space *, struct txn *, struct request *);
+	/**
+	 * Delete all tuples whose primary keys lie in the
+	 * half-open interval [request->key, request->tuple).
+	 */
+	int (*execute_delete_range)(struct space *, struct txn *,
+				    struct request *);
 
 	int (*ephemeral_replace)(struct space *, const char *, const char *);
 
@@ -193,6 +193,7 @@ static const struct index_vtab sysview_index_vtab = {
 	/* .random = */ generic_index_random,
 	/* .count = */ generic_index_count,
 	/* .get = */ sysview_index_get,
+	/* .get_many = */ generic_index_get_many,
 	/* .replace = */ generic_index_replace,
 	/* .create_iterator = */ sysview_index_create_iterator,
 	/* .create_snapshot_iterator = */
@@ -255,6 +256,16 @@ sysview_space_execute_upsert(struct space *space, struct txn *txn,
 	return -1;
 }
 
+static int
+sysview_space_execute_delete_range(struct space *space, struct txn *txn,
+				   struct request *request)
+{
+	(void)txn;
+	(void)request;
+	diag_set(ClientError, ER_VIEW_IS_RO, space->def->name);
+	return -1;
+}
+
 /*
  * System view filters.
  * Filter gives access to an object, if one of the following conditions is true:
@@ -494,6 +505,7 @@ static const struct space_vtab sysview_space_vtab = {
 	/* .execute_delete = */ sysview_space_execute_delete,
 	/* .execute_update = */ sysview_space_execute_update,
 	/* .execute_upsert = */ sysview_space_execute_upsert,
+	/* .execute_delete_range = */ sysview_space_execute_delete_range,
 	/* .ephemeral_replace = */ generic_space_ephemeral_replace,
 	/* .ephemeral_delete = */ generic_space_ephemeral_delete,
 	/* .ephemeral_rowid_next = */ generic_space_ephemeral_rowid_next,
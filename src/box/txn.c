@@ -209,6 +209,12 @@ txn_begin(void)
 {
 	static int64_t tsn = 0;
 	assert(! in_txn());
+	/*
+	 * Throttle writers while nothing has been changed yet:
+	 * a transaction may not yield once it has modified data.
+	 */
+	if (journal_wait_room() != 0)
+		return NULL;
 	struct txn *txn = txn_new();
 	if (txn == NULL)
 		return NULL;
@@ -265,7 +265,8 @@ fiber_set_txn(struct fiber *fiber, struct txn *txn)
 }
 
 /**
- * Start a transaction explicitly.
+ * Start a transaction explicitly. May yield if the journal
+ * is full, see journal_wait_room().
  * @pre no transaction is active
  */
 struct txn *
@@ -33,6 +33,7 @@
 #include "vy_mem.h"
 #include "vy_run.h"
 #include "vy_range.h"
+#include "vy_range_filter.h"
 #include "vy_lsm.h"
 #include "vy_tx.h"
 #include "vy_cache.h"
@@ -45,6 +46,7 @@
 #include "vy_scheduler.h"
 #include "vy_regulator.h"
 #include "vy_stat.h"
+#include "vy_tombstone.h"
 
 #include <stdbool.h>
 #include <stddef.h>
@@ -54,6 +56,7 @@
 #include <small/lsregion.h>
 #include <small/region.h>
 #include <small/mempool.h>
+#include <pmatomic.h>
 
 #include "coio_task.h"
 #include "cbus.h"
@@ -67,9 +70,12 @@
 #include "index.h"
 #include "schema.h"
 #include "xstream.h"
+#include "latch.h"
+#include "replication.h"
 #include "info/info.h"
 #include "column_mask.h"
 #include "trigger.h"
+#include "assoc.h"
 #include "wal.h" /* wal_mode() */
 
 /**
@@ -261,9 +267,71 @@ vy_info_append_regulator(struct vy_env *env, struct info_handler *h)
 	info_append_int(h, "dump_watermark", r->dump_watermark);
 	info_append_int(h, "rate_limit", vy_quota_get_rate_limit(r->quota,
 							VY_QUOTA_CONSUMER_TX));
+	info_append_double(h, "read_latency", r->read_latency_p99);
+	info_append_double(h, "read_latency_slo", r->read_latency_slo);
+	info_append_int(h, "compaction_rate_limit", r->compaction_rate_limit);
 	info_table_end(h); /* regulator */
 }
 
+static void
+vy_info_append_page_cache(struct vy_env *env, struct info_handler *h)
+{
+	struct vy_page_cache *cache = &env->run_env.page_cache;
+
+	info_table_begin(h, "page_cache");
+	info_append_int(h, "quota", cache->quota);
+	info_append_int(h, "used", cache->mem_used);
+	info_append_int(h, "lookup", cache->stat.lookup);
+	info_append_int(h, "hit", cache->stat.hit);
+	info_append_int(h, "put", cache->stat.put);
+	info_append_int(h, "evict", cache->stat.evict);
+	info_table_end(h); /* page_cache */
+}
+
+static void
+vy_info_append_readahead(struct vy_env *env, struct info_handler *h)
+{
+	struct vy_run_env *run_env = &env->run_env;
+
+	info_table_begin(h, "readahead");
+	info_append_int(h, "used", run_env->readahead_mem_used);
+	info_append_int(h, "pages", run_env->readahead_stat.pages);
+	info_append_int(h, "useful", run_env->readahead_stat.useful);
+	info_append_int(h, "wasted", run_env->readahead_stat.wasted);
+	info_table_end(h); /* readahead */
+}
+
+static void
+vy_info_append_amplification(struct vy_env *env, struct info_handler *h)
+{
+	info_table_begin(h, "amplification");
+	for (int i = 0; i < index_compaction_policy_MAX; i++) {
+		const struct vy_compaction_policy_stat *stat =
+					&env->lsm_env.policy_stat[i];
+		info_table_begin(h, index_compaction_policy_strs[i]);
+		/*
+		 * Write amplification is the ratio of the amount of
+		 * data written to disk to the amount of data dumped.
+		 * Read amplification is the average number of run
+		 * slices per range, i.e. the number of runs a point
+		 * lookup may need to check. Space amplification is the ratio
+		 * of the size of data stored on disk to the size of
+		 * data stored at the last LSM tree level.
+		 */
+		info_append_double(h, "write", stat->dump_input == 0 ? 0 :
+				   (double)stat->disk_output /
+				   stat->dump_input);
+		info_append_double(h, "read", stat->range_count == 0 ? 0 :
+				   (double)stat->slice_count /
+				   stat->range_count);
+		info_append_double(h, "space", stat->compacted_size == 0 ? 0 :
+				   (double)stat->disk_size /
+				   stat->compacted_size);
+		info_table_end(h);
+	}
+	info_table_end(h); /* amplification */
+}
+
 static void
 vy_info_append_tx(struct vy_env *env, struct info_handler *h)
 {
@@ -297,6 +365,7 @@ vy_info_append_memory(struct vy_env *env, struct info_handler *h)
 	info_append_int(h, "tuple_cache", env->cache_env.mem_used);
 	info_append_int(h, "page_index", env->lsm_env.page_index_size);
 	info_append_int(h, "bloom_filter", env->lsm_env.bloom_size);
+	info_append_int(h, "vylog", vy_log_image_mem_used());
 	info_table_end(h); /* memory */
 }
 
@@ -321,6 +390,9 @@ vinyl_engine_stat(struct engine *engine, struct info_handler *h)
 	vy_info_append_disk(env, h);
 	vy_info_append_scheduler(env, h);
 	vy_info_append_regulator(env, h);
+	vy_info_append_page_cache(env, h);
+	vy_info_append_readahead(env, h);
+	vy_info_append_amplification(env, h);
 	info_end(h);
 }
 
@@ -377,6 +449,18 @@ vinyl_index_stat(struct index *index, struct info_handler *h)
 	info_append_double(h, "p99", latency_get(&stat->latency, 99));
 	info_table_end(h); /* latency */
 
+	info_table_begin(h, "batch");
+	info_append_int(h, "count", stat->batch.count);
+	info_append_int(h, "keys", stat->batch.keys);
+	info_append_int(h, "disk_keys", stat->batch.disk_keys);
+	info_append_double(h, "io_depth", stat->batch.count == 0 ? 0 :
+			   (double)stat->batch.io_depth / stat->batch.count);
+	info_table_begin(h, "latency");
+	info_append_double(h, "p50", latency_get(&stat->batch.latency, 50));
+	info_append_double(h, "p99", latency_get(&stat->batch.latency, 99));
+	info_table_end(h); /* latency */
+	info_table_end(h); /* batch */
+
 	info_table_begin(h, "upsert");
 	info_append_int(h, "squashed", stat->upsert.squashed);
 	info_append_int(h, "applied", stat->upsert.applied);
@@ -405,10 +489,16 @@ vinyl_index_stat(struct index *index, struct info_handler *h)
 	info_append_int(h, "lookup", stat->disk.iterator.lookup);
 	vy_info_append_stmt_counter(h, "get", &stat->disk.iterator.get);
 	vy_info_append_disk_stmt_counter(h, "read", &stat->disk.iterator.read);
+	info_append_double(h, "read_time", stat->disk.iterator.read_time);
 	info_table_begin(h, "bloom");
 	info_append_int(h, "hit", stat->disk.iterator.bloom_hit);
 	info_append_int(h, "miss", stat->disk.iterator.bloom_miss);
 	info_table_end(h); /* bloom */
+	info_table_begin(h, "range_filter");
+	info_append_int(h, "hit", stat->disk.iterator.range_filter_hit);
+	info_append_int(h, "miss", stat->disk.iterator.range_filter_miss);
+	info_append_int(h, "saved", stat->disk.iterator.range_filter_saved);
+	info_table_end(h); /* range_filter */
 	info_table_end(h); /* iterator */
 	info_table_begin(h, "dump");
 	info_append_int(h, "count", stat->disk.dump.count);
@@ -425,13 +515,16 @@ vinyl_index_stat(struct index *index, struct info_handler *h)
 	info_table_end(h); /* compaction */
 	info_append_int(h, "index_size", lsm->page_index_size);
 	info_append_int(h, "bloom_size", lsm->bloom_size);
+	info_append_int(h, "dict_size", lsm->dict_size);
 	info_table_end(h); /* disk */
 
 	info_table_begin(h, "cache");
 	vy_info_append_stmt_counter(h, NULL, &cache_stat->count);
 	info_append_int(h, "lookup", cache_stat->lookup);
+	info_append_int(h, "hit", cache_stat->hit);
 	vy_info_append_stmt_counter(h, "get", &cache_stat->get);
 	vy_info_append_stmt_counter(h, "put", &cache_stat->put);
+	vy_info_append_stmt_counter(h, "reject", &cache_stat->reject);
 	vy_info_append_stmt_counter(h, "invalidate", &cache_stat->invalidate);
 	vy_info_append_stmt_counter(h, "evict", &cache_stat->evict);
 	info_append_int(h, "index_size",
@@ -473,6 +566,13 @@ vinyl_index_reset_stat(struct index *index)
 	vy_stmt_counter_reset(&stat->put);
 	memset(&stat->upsert, 0, sizeof(stat->upsert));
 
+	/* Batch */
+	stat->batch.count = 0;
+	stat->batch.keys = 0;
+	stat->batch.disk_keys = 0;
+	stat->batch.io_depth = 0;
+	latency_reset(&stat->batch.latency);
+
 	/* Iterator */
 	memset(&stat->txw.iterator, 0, sizeof(stat->txw.iterator));
 	memset(&stat->memory.iterator, 0, sizeof(stat->memory.iterator));
@@ -492,8 +592,10 @@ vinyl_index_reset_stat(struct index *index)
 
 	/* Cache */
 	cache_stat->lookup = 0;
+	cache_stat->hit = 0;
 	vy_stmt_counter_reset(&cache_stat->get);
 	vy_stmt_counter_reset(&cache_stat->put);
+	vy_stmt_counter_reset(&cache_stat->reject);
 	vy_stmt_counter_reset(&cache_stat->invalidate);
 	vy_stmt_counter_reset(&cache_stat->evict);
 }
@@ -509,6 +611,8 @@ vinyl_engine_memory_stat(struct engine *engine, struct engine_memory_stat *stat)
 	stat->index += env->lsm_env.bloom_size;
 	stat->index += env->lsm_env.page_index_size;
 	stat->cache += env->cache_env.mem_used;
+	stat->cache += env->run_env.page_cache.mem_used;
+	stat->cache += env->run_env.readahead_mem_used;
 	stat->tx += tx_manager_mem_used(env->xm);
 }
 
@@ -522,6 +626,16 @@ vinyl_engine_reset_stat(struct engine *engine)
 
 	vy_scheduler_reset_stat(&env->scheduler);
 	vy_regulator_reset_stat(&env->regulator);
+	memset(&env->run_env.page_cache.stat, 0,
+	       sizeof(env->run_env.page_cache.stat));
+	memset(&env->run_env.readahead_stat, 0,
+	       sizeof(env->run_env.readahead_stat));
+	for (int i = 0; i < index_compaction_policy_MAX; i++) {
+		struct vy_compaction_policy_stat *stat =
+					&env->lsm_env.policy_stat[i];
+		stat->dump_input = 0;
+		stat->disk_output = 0;
+	}
 }
 
 /** }}} Introspection */
@@ -574,6 +688,25 @@ vy_lsm_find_unique(struct space *space, uint32_t index_id)
 	return lsm;
 }
 
+/**
+ * Return true if the space has a covering secondary index.
+ *
+ * Reads from a covering index don't look up the primary index
+ * and so can't filter out tuples that have been overwritten in
+ * the primary index, but not yet deleted from the secondary index.
+ * Hence we never defer generation of DELETE statements for
+ * secondary indexes of such a space.
+ */
+static bool
+vy_space_has_covering_index(struct space *space)
+{
+	for (uint32_t i = 1; i < space->index_count; i++) {
+		if (vy_lsm(space->index[i])->opts.covering)
+			return true;
+	}
+	return false;
+}
+
 static int
 vinyl_engine_check_space_def(struct space_def *def)
 {
@@ -672,6 +805,74 @@ vinyl_space_check_index_def(struct space *space, struct index_def *index_def)
 			 "functional index");
 		return -1;
 	}
+	if (index_def->opts.blob_threshold > 0 && index_def->iid > 0) {
+		diag_set(ClientError, ER_MODIFY_INDEX,
+			 index_def->name, space_name(space),
+			 "blob_threshold is only supported by primary index");
+		return -1;
+	}
+	if (index_def->opts.ttl > 0 && index_def->iid > 0) {
+		diag_set(ClientError, ER_MODIFY_INDEX,
+			 index_def->name, space_name(space),
+			 "ttl is only supported by primary index");
+		return -1;
+	}
+	if (index_def->opts.compression_dict_size > VY_RUN_DICT_SIZE_MAX) {
+		diag_set(ClientError, ER_MODIFY_INDEX,
+			 index_def->name, space_name(space),
+			 tt_sprintf("compression_dict_size must not exceed %d",
+				    VY_RUN_DICT_SIZE_MAX));
+		return -1;
+	}
+	if (index_def->opts.range_filter &&
+	    !vy_range_filter_is_supported(index_def->key_def)) {
+		diag_set(ClientError, ER_MODIFY_INDEX,
+			 index_def->name, space_name(space),
+			 "range_filter requires the first key part to be "
+			 "unsigned, integer, or string without collation "
+			 "and the index not to be multikey");
+		return -1;
+	}
+	if (index_def->opts.covering && index_def->iid == 0) {
+		diag_set(ClientError, ER_MODIFY_INDEX,
+			 index_def->name, space_name(space),
+			 "covering is only supported by secondary indexes");
+		return -1;
+	}
+	if (index_def->opts.covering && index_def->key_def->is_multikey) {
+		diag_set(ClientError, ER_MODIFY_INDEX,
+			 index_def->name, space_name(space),
+			 "covering is not supported by multikey indexes");
+		return -1;
+	}
+	/*
+	 * Tuples expired by ttl are dropped by primary index
+	 * compaction, which generates deferred DELETEs for them,
+	 * see optimization #6 in vy_write_iterator.h. Until such
+	 * a DELETE is compacted, a stale secondary index entry is
+	 * only filtered out by looking up the primary index, which
+	 * a covering index doesn't do, so it would return expired
+	 * tuples.
+	 */
+	if (index_def->opts.covering && space->index_count > 0 &&
+	    space->index[0]->def->opts.ttl > 0) {
+		diag_set(ClientError, ER_MODIFY_INDEX,
+			 index_def->name, space_name(space),
+			 "covering is not supported if the primary index "
+			 "has ttl");
+		return -1;
+	}
+	if (index_def->opts.ttl > 0 && index_def->iid == 0) {
+		for (uint32_t i = 1; i < space->index_count; i++) {
+			if (!space->index[i]->def->opts.covering)
+				continue;
+			diag_set(ClientError, ER_MODIFY_INDEX,
+				 index_def->name, space_name(space),
+				 "ttl is not supported if the space has "
+				 "a covering index");
+			return -1;
+		}
+	}
 	return 0;
 }
 
@@ -899,6 +1100,7 @@ static void
 vinyl_index_update_def(struct index *index)
 {
 	struct vy_lsm *lsm = vy_lsm(index);
+	vy_lsm_set_compaction_policy(lsm, index->def->opts.compaction_policy);
 	lsm->opts = index->def->opts;
 	key_def_copy(lsm->key_def, index->def->key_def);
 	key_def_copy(lsm->cmp_def, index->def->cmp_def);
@@ -929,6 +1131,9 @@ vinyl_index_def_change_requires_rebuild(struct index *index,
 		return true;
 	if (old_def->opts.func_id != new_def->opts.func_id)
 		return true;
+	/* Covering indexes store full tuples in runs. */
+	if (old_def->opts.covering != new_def->opts.covering)
+		return true;
 
 	assert(index_depends_on_pk(index));
 	const struct key_def *old_cmp_def = old_def->cmp_def;
@@ -1250,55 +1455,46 @@ vy_is_committed(struct vy_env *env, struct vy_lsm *lsm)
 }
 
 /**
- * Get a full tuple by a tuple read from a secondary index.
- * @param lsm         LSM tree from which the tuple was read.
- * @param tx          Current transaction.
- * @param rv          Read view.
- * @param entry       Tuple read from a secondary index.
- * @param[out] result The found tuple is stored here. Must be
- *                    unreferenced after usage.
+ * Get the primary key of a tuple read from a secondary index.
+ * There are two cases: the secondary statement may be a key,
+ * if we got this tuple from disk, in which case we need to
+ * extract the primary key parts from it; or it may be a full
+ * tuple, if we got this tuple from the tuple cache or level 0,
+ * in which case we may use it as a key immediately.
  *
- * @param  0 Success.
- * @param -1 Memory error or read error.
+ * The returned key must be unreferenced after usage.
  */
 static int
-vy_get_by_secondary_tuple(struct vy_lsm *lsm, struct vy_tx *tx,
-			  const struct vy_read_view **rv,
-			  struct vy_entry entry, struct vy_entry *result)
+vy_secondary_tuple_pk_key(struct vy_lsm *lsm, struct vy_entry entry,
+			  struct vy_entry *key)
 {
-	int rc = 0;
-	assert(lsm->index_id > 0);
-
-	/*
-	 * Lookup the full tuple by a secondary statement.
-	 * There are two cases: the secondary statement may be
-	 * a key, if we got this tuple from disk, in which case
-	 * we need to extract the primary key parts from it; or
-	 * it may be a full tuple, if we got this tuple from
-	 * the tuple cache or level 0, in which case we may pass
-	 * it immediately to the iterator.
-	 */
-	struct vy_entry key;
 	if (vy_stmt_is_key(entry.stmt)) {
-		key.stmt = vy_stmt_extract_key(entry.stmt, lsm->pk_in_cmp_def,
-					       lsm->env->key_format,
-					       MULTIKEY_NONE);
-		if (key.stmt == NULL)
+		key->stmt = vy_stmt_extract_key(entry.stmt,
+						lsm->pk_in_cmp_def,
+						lsm->env->key_format,
+						MULTIKEY_NONE);
+		if (key->stmt == NULL)
 			return -1;
 	} else {
-		key.stmt = entry.stmt;
-		tuple_ref(key.stmt);
-	}
-	key.hint = vy_stmt_hint(key.stmt, lsm->pk->cmp_def);
-
-	lsm->pk->stat.lookup++;
-
-	struct vy_entry pk_entry;
-	if (vy_point_lookup(lsm->pk, tx, rv, key, &pk_entry) != 0) {
-		rc = -1;
-		goto out;
+		key->stmt = entry.stmt;
+		tuple_ref(key->stmt);
 	}
+	key->hint = vy_stmt_hint(key->stmt, lsm->pk->cmp_def);
+	return 0;
+}
 
+/**
+ * Complete vy_get_by_secondary_tuple() given the tuple found in
+ * the primary index by the key returned by
+ * vy_secondary_tuple_pk_key(). Takes the reference to @pk_entry.
+ */
+static int
+vy_get_by_secondary_tuple_finish(struct vy_lsm *lsm, struct vy_tx *tx,
+				 const struct vy_read_view **rv,
+				 struct vy_entry entry, struct vy_entry key,
+				 struct vy_entry pk_entry, bool skip_cache,
+				 struct vy_entry *result)
+{
 	bool match = false;
 	struct vy_entry full_entry;
 	if (pk_entry.stmt != NULL) {
@@ -1333,7 +1529,7 @@ vy_get_by_secondary_tuple(struct vy_lsm *lsm, struct vy_tx *tx,
 		 */
 		vy_cache_on_write(&lsm->cache, entry, NULL);
 		*result = vy_entry_none();
-		goto out;
+		return 0;
 	}
 
 	/*
@@ -1346,22 +1542,154 @@ vy_get_by_secondary_tuple(struct vy_lsm *lsm, struct vy_tx *tx,
 	 */
 	if (tx != NULL && vy_tx_track_point(tx, lsm->pk, pk_entry) != 0) {
 		tuple_unref(pk_entry.stmt);
-		rc = -1;
-		goto out;
+		return -1;
 	}
 
-	if ((*rv)->vlsn == INT64_MAX) {
+	if (!skip_cache && (*rv)->vlsn == INT64_MAX) {
 		vy_cache_add(&lsm->pk->cache, pk_entry,
 			     vy_entry_none(), key, ITER_EQ);
 	}
 
 	vy_stmt_counter_acct_tuple(&lsm->pk->stat.get, pk_entry.stmt);
 	*result = full_entry;
+	return 0;
+}
+
+/**
+ * Get a full tuple by a tuple read from a secondary index.
+ * @param lsm         LSM tree from which the tuple was read.
+ * @param tx          Current transaction.
+ * @param rv          Read view.
+ * @param entry       Tuple read from a secondary index.
+ * @param skip_cache  Don't add the full tuple to the cache.
+ * @param[out] result The found tuple is stored here. Must be
+ *                    unreferenced after usage.
+ *
+ * @param  0 Success.
+ * @param -1 Memory error or read error.
+ */
+static int
+vy_get_by_secondary_tuple(struct vy_lsm *lsm, struct vy_tx *tx,
+			  const struct vy_read_view **rv,
+			  struct vy_entry entry, bool skip_cache,
+			  struct vy_entry *result)
+{
+	int rc = 0;
+	assert(lsm->index_id > 0);
+
+	if (lsm->opts.covering) {
+		/*
+		 * A covering index stores full tuples and is
+		 * never behind the primary index, because DELETEs
+		 * aren't deferred in a space with a covering index,
+		 * see vy_space_has_covering_index(). So there's no
+		 * need to look up the primary index.
+		 */
+		assert(!vy_stmt_is_key(entry.stmt));
+		tuple_ref(entry.stmt);
+		*result = entry;
+		return 0;
+	}
+
+	/* Lookup the full tuple by a secondary statement. */
+	struct vy_entry key;
+	if (vy_secondary_tuple_pk_key(lsm, entry, &key) != 0)
+		return -1;
+
+	lsm->pk->stat.lookup++;
+
+	struct vy_entry pk_entry;
+	if (vy_point_lookup(lsm->pk, tx, rv, key, &pk_entry) != 0) {
+		rc = -1;
+		goto out;
+	}
+	rc = vy_get_by_secondary_tuple_finish(lsm, tx, rv, entry, key,
+					      pk_entry, skip_cache, result);
 out:
 	tuple_unref(key.stmt);
 	return rc;
 }
 
+/**
+ * Replace tuples read from a secondary index with full tuples
+ * looked up in the primary index in one batch, see
+ * vy_point_lookup_batch(). Works like vy_get_by_secondary_tuple()
+ * called for each non-empty entry of @entries.
+ *
+ * Each non-empty entry is unreferenced and replaced with the
+ * corresponding full tuple, or with nothing if it turns out to
+ * be stale. Entries must be unreferenced after usage, even on
+ * failure.
+ */
+static int
+vy_get_many_by_secondary_tuples(struct vy_lsm *lsm, struct vy_tx *tx,
+				const struct vy_read_view **rv,
+				struct vy_entry *entries, uint32_t count)
+{
+	assert(lsm->index_id > 0);
+	if (lsm->opts.covering) {
+		/* See vy_get_by_secondary_tuple(). */
+		return 0;
+	}
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	size_t size;
+	struct vy_entry *keys = region_alloc_array(region,
+			typeof(keys[0]), 2 * count, &size);
+	if (keys == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc_array", "keys");
+		return -1;
+	}
+	struct vy_entry *pk_entries = keys + count;
+	uint32_t *key_idx = region_alloc_array(region,
+			typeof(key_idx[0]), count, &size);
+	if (key_idx == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc_array", "key_idx");
+		region_truncate(region, region_svp);
+		return -1;
+	}
+	int rc = 0;
+	uint32_t i, key_count = 0;
+	for (i = 0; i < count; i++) {
+		if (entries[i].stmt == NULL)
+			continue;
+		if (vy_secondary_tuple_pk_key(lsm, entries[i],
+					      &keys[key_count]) != 0) {
+			rc = -1;
+			goto out;
+		}
+		key_idx[key_count++] = i;
+	}
+	if (key_count == 0)
+		goto out;
+	lsm->pk->stat.lookup += key_count;
+	rc = vy_point_lookup_batch(lsm->pk, tx, rv, keys, key_count,
+				   pk_entries);
+	if (rc != 0)
+		goto out;
+	for (i = 0; i < key_count; i++) {
+		struct vy_entry *entry = &entries[key_idx[i]];
+		struct vy_entry full_entry = vy_entry_none();
+		if (rc != 0) {
+			if (pk_entries[i].stmt != NULL)
+				tuple_unref(pk_entries[i].stmt);
+			continue;
+		}
+		rc = vy_get_by_secondary_tuple_finish(lsm, tx, rv, *entry,
+						      keys[i], pk_entries[i],
+						      false, &full_entry);
+		if (rc != 0)
+			continue;
+		tuple_unref(entry->stmt);
+		*entry = full_entry;
+	}
+out:
+	for (i = 0; i < key_count; i++)
+		tuple_unref(keys[i].stmt);
+	region_truncate(region, region_svp);
+	return rc;
+}
+
 /**
  * Get a tuple from a vinyl space by key.
  * @param lsm         LSM tree in which search.
@@ -1404,8 +1732,8 @@ vy_get(struct vy_lsm *lsm, struct vy_tx *tx,
 		if (vy_point_lookup(lsm, tx, rv, key, &partial) != 0)
 			return -1;
 		if (lsm->index_id > 0 && partial.stmt != NULL) {
-			rc = vy_get_by_secondary_tuple(lsm, tx, rv,
-						       partial, &entry);
+			rc = vy_get_by_secondary_tuple(lsm, tx, rv, partial,
+						       false, &entry);
 			tuple_unref(partial.stmt);
 			if (rc != 0)
 				return -1;
@@ -1428,7 +1756,8 @@ vy_get(struct vy_lsm *lsm, struct vy_tx *tx,
 				tuple_ref(entry.stmt);
 			break;
 		}
-		rc = vy_get_by_secondary_tuple(lsm, tx, rv, partial, &entry);
+		rc = vy_get_by_secondary_tuple(lsm, tx, rv, partial,
+					       false, &entry);
 		if (rc != 0 || entry.stmt != NULL)
 			break;
 	}
@@ -1482,6 +1811,94 @@ vy_get_by_raw_key(struct vy_lsm *lsm, struct vy_tx *tx,
 	return rc;
 }
 
+/**
+ * Get tuples from a vinyl space by an array of raw keys.
+ * Works like vy_get_by_raw_key() called for each key, but looks
+ * up all keys in one batch, see vy_point_lookup_batch().
+ *
+ * @param lsm         LSM tree in which search.
+ * @param tx          Current transaction.
+ * @param rv          Read view.
+ * @param keys        MsgPack arrays of key fields.
+ * @param key_count   Number of keys.
+ * @param[out] result Found tuples, one per key. Must be
+ *                    unreferenced after usage.
+ *
+ * @param  0 Success.
+ * @param -1 Memory error or read error.
+ */
+static int
+vy_get_many(struct vy_lsm *lsm, struct vy_tx *tx,
+	    const struct vy_read_view **rv,
+	    const char **keys, uint32_t key_count,
+	    struct tuple **result)
+{
+	double start_time = ev_monotonic_now(loop());
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	size_t size;
+	struct vy_entry *entries = region_alloc_array(region,
+			typeof(entries[0]), 2 * key_count, &size);
+	if (entries == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc_array", "entries");
+		return -1;
+	}
+	struct vy_entry *partial = entries + key_count;
+	int rc = 0;
+	uint32_t i, key_created = 0;
+	for (i = 0; i < key_count; i++) {
+		const char *key = keys[i];
+		uint32_t part_count = mp_decode_array(&key);
+		entries[i].stmt = vy_key_new(lsm->env->key_format,
+					     key, part_count);
+		if (entries[i].stmt == NULL) {
+			rc = -1;
+			goto out;
+		}
+		key_created++;
+		entries[i].hint = vy_stmt_hint(entries[i].stmt, lsm->cmp_def);
+		if (tx != NULL && vy_tx_track_point(tx, lsm, entries[i]) != 0) {
+			rc = -1;
+			goto out;
+		}
+	}
+	lsm->stat.lookup += key_count;
+	rc = vy_point_lookup_batch(lsm, tx, rv, entries, key_count, partial);
+	if (rc != 0)
+		goto out;
+	if (lsm->index_id > 0)
+		rc = vy_get_many_by_secondary_tuples(lsm, tx, rv, partial,
+						     key_count);
+	for (i = 0; i < key_count; i++) {
+		struct vy_entry entry = partial[i];
+		if (rc != 0) {
+			if (entry.stmt != NULL)
+				tuple_unref(entry.stmt);
+			continue;
+		}
+		if ((*rv)->vlsn == INT64_MAX) {
+			vy_cache_add(&lsm->cache, entry, vy_entry_none(),
+				     entries[i], ITER_EQ);
+		}
+		if (entry.stmt != NULL)
+			vy_stmt_counter_acct_tuple(&lsm->stat.get, entry.stmt);
+		result[i] = entry.stmt;
+	}
+	if (rc != 0)
+		goto out;
+	double latency = ev_monotonic_now(loop()) - start_time;
+	if (latency > lsm->env->too_long_threshold) {
+		say_warn_ratelimited("%s: get_many(%u keys) took too long: "
+				     "%.3f sec", vy_lsm_name(lsm), key_count,
+				     latency);
+	}
+out:
+	for (i = 0; i < key_created; i++)
+		tuple_unref(entries[i].stmt);
+	region_truncate(region, region_svp);
+	return rc;
+}
+
 /**
  * Check if insertion of a new tuple violates unique constraint
  * of the primary index.
@@ -1735,8 +2152,11 @@ vy_delete(struct vy_env *env, struct vy_tx *tx, struct txn_stmt *stmt,
 	 * - if the space has on_replace triggers and need to pass
 	 *   to them the old tuple.
 	 * - if deletion is done by a secondary index.
+	 * - if the space has a covering index and so we can't
+	 *   defer deletion from secondary indexes.
 	 */
-	if (lsm->index_id > 0 || !rlist_empty(&space->on_replace)) {
+	if (lsm->index_id > 0 || !rlist_empty(&space->on_replace) ||
+	    vy_space_has_covering_index(space)) {
 		if (vy_get_by_raw_key(lsm, tx, vy_tx_read_view(tx),
 				      key, part_count, &stmt->old_tuple) != 0)
 			return -1;
@@ -1772,6 +2192,171 @@ vy_delete(struct vy_env *env, struct vy_tx *tx, struct txn_stmt *stmt,
 	return rc;
 }
 
+/**
+ * Replace statements of a transaction falling in a range deleted
+ * by the transaction with DELETEs. A range tombstone doesn't
+ * cover statements of the transaction that created it, because
+ * they are committed with the same LSN, so they have to be
+ * overwritten explicitly. This also removes them from secondary
+ * indexes.
+ */
+static int
+vy_delete_range_in_tx(struct vy_env *env, struct vy_tx *tx,
+		      struct space *space, struct vy_tombstone *tombstone)
+{
+	struct vy_lsm *pk = tombstone->lsm;
+	uint32_t count = 0;
+	struct txv *v;
+	struct write_set_iterator it;
+	write_set_ifirst(&tx->write_set, &it);
+	while ((v = write_set_inext(&it)) != NULL) {
+		if (v->lsm == pk &&
+		    vy_stmt_type(v->entry.stmt) != IPROTO_DELETE &&
+		    vy_tombstone_covers(tombstone, v->entry, pk->cmp_def))
+			count++;
+	}
+	if (count == 0)
+		return 0;
+	struct tuple **keys = malloc(count * sizeof(*keys));
+	if (keys == NULL) {
+		diag_set(OutOfMemory, count * sizeof(*keys),
+			 "malloc", "keys");
+		return -1;
+	}
+	uint32_t i = 0;
+	write_set_ifirst(&tx->write_set, &it);
+	while ((v = write_set_inext(&it)) != NULL) {
+		if (v->lsm == pk &&
+		    vy_stmt_type(v->entry.stmt) != IPROTO_DELETE &&
+		    vy_tombstone_covers(tombstone, v->entry, pk->cmp_def)) {
+			keys[i] = v->entry.stmt;
+			tuple_ref(keys[i++]);
+		}
+	}
+	assert(i == count);
+	int rc = 0;
+	for (i = 0; i < count && rc == 0; i++) {
+		struct tuple *tuple;
+		rc = vy_get(pk, tx, vy_tx_read_view(tx), keys[i], &tuple);
+		if (rc != 0 || tuple == NULL)
+			continue;
+		struct tuple *delete = vy_stmt_new_surrogate_delete(
+						pk->mem_format, tuple);
+		tuple_unref(tuple);
+		if (delete == NULL) {
+			rc = -1;
+			break;
+		}
+		for (uint32_t j = 0; j < space->index_count; j++) {
+			struct vy_lsm *lsm = vy_lsm(space->index[j]);
+			if (vy_is_committed(env, lsm))
+				continue;
+			rc = vy_tx_set(tx, lsm, delete);
+			if (rc != 0)
+				break;
+		}
+		tuple_unref(delete);
+	}
+	for (i = 0; i < count; i++)
+		tuple_unref(keys[i]);
+	free(keys);
+	return rc;
+}
+
+/**
+ * Delete all tuples falling in a range one by one, inserting
+ * a DELETE statement for each of them into all indexes.
+ */
+static int
+vy_delete_range_by_tuple(struct vy_env *env, struct vy_tx *tx,
+			 struct space *space, struct request *request)
+{
+	struct vy_lsm *pk = vy_lsm(space->index[0]);
+	struct tuple **tuples;
+	uint32_t count;
+	if (index_collect_range(&pk->base, request->key, request->tuple,
+				&tuples, &count) != 0)
+		return -1;
+	int rc = 0;
+	for (uint32_t i = 0; i < count && rc == 0; i++) {
+		struct tuple *delete;
+		delete = vy_stmt_new_surrogate_delete(pk->mem_format,
+						      tuples[i]);
+		if (delete == NULL) {
+			rc = -1;
+			break;
+		}
+		for (uint32_t j = 0; j < space->index_count; j++) {
+			struct vy_lsm *lsm = vy_lsm(space->index[j]);
+			if (vy_is_committed(env, lsm))
+				continue;
+			rc = vy_tx_set(tx, lsm, delete);
+			if (rc != 0)
+				break;
+		}
+		tuple_unref(delete);
+	}
+	for (uint32_t i = 0; i < count; i++)
+		tuple_unref(tuples[i]);
+	free(tuples);
+	return rc;
+}
+
+/**
+ * Execute DELETE_RANGE in a vinyl space.
+ *
+ * The range is deleted by a range tombstone written to the
+ * primary index, see struct vy_tombstone, so the cost of the
+ * operation doesn't depend on the number of deleted tuples.
+ * Secondary indexes are cleaned up by deferred DELETEs generated
+ * when the primary index is compacted.
+ *
+ * Deferred DELETEs can't be used if the space has a covering
+ * secondary index, because a tuple read from such an index isn't
+ * looked up in the primary index. In this case we look up all
+ * tuples falling in the range and insert a DELETE statement for
+ * each of them into all indexes.
+ *
+ * @param env     Vinyl environment.
+ * @param tx      Current transaction.
+ * @param space   Space to delete tuples from.
+ * @param request Request with the range boundaries.
+ *
+ * @retval  0 Success
+ * @retval -1 Memory error OR read error.
+ */
+static int
+vy_delete_range(struct vy_env *env, struct vy_tx *tx,
+		struct space *space, struct request *request)
+{
+	struct vy_lsm *pk = vy_lsm_find(space, 0);
+	if (pk == NULL)
+		return -1;
+	if (vy_is_committed(env, pk))
+		return 0;
+	if (vy_space_has_covering_index(space))
+		return vy_delete_range_by_tuple(env, tx, space, request);
+	if (env->status == VINYL_FINAL_RECOVERY_LOCAL) {
+		/*
+		 * The tombstone may have been logged to vylog
+		 * before the restart, in which case it has already
+		 * been loaded by vy_lsm_recover().
+		 */
+		int64_t lsn = vclock_sum(env->recovery_vclock);
+		struct vy_tombstone *tombstone;
+		rlist_foreach_entry(tombstone, &pk->tombstones, in_lsm) {
+			if (tombstone->lsn == lsn)
+				return 0;
+		}
+	}
+	if (vy_tx_delete_range(tx, pk, vy_log_next_id(),
+			       request->key, request->tuple) != 0)
+		return -1;
+	struct vy_tombstone *tombstone = rlist_last_entry(&tx->tombstones,
+					struct vy_tombstone, in_tx);
+	return vy_delete_range_in_tx(env, tx, space, tombstone);
+}
+
 /**
  * We do not allow changes of the primary key during update.
  *
@@ -1822,7 +2407,14 @@ vy_perform_update(struct vy_env *env, struct vy_tx *tx, struct txn_stmt *stmt,
 			       column_mask) != 0)
 		return -1;
 
-	vy_stmt_set_flags(stmt->new_tuple, VY_STMT_UPDATE);
+	/*
+	 * REPLACE generated by UPDATE may be turned into INSERT
+	 * in secondary indexes, because DELETE + REPLACE for the
+	 * same key is optimized out, see vy_tx_set_entry(). This
+	 * isn't true for covering indexes.
+	 */
+	if (!vy_space_has_covering_index(space))
+		vy_stmt_set_flags(stmt->new_tuple, VY_STMT_UPDATE);
 
 	if (vy_tx_set(tx, pk, stmt->new_tuple) != 0)
 		return -1;
@@ -2257,9 +2849,12 @@ vy_replace(struct vy_env *env, struct vy_tx *tx, struct txn_stmt *stmt,
 	/*
 	 * Get the overwritten tuple from the primary index if
 	 * the space has on_replace triggers, in which case we
-	 * need to pass the old tuple to trigger callbacks.
+	 * need to pass the old tuple to trigger callbacks, or
+	 * a covering index, which must not lag behind the
+	 * primary index.
 	 */
-	if (!rlist_empty(&space->on_replace)) {
+	if (!rlist_empty(&space->on_replace) ||
+	    vy_space_has_covering_index(space)) {
 		if (vy_get(pk, tx, vy_tx_read_view(tx),
 			   stmt->new_tuple, &stmt->old_tuple) != 0)
 			return -1;
@@ -2370,6 +2965,15 @@ vinyl_space_execute_upsert(struct space *space, struct txn *txn,
 	return vy_upsert(env, tx, stmt, space, request);
 }
 
+static int
+vinyl_space_execute_delete_range(struct space *space, struct txn *txn,
+				 struct request *request)
+{
+	struct vy_env *env = vy_env(space->engine);
+	struct vy_tx *tx = txn->engine_tx;
+	return vy_delete_range(env, tx, space, request);
+}
+
 static int
 vinyl_engine_begin(struct engine *engine, struct txn *txn)
 {
@@ -2388,7 +2992,7 @@ vinyl_engine_prepare(struct engine *engine, struct txn *txn)
 	struct vy_tx *tx = txn->engine_tx;
 	assert(tx != NULL);
 
-	if (tx->write_size > 0 &&
+	if ((tx->write_size > 0 || !rlist_empty(&tx->tombstones)) &&
 	    vinyl_check_wal(env, "DML") != 0)
 		return -1;
 
@@ -2429,6 +3033,25 @@ vinyl_engine_commit(struct engine *engine, struct txn *txn)
 	struct vy_tx *tx = txn->engine_tx;
 	assert(tx != NULL);
 
+	/*
+	 * Range tombstones aren't stored in runs so we persist
+	 * them in the metadata log. A tombstone that failed to be
+	 * logged is recreated on WAL replay, see vy_delete_range().
+	 */
+	if (!rlist_empty(&tx->tombstones)) {
+		vy_log_tx_begin();
+		struct vy_tombstone *t;
+		rlist_foreach_entry(t, &tx->tombstones, in_tx) {
+			vy_log_insert_tombstone(t->lsm->id, t->id,
+				txn->signature,
+				t->begin.stmt != NULL ?
+				tuple_data(t->begin.stmt) : NULL,
+				t->end.stmt != NULL ?
+				tuple_data(t->end.stmt) : NULL);
+		}
+		vy_log_tx_try_commit();
+	}
+
 	/*
 	 * vy_tx_commit() may trigger an upsert squash.
 	 * If there is no memory for a created statement,
@@ -2518,6 +3141,14 @@ vy_env_trigger_dump_cb(struct vy_regulator *regulator)
 	return 0;
 }
 
+static void
+vy_env_set_compaction_rate_limit_cb(struct vy_regulator *regulator,
+				    size_t limit)
+{
+	struct vy_env *env = container_of(regulator, struct vy_env, regulator);
+	pm_atomic_store(&env->scheduler.compaction_rate_limit, limit);
+}
+
 static void
 vy_env_dump_complete_cb(struct vy_scheduler *scheduler,
 			int64_t dump_generation, double dump_duration)
@@ -2594,7 +3225,9 @@ vy_env_new(const char *path, size_t memory,
 
 	vy_quota_create(&e->quota, memory, vy_env_quota_exceeded_cb);
 	vy_regulator_create(&e->regulator, &e->quota,
-			    vy_env_trigger_dump_cb);
+			    vy_env_trigger_dump_cb,
+			    vy_env_set_compaction_rate_limit_cb,
+			    &e->run_env.read_latency);
 
 	struct slab_cache *slab_cache = cord_slab_cache();
 	mempool_create(&e->iterator_pool, slab_cache,
@@ -2679,6 +3312,20 @@ vinyl_engine_set_cache(struct engine *engine, size_t quota)
 	vy_cache_env_set_quota(&env->cache_env, quota);
 }
 
+void
+vinyl_engine_set_page_cache(struct engine *engine, size_t quota)
+{
+	struct vy_env *env = vy_env(engine);
+	vy_run_env_set_page_cache_quota(&env->run_env, quota);
+}
+
+void
+vinyl_engine_set_read_latency_slo(struct engine *engine, double slo)
+{
+	struct vy_env *env = vy_env(engine);
+	vy_regulator_set_read_latency_slo(&env->regulator, slo);
+}
+
 int
 vinyl_engine_set_memory(struct engine *engine, size_t size)
 {
@@ -2915,47 +3562,126 @@ vinyl_engine_end_recovery(struct engine *engine)
 
 /** {{{ Replication */
 
+/**
+ * A chunk of a vinyl space sent to a joining replica.
+ * Big spaces are split into several chunks along range
+ * boundaries so that they can be read in parallel.
+ */
 struct vy_join_entry {
 	struct rlist in_ctx;
 	uint32_t space_id;
-	struct snapshot_iterator *iterator;
+	/** Primary index of the space. */
+	struct vy_lsm *lsm;
+	/** Read view to send the chunk from. */
+	struct vy_read_view *rv;
+	/** Chunk lower bound (inclusive), NULL if leftmost. */
+	struct vy_entry begin;
+	/** Chunk upper bound (exclusive), NULL if rightmost. */
+	struct vy_entry end;
 };
 
 struct vy_join_ctx {
 	struct rlist entries;
+	struct xstream *stream;
+	/**
+	 * Link of the next entry to be sent, or the list head
+	 * if all entries have been taken by join fibers.
+	 */
+	struct rlist *next;
+	/** Serializes writes to the stream among join fibers. */
+	struct latch latch;
+	/** Set if a join fiber failed. Tells others to stop. */
+	bool is_aborted;
 };
 
+static void
+vy_join_entry_delete(struct vy_env *env, struct vy_join_entry *entry)
+{
+	if (entry->begin.stmt != NULL)
+		tuple_unref(entry->begin.stmt);
+	if (entry->end.stmt != NULL)
+		tuple_unref(entry->end.stmt);
+	tx_manager_destroy_read_view(env->xm, entry->rv);
+	vy_lsm_unref(entry->lsm);
+	free(entry);
+}
+
 static int
-vy_join_add_space(struct space *space, void *arg)
+vy_join_add_entry(struct vy_join_ctx *ctx, struct vy_env *env,
+		  struct vy_lsm *lsm, struct vy_entry begin,
+		  struct vy_entry end)
 {
-	struct vy_join_ctx *ctx = arg;
-	if (!space_is_vinyl(space))
-		return 0;
-	if (space_group_id(space) == GROUP_LOCAL)
-		return 0;
-	struct index *pk = space_index(space, 0);
-	if (pk == NULL)
-		return 0;
 	struct vy_join_entry *entry = malloc(sizeof(*entry));
 	if (entry == NULL) {
 		diag_set(OutOfMemory, sizeof(*entry),
 			 "malloc", "struct vy_join_entry");
 		return -1;
 	}
-	entry->space_id = space_id(space);
-	entry->iterator = index_create_snapshot_iterator(pk);
-	if (entry->iterator == NULL) {
+	/*
+	 * All read views are created at once, without yielding,
+	 * so the chunks are consistent with each other.
+	 */
+	entry->rv = tx_manager_read_view(env->xm);
+	if (entry->rv == NULL) {
 		free(entry);
 		return -1;
 	}
+	entry->space_id = lsm->space_id;
+	entry->begin = begin;
+	if (begin.stmt != NULL)
+		tuple_ref(begin.stmt);
+	entry->end = end;
+	if (end.stmt != NULL)
+		tuple_ref(end.stmt);
+	/*
+	 * The index may be dropped while we are reading it.
+	 * The join must go on as if nothing happened.
+	 */
+	entry->lsm = lsm;
+	vy_lsm_ref(lsm);
 	rlist_add_tail_entry(&ctx->entries, entry, in_ctx);
 	return 0;
 }
 
+static int
+vy_join_add_space(struct space *space, void *arg)
+{
+	struct vy_join_ctx *ctx = arg;
+	if (!space_is_vinyl(space))
+		return 0;
+	if (space_group_id(space) == GROUP_LOCAL)
+		return 0;
+	struct index *pk = space_index(space, 0);
+	if (pk == NULL)
+		return 0;
+	struct vy_env *env = vy_env(space->engine);
+	struct vy_lsm *lsm = vy_lsm(pk);
+	/*
+	 * Split the space into as many chunks as there are
+	 * join workers, uniting adjacent ranges.
+	 */
+	int chunk_count = MIN(lsm->range_count, replication_join_workers);
+	int ranges_per_chunk = DIV_ROUND_UP(lsm->range_count, chunk_count);
+	struct vy_range *range = vy_range_tree_first(&lsm->range_tree);
+	while (range != NULL) {
+		struct vy_entry begin = range->begin;
+		for (int i = 1; i < ranges_per_chunk; i++) {
+			struct vy_range *next = vy_range_tree_next(
+					&lsm->range_tree, range);
+			if (next == NULL)
+				break;
+			range = next;
+		}
+		if (vy_join_add_entry(ctx, env, lsm, begin, range->end) != 0)
+			return -1;
+		range = vy_range_tree_next(&lsm->range_tree, range);
+	}
+	return 0;
+}
+
 static int
 vinyl_engine_prepare_join(struct engine *engine, void **arg)
 {
-	(void)engine;
 	struct vy_join_ctx *ctx = malloc(sizeof(*ctx));
 	if (ctx == NULL) {
 		diag_set(OutOfMemory, sizeof(*ctx),
@@ -2964,9 +3690,13 @@ vinyl_engine_prepare_join(struct engine *engine, void **arg)
 	}
 	rlist_create(&ctx->entries);
 	if (space_foreach(vy_join_add_space, ctx) != 0) {
+		struct vy_join_entry *entry, *next;
+		rlist_foreach_entry_safe(entry, &ctx->entries, in_ctx, next)
+			vy_join_entry_delete(vy_env(engine), entry);
 		free(ctx);
 		return -1;
 	}
+	latch_create(&ctx->latch);
 	*arg = ctx;
 	return 0;
 }
@@ -2992,40 +3722,100 @@ vy_join_send_tuple(struct xstream *stream, uint32_t space_id,
 }
 
 static int
-vinyl_engine_join(struct engine *engine, void *arg, struct xstream *stream)
+vy_join_send_entry(struct vy_join_ctx *ctx, struct vy_join_entry *entry)
 {
-	(void)engine;
-	int loops = 0;
-	struct vy_join_ctx *ctx = arg;
-	struct vy_join_entry *entry;
-	rlist_foreach_entry(entry, &ctx->entries, in_ctx) {
-		struct snapshot_iterator *it = entry->iterator;
-		int rc;
+	struct vy_lsm *lsm = entry->lsm;
+	struct vy_entry key = entry->begin.stmt != NULL ?
+			      entry->begin : lsm->env->empty_key;
+	struct vy_read_iterator itr;
+	vy_read_iterator_open(&itr, lsm, NULL, ITER_GE, key,
+			      (const struct vy_read_view **)&entry->rv);
+	int rc;
+	struct vy_entry stmt;
+	while ((rc = vy_read_iterator_next(&itr, &stmt)) == 0 &&
+	       stmt.stmt != NULL && !ctx->is_aborted) {
+		if (entry->end.stmt != NULL &&
+		    vy_entry_compare(stmt, entry->end, lsm->cmp_def) >= 0)
+			break;
 		uint32_t size;
-		const char *data;
-		while ((rc = it->next(it, &data, &size)) == 0 && data != NULL) {
-			if (vy_join_send_tuple(stream, entry->space_id,
-					       data, size) != 0)
-				return -1;
-		}
+		const char *data = tuple_data_range(stmt.stmt, &size);
+		/*
+		 * The stream may yield on write, while other
+		 * fibers go on reading their chunks.
+		 */
+		latch_lock(&ctx->latch);
+		rc = vy_join_send_tuple(ctx->stream, entry->space_id,
+					data, size);
+		latch_unlock(&ctx->latch);
 		if (rc != 0)
+			break;
+	}
+	vy_read_iterator_close(&itr);
+	return rc;
+}
+
+static int
+vy_join_f(va_list ap)
+{
+	struct vy_join_ctx *ctx = va_arg(ap, struct vy_join_ctx *);
+	int loops = 0;
+	while (!ctx->is_aborted && ctx->next != &ctx->entries) {
+		struct vy_join_entry *entry = rlist_entry(ctx->next,
+					struct vy_join_entry, in_ctx);
+		ctx->next = ctx->next->next;
+		if (vy_join_send_entry(ctx, entry) != 0) {
+			ctx->is_aborted = true;
 			return -1;
+		}
 		if (++loops % VY_YIELD_LOOPS == 0)
 			fiber_sleep(0);
 	}
 	return 0;
 }
 
+static int
+vinyl_engine_join(struct engine *engine, void *arg, struct xstream *stream)
+{
+	(void)engine;
+	struct vy_join_ctx *ctx = arg;
+	ctx->stream = stream;
+	ctx->next = rlist_first(&ctx->entries);
+	ctx->is_aborted = false;
+	/*
+	 * Reading a vinyl space mostly boils down to waiting for
+	 * disk reads, so send several chunks at once from
+	 * different fibers to keep reader threads busy.
+	 */
+	struct fiber *workers[REPLICATION_JOIN_WORKERS_MAX];
+	int worker_count;
+	int rc = 0;
+	for (worker_count = 0; worker_count < replication_join_workers;
+	     worker_count++) {
+		struct fiber *f = fiber_new("vinyl.join", vy_join_f);
+		if (f == NULL) {
+			ctx->is_aborted = true;
+			rc = -1;
+			break;
+		}
+		fiber_set_joinable(f, true);
+		fiber_start(f, ctx);
+		workers[worker_count] = f;
+	}
+	for (int i = 0; i < worker_count; i++) {
+		if (fiber_join(workers[i]) != 0)
+			rc = -1;
+	}
+	return rc;
+}
+
 static void
 vinyl_engine_complete_join(struct engine *engine, void *arg)
 {
-	(void)engine;
 	struct vy_join_ctx *ctx = arg;
 	struct vy_join_entry *entry, *next;
-	rlist_foreach_entry_safe(entry, &ctx->entries, in_ctx, next) {
-		entry->iterator->free(entry->iterator);
-		free(entry);
-	}
+	rlist_foreach_entry_safe(entry, &ctx->entries, in_ctx, next)
+		vy_join_entry_delete(vy_env(engine), entry);
+	latch_destroy(&ctx->latch);
 	free(ctx);
 }
 
@@ -3042,8 +3832,34 @@ vinyl_engine_complete_join(struct engine *engine, void *arg)
 static void
 vy_gc_run(struct vy_env *env,
 	  struct vy_lsm_recovery_info *lsm_info,
-	  struct vy_run_recovery_info *run_info)
+	  struct vy_run_recovery_info *run_info,
+	  struct mh_i64ptr_t *live_blobs)
 {
+	/*
+	 * Delete blob files that are referenced only by garbage
+	 * runs. The blob file of an incomplete run may have been
+	 * written, but it isn't recorded in the log.
+	 */
+	if (run_info->is_incomplete &&
+	    vy_run_remove_blob_file(env->path, lsm_info->space_id,
+				    lsm_info->index_id, run_info->id) != 0)
+		return;
+	if (run_info->blobs != NULL) {
+		const char *data = run_info->blobs;
+		uint32_t count = mp_decode_array(&data);
+		for (uint32_t i = 0; i < count; i++) {
+			int64_t blob_id = vy_run_blob_decode_id(&data);
+			if (mh_i64ptr_find(live_blobs, blob_id,
+					   NULL) != mh_end(live_blobs))
+				continue;
+			if (vy_run_remove_blob_file(env->path,
+						    lsm_info->space_id,
+						    lsm_info->index_id,
+						    blob_id) != 0)
+				return;
+		}
+	}
+
 	/* Try to delete files. */
 	if (vy_run_remove_files(env->path, lsm_info->space_id,
 				lsm_info->index_id, run_info->id) != 0)
@@ -3084,6 +3900,9 @@ vy_gc_lsm(struct vy_lsm_recovery_info *lsm_info)
 			vy_log_delete_slice(slice_info->id);
 		vy_log_delete_range(range_info->id);
 	}
+	struct vy_tombstone_recovery_info *tombstone_info;
+	rlist_foreach_entry(tombstone_info, &lsm_info->tombstones, in_lsm)
+		vy_log_delete_tombstone(tombstone_info->id);
 	struct vy_run_recovery_info *run_info;
 	rlist_foreach_entry(run_info, &lsm_info->runs, in_lsm) {
 		if (lsm_info->create_lsn < 0)
@@ -3100,6 +3919,53 @@ vy_gc_lsm(struct vy_lsm_recovery_info *lsm_info)
 	vy_log_tx_try_commit();
 }
 
+/**
+ * Return true if the given run may be deleted by garbage
+ * collection, see vy_gc().
+ */
+static bool
+vy_gc_run_is_garbage(struct vy_run_recovery_info *run_info,
+		     unsigned int gc_mask, int64_t gc_lsn)
+{
+	return (run_info->is_dropped && run_info->gc_lsn < gc_lsn &&
+		(gc_mask & VY_GC_DROPPED) != 0) ||
+	       (run_info->is_incomplete &&
+		(gc_mask & VY_GC_INCOMPLETE) != 0);
+}
+
+/**
+ * Return a hash of IDs of blob files referenced by runs of
+ * the given LSM tree that will be left after garbage collection.
+ * Returns NULL on memory allocation error.
+ */
+static struct mh_i64ptr_t *
+vy_gc_live_blobs(struct vy_lsm_recovery_info *lsm_info,
+		 unsigned int gc_mask, int64_t gc_lsn)
+{
+	struct mh_i64ptr_t *live_blobs = mh_i64ptr_new();
+	if (live_blobs == NULL)
+		return NULL;
+	struct vy_run_recovery_info *run_info;
+	rlist_foreach_entry(run_info, &lsm_info->runs, in_lsm) {
+		if (run_info->blobs == NULL ||
+		    vy_gc_run_is_garbage(run_info, gc_mask, gc_lsn))
+			continue;
+		const char *data = run_info->blobs;
+		uint32_t count = mp_decode_array(&data);
+		for (uint32_t i = 0; i < count; i++) {
+			struct mh_i64ptr_node_t node;
+			node.key = vy_run_blob_decode_id(&data);
+			node.val = NULL;
+			if (mh_i64ptr_put(live_blobs, &node, NULL,
+					  NULL) == mh_end(live_blobs)) {
+				mh_i64ptr_delete(live_blobs);
+				return NULL;
+			}
+		}
+	}
+	return live_blobs;
+}
+
 /**
  * Delete unused run files stored in the recovery context.
  * @param env      Vinyl environment.
@@ -3120,18 +3986,22 @@ vy_gc(struct vy_env *env, struct vy_recovery *recovery,
 		     (gc_mask & VY_GC_INCOMPLETE) != 0))
 			vy_gc_lsm(lsm_info);
 
+		struct mh_i64ptr_t *live_blobs;
+		live_blobs = vy_gc_live_blobs(lsm_info, gc_mask, gc_lsn);
+		if (live_blobs == NULL) {
+			/* Retry next time garbage collection is invoked. */
+			say_error("failed to collect garbage for %lld: "
+				  "out of memory", (long long)lsm_info->id);
+			continue;
+		}
 		struct vy_run_recovery_info *run_info;
 		rlist_foreach_entry(run_info, &lsm_info->runs, in_lsm) {
-			if ((run_info->is_dropped &&
-			     run_info->gc_lsn < gc_lsn &&
-			     (gc_mask & VY_GC_DROPPED) != 0) ||
-			    (run_info->is_incomplete &&
-			     (gc_mask & VY_GC_INCOMPLETE) != 0)) {
-				vy_gc_run(env, lsm_info, run_info);
-			}
+			if (vy_gc_run_is_garbage(run_info, gc_mask, gc_lsn))
+				vy_gc_run(env, lsm_info, run_info, live_blobs);
 			if (loops % VY_YIELD_LOOPS == 0)
 				fiber_sleep(0);
 		}
+		mh_i64ptr_delete(live_blobs);
 	}
 }
 
@@ -3180,12 +4050,20 @@ vinyl_engine_backup(struct engine *engine, const struct vclock *vclock,
 	}
 	int rc = 0;
 	int loops = 0;
+	/* IDs of blob files that have already been backed up. */
+	struct mh_i64ptr_t *blobs = mh_i64ptr_new();
+	if (blobs == NULL) {
+		diag_set(OutOfMemory, 0, "mh_i64ptr_new", "blobs");
+		vy_recovery_delete(recovery);
+		return -1;
+	}
 	struct vy_lsm_recovery_info *lsm_info;
 	rlist_foreach_entry(lsm_info, &recovery->lsms, in_recovery) {
 		if (lsm_info->drop_lsn >= 0 || lsm_info->create_lsn < 0) {
 			/* Dropped or not yet built LSM tree. */
 			continue;
 		}
+		mh_i64ptr_clear(blobs);
 		struct vy_run_recovery_info *run_info;
 		rlist_foreach_entry(run_info, &lsm_info->runs, in_lsm) {
 			if (run_info->is_dropped || run_info->is_incomplete)
@@ -3193,7 +4071,8 @@ vinyl_engine_backup(struct engine *engine, const struct vclock *vclock,
 			char path[PATH_MAX];
 			for (int type = 0; type < vy_file_MAX; type++) {
 				if (type == VY_FILE_RUN_INPROGRESS ||
-				    type == VY_FILE_INDEX_INPROGRESS)
+				    type == VY_FILE_INDEX_INPROGRESS ||
+				    type == VY_FILE_BLOB)
 					continue;
 				vy_run_snprint_path(path, sizeof(path),
 						    env->path,
@@ -3204,11 +4083,38 @@ vinyl_engine_backup(struct engine *engine, const struct vclock *vclock,
 				if (rc != 0)
 					goto out;
 			}
+			const char *data = run_info->blobs;
+			uint32_t count = data != NULL ?
+					 mp_decode_array(&data) : 0;
+			for (uint32_t i = 0; i < count; i++) {
+				struct mh_i64ptr_node_t node;
+				node.key = vy_run_blob_decode_id(&data);
+				node.val = NULL;
+				if (mh_i64ptr_find(blobs, node.key,
+						   NULL) != mh_end(blobs))
+					continue;
+				if (mh_i64ptr_put(blobs, &node, NULL,
+						  NULL) == mh_end(blobs)) {
+					diag_set(OutOfMemory, 0,
+						 "mh_i64ptr_put", "blobs");
+					rc = -1;
+					goto out;
+				}
+				vy_run_snprint_path(path, sizeof(path),
+						    env->path,
+						    lsm_info->space_id,
+						    lsm_info->index_id,
+						    node.key, VY_FILE_BLOB);
+				rc = cb(path, cb_arg);
+				if (rc != 0)
+					goto out;
+			}
 			if (loops % VY_YIELD_LOOPS == 0)
 				fiber_sleep(0);
 		}
 	}
 out:
+	mh_i64ptr_delete(blobs);
 	vy_recovery_delete(recovery);
 	return rc;
 }
@@ -3541,6 +4447,8 @@ vinyl_iterator_primary_next(struct iterator *base, struct tuple **ret)
 	if (vinyl_iterator_check_tx(it) != 0)
 		goto fail;
 
+	/* The hint is set by the caller after creation. */
+	it->iterator.skip_cache = base->skip_cache;
 	struct vy_entry entry;
 	if (vy_read_iterator_next(&it->iterator, &entry) != 0)
 		goto fail;
@@ -3576,6 +4484,8 @@ vinyl_iterator_secondary_next(struct iterator *base, struct tuple **ret)
 	 */
 	vy_lsm_ref(lsm);
 
+	/* The hint is set by the caller after creation. */
+	it->iterator.skip_cache = base->skip_cache;
 	struct vy_entry partial, entry;
 next:
 	if (vinyl_iterator_check_tx(it) != 0)
@@ -3595,7 +4505,8 @@ next:
 	ERROR_INJECT_YIELD(ERRINJ_VY_DELAY_PK_LOOKUP);
 	/* Get the full tuple from the primary index. */
 	if (vy_get_by_secondary_tuple(lsm, it->tx, vy_tx_read_view(it->tx),
-				      partial, &entry) != 0)
+				      partial, it->iterator.skip_cache,
+				      &entry) != 0)
 		goto fail;
 	if (entry.stmt == NULL)
 		goto next;
@@ -3777,6 +4688,33 @@ vinyl_index_get(struct index *index, const char *key,
 	return 0;
 }
 
+static int
+vinyl_index_get_many(struct index *index, const char **keys,
+		     uint32_t key_count, struct tuple **result)
+{
+	assert(index->def->opts.is_unique);
+
+	struct vy_lsm *lsm = vy_lsm(index);
+	struct vy_env *env = vy_env(index->engine);
+	struct vy_tx *tx = in_txn() ? in_txn()->engine_tx : NULL;
+	const struct vy_read_view **rv = (tx != NULL ? vy_tx_read_view(tx) :
+					  &env->xm->p_global_read_view);
+
+	if (tx != NULL && tx->state == VINYL_TX_ABORT) {
+		diag_set(ClientError, ER_TRANSACTION_CONFLICT);
+		return -1;
+	}
+
+	/*
+	 * Make sure the LSM tree isn't deleted while we are
+	 * reading from it.
+	 */
+	vy_lsm_ref(lsm);
+	int rc = vy_get_many(lsm, tx, rv, keys, key_count, result);
+	vy_lsm_unref(lsm);
+	return rc;
+}
+
 /*** }}} Cursor */
 
 /* {{{ Index build */
@@ -4524,6 +5462,7 @@ static const struct space_vtab vinyl_space_vtab = {
 	/* .execute_delete = */ vinyl_space_execute_delete,
 	/* .execute_update = */ vinyl_space_execute_update,
 	/* .execute_upsert = */ vinyl_space_execute_upsert,
+	/* .execute_delete_range = */ vinyl_space_execute_delete_range,
 	/* .ephemeral_replace = */ generic_space_ephemeral_replace,
 	/* .ephemeral_delete = */ generic_space_ephemeral_delete,
 	/* .ephemeral_rowid_next = */ generic_space_ephemeral_rowid_next,
@@ -4557,6 +5496,7 @@ static const struct index_vtab vinyl_index_vtab = {
 	/* .random = */ generic_index_random,
 	/* .count = */ generic_index_count,
 	/* .get = */ vinyl_index_get,
+	/* .get_many = */ vinyl_index_get_many,
 	/* .replace = */ generic_index_replace,
 	/* .create_iterator = */ vinyl_index_create_iterator,
 	/* .create_snapshot_iterator = */
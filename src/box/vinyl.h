@@ -57,6 +57,18 @@ vinyl_engine_stat(struct engine *engine, struct info_handler *handler);
 void
 vinyl_engine_set_cache(struct engine *engine, size_t quota);
 
+/**
+ * Update vinyl page cache size.
+ */
+void
+vinyl_engine_set_page_cache(struct engine *engine, size_t quota);
+
+/**
+ * Update target disk read latency, in seconds.
+ */
+void
+vinyl_engine_set_read_latency_slo(struct engine *engine, double slo);
+
 /**
  * Update vinyl memory size.
  */
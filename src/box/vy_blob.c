@@ -0,0 +1,738 @@
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "vy_blob.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <msgpuck.h>
+#include <small/ibuf.h>
+#include <small/region.h>
+
+#include "assoc.h"
+#include "coio_file.h"
+#include "diag.h"
+#include "fiber.h"
+#include "fio.h"
+#include "say.h"
+#include "trivia/util.h"
+#include "tt_static.h"
+#include "tuple.h"
+#include "vy_stmt.h"
+
+/** Max size of the payload of a blob reference. */
+static const uint32_t VY_BLOB_REF_PAYLOAD_MAX = 1 + 3 * 9;
+
+/**
+ * Blob writer buffer is flushed to disk when its size exceeds
+ * this value.
+ */
+enum { VY_BLOB_WRITE_BUF_SIZE = 1024 * 1024 };
+
+void
+vy_blob_unref(struct vy_blob *blob)
+{
+	assert(blob->refs > 0);
+	if (--blob->refs > 0)
+		return;
+	if (blob->hash != NULL) {
+		struct mh_i64ptr_t *h = blob->hash;
+		mh_int_t k = mh_i64ptr_find(h, blob->id, NULL);
+		assert(k != mh_end(h));
+		mh_i64ptr_del(h, k, NULL);
+	}
+	if (close(blob->fd) < 0)
+		say_syserror("close failed");
+	TRASH(blob);
+	free(blob);
+}
+
+struct vy_blob *
+vy_blob_hash_find(struct mh_i64ptr_t *hash, int64_t id)
+{
+	mh_int_t k = mh_i64ptr_find(hash, id, NULL);
+	if (k == mh_end(hash))
+		return NULL;
+	return mh_i64ptr_node(hash, k)->val;
+}
+
+struct vy_blob *
+vy_blob_hash_open(struct mh_i64ptr_t *hash, int64_t id, const char *path)
+{
+	struct vy_blob *blob = vy_blob_hash_find(hash, id);
+	if (blob != NULL) {
+		vy_blob_ref(blob);
+		return blob;
+	}
+	blob = malloc(sizeof(*blob));
+	if (blob == NULL) {
+		diag_set(OutOfMemory, sizeof(*blob), "malloc",
+			 "struct vy_blob");
+		return NULL;
+	}
+	blob->fd = open(path, O_RDONLY);
+	if (blob->fd < 0) {
+		diag_set(SystemError, "failed to open '%s' file", path);
+		goto fail;
+	}
+	struct stat st;
+	if (fstat(blob->fd, &st) < 0) {
+		diag_set(SystemError, "failed to stat '%s' file", path);
+		goto fail_close;
+	}
+	struct mh_i64ptr_node_t node = { id, blob };
+	if (mh_i64ptr_put(hash, &node, NULL, NULL) == mh_end(hash)) {
+		diag_set(OutOfMemory, 0, "mh_i64ptr_put", "mh_i64ptr_node_t");
+		goto fail_close;
+	}
+	blob->id = id;
+	blob->refs = 1;
+	blob->size = st.st_size;
+	blob->live_bytes = 0;
+	blob->hash = hash;
+	return blob;
+fail_close:
+	close(blob->fd);
+fail:
+	free(blob);
+	return NULL;
+}
+
+void
+vy_blob_hash_delete(struct mh_i64ptr_t *hash)
+{
+	mh_int_t k;
+	mh_foreach(hash, k) {
+		struct vy_blob *blob = mh_i64ptr_node(hash, k)->val;
+		blob->hash = NULL;
+	}
+	mh_i64ptr_delete(hash);
+}
+
+/** Return true if the given MsgPack field is a blob reference. */
+static inline bool
+vy_blob_is_ref(const char *data)
+{
+	if (mp_typeof(*data) != MP_EXT)
+		return false;
+	int8_t type;
+	mp_decode_extl(&data, &type);
+	return type == MP_VY_BLOB;
+}
+
+/** Decode a blob reference. */
+static void
+vy_blob_ref_decode(const char **data, int64_t *blob_id,
+		   uint64_t *offset, uint64_t *size)
+{
+	int8_t type;
+	mp_decode_extl(data, &type);
+	assert(type == MP_VY_BLOB);
+	uint32_t len = mp_decode_array(data);
+	assert(len == 3);
+	(void)len;
+	*blob_id = mp_decode_uint(data);
+	*offset = mp_decode_uint(data);
+	*size = mp_decode_uint(data);
+}
+
+/** Encode a blob reference. */
+static char *
+vy_blob_ref_encode(char *data, int64_t blob_id, uint64_t offset,
+		   uint64_t size)
+{
+	uint32_t len = mp_sizeof_array(3) + mp_sizeof_uint(blob_id) +
+		       mp_sizeof_uint(offset) + mp_sizeof_uint(size);
+	assert(len <= VY_BLOB_REF_PAYLOAD_MAX);
+	data = mp_encode_extl(data, MP_VY_BLOB, len);
+	data = mp_encode_array(data, 3);
+	data = mp_encode_uint(data, blob_id);
+	data = mp_encode_uint(data, offset);
+	data = mp_encode_uint(data, size);
+	return data;
+}
+
+void
+vy_blob_stmt_extent(struct tuple *stmt, struct vy_blob_extent *extent)
+{
+	assert((vy_stmt_flags(stmt) & VY_STMT_BLOB) != 0);
+	assert(vy_stmt_type(stmt) == IPROTO_REPLACE ||
+	       vy_stmt_type(stmt) == IPROTO_INSERT);
+	uint64_t begin = UINT64_MAX;
+	uint64_t end = 0;
+	extent->blob_id = -1;
+	extent->field_no = UINT32_MAX;
+	const char *data = tuple_data(stmt);
+	uint32_t field_count = mp_decode_array(&data);
+	for (uint32_t i = 0; i < field_count; i++) {
+		if (!vy_blob_is_ref(data)) {
+			mp_next(&data);
+			continue;
+		}
+		int64_t blob_id;
+		uint64_t offset, size;
+		vy_blob_ref_decode(&data, &blob_id, &offset, &size);
+		/* All values of a statement are stored in one file. */
+		assert(extent->blob_id < 0 || extent->blob_id == blob_id);
+		extent->blob_id = blob_id;
+		extent->field_no = MIN(extent->field_no, i);
+		begin = MIN(begin, offset);
+		end = MAX(end, offset + size);
+	}
+	assert(extent->blob_id >= 0);
+	extent->offset = begin;
+	extent->size = end - begin;
+}
+
+/**
+ * Create a copy of a statement with blob references replaced
+ * with values stored in @a buf, which contains the extent of
+ * the blob file referenced by the statement.
+ */
+static struct tuple *
+vy_blob_stmt_restore(struct tuple *stmt, const struct vy_blob_extent *extent,
+		     const char *buf)
+{
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	uint32_t bsize;
+	const char *data = tuple_data_range(stmt, &bsize);
+	size_t size = bsize + extent->size;
+	char *new_data = region_alloc(region, size);
+	if (new_data == NULL) {
+		diag_set(OutOfMemory, size, "region", "tuple");
+		return NULL;
+	}
+	char *pos = new_data;
+	uint32_t field_count = mp_decode_array(&data);
+	pos = mp_encode_array(pos, field_count);
+	for (uint32_t i = 0; i < field_count; i++) {
+		const char *field = data;
+		if (!vy_blob_is_ref(data)) {
+			mp_next(&data);
+			memcpy(pos, field, data - field);
+			pos += data - field;
+			continue;
+		}
+		int64_t blob_id;
+		uint64_t offset, value_size;
+		vy_blob_ref_decode(&data, &blob_id, &offset, &value_size);
+		assert(offset >= extent->offset);
+		assert(offset + value_size <= extent->offset + extent->size);
+		memcpy(pos, buf + offset - extent->offset, value_size);
+		pos += value_size;
+	}
+	assert(pos <= new_data + size);
+	struct tuple *ret = NULL;
+	const char *check = new_data;
+	if (mp_check(&check, pos) != 0 || check != pos) {
+		diag_set(ClientError, ER_INVALID_RUN_FILE,
+			 tt_sprintf("Invalid value in blob file %lld",
+				    (long long)extent->blob_id));
+		goto out;
+	}
+	ret = vy_stmt_new_replace(tuple_format(stmt), new_data, pos);
+	if (ret == NULL)
+		goto out;
+	vy_stmt_set_type(ret, vy_stmt_type(stmt));
+	vy_stmt_set_lsn(ret, vy_stmt_lsn(stmt));
+	vy_stmt_set_flags(ret, vy_stmt_flags(stmt) & ~VY_STMT_BLOB);
+out:
+	region_truncate(region, region_svp);
+	return ret;
+}
+
+int
+vy_blob_load(struct vy_blob *blob, struct tuple *stmt, struct tuple **ret)
+{
+	struct vy_blob_extent extent;
+	vy_blob_stmt_extent(stmt, &extent);
+	assert(extent.blob_id == blob->id);
+
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	char *buf = region_alloc(region, extent.size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, extent.size, "region", "blob");
+		return -1;
+	}
+	/* Don't let the file be closed while we are reading it. */
+	vy_blob_ref(blob);
+	ssize_t rc = coio_preadn(blob->fd, buf, extent.size, extent.offset);
+	vy_blob_unref(blob);
+	if (rc < 0) {
+		diag_set(SystemError, "failed to read from blob file");
+		region_truncate(region, region_svp);
+		return -1;
+	}
+	*ret = vy_blob_stmt_restore(stmt, &extent, buf);
+	region_truncate(region, region_svp);
+	return *ret != NULL ? 0 : -1;
+}
+
+void
+vy_blob_map_destroy(struct vy_blob_map *map)
+{
+	for (int i = 0; i < map->count; i++)
+		vy_blob_unref(map->entries[i].blob);
+	free(map->entries);
+	map->entries = NULL;
+	map->count = 0;
+	map->capacity = 0;
+}
+
+/**
+ * Return the position of the first entry of a blob map with
+ * ID greater than or equal to the given one.
+ */
+static int
+vy_blob_map_lower_bound(struct vy_blob_map *map, int64_t id)
+{
+	int begin = 0, end = map->count;
+	while (begin < end) {
+		int mid = begin + (end - begin) / 2;
+		if (map->entries[mid].blob->id < id)
+			begin = mid + 1;
+		else
+			end = mid;
+	}
+	return begin;
+}
+
+struct vy_blob_map_entry *
+vy_blob_map_find(struct vy_blob_map *map, int64_t id)
+{
+	int i = vy_blob_map_lower_bound(map, id);
+	if (i < map->count && map->entries[i].blob->id == id)
+		return &map->entries[i];
+	return NULL;
+}
+
+int
+vy_blob_map_add(struct vy_blob_map *map, struct vy_blob *blob,
+		bool is_garbage)
+{
+	int i = vy_blob_map_lower_bound(map, blob->id);
+	if (i < map->count && map->entries[i].blob == blob)
+		return 0;
+	if (map->count == map->capacity) {
+		int capacity = MAX(map->capacity * 2, 8);
+		size_t size = capacity * sizeof(*map->entries);
+		struct vy_blob_map_entry *entries = realloc(map->entries,
+							    size);
+		if (entries == NULL) {
+			diag_set(OutOfMemory, size, "realloc",
+				 "struct vy_blob_map_entry");
+			return -1;
+		}
+		map->entries = entries;
+		map->capacity = capacity;
+	}
+	memmove(&map->entries[i + 1], &map->entries[i],
+		(map->count - i) * sizeof(*map->entries));
+	map->entries[i].blob = blob;
+	map->entries[i].is_garbage = is_garbage;
+	map->count++;
+	vy_blob_ref(blob);
+	return 0;
+}
+
+/**
+ * Read values referenced by a statement from a blob file stored
+ * in a map. Unlike vy_blob_load(), this function doesn't yield
+ * and so can be used in a worker thread.
+ */
+static int
+vy_blob_map_do_load(struct vy_blob *blob, struct tuple *stmt,
+		    const struct vy_blob_extent *extent, struct tuple **ret)
+{
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	char *buf = region_alloc(region, extent->size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, extent->size, "region", "blob");
+		return -1;
+	}
+	ssize_t rc = fio_pread(blob->fd, buf, extent->size, extent->offset);
+	if (rc < 0) {
+		diag_set(SystemError, "failed to read from blob file");
+		goto fail;
+	}
+	if ((uint64_t)rc != extent->size) {
+		diag_set(ClientError, ER_INVALID_RUN_FILE,
+			 "Unexpected end of blob file");
+		goto fail;
+	}
+	*ret = vy_blob_stmt_restore(stmt, extent, buf);
+	region_truncate(region, region_svp);
+	return *ret != NULL ? 0 : -1;
+fail:
+	region_truncate(region, region_svp);
+	return -1;
+}
+
+int
+vy_blob_map_load(struct vy_blob_map *map, struct tuple *stmt,
+		 bool keys_only, struct tuple **ret)
+{
+	*ret = stmt;
+	if ((vy_stmt_flags(stmt) & VY_STMT_BLOB) == 0)
+		return 0;
+	struct vy_blob_extent extent;
+	vy_blob_stmt_extent(stmt, &extent);
+	if (keys_only && extent.field_no >= map->index_field_count)
+		return 0;
+	struct vy_blob_map_entry *entry = vy_blob_map_find(map,
+							   extent.blob_id);
+	if (entry == NULL) {
+		diag_set(ClientError, ER_INVALID_RUN_FILE,
+			 tt_sprintf("Blob file %lld not found",
+				    (long long)extent.blob_id));
+		return -1;
+	}
+	return vy_blob_map_do_load(entry->blob, stmt, &extent, ret);
+}
+
+void
+vy_blob_writer_create(struct vy_blob_writer *writer, const char *path,
+		      int64_t id)
+{
+	memset(writer, 0, sizeof(*writer));
+	snprintf(writer->path, sizeof(writer->path), "%s", path);
+	writer->id = id;
+	writer->fd = -1;
+	ibuf_create(&writer->buf, &cord()->slabc, VY_BLOB_WRITE_BUF_SIZE);
+}
+
+/** Account a reference to a blob file in the writer. */
+static int
+vy_blob_writer_add_ref(struct vy_blob_writer *writer, int64_t id,
+		       uint64_t bytes)
+{
+	for (uint32_t i = 0; i < writer->ref_count; i++) {
+		if (writer->refs[i].id == id) {
+			writer->refs[i].bytes += bytes;
+			return 0;
+		}
+	}
+	if (writer->ref_count == writer->ref_capacity) {
+		uint32_t capacity = MAX(writer->ref_capacity * 2, 4);
+		size_t size = capacity * sizeof(*writer->refs);
+		struct vy_run_blob *refs = realloc(writer->refs, size);
+		if (refs == NULL) {
+			diag_set(OutOfMemory, size, "realloc",
+				 "struct vy_run_blob");
+			return -1;
+		}
+		writer->refs = refs;
+		writer->ref_capacity = capacity;
+	}
+	struct vy_run_blob *ref = &writer->refs[writer->ref_count++];
+	ref->id = id;
+	ref->bytes = bytes;
+	ref->blob = NULL;
+	return 0;
+}
+
+/** Write buffered values to the blob file. */
+static int
+vy_blob_writer_flush(struct vy_blob_writer *writer)
+{
+	size_t used = ibuf_used(&writer->buf);
+	if (used == 0)
+		return 0;
+	if (writer->fd < 0) {
+		writer->fd = open(writer->path, O_WRONLY | O_CREAT | O_TRUNC,
+				  0644);
+		if (writer->fd < 0) {
+			diag_set(SystemError, "failed to create file '%s'",
+				 writer->path);
+			return -1;
+		}
+		say_info("writing `%s'", writer->path);
+	}
+	if (fio_writen(writer->fd, writer->buf.rpos, used) != 0) {
+		diag_set(SystemError, "failed to write to file '%s'",
+			 writer->path);
+		return -1;
+	}
+	ibuf_reset(&writer->buf);
+	return 0;
+}
+
+/**
+ * Return true if the given field of a statement may be moved
+ * to a blob file.
+ */
+static inline bool
+vy_blob_writer_field_is_movable(struct vy_blob_writer *writer,
+				uint32_t field_no, const char *field,
+				const char *field_end)
+{
+	if (field_no < writer->index_field_count)
+		return false;
+	if (mp_typeof(*field) != MP_STR && mp_typeof(*field) != MP_BIN)
+		return false;
+	return field_end - field >= VY_BLOB_FIELD_SIZE_MIN;
+}
+
+/**
+ * Move values of a statement to the blob file if the statement
+ * is big enough.
+ */
+static int
+vy_blob_writer_separate(struct vy_blob_writer *writer, struct tuple *stmt,
+			struct tuple **ret)
+{
+	*ret = stmt;
+	enum iproto_type type = vy_stmt_type(stmt);
+	if (writer->threshold == 0 || stmt->bsize < writer->threshold ||
+	    (type != IPROTO_REPLACE && type != IPROTO_INSERT))
+		return 0;
+	uint32_t bsize;
+	const char *data = tuple_data_range(stmt, &bsize);
+	const char *pos = data;
+	uint32_t field_count = mp_decode_array(&pos);
+	uint32_t ref_count = 0;
+	for (uint32_t i = 0; i < field_count; i++) {
+		const char *field = pos;
+		mp_next(&pos);
+		/*
+		 * Blob references can't be told apart from user
+		 * data of the same MsgPack extension type so never
+		 * separate values of a tuple containing such data.
+		 */
+		if (vy_blob_is_ref(field))
+			return 0;
+		if (vy_blob_writer_field_is_movable(writer, i, field, pos))
+			ref_count++;
+	}
+	if (ref_count == 0)
+		return 0;
+
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	size_t size = bsize + ref_count *
+		      mp_sizeof_ext(VY_BLOB_REF_PAYLOAD_MAX);
+	char *new_data = region_alloc(region, size);
+	if (new_data == NULL) {
+		diag_set(OutOfMemory, size, "region", "tuple");
+		return -1;
+	}
+	char *new_pos = mp_encode_array(new_data, field_count);
+	uint64_t bytes = 0;
+	pos = data;
+	mp_decode_array(&pos);
+	for (uint32_t i = 0; i < field_count; i++) {
+		const char *field = pos;
+		mp_next(&pos);
+		size_t field_size = pos - field;
+		if (!vy_blob_writer_field_is_movable(writer, i, field, pos)) {
+			memcpy(new_pos, field, field_size);
+			new_pos += field_size;
+			continue;
+		}
+		char *buf = ibuf_alloc(&writer->buf, field_size);
+		if (buf == NULL) {
+			diag_set(OutOfMemory, field_size, "ibuf", "blob");
+			goto fail;
+		}
+		memcpy(buf, field, field_size);
+		new_pos = vy_blob_ref_encode(new_pos, writer->id,
+					     writer->size, field_size);
+		writer->size += field_size;
+		bytes += field_size;
+	}
+	assert(new_pos <= new_data + size);
+	struct tuple *new_stmt = vy_stmt_new_replace(tuple_format(stmt),
+						     new_data, new_pos);
+	if (new_stmt == NULL)
+		goto fail;
+	vy_stmt_set_type(new_stmt, type);
+	vy_stmt_set_lsn(new_stmt, vy_stmt_lsn(stmt));
+	vy_stmt_set_flags(new_stmt, vy_stmt_flags(stmt) | VY_STMT_BLOB);
+	if (vy_blob_writer_add_ref(writer, writer->id, bytes) != 0) {
+		tuple_unref(new_stmt);
+		goto fail;
+	}
+	region_truncate(region, region_svp);
+	if (ibuf_used(&writer->buf) >= VY_BLOB_WRITE_BUF_SIZE &&
+	    vy_blob_writer_flush(writer) != 0) {
+		tuple_unref(new_stmt);
+		return -1;
+	}
+	*ret = new_stmt;
+	return 0;
+fail:
+	region_truncate(region, region_svp);
+	return -1;
+}
+
+int
+vy_blob_writer_prepare(struct vy_blob_writer *writer, struct tuple *stmt,
+		       struct tuple **ret)
+{
+	*ret = stmt;
+	struct tuple *loaded = NULL;
+	if ((vy_stmt_flags(stmt) & VY_STMT_BLOB) != 0) {
+		struct vy_blob_extent extent;
+		vy_blob_stmt_extent(stmt, &extent);
+		struct vy_blob_map_entry *entry = NULL;
+		if (writer->map != NULL)
+			entry = vy_blob_map_find(writer->map, extent.blob_id);
+		if (entry == NULL || !entry->is_garbage) {
+			/* Carry the references over to the new run. */
+			return vy_blob_writer_add_ref(writer, extent.blob_id,
+						      extent.size);
+		}
+		/*
+		 * Most of the blob file is garbage. Load the values
+		 * so that they are written to the new blob file and
+		 * the old one can be deleted eventually.
+		 */
+		if (vy_blob_map_do_load(entry->blob, stmt, &extent,
+					&loaded) != 0)
+			return -1;
+		stmt = loaded;
+		*ret = loaded;
+	}
+	if (vy_blob_writer_separate(writer, stmt, ret) != 0) {
+		if (loaded != NULL)
+			tuple_unref(loaded);
+		return -1;
+	}
+	if (loaded != NULL && *ret != loaded)
+		tuple_unref(loaded);
+	return 0;
+}
+
+/** Close the blob file and free the writer buffers. */
+static void
+vy_blob_writer_destroy(struct vy_blob_writer *writer)
+{
+	if (writer->fd >= 0 && close(writer->fd) < 0)
+		say_syserror("close failed");
+	writer->fd = -1;
+	ibuf_destroy(&writer->buf);
+	free(writer->refs);
+	writer->refs = NULL;
+	writer->ref_count = 0;
+}
+
+int
+vy_blob_writer_commit(struct vy_blob_writer *writer,
+		      struct vy_run_blob **refs, uint32_t *ref_count)
+{
+	if (vy_blob_writer_flush(writer) != 0)
+		return -1;
+	if (writer->fd >= 0 && fsync(writer->fd) < 0) {
+		diag_set(SystemError, "failed to sync file '%s'",
+			 writer->path);
+		return -1;
+	}
+	*refs = writer->refs;
+	*ref_count = writer->ref_count;
+	writer->refs = NULL;
+	writer->ref_count = 0;
+	vy_blob_writer_destroy(writer);
+	return 0;
+}
+
+void
+vy_blob_writer_abort(struct vy_blob_writer *writer)
+{
+	bool created = writer->fd >= 0;
+	vy_blob_writer_destroy(writer);
+	if (created && unlink(writer->path) < 0 && errno != ENOENT)
+		say_syserror("failed to unlink file '%s'", writer->path);
+}
+
+const char *
+vy_run_blob_encode(const struct vy_run_blob *blobs, uint32_t count)
+{
+	size_t size = mp_sizeof_array(count);
+	for (uint32_t i = 0; i < count; i++) {
+		size += mp_sizeof_array(2);
+		size += mp_sizeof_uint(blobs[i].id);
+		size += mp_sizeof_uint(blobs[i].bytes);
+	}
+	char *data = region_alloc(&fiber()->gc, size);
+	if (data == NULL) {
+		diag_set(OutOfMemory, size, "region", "run blobs");
+		return NULL;
+	}
+	char *pos = mp_encode_array(data, count);
+	for (uint32_t i = 0; i < count; i++) {
+		pos = mp_encode_array(pos, 2);
+		pos = mp_encode_uint(pos, blobs[i].id);
+		pos = mp_encode_uint(pos, blobs[i].bytes);
+	}
+	assert(pos == data + size);
+	return data;
+}
+
+int
+vy_run_blob_decode(const char *data, struct vy_run_blob **blobs,
+		   uint32_t *count)
+{
+	uint32_t n = mp_decode_array(&data);
+	struct vy_run_blob *array = NULL;
+	if (n > 0) {
+		size_t size = n * sizeof(*array);
+		array = malloc(size);
+		if (array == NULL) {
+			diag_set(OutOfMemory, size, "malloc",
+				 "struct vy_run_blob");
+			return -1;
+		}
+	}
+	for (uint32_t i = 0; i < n; i++) {
+		uint32_t len = mp_decode_array(&data);
+		array[i].id = mp_decode_uint(&data);
+		array[i].bytes = mp_decode_uint(&data);
+		array[i].blob = NULL;
+		/* Skip fields added by future versions. */
+		for (uint32_t j = 2; j < len; j++)
+			mp_next(&data);
+	}
+	*blobs = array;
+	*count = n;
+	return 0;
+}
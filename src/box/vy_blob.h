@@ -0,0 +1,365 @@
+#ifndef INCLUDES_TARANTOOL_BOX_VY_BLOB_H
+#define INCLUDES_TARANTOOL_BOX_VY_BLOB_H
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <assert.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <small/ibuf.h>
+#include <msgpuck.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * Key-value separation.
+ *
+ * Values of big tuples stored in a primary index may be moved
+ * from run files to separate blob files so that compaction
+ * doesn't have to rewrite them over and over again.
+ *
+ * If the blob_threshold index option is set, a run writer moves
+ * string and binary fields that are not indexed (i.e. follow
+ * all indexed fields) and are at least VY_BLOB_FIELD_SIZE_MIN
+ * bytes long out of each REPLACE or INSERT statement that is at
+ * least blob_threshold bytes long. The fields are appended to
+ * the blob file created for the run being written (<run_id>.blob)
+ * one after another and replaced in the statement with blob
+ * references. A blob reference is stored as MP_EXT of type
+ * MP_VY_BLOB containing MsgPack array [blob_id, offset, size].
+ * Statements with blob references are marked with VY_STMT_BLOB.
+ *
+ * Since all values of a statement are stored in the same blob
+ * file contiguously, they can be loaded with a single read.
+ * This is done by the read iterator and point lookup when they
+ * encounter such a statement in a run, while slices are still
+ * pinned, so a lookup never returns a statement with blob
+ * references.
+ *
+ * Compaction carries blob references over to the output run
+ * as is, unless the blob file they point to is mostly garbage,
+ * in which case the values are loaded and written to the blob
+ * file of the new run. Each run stores the list of blob files
+ * it references along with the size of referenced values in
+ * the metadata log (see VY_LOG_CREATE_RUN). This is used to
+ * estimate the amount of garbage in blob files and to delete
+ * blob files that aren't referenced by any run.
+ */
+
+struct tuple;
+struct mh_i64ptr_t;
+
+enum {
+	/** MsgPack extension type of a blob reference. */
+	MP_VY_BLOB = 127,
+	/** Min size of a field that may be stored in a blob file. */
+	VY_BLOB_FIELD_SIZE_MIN = 64,
+};
+
+/**
+ * A blob file is considered garbage and its values are rewritten
+ * on compaction if less than this fraction of it is referenced
+ * by runs of the LSM tree.
+ */
+#define VY_BLOB_GARBAGE_RATIO 0.5
+
+/** An open blob file. Only accessed from the tx thread. */
+struct vy_blob {
+	/** ID of the blob file, same as the ID of its run. */
+	int64_t id;
+	/** File descriptor. */
+	int fd;
+	/**
+	 * Reference counter. A blob file is referenced by each
+	 * run that refers to values stored in it and by each
+	 * compaction task reading such runs.
+	 */
+	int refs;
+	/** Size of the blob file. */
+	int64_t size;
+	/**
+	 * Size of values stored in the file that are referenced
+	 * by runs of the LSM tree.
+	 */
+	int64_t live_bytes;
+	/**
+	 * Hash the blob file is registered in or NULL if the
+	 * LSM tree owning it has been deleted.
+	 */
+	struct mh_i64ptr_t *hash;
+};
+
+/** Reference from a run to a blob file. */
+struct vy_run_blob {
+	/** ID of the blob file. */
+	int64_t id;
+	/** Size of values stored in the file referenced by the run. */
+	int64_t bytes;
+	/**
+	 * Open blob file. Set when the run is attached to
+	 * an LSM tree in the tx thread, NULL before that.
+	 */
+	struct vy_blob *blob;
+};
+
+/** Location of values of a statement in a blob file. */
+struct vy_blob_extent {
+	/** ID of the blob file. */
+	int64_t blob_id;
+	/** Offset of the first value in the file. */
+	uint64_t offset;
+	/** Total size of the values. */
+	uint64_t size;
+	/** Min number of a field stored in the blob file. */
+	uint32_t field_no;
+};
+
+static inline void
+vy_blob_ref(struct vy_blob *blob)
+{
+	assert(blob->refs >= 0);
+	blob->refs++;
+}
+
+/**
+ * Drop a reference to a blob file. The file is closed and
+ * unregistered when the last reference is dropped.
+ */
+void
+vy_blob_unref(struct vy_blob *blob);
+
+/**
+ * Look up a blob file in the given hash or open it and add it
+ * to the hash if it isn't there. Returns the blob file with
+ * the reference counter incremented on success, NULL on error.
+ */
+struct vy_blob *
+vy_blob_hash_open(struct mh_i64ptr_t *hash, int64_t id, const char *path);
+
+/** Look up a blob file in the given hash. */
+struct vy_blob *
+vy_blob_hash_find(struct mh_i64ptr_t *hash, int64_t id);
+
+/**
+ * Delete a hash of blob files. Blob files that are still
+ * referenced are detached from the hash.
+ */
+void
+vy_blob_hash_delete(struct mh_i64ptr_t *hash);
+
+/**
+ * Find out where values referenced by a statement marked with
+ * VY_STMT_BLOB are stored.
+ */
+void
+vy_blob_stmt_extent(struct tuple *stmt, struct vy_blob_extent *extent);
+
+/**
+ * Load values referenced by a statement from a blob file.
+ * Returns a new statement with the values inlined in @a ret.
+ * May yield. Must be called from the tx thread.
+ * Returns 0 on success, -1 on error.
+ */
+int
+vy_blob_load(struct vy_blob *blob, struct tuple *stmt, struct tuple **ret);
+
+/** Entry of vy_blob_map. */
+struct vy_blob_map_entry {
+	/** Blob file (referenced). */
+	struct vy_blob *blob;
+	/** Set if values stored in the file should be rewritten. */
+	bool is_garbage;
+};
+
+/**
+ * Blob files referenced by runs compacted by a task. Built and
+ * destroyed in the tx thread, used by a worker thread to load
+ * values referenced by the compacted runs.
+ */
+struct vy_blob_map {
+	/** Array of entries, sorted by blob file ID. */
+	struct vy_blob_map_entry *entries;
+	/** Number of entries. */
+	int count;
+	/** Number of entries allocated. */
+	int capacity;
+	/**
+	 * Number of indexed fields in the space at the time
+	 * the map was built.
+	 */
+	uint32_t index_field_count;
+};
+
+static inline void
+vy_blob_map_create(struct vy_blob_map *map, uint32_t index_field_count)
+{
+	map->entries = NULL;
+	map->count = 0;
+	map->capacity = 0;
+	map->index_field_count = index_field_count;
+}
+
+/** Release blob files referenced by a map and free it. */
+void
+vy_blob_map_destroy(struct vy_blob_map *map);
+
+/**
+ * Add a blob file to a map unless it's already there.
+ * Returns 0 on success, -1 on memory allocation error.
+ */
+int
+vy_blob_map_add(struct vy_blob_map *map, struct vy_blob *blob,
+		bool is_garbage);
+
+/** Look up a blob file in a map. Returns NULL if not found. */
+struct vy_blob_map_entry *
+vy_blob_map_find(struct vy_blob_map *map, int64_t id);
+
+/**
+ * Load values referenced by a statement from a blob file
+ * stored in a map. If @a keys_only is set, the values are
+ * only loaded if any of them may be indexed, otherwise @a ret
+ * is set to @a stmt. Doesn't yield.
+ * Returns 0 on success, -1 on error.
+ */
+int
+vy_blob_map_load(struct vy_blob_map *map, struct tuple *stmt,
+		 bool keys_only, struct tuple **ret);
+
+/** Writer of a blob file, used by the run writer. */
+struct vy_blob_writer {
+	/** Path to the blob file. */
+	char path[PATH_MAX];
+	/** ID of the blob file. */
+	int64_t id;
+	/**
+	 * Min size of a statement to move its values to the
+	 * blob file. If 0, values are never moved.
+	 */
+	uint32_t threshold;
+	/** Number of indexed fields in the space. */
+	uint32_t index_field_count;
+	/**
+	 * Blob files referenced by statements passed to the
+	 * writer or NULL if there's no such statements.
+	 */
+	struct vy_blob_map *map;
+	/** Blob file descriptor or -1 if not created yet. */
+	int fd;
+	/** Number of bytes written to the blob file. */
+	uint64_t size;
+	/** Data that hasn't been flushed to the file yet. */
+	struct ibuf buf;
+	/** Blob files referenced by written statements. */
+	struct vy_run_blob *refs;
+	/** Number of entries in @refs. */
+	uint32_t ref_count;
+	/** Number of entries allocated for @refs. */
+	uint32_t ref_capacity;
+};
+
+/**
+ * Create a blob writer. It is disabled, i.e. doesn't move
+ * values out of statements, until threshold is set.
+ */
+void
+vy_blob_writer_create(struct vy_blob_writer *writer, const char *path,
+		      int64_t id);
+
+/**
+ * Prepare a statement for writing to a run: move its values
+ * to the blob file if it's big enough or rewrite values it
+ * references if they are stored in a garbage blob file. Blob
+ * references of the statement are accounted in writer->refs.
+ *
+ * The statement to write is returned in @a ret. If it isn't
+ * @a stmt, the caller must unreference it.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int
+vy_blob_writer_prepare(struct vy_blob_writer *writer, struct tuple *stmt,
+		       struct tuple **ret);
+
+/**
+ * Flush and sync the blob file and return blob files referenced
+ * by written statements. The array is allocated with malloc()
+ * and should be freed by the caller. The writer is destroyed.
+ * Returns 0 on success, -1 on error.
+ */
+int
+vy_blob_writer_commit(struct vy_blob_writer *writer,
+		      struct vy_run_blob **refs, uint32_t *ref_count);
+
+/** Destroy a blob writer and delete the blob file. */
+void
+vy_blob_writer_abort(struct vy_blob_writer *writer);
+
+/**
+ * Encode blob references of a run in a MsgPack array, as
+ * it is stored in the metadata log: [[id, bytes], ...].
+ * The array is allocated on the fiber region.
+ * Returns NULL on memory allocation error.
+ */
+const char *
+vy_run_blob_encode(const struct vy_run_blob *blobs, uint32_t count);
+
+/**
+ * Decode blob references of a run encoded with
+ * vy_run_blob_encode(). The array is allocated with malloc().
+ * Returns 0 on success, -1 on memory allocation error.
+ */
+int
+vy_run_blob_decode(const char *data, struct vy_run_blob **blobs,
+		   uint32_t *count);
+
+/**
+ * Decode the ID of the next blob file from MsgPack encoded
+ * with vy_run_blob_encode().
+ */
+static inline int64_t
+vy_run_blob_decode_id(const char **data)
+{
+	mp_decode_array(data);
+	int64_t id = mp_decode_uint(data);
+	mp_next(data);
+	return id;
+}
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* INCLUDES_TARANTOOL_BOX_VY_BLOB_H */
@@ -31,8 +31,10 @@
 #include "vy_cache.h"
 #include "diag.h"
 #include "fiber.h"
+#include "say.h"
 #include "schema_def.h"
 #include "vy_history.h"
+#include "third_party/PMurHash.h"
 
 #ifndef CT_ASSERT_G
 #define CT_ASSERT_G(e) typedef char CONCAT(__ct_assert_, __LINE__)[(e) ? 1 :-1]
@@ -50,14 +52,120 @@ enum {
 	/* Max number of deletes that are made by cleanup action per one
 	 * cache operation */
 	VY_CACHE_CLEANUP_MAX_STEPS = 10,
+	/* Max share of the cache quota that may be used by the
+	 * protected LRU list, in percent */
+	VY_CACHE_PROTECTED_PCT = 80,
+	/* Number of rows in the frequency sketch */
+	VY_CACHE_SKETCH_DEPTH = 4,
+	/* Max value of a frequency sketch counter */
+	VY_CACHE_SKETCH_COUNTER_MAX = 15,
+	/* Cache quota per frequency sketch counter, in bytes */
+	VY_CACHE_SKETCH_QUOTA_PER_COUNTER = 512,
+	/* Min and max number of counters in a sketch row */
+	VY_CACHE_SKETCH_WIDTH_MIN = 16 * 1024,
+	VY_CACHE_SKETCH_WIDTH_MAX = 1 << 24,
+	/* Sketch counters are halved after this many increments
+	 * per counter in a row */
+	VY_CACHE_SKETCH_AGING_FACTOR = 10,
 };
 
+/**
+ * Reallocate the frequency sketch to fit the given cache quota.
+ * On allocation failure the sketch is left empty, which disables
+ * the admission policy.
+ */
+static void
+vy_cache_sketch_reset(struct vy_cache_sketch *sketch, size_t quota)
+{
+	free(sketch->counters);
+	sketch->counters = NULL;
+	sketch->width = 0;
+	sketch->increments = 0;
+	if (quota == 0)
+		return;
+	size_t width = VY_CACHE_SKETCH_WIDTH_MIN;
+	while (width < quota / VY_CACHE_SKETCH_QUOTA_PER_COUNTER &&
+	       width < VY_CACHE_SKETCH_WIDTH_MAX)
+		width *= 2;
+	sketch->counters = calloc(VY_CACHE_SKETCH_DEPTH, width);
+	if (sketch->counters == NULL) {
+		say_warn("failed to allocate tuple cache frequency sketch, "
+			 "cache admission policy is disabled");
+		return;
+	}
+	sketch->width = width;
+}
+
+/** Position of a statement hash in the given sketch row. */
+static inline uint32_t
+vy_cache_sketch_slot(struct vy_cache_sketch *sketch, uint32_t hash,
+		     uint32_t row)
+{
+	/* Double hashing: derive row hashes from one hash. */
+	uint32_t step = ((hash >> 17) | (hash << 15)) | 1;
+	return row * sketch->width + ((hash + row * step) &
+				      (sketch->width - 1));
+}
+
+/** Estimate how many times a statement with the given hash was read. */
+static uint32_t
+vy_cache_sketch_estimate(struct vy_cache_sketch *sketch, uint32_t hash)
+{
+	uint32_t freq = VY_CACHE_SKETCH_COUNTER_MAX;
+	for (uint32_t i = 0; i < VY_CACHE_SKETCH_DEPTH; i++) {
+		uint8_t c = sketch->counters[vy_cache_sketch_slot(sketch,
+								  hash, i)];
+		freq = MIN(freq, (uint32_t)c);
+	}
+	return freq;
+}
+
+/** Account a read of a statement with the given hash. */
+static void
+vy_cache_sketch_inc(struct vy_cache_sketch *sketch, uint32_t hash)
+{
+	for (uint32_t i = 0; i < VY_CACHE_SKETCH_DEPTH; i++) {
+		uint8_t *c = &sketch->counters[vy_cache_sketch_slot(sketch,
+								    hash, i)];
+		if (*c < VY_CACHE_SKETCH_COUNTER_MAX)
+			(*c)++;
+	}
+	if (++sketch->increments < sketch->width *
+				   VY_CACHE_SKETCH_AGING_FACTOR)
+		return;
+	sketch->increments = 0;
+	size_t count = (size_t)sketch->width * VY_CACHE_SKETCH_DEPTH;
+	for (size_t i = 0; i < count; i++)
+		sketch->counters[i] /= 2;
+}
+
+/** Hash of a cached statement key used by the frequency sketch. */
+static uint32_t
+vy_cache_entry_hash(struct vy_cache *cache, struct vy_entry entry)
+{
+	struct key_def *cmp_def = cache->cmp_def;
+	int multikey_idx = vy_entry_multikey_idx(entry, cmp_def);
+	/* Different LSM trees may store equal keys. */
+	uint32_t h = (uint32_t)(uintptr_t)cache;
+	uint32_t carry = 0;
+	uint32_t total_size = 0;
+	for (uint32_t i = 0; i < cmp_def->part_count; i++) {
+		total_size += tuple_hash_key_part(&h, &carry, entry.stmt,
+						  &cmp_def->parts[i],
+						  multikey_idx);
+	}
+	return PMurHash32_Result(h, carry, total_size);
+}
+
 void
 vy_cache_env_create(struct vy_cache_env *e, struct slab_cache *slab_cache)
 {
-	rlist_create(&e->cache_lru);
+	rlist_create(&e->probation);
+	rlist_create(&e->protected);
 	e->mem_used = 0;
+	e->protected_mem_used = 0;
 	e->mem_quota = 0;
+	memset(&e->sketch, 0, sizeof(e->sketch));
 	mempool_create(&e->cache_node_mempool, slab_cache,
 		       sizeof(struct vy_cache_node));
 }
@@ -65,6 +173,7 @@ vy_cache_env_create(struct vy_cache_env *e, struct slab_cache *slab_cache)
 void
 vy_cache_env_destroy(struct vy_cache_env *e)
 {
+	vy_cache_sketch_reset(&e->sketch, 0);
 	mempool_destroy(&e->cache_node_mempool);
 }
 
@@ -95,7 +204,8 @@ vy_cache_node_new(struct vy_cache_env *env, struct vy_cache *cache,
 	node->flags = 0;
 	node->left_boundary_level = cache->cmp_def->part_count;
 	node->right_boundary_level = cache->cmp_def->part_count;
-	rlist_add(&env->cache_lru, &node->in_lru);
+	node->is_protected = false;
+	rlist_add(&env->probation, &node->in_lru);
 	env->mem_used += vy_cache_node_size(node);
 	vy_stmt_counter_acct_tuple(&cache->stat.count, entry.stmt);
 	return node;
@@ -108,12 +218,84 @@ vy_cache_node_delete(struct vy_cache_env *env, struct vy_cache_node *node)
 				     node->entry.stmt);
 	assert(env->mem_used >= vy_cache_node_size(node));
 	env->mem_used -= vy_cache_node_size(node);
+	if (node->is_protected) {
+		assert(env->protected_mem_used >= vy_cache_node_size(node));
+		env->protected_mem_used -= vy_cache_node_size(node);
+	}
 	tuple_unref(node->entry.stmt);
 	rlist_del(&node->in_lru);
 	TRASH(node);
 	mempool_free(&env->cache_node_mempool, node);
 }
 
+/**
+ * Move a node that was read again to the head of the protected
+ * LRU list. If the protected list grows too big, demote its
+ * least recently used nodes back to the probation list.
+ */
+static void
+vy_cache_node_protect(struct vy_cache_env *env, struct vy_cache_node *node)
+{
+	rlist_move(&env->protected, &node->in_lru);
+	if (node->is_protected)
+		return;
+	node->is_protected = true;
+	env->protected_mem_used += vy_cache_node_size(node);
+	size_t limit = env->mem_quota / 100 * VY_CACHE_PROTECTED_PCT;
+	while (env->protected_mem_used > limit) {
+		struct vy_cache_node *victim = rlist_last_entry(
+			&env->protected, struct vy_cache_node, in_lru);
+		if (victim == node)
+			break;
+		victim->is_protected = false;
+		env->protected_mem_used -= vy_cache_node_size(victim);
+		rlist_move(&env->probation, &victim->in_lru);
+	}
+}
+
+/** Return the node that will be evicted next or NULL. */
+static struct vy_cache_node *
+vy_cache_env_victim(struct vy_cache_env *env)
+{
+	struct rlist *lru = !rlist_empty(&env->probation) ?
+			    &env->probation : &env->protected;
+	if (rlist_empty(lru))
+		return NULL;
+	return rlist_last_entry(lru, struct vy_cache_node, in_lru);
+}
+
+/**
+ * TinyLFU admission policy. Check if a statement that isn't
+ * in the cache yet may be added to it. If adding it would make
+ * the cache evict another statement, the statement is admitted
+ * only if it's read at least as often as the eviction victim.
+ * This way a long scan can't wash frequently read tuples out
+ * of the cache.
+ */
+static bool
+vy_cache_admit(struct vy_cache *cache, struct vy_entry entry, uint32_t freq)
+{
+	struct vy_cache_env *env = cache->env;
+	if (env->sketch.counters == NULL)
+		return true;
+	size_t size = sizeof(struct vy_cache_node);
+	if (cache->is_primary)
+		size += tuple_size(entry.stmt);
+	if (env->mem_used + size <= env->mem_quota)
+		return true;
+	if (vy_cache_tree_find(&cache->cache_tree, entry) != NULL)
+		return true;
+	struct vy_cache_node *victim = vy_cache_env_victim(env);
+	if (victim == NULL)
+		return true;
+	uint32_t victim_hash = vy_cache_entry_hash(victim->cache,
+						   victim->entry);
+	if (freq >= vy_cache_sketch_estimate(&env->sketch, victim_hash))
+		return true;
+	vy_stmt_counter_acct_tuple(&cache->stat.reject, entry.stmt);
+	return false;
+}
+
 static void *
 vy_cache_tree_page_alloc(void *ctx)
 {
@@ -163,12 +345,21 @@ vy_cache_destroy(struct vy_cache *cache)
 	vy_cache_tree_destroy(&cache->cache_tree);
 }
 
+void
+vy_cache_invalidate(struct vy_cache *cache)
+{
+	vy_cache_destroy(cache);
+	vy_cache_tree_create(&cache->cache_tree, cache->cmp_def,
+			     vy_cache_tree_page_alloc,
+			     vy_cache_tree_page_free, cache->env);
+	cache->version++;
+}
+
 static void
 vy_cache_gc_step(struct vy_cache_env *env)
 {
-	struct rlist *lru = &env->cache_lru;
-	struct vy_cache_node *node =
-		rlist_last_entry(lru, struct vy_cache_node, in_lru);
+	struct vy_cache_node *node = vy_cache_env_victim(env);
+	assert(node != NULL);
 	struct vy_cache *cache = node->cache;
 	struct vy_cache_tree *tree = &cache->cache_tree;
 	if (node->flags & (VY_CACHE_LEFT_LINKED | VY_CACHE_RIGHT_LINKED)) {
@@ -214,6 +405,7 @@ void
 vy_cache_env_set_quota(struct vy_cache_env *env, size_t quota)
 {
 	env->mem_quota = quota;
+	vy_cache_sketch_reset(&env->sketch, quota);
 	while (env->mem_used > env->mem_quota) {
 		vy_cache_gc(env);
 		/*
@@ -255,6 +447,12 @@ vy_cache_add(struct vy_cache *cache, struct vy_entry curr,
 		return;
 	}
 
+	/*
+	 * If curr is NULL, the reader reached the end of the
+	 * result and prev was accounted on the previous call.
+	 */
+	bool is_read = curr.stmt != NULL;
+
 	int direction = iterator_direction(order);
 	/**
 	 * Let's determine boundary_level (left/right) of the new record
@@ -298,6 +496,18 @@ vy_cache_add(struct vy_cache *cache, struct vy_entry curr,
 	assert(prev.stmt == NULL ||
 	       vy_stmt_type(prev.stmt) == IPROTO_INSERT ||
 	       vy_stmt_type(prev.stmt) == IPROTO_REPLACE);
+
+	struct vy_cache_sketch *sketch = &cache->env->sketch;
+	uint32_t freq = 0;
+	if (sketch->counters != NULL) {
+		uint32_t hash = vy_cache_entry_hash(cache, curr);
+		if (is_read)
+			vy_cache_sketch_inc(sketch, hash);
+		freq = vy_cache_sketch_estimate(sketch, hash);
+	}
+	if (!vy_cache_admit(cache, curr, freq))
+		return;
+
 	cache->version++;
 
 	/* Insert/replace new node to the tree */
@@ -321,6 +531,8 @@ vy_cache_add(struct vy_cache *cache, struct vy_entry curr,
 		node->left_boundary_level = replaced->left_boundary_level;
 		node->right_boundary_level = replaced->right_boundary_level;
 		vy_cache_node_delete(cache->env, replaced);
+		/* The statement was read again, protect it. */
+		vy_cache_node_protect(cache->env, node);
 	}
 	if (direction > 0 && boundary_level < node->left_boundary_level)
 		node->left_boundary_level = boundary_level;
@@ -389,6 +601,17 @@ vy_cache_add(struct vy_cache *cache, struct vy_entry curr,
 	if (node->flags & flag)
 		return;
 
+	/*
+	 * Usually prev is already in the cache, but it may have
+	 * been rejected by the admission policy or evicted.
+	 */
+	if (sketch->counters != NULL) {
+		uint32_t hash = vy_cache_entry_hash(cache, prev);
+		freq = vy_cache_sketch_estimate(sketch, hash);
+		if (!vy_cache_admit(cache, prev, freq))
+			return;
+	}
+
 	/* Insert/replace node with previous statement */
 	struct vy_cache_node *prev_node =
 		vy_cache_node_new(cache->env, cache, prev);
@@ -406,7 +629,14 @@ vy_cache_add(struct vy_cache *cache, struct vy_entry curr,
 		prev_node->flags = replaced->flags;
 		prev_node->left_boundary_level = replaced->left_boundary_level;
 		prev_node->right_boundary_level = replaced->right_boundary_level;
+		bool is_protected = replaced->is_protected;
 		vy_cache_node_delete(cache->env, replaced);
+		/*
+		 * Re-linking a chain doesn't mean the statement
+		 * was read again so keep it in the same list.
+		 */
+		if (is_protected)
+			vy_cache_node_protect(cache->env, prev_node);
 	}
 
 	/* Set proper flags */
@@ -689,6 +919,7 @@ vy_cache_iterator_seek(struct vy_cache_iterator *itr, struct vy_entry last)
 						    itr->cache->cmp_def) != 0)))
 		return false;
 
+	itr->cache->stat.hit++;
 	itr->curr = node->entry;
 	tuple_ref(itr->curr.stmt);
 	return vy_cache_iterator_is_stop(itr, node);
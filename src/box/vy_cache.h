@@ -56,7 +56,7 @@ struct vy_cache_node {
 	struct vy_cache *cache;
 	/* Statement in cache */
 	struct vy_entry entry;
-	/* Link in LRU list */
+	/* Link in the probation or protected LRU list */
 	struct rlist in_lru;
 	/* VY_CACHE_LEFT_LINKED and/or VY_CACHE_RIGHT_LINKED, see
 	 * description of them for more information */
@@ -65,6 +65,8 @@ struct vy_cache_node {
 	uint8_t left_boundary_level;
 	/* Number of parts in key when the value was the last in EQ search */
 	uint8_t right_boundary_level;
+	/* Set if the node is in the protected LRU list */
+	bool is_protected;
 };
 
 /**
@@ -111,18 +113,48 @@ vy_cache_tree_key_cmp(struct vy_cache_node *a, struct vy_entry b,
 #undef bps_tree_arg_t
 #undef BPS_TREE_IS_IDENTICAL
 
+/**
+ * Count-min sketch estimating how often statements are read.
+ * Used by the cache admission policy (TinyLFU): a statement
+ * is let in only if it is read at least as often as the one
+ * it would push out of the cache.
+ */
+struct vy_cache_sketch {
+	/** VY_CACHE_SKETCH_DEPTH rows of counters, 'width' each. */
+	uint8_t *counters;
+	/** Number of counters in a row, a power of two. */
+	uint32_t width;
+	/**
+	 * Number of increments since the counters were halved
+	 * last time. Halving lets the sketch forget old reads.
+	 */
+	uint32_t increments;
+};
+
 /**
  * Environment of the cache
  */
 struct vy_cache_env {
-	/** Common LRU list of read cache. The first element is the newest */
-	struct rlist cache_lru;
+	/**
+	 * Segmented LRU of read cache. A node is put to the
+	 * probation list when it's added to the cache and moved
+	 * to the protected list when it's read again. Nodes are
+	 * evicted from the probation list first so that a scan
+	 * can't flush tuples that are read repeatedly. In both
+	 * lists the first element is the newest.
+	 */
+	struct rlist probation;
+	struct rlist protected;
 	/** Common mempool for vy_cache_node struct */
 	struct mempool cache_node_mempool;
 	/** Size of memory occupied by cached tuples */
 	size_t mem_used;
+	/** Size of memory occupied by protected tuples */
+	size_t protected_mem_used;
 	/** Max memory size that can be used for cache */
 	size_t mem_quota;
+	/** Read frequency sketch used for admission. */
+	struct vy_cache_sketch sketch;
 };
 
 /**
@@ -189,6 +221,14 @@ vy_cache_create(struct vy_cache *cache, struct vy_cache_env *env,
 void
 vy_cache_destroy(struct vy_cache *cache);
 
+/**
+ * Drop all cached statements, e.g. when a range deletion
+ * makes an unknown number of them stale.
+ * @param cache - pointer to tuple cache to invalidate.
+ */
+void
+vy_cache_invalidate(struct vy_cache *cache);
+
 /**
  * Add a value to the cache. Can be used only if the reader read the latest
  * data (vlsn = INT64_MAX).
@@ -60,6 +60,21 @@ vy_history_append_stmt(struct vy_history *history, struct vy_entry entry)
 	return 0;
 }
 
+void
+vy_history_replace_oldest_stmt(struct vy_history *history,
+			       struct tuple *stmt)
+{
+	assert(!rlist_empty(&history->stmts));
+	assert(vy_stmt_is_refable(stmt));
+	struct vy_history_node *node = rlist_last_entry(&history->stmts,
+					struct vy_history_node, link);
+	if (node->is_refable)
+		tuple_unref(node->entry.stmt);
+	tuple_ref(stmt);
+	node->entry.stmt = stmt;
+	node->is_refable = true;
+}
+
 void
 vy_history_cleanup(struct vy_history *history)
 {
@@ -72,6 +87,52 @@ vy_history_cleanup(struct vy_history *history)
 	rlist_create(&history->stmts);
 }
 
+int
+vy_history_cut(struct vy_history *history, int64_t lsn,
+	       struct key_def *cmp_def, struct tuple_format *key_format)
+{
+	struct vy_history_node *node, *tmp;
+	struct vy_history_node *cut = NULL;
+	rlist_foreach_entry_safe(node, &history->stmts, link, tmp) {
+		if (vy_stmt_lsn(node->entry.stmt) >= lsn)
+			continue;
+		/*
+		 * The list is sorted by LSN so the rest of it is
+		 * covered, too. Keep the newest covered statement
+		 * to build a DELETE from its key.
+		 */
+		if (cut == NULL) {
+			cut = node;
+			rlist_del_entry(node, link);
+			continue;
+		}
+		if (node->is_refable)
+			tuple_unref(node->entry.stmt);
+		rlist_del_entry(node, link);
+		mempool_free(history->pool, node);
+	}
+	if (cut == NULL)
+		return 0;
+	int rc = 0;
+	if (!vy_history_is_terminal(history)) {
+		struct vy_entry entry;
+		entry.hint = cut->entry.hint;
+		entry.stmt = vy_stmt_new_delete_by_key(cut->entry.stmt,
+						       cmp_def, key_format);
+		if (entry.stmt != NULL) {
+			vy_stmt_set_lsn(entry.stmt, lsn);
+			rc = vy_history_append_stmt(history, entry);
+			tuple_unref(entry.stmt);
+		} else {
+			rc = -1;
+		}
+	}
+	if (cut->is_refable)
+		tuple_unref(cut->entry.stmt);
+	mempool_free(history->pool, cut);
+	return rc;
+}
+
 int
 vy_history_apply(struct vy_history *history, struct key_def *cmp_def,
 		 bool keep_delete, int *upserts_applied, struct vy_entry *ret)
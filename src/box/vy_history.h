@@ -138,6 +138,16 @@ vy_history_splice(struct vy_history *dst, struct vy_history *src)
 int
 vy_history_append_stmt(struct vy_history *history, struct vy_entry entry);
 
+/**
+ * Replace the oldest statement of a non-empty history list
+ * with the given one, e.g. with the same statement loaded from
+ * blob files. The new statement must be refable; it is
+ * referenced by the history.
+ */
+void
+vy_history_replace_oldest_stmt(struct vy_history *history,
+			       struct tuple *stmt);
+
 /**
  * Release all statements stored in the given history and
  * reinitialize the history list.
@@ -145,6 +155,21 @@ vy_history_append_stmt(struct vy_history *history, struct vy_entry entry);
 void
 vy_history_cleanup(struct vy_history *history);
 
+/**
+ * Discard statements older than @lsn from the given history,
+ * because they are covered by a range tombstone with this LSN,
+ * see vy_tombstone.h. If any statement is discarded and the
+ * rest of the history isn't terminal, a DELETE with @lsn is
+ * appended in place of the discarded statements so that the
+ * history resolves to the same value as it would if the
+ * tombstone were a regular DELETE.
+ *
+ * Returns 0 on success, -1 on memory allocation error.
+ */
+int
+vy_history_cut(struct vy_history *history, int64_t lsn,
+	       struct key_def *cmp_def, struct tuple_format *key_format);
+
 /**
  * Get a resultant statement from collected history.
  * If the resultant statement is a DELETE, the function
@@ -86,6 +86,9 @@ enum vy_log_key {
 	VY_LOG_KEY_DROP_LSN		= 14,
 	VY_LOG_KEY_GROUP_ID		= 15,
 	VY_LOG_KEY_DUMP_COUNT		= 16,
+	VY_LOG_KEY_BLOBS		= 17,
+	VY_LOG_KEY_TOMBSTONE_ID		= 18,
+	VY_LOG_KEY_TOMBSTONE_LSN	= 19,
 };
 
 /** vy_log_key -> human readable name. */
@@ -107,6 +110,9 @@ static const char *vy_log_key_name[] = {
 	[VY_LOG_KEY_DROP_LSN]		= "drop_lsn",
 	[VY_LOG_KEY_GROUP_ID]		= "group_id",
 	[VY_LOG_KEY_DUMP_COUNT]		= "dump_count",
+	[VY_LOG_KEY_BLOBS]		= "blobs",
+	[VY_LOG_KEY_TOMBSTONE_ID]	= "tombstone_id",
+	[VY_LOG_KEY_TOMBSTONE_LSN]	= "tombstone_lsn",
 };
 
 /** vy_log_type -> human readable name. */
@@ -129,6 +135,8 @@ static const char *vy_log_type_name[] = {
 	[VY_LOG_PREPARE_LSM]		= "prepare_lsm",
 	[VY_LOG_REBOOTSTRAP]		= "rebootstrap",
 	[VY_LOG_ABORT_REBOOTSTRAP]	= "abort_rebootstrap",
+	[VY_LOG_INSERT_TOMBSTONE]	= "insert_tombstone",
+	[VY_LOG_DELETE_TOMBSTONE]	= "delete_tombstone",
 };
 
 /** Batch of vylog records that must be written in one go. */
@@ -153,6 +161,15 @@ struct vy_log {
 	struct vclock last_checkpoint;
 	/** Recovery context. */
 	struct vy_recovery *recovery;
+	/**
+	 * Image of the current log file, i.e. the state of all
+	 * vinyl objects as of the last record written to the log,
+	 * or NULL if it hasn't been loaded yet. It is loaded on
+	 * the first log rotation and then kept up-to-date with each
+	 * log write so that we don't need to replay the whole log
+	 * to create a new one on the next rotation.
+	 */
+	struct vy_recovery *image;
 	/**
 	 * Latch that syncs log writers against readers.
 	 * Needed so that we don't miss any records during
@@ -314,6 +331,20 @@ vy_log_record_snprint(char *buf, int size, const struct vy_log_record *record)
 		SNPRINT(total, snprintf, buf, size, "%s=%"PRIu32", ",
 			vy_log_key_name[VY_LOG_KEY_DUMP_COUNT],
 			record->dump_count);
+	if (record->blobs != NULL) {
+		SNPRINT(total, snprintf, buf, size, "%s=",
+			vy_log_key_name[VY_LOG_KEY_BLOBS]);
+		SNPRINT(total, mp_snprint, buf, size, record->blobs);
+		SNPRINT(total, snprintf, buf, size, ", ");
+	}
+	if (record->tombstone_id > 0)
+		SNPRINT(total, snprintf, buf, size, "%s=%"PRIi64", ",
+			vy_log_key_name[VY_LOG_KEY_TOMBSTONE_ID],
+			record->tombstone_id);
+	if (record->tombstone_lsn > 0)
+		SNPRINT(total, snprintf, buf, size, "%s=%"PRIi64", ",
+			vy_log_key_name[VY_LOG_KEY_TOMBSTONE_LSN],
+			record->tombstone_lsn);
 	SNPRINT(total, snprintf, buf, size, "}");
 	return total;
 }
@@ -445,6 +476,24 @@ vy_log_record_encode(const struct vy_log_record *record,
 		size += mp_sizeof_uint(record->dump_count);
 		n_keys++;
 	}
+	if (record->blobs != NULL) {
+		size += mp_sizeof_uint(VY_LOG_KEY_BLOBS);
+		const char *p = record->blobs;
+		assert(mp_typeof(*p) == MP_ARRAY);
+		mp_next(&p);
+		size += p - record->blobs;
+		n_keys++;
+	}
+	if (record->tombstone_id > 0) {
+		size += mp_sizeof_uint(VY_LOG_KEY_TOMBSTONE_ID);
+		size += mp_sizeof_uint(record->tombstone_id);
+		n_keys++;
+	}
+	if (record->tombstone_lsn > 0) {
+		size += mp_sizeof_uint(VY_LOG_KEY_TOMBSTONE_LSN);
+		size += mp_sizeof_uint(record->tombstone_lsn);
+		n_keys++;
+	}
 	size += mp_sizeof_map(n_keys);
 
 	/*
@@ -531,6 +580,21 @@ vy_log_record_encode(const struct vy_log_record *record,
 		pos = mp_encode_uint(pos, VY_LOG_KEY_DUMP_COUNT);
 		pos = mp_encode_uint(pos, record->dump_count);
 	}
+	if (record->blobs != NULL) {
+		pos = mp_encode_uint(pos, VY_LOG_KEY_BLOBS);
+		const char *p = record->blobs;
+		mp_next(&p);
+		memcpy(pos, record->blobs, p - record->blobs);
+		pos += p - record->blobs;
+	}
+	if (record->tombstone_id > 0) {
+		pos = mp_encode_uint(pos, VY_LOG_KEY_TOMBSTONE_ID);
+		pos = mp_encode_uint(pos, record->tombstone_id);
+	}
+	if (record->tombstone_lsn > 0) {
+		pos = mp_encode_uint(pos, VY_LOG_KEY_TOMBSTONE_LSN);
+		pos = mp_encode_uint(pos, record->tombstone_lsn);
+	}
 	assert(pos == tuple + size);
 
 	/*
@@ -663,6 +727,17 @@ vy_log_record_decode(struct vy_log_record *record,
 		case VY_LOG_KEY_DUMP_COUNT:
 			record->dump_count = mp_decode_uint(&pos);
 			break;
+		case VY_LOG_KEY_BLOBS:
+			tmp = pos;
+			record->blobs = mp_decode_array(&tmp) > 0 ? pos : NULL;
+			mp_next(&pos);
+			break;
+		case VY_LOG_KEY_TOMBSTONE_ID:
+			record->tombstone_id = mp_decode_uint(&pos);
+			break;
+		case VY_LOG_KEY_TOMBSTONE_LSN:
+			record->tombstone_lsn = mp_decode_uint(&pos);
+			break;
 		default:
 			mp_next(&pos); /* unknown key, ignore */
 			break;
@@ -734,6 +809,18 @@ vy_log_record_dup(struct region *pool, const struct vy_log_record *src)
 		}
 		memcpy((char *)dst->end, src->end, size);
 	}
+	if (src->blobs != NULL) {
+		const char *data = src->blobs;
+		mp_next(&data);
+		size = data - src->blobs;
+		dst->blobs = region_alloc(pool, size);
+		if (dst->blobs == NULL) {
+			diag_set(OutOfMemory, size, "region",
+				 "vy_log_record::blobs");
+			goto err;
+		}
+		memcpy((char *)dst->blobs, src->blobs, size);
+	}
 	if (src->key_def != NULL) {
 		dst->key_parts =
 			region_alloc_array(pool, typeof(dst->key_parts[0]),
@@ -795,6 +882,46 @@ vy_log_tx_delete(struct vy_log_tx *tx)
 	mempool_free(&vy_log.tx_pool, tx);
 }
 
+/**
+ * Apply records of a transaction that has been written to disk
+ * to the log image, see vy_log::image. On failure, the image is
+ * dropped and will be reloaded from disk on the next rotation.
+ */
+static void
+vy_log_update_image(struct vy_log_tx *tx)
+{
+	struct vy_recovery *image = vy_log.image;
+	if (image == NULL)
+		return;
+	struct vy_log_record *record;
+	stailq_foreach_entry(record, &tx->records, in_tx) {
+		/*
+		 * Rebootstrap is resolved on log load and hence
+		 * can't be applied incrementally.
+		 */
+		if (record->type == VY_LOG_REBOOTSTRAP ||
+		    record->type == VY_LOG_ABORT_REBOOTSTRAP)
+			goto drop;
+		/*
+		 * Initialize 'modify_lsn' the same way it would be
+		 * initialized on decoding, see vy_log_record_decode().
+		 */
+		struct vy_log_record tmp = *record;
+		if (tmp.type == VY_LOG_CREATE_LSM && tmp.modify_lsn == 0)
+			tmp.modify_lsn = tmp.create_lsn;
+		if (vy_recovery_process_record(image, &tmp) != 0) {
+			diag_log();
+			goto drop;
+		}
+	}
+	return;
+drop:
+	say_warn("dropping vylog image, "
+		 "the log will be reloaded on rotation");
+	vy_log.image = NULL;
+	vy_recovery_delete(image);
+}
+
 /**
  * Write a given transaction to disk.
  */
@@ -853,6 +980,7 @@ vy_log_tx_flush(struct vy_log_tx *tx)
 		goto err;
 
 	region_truncate(&fiber()->gc, used);
+	vy_log_update_image(tx);
 	return 0;
 err:
 	region_truncate(&fiber()->gc, used);
@@ -929,6 +1057,9 @@ vy_log_free(void)
 	stailq_foreach_entry_safe(tx, next_tx, &vy_log.pending_tx, in_pending)
 		vy_log_tx_delete(tx);
 	stailq_create(&vy_log.pending_tx);
+	if (vy_log.image != NULL)
+		vy_recovery_delete(vy_log.image);
+	vy_log.image = NULL;
 	mempool_destroy(&vy_log.tx_pool);
 	xdir_destroy(&vy_log.dir);
 	diag_destroy(&vy_log.tx_diag);
@@ -1078,11 +1209,14 @@ vy_log_begin_recovery(const struct vclock *vclock)
 	 * rebootstrap section, checkpoint (and hence rebootstrap)
 	 * failed, and we need to mark rebootstrap as aborted.
 	 */
+	double load_start = ev_monotonic_now(loop());
 	struct vy_recovery *recovery;
 	recovery = vy_recovery_new(vclock_sum(&vy_log.last_checkpoint),
 				   VY_RECOVERY_ABORT_REBOOTSTRAP);
 	if (recovery == NULL)
 		return NULL;
+	say_info("vylog loaded in %.3f sec",
+		 ev_monotonic_now(loop()) - load_start);
 
 	if (recovery->in_rebootstrap) {
 		struct vy_log_record record;
@@ -1168,14 +1302,39 @@ vy_log_rotate(const struct vclock *vclock)
 	 */
 	latch_lock(&vy_log.latch);
 
-	struct vy_recovery *recovery;
-	recovery = vy_recovery_new_locked(prev_signature, 0);
-	if (recovery == NULL)
-		goto fail;
+	/*
+	 * If the log image is available, write it right away
+	 * instead of replaying the old log. Otherwise load the
+	 * old log and keep the image for the next rotation.
+	 */
+	struct vy_recovery *recovery = vy_log.image;
+	if (recovery != NULL) {
+		if (vy_log_flush() != 0) {
+			diag_log();
+			say_error("failed to flush vylog for rotation");
+			goto fail;
+		}
+		/* The flush may have dropped the image. */
+		recovery = vy_log.image;
+	}
+	if (recovery == NULL) {
+		recovery = vy_recovery_new_locked(prev_signature, 0);
+		if (recovery == NULL)
+			goto fail;
+		if (!recovery->in_rebootstrap) {
+			/*
+			 * The index id map isn't maintained by
+			 * incremental updates, see vy_log_update_image().
+			 */
+			mh_i64ptr_clear(recovery->index_id_hash);
+			vy_log.image = recovery;
+		}
+	}
 
 	/* Do actual work from coio so as not to stall tx thread. */
 	int rc = coio_call(vy_log_rotate_f, recovery, vclock);
-	vy_recovery_delete(recovery);
+	if (recovery != vy_log.image)
+		vy_recovery_delete(recovery);
 	if (rc < 0) {
 		diag_log();
 		say_error("failed to write `%s'", vy_log_filename(signature));
@@ -1436,6 +1595,28 @@ vy_recovery_alloc_key_parts(const struct key_part_def *key_parts,
 	return new_parts;
 }
 
+/**
+ * Return the total size of the given range boundaries.
+ * Either boundary may be NULL.
+ */
+static size_t
+vy_recovery_key_size(const char *begin, const char *end)
+{
+	size_t size = 0;
+	const char *data;
+	if (begin != NULL) {
+		data = begin;
+		mp_next(&data);
+		size += data - begin;
+	}
+	if (end != NULL) {
+		data = end;
+		mp_next(&data);
+		size += data - end;
+	}
+	return size;
+}
+
 /**
  * Allocate a new LSM tree with the given ID and add it to
  * the recovery context.
@@ -1488,6 +1669,7 @@ vy_recovery_do_create_lsm(struct vy_recovery *recovery, int64_t id,
 	lsm->prepared = NULL;
 	rlist_create(&lsm->ranges);
 	rlist_create(&lsm->runs);
+	rlist_create(&lsm->tombstones);
 	/*
 	 * Keep newer LSM trees closer to the tail of the list
 	 * so that on log rotation we create/drop past incarnations
@@ -1644,7 +1826,8 @@ vy_recovery_drop_lsm(struct vy_recovery *recovery, int64_t id, int64_t drop_lsn)
 /**
  * Handle a VY_LOG_FORGET_LSM log record.
  * This function removes the LSM tree with ID @id from the context.
- * All ranges and runs of the LSM tree must have been deleted by now.
+ * All ranges, runs, and tombstones of the LSM tree must have been
+ * deleted by now.
  * Returns 0 on success, -1 if ID was not found or there are objects
  * associated with the LSM tree.
  */
@@ -1660,10 +1843,11 @@ vy_recovery_forget_lsm(struct vy_recovery *recovery, int64_t id)
 		return -1;
 	}
 	struct vy_lsm_recovery_info *lsm = mh_i64ptr_node(h, k)->val;
-	if (!rlist_empty(&lsm->ranges) || !rlist_empty(&lsm->runs)) {
+	if (!rlist_empty(&lsm->ranges) || !rlist_empty(&lsm->runs) ||
+	    !rlist_empty(&lsm->tombstones)) {
 		diag_set(ClientError, ER_INVALID_VYLOG_FILE,
-			 tt_sprintf("Forgotten LSM tree %lld has ranges/runs",
-				    (long long)id));
+			 tt_sprintf("Forgotten LSM tree %lld has "
+				    "ranges/runs/tombstones", (long long)id));
 		return -1;
 	}
 	mh_i64ptr_del(h, k, NULL);
@@ -1721,6 +1905,7 @@ vy_recovery_do_create_run(struct vy_recovery *recovery, int64_t run_id)
 	run->dump_lsn = -1;
 	run->gc_lsn = -1;
 	run->dump_count = 0;
+	run->blobs = NULL;
 	run->is_incomplete = false;
 	run->is_dropped = false;
 	run->data = NULL;
@@ -1769,13 +1954,15 @@ vy_recovery_prepare_run(struct vy_recovery *recovery, int64_t lsm_id,
  * Handle a VY_LOG_CREATE_RUN log record.
  * This function adds the vinyl run with ID @run_id to the list
  * of runs of the LSM tree with ID @sm_id and marks it committed.
- * If the run does not exist, it will be created.
+ * If the run does not exist, it will be created. @blobs is
+ * a MsgPack array of IDs of blob files referenced by the run.
  * Return 0 on success, -1 if LSM tree not found, run or LSM tree
  * is dropped, or OOM.
  */
 static int
 vy_recovery_create_run(struct vy_recovery *recovery, int64_t lsm_id,
-		       int64_t run_id, int64_t dump_lsn, uint32_t dump_count)
+		       int64_t run_id, int64_t dump_lsn, uint32_t dump_count,
+		       const char *blobs)
 {
 	struct vy_lsm_recovery_info *lsm;
 	lsm = vy_recovery_lookup_lsm(recovery, lsm_id);
@@ -1799,6 +1986,19 @@ vy_recovery_create_run(struct vy_recovery *recovery, int64_t lsm_id,
 		if (run == NULL)
 			return -1;
 	}
+	if (blobs != NULL) {
+		const char *blobs_end = blobs;
+		mp_next(&blobs_end);
+		size_t size = blobs_end - blobs;
+		char *blobs_copy = malloc(size);
+		if (blobs_copy == NULL) {
+			diag_set(OutOfMemory, size, "malloc", "run blobs");
+			return -1;
+		}
+		memcpy(blobs_copy, blobs, size);
+		free(run->blobs);
+		run->blobs = blobs_copy;
+	}
 	run->dump_lsn = dump_lsn;
 	run->dump_count = dump_count;
 	run->is_incomplete = false;
@@ -1855,6 +2055,7 @@ vy_recovery_forget_run(struct vy_recovery *recovery, int64_t run_id)
 	struct vy_run_recovery_info *run = mh_i64ptr_node(h, k)->val;
 	mh_i64ptr_del(h, k, NULL);
 	rlist_del_entry(run, in_lsm);
+	free(run->blobs);
 	free(run);
 	return 0;
 }
@@ -1925,6 +2126,7 @@ vy_recovery_insert_range(struct vy_recovery *recovery, int64_t lsm_id,
 		range->end = NULL;
 	rlist_create(&range->slices);
 	rlist_add_entry(&lsm->ranges, range, in_lsm);
+	recovery->key_size += begin_size + end_size;
 	if (recovery->max_id < range_id)
 		recovery->max_id = range_id;
 	return 0;
@@ -1956,6 +2158,7 @@ vy_recovery_delete_range(struct vy_recovery *recovery, int64_t range_id)
 	}
 	mh_i64ptr_del(h, k, NULL);
 	rlist_del_entry(range, in_lsm);
+	recovery->key_size -= vy_recovery_key_size(range->begin, range->end);
 	free(range);
 	return 0;
 }
@@ -2047,6 +2250,7 @@ vy_recovery_insert_slice(struct vy_recovery *recovery, int64_t range_id,
 			break;
 	}
 	rlist_add_tail(&next_slice->in_range, &slice->in_range);
+	recovery->key_size += begin_size + end_size;
 	if (recovery->max_id < slice_id)
 		recovery->max_id = slice_id;
 	return 0;
@@ -2071,10 +2275,112 @@ vy_recovery_delete_slice(struct vy_recovery *recovery, int64_t slice_id)
 	struct vy_slice_recovery_info *slice = mh_i64ptr_node(h, k)->val;
 	mh_i64ptr_del(h, k, NULL);
 	rlist_del_entry(slice, in_range);
+	recovery->key_size -= vy_recovery_key_size(slice->begin, slice->end);
 	free(slice);
 	return 0;
 }
 
+/**
+ * Handle a VY_LOG_INSERT_TOMBSTONE log record.
+ * This function allocates a new range tombstone with ID
+ * @tombstone_id, inserts it to the hash, and adds it to the
+ * list of tombstones of the LSM tree with ID @lsm_id.
+ * Return 0 on success, -1 on failure (ID collision or OOM).
+ */
+static int
+vy_recovery_insert_tombstone(struct vy_recovery *recovery, int64_t lsm_id,
+			     int64_t tombstone_id, int64_t tombstone_lsn,
+			     const char *begin, const char *end)
+{
+	struct mh_i64ptr_t *h = recovery->tombstone_hash;
+	if (mh_i64ptr_find(h, tombstone_id, NULL) != mh_end(h)) {
+		diag_set(ClientError, ER_INVALID_VYLOG_FILE,
+			 tt_sprintf("Duplicate tombstone id %lld",
+				    (long long)tombstone_id));
+		return -1;
+	}
+	struct vy_lsm_recovery_info *lsm;
+	lsm = vy_recovery_lookup_lsm(recovery, lsm_id);
+	if (lsm == NULL) {
+		diag_set(ClientError, ER_INVALID_VYLOG_FILE,
+			 tt_sprintf("Tombstone %lld created for unregistered "
+				    "LSM tree %lld", (long long)tombstone_id,
+				    (long long)lsm_id));
+		return -1;
+	}
+
+	size_t size = sizeof(struct vy_tombstone_recovery_info);
+	const char *data;
+	data = begin;
+	if (data != NULL)
+		mp_next(&data);
+	size_t begin_size = data - begin;
+	size += begin_size;
+	data = end;
+	if (data != NULL)
+		mp_next(&data);
+	size_t end_size = data - end;
+	size += end_size;
+
+	struct vy_tombstone_recovery_info *tombstone = malloc(size);
+	if (tombstone == NULL) {
+		diag_set(OutOfMemory, size,
+			 "malloc", "struct vy_tombstone_recovery_info");
+		return -1;
+	}
+	struct mh_i64ptr_node_t node = { tombstone_id, tombstone };
+	if (mh_i64ptr_put(h, &node, NULL, NULL) == mh_end(h)) {
+		diag_set(OutOfMemory, 0, "mh_i64ptr_put", "mh_i64ptr_node_t");
+		free(tombstone);
+		return -1;
+	}
+	tombstone->id = tombstone_id;
+	tombstone->lsn = tombstone_lsn;
+	if (begin != NULL) {
+		tombstone->begin = (void *)tombstone + sizeof(*tombstone);
+		memcpy(tombstone->begin, begin, begin_size);
+	} else
+		tombstone->begin = NULL;
+	if (end != NULL) {
+		tombstone->end = (void *)tombstone + sizeof(*tombstone) +
+				 begin_size;
+		memcpy(tombstone->end, end, end_size);
+	} else
+		tombstone->end = NULL;
+	rlist_add_tail_entry(&lsm->tombstones, tombstone, in_lsm);
+	recovery->key_size += begin_size + end_size;
+	if (recovery->max_id < tombstone_id)
+		recovery->max_id = tombstone_id;
+	return 0;
+}
+
+/**
+ * Handle a VY_LOG_DELETE_TOMBSTONE log record.
+ * This function frees the range tombstone with ID @tombstone_id.
+ * Return 0 on success, -1 if the tombstone not found.
+ */
+static int
+vy_recovery_delete_tombstone(struct vy_recovery *recovery,
+			     int64_t tombstone_id)
+{
+	struct mh_i64ptr_t *h = recovery->tombstone_hash;
+	mh_int_t k = mh_i64ptr_find(h, tombstone_id, NULL);
+	if (k == mh_end(h)) {
+		diag_set(ClientError, ER_INVALID_VYLOG_FILE,
+			 tt_sprintf("Tombstone %lld deleted but not registered",
+				    (long long)tombstone_id));
+		return -1;
+	}
+	struct vy_tombstone_recovery_info *tombstone =
+		mh_i64ptr_node(h, k)->val;
+	mh_i64ptr_del(h, k, NULL);
+	rlist_del_entry(tombstone, in_lsm);
+	recovery->key_size -= vy_recovery_key_size(tombstone->begin,
+						   tombstone->end);
+	free(tombstone);
+	return 0;
+}
+
 /**
  * Mark all LSM trees created during rebootstrap as dropped so
  * that they will be purged on the next garbage collection.
@@ -2163,7 +2469,7 @@ vy_recovery_process_record(struct vy_recovery *recovery,
 	case VY_LOG_CREATE_RUN:
 		rc = vy_recovery_create_run(recovery, record->lsm_id,
 					    record->run_id, record->dump_lsn,
-					    record->dump_count);
+					    record->dump_count, record->blobs);
 		break;
 	case VY_LOG_DROP_RUN:
 		rc = vy_recovery_drop_run(recovery, record->run_id,
@@ -2184,6 +2490,15 @@ vy_recovery_process_record(struct vy_recovery *recovery,
 		rc = vy_recovery_dump_lsm(recovery, record->lsm_id,
 					    record->dump_lsn);
 		break;
+	case VY_LOG_INSERT_TOMBSTONE:
+		rc = vy_recovery_insert_tombstone(recovery, record->lsm_id,
+				record->tombstone_id, record->tombstone_lsn,
+				record->begin, record->end);
+		break;
+	case VY_LOG_DELETE_TOMBSTONE:
+		rc = vy_recovery_delete_tombstone(recovery,
+						  record->tombstone_id);
+		break;
 	case VY_LOG_TRUNCATE_LSM:
 		/* Not used anymore, ignore. */
 		rc = 0;
@@ -2292,20 +2607,15 @@ vy_recovery_build_index_id_hash(struct vy_recovery *recovery)
 	return 0;
 }
 
-static ssize_t
-vy_recovery_new_f(va_list ap)
+/** Allocate an empty recovery context. */
+static struct vy_recovery *
+vy_recovery_alloc(void)
 {
-	int64_t signature = va_arg(ap, int64_t);
-	int flags = va_arg(ap, int);
-	struct vy_recovery **p_recovery = va_arg(ap, struct vy_recovery **);
-
-	say_verbose("loading vylog %lld", (long long)signature);
-
 	struct vy_recovery *recovery = malloc(sizeof(*recovery));
 	if (recovery == NULL) {
 		diag_set(OutOfMemory, sizeof(*recovery),
 			 "malloc", "struct vy_recovery");
-		goto fail;
+		return NULL;
 	}
 
 	rlist_create(&recovery->lsms);
@@ -2314,7 +2624,9 @@ vy_recovery_new_f(va_list ap)
 	recovery->range_hash = NULL;
 	recovery->run_hash = NULL;
 	recovery->slice_hash = NULL;
+	recovery->tombstone_hash = NULL;
 	recovery->max_id = -1;
+	recovery->key_size = 0;
 	recovery->in_rebootstrap = false;
 
 	recovery->index_id_hash = mh_i64ptr_new();
@@ -2322,14 +2634,32 @@ vy_recovery_new_f(va_list ap)
 	recovery->range_hash = mh_i64ptr_new();
 	recovery->run_hash = mh_i64ptr_new();
 	recovery->slice_hash = mh_i64ptr_new();
+	recovery->tombstone_hash = mh_i64ptr_new();
 	if (recovery->index_id_hash == NULL ||
 	    recovery->lsm_hash == NULL ||
 	    recovery->range_hash == NULL ||
 	    recovery->run_hash == NULL ||
-	    recovery->slice_hash == NULL) {
+	    recovery->slice_hash == NULL ||
+	    recovery->tombstone_hash == NULL) {
 		diag_set(OutOfMemory, 0, "mh_i64ptr_new", "mh_i64ptr_t");
-		goto fail_free;
+		vy_recovery_delete(recovery);
+		return NULL;
 	}
+	return recovery;
+}
+
+static ssize_t
+vy_recovery_new_f(va_list ap)
+{
+	int64_t signature = va_arg(ap, int64_t);
+	int flags = va_arg(ap, int);
+	struct vy_recovery **p_recovery = va_arg(ap, struct vy_recovery **);
+
+	say_verbose("loading vylog %lld", (long long)signature);
+
+	struct vy_recovery *recovery = vy_recovery_alloc();
+	if (recovery == NULL)
+		goto fail;
 
 	/*
 	 * We don't create a log file if there are no objects to
@@ -2345,12 +2675,15 @@ vy_recovery_new_f(va_list ap)
 		goto fail_free;
 
 	int rc;
+	int64_t record_count = 0;
+	double load_start = ev_monotonic_time();
 	struct xrow_header row;
 	while ((rc = xlog_cursor_next(&cursor, &row, false)) == 0) {
 		struct vy_log_record record;
 		rc = vy_log_record_decode(&record, &row);
 		if (rc < 0)
 			break;
+		record_count++;
 		say_verbose("load vylog record: %s",
 			    vy_log_record_str(&record));
 		if (record.type == VY_LOG_SNAPSHOT) {
@@ -2378,6 +2711,9 @@ vy_recovery_new_f(va_list ap)
 
 	if (vy_recovery_build_index_id_hash(recovery) != 0)
 		goto fail_free;
+
+	say_verbose("loaded %lld vylog records in %.3f sec",
+		    (long long)record_count, ev_monotonic_time() - load_start);
 out:
 	say_verbose("done loading vylog");
 	*p_recovery = recovery;
@@ -2441,6 +2777,7 @@ vy_recovery_delete(struct vy_recovery *recovery)
 	struct vy_range_recovery_info *range, *next_range;
 	struct vy_slice_recovery_info *slice, *next_slice;
 	struct vy_run_recovery_info *run, *next_run;
+	struct vy_tombstone_recovery_info *tombstone, *next_tombstone;
 
 	rlist_foreach_entry_safe(lsm, &recovery->lsms, in_recovery, next_lsm) {
 		rlist_foreach_entry_safe(range, &lsm->ranges,
@@ -2450,8 +2787,13 @@ vy_recovery_delete(struct vy_recovery *recovery)
 				free(slice);
 			free(range);
 		}
-		rlist_foreach_entry_safe(run, &lsm->runs, in_lsm, next_run)
+		rlist_foreach_entry_safe(run, &lsm->runs, in_lsm, next_run) {
+			free(run->blobs);
 			free(run);
+		}
+		rlist_foreach_entry_safe(tombstone, &lsm->tombstones,
+					 in_lsm, next_tombstone)
+			free(tombstone);
 		free(lsm->key_parts);
 		free(lsm);
 	}
@@ -2465,10 +2807,43 @@ vy_recovery_delete(struct vy_recovery *recovery)
 		mh_i64ptr_delete(recovery->run_hash);
 	if (recovery->slice_hash != NULL)
 		mh_i64ptr_delete(recovery->slice_hash);
+	if (recovery->tombstone_hash != NULL)
+		mh_i64ptr_delete(recovery->tombstone_hash);
 	TRASH(recovery);
 	free(recovery);
 }
 
+size_t
+vy_recovery_mem_used(struct vy_recovery *recovery)
+{
+	size_t size = sizeof(*recovery) + recovery->key_size;
+	size += mh_i64ptr_memsize(recovery->index_id_hash);
+	size += mh_i64ptr_memsize(recovery->lsm_hash);
+	size += mh_i64ptr_memsize(recovery->range_hash);
+	size += mh_i64ptr_memsize(recovery->run_hash);
+	size += mh_i64ptr_memsize(recovery->slice_hash);
+	size += mh_i64ptr_memsize(recovery->tombstone_hash);
+	size += mh_size(recovery->lsm_hash) *
+		sizeof(struct vy_lsm_recovery_info);
+	size += mh_size(recovery->range_hash) *
+		sizeof(struct vy_range_recovery_info);
+	size += mh_size(recovery->run_hash) *
+		sizeof(struct vy_run_recovery_info);
+	size += mh_size(recovery->slice_hash) *
+		sizeof(struct vy_slice_recovery_info);
+	size += mh_size(recovery->tombstone_hash) *
+		sizeof(struct vy_tombstone_recovery_info);
+	return size;
+}
+
+size_t
+vy_log_image_mem_used(void)
+{
+	if (vy_log.image == NULL)
+		return 0;
+	return vy_recovery_mem_used(vy_log.image);
+}
+
 /** Write a record to vylog. */
 static int
 vy_log_append_record(struct xlog *xlog, struct vy_log_record *record)
@@ -2490,6 +2865,7 @@ vy_log_append_lsm(struct xlog *xlog, struct vy_lsm_recovery_info *lsm)
 	struct vy_range_recovery_info *range;
 	struct vy_slice_recovery_info *slice;
 	struct vy_run_recovery_info *run;
+	struct vy_tombstone_recovery_info *tombstone;
 	struct vy_log_record record;
 
 	vy_log_record_init(&record);
@@ -2515,6 +2891,7 @@ vy_log_append_lsm(struct xlog *xlog, struct vy_lsm_recovery_info *lsm)
 			record.type = VY_LOG_CREATE_RUN;
 			record.dump_lsn = run->dump_lsn;
 			record.dump_count = run->dump_count;
+			record.blobs = run->blobs;
 		}
 		record.lsm_id = lsm->id;
 		record.run_id = run->id;
@@ -2559,6 +2936,18 @@ vy_log_append_lsm(struct xlog *xlog, struct vy_lsm_recovery_info *lsm)
 		}
 	}
 
+	rlist_foreach_entry(tombstone, &lsm->tombstones, in_lsm) {
+		vy_log_record_init(&record);
+		record.type = VY_LOG_INSERT_TOMBSTONE;
+		record.lsm_id = lsm->id;
+		record.tombstone_id = tombstone->id;
+		record.tombstone_lsn = tombstone->lsn;
+		record.begin = tombstone->begin;
+		record.end = tombstone->end;
+		if (vy_log_append_record(xlog, &record) != 0)
+			return -1;
+	}
+
 	if (lsm->drop_lsn >= 0) {
 		vy_log_record_init(&record);
 		record.type = VY_LOG_DROP_LSM;
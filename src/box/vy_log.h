@@ -97,6 +97,7 @@ enum vy_log_record_type {
 	/**
 	 * Commit a vinyl run file creation.
 	 * Requires vy_log_record::lsm_id, run_id, dump_lsn, dump_count.
+	 * Optionally stores blobs.
 	 *
 	 * Written after a run file was successfully created.
 	 */
@@ -217,6 +218,17 @@ enum vy_log_record_type {
 	 * See also VY_LOG_REBOOTSTRAP.
 	 */
 	VY_LOG_ABORT_REBOOTSTRAP	= 17,
+	/**
+	 * Insert a range tombstone into an LSM tree.
+	 * Requires vy_log_record::lsm_id, tombstone_id, tombstone_lsn,
+	 * begin, end. See vy_tombstone.h.
+	 */
+	VY_LOG_INSERT_TOMBSTONE		= 18,
+	/**
+	 * Delete a range tombstone purged by compaction.
+	 * Requires vy_log_record::tombstone_id.
+	 */
+	VY_LOG_DELETE_TOMBSTONE		= 19,
 
 	vy_log_record_type_MAX
 };
@@ -283,6 +295,15 @@ struct vy_log_record {
 	int64_t gc_lsn;
 	/** For runs: number of dumps it took to create the run. */
 	uint32_t dump_count;
+	/**
+	 * For runs: MsgPack array of IDs of blob files storing
+	 * values referenced by the run, NULL if there's none.
+	 */
+	const char *blobs;
+	/** Unique ID of the range tombstone. */
+	int64_t tombstone_id;
+	/** LSN of the WAL row that committed the range tombstone. */
+	int64_t tombstone_lsn;
 	/** Link in vy_log_tx::records. */
 	struct stailq_entry in_tx;
 };
@@ -304,11 +325,18 @@ struct vy_recovery {
 	struct mh_i64ptr_t *run_hash;
 	/** ID -> vy_slice_recovery_info. */
 	struct mh_i64ptr_t *slice_hash;
+	/** ID -> vy_tombstone_recovery_info. */
+	struct mh_i64ptr_t *tombstone_hash;
 	/**
 	 * Maximal vinyl object ID, according to the metadata log,
 	 * or -1 in case no vinyl objects were recovered.
 	 */
 	int64_t max_id;
+	/**
+	 * Total size of keys stored in ranges, slices and range
+	 * tombstones, see vy_recovery_mem_used().
+	 */
+	size_t key_size;
 	/**
 	 * Set if we are currently processing a rebootstrap section,
 	 * i.e. we encountered a VY_LOG_REBOOTSTRAP record and haven't
@@ -360,6 +388,11 @@ struct vy_lsm_recovery_info {
 	 * vy_run_recovery_info::in_lsm.
 	 */
 	struct rlist runs;
+	/**
+	 * List of all range tombstones of the LSM tree, linked by
+	 * vy_tombstone_recovery_info::in_lsm, oldest first.
+	 */
+	struct rlist tombstones;
 	/**
 	 * Pointer to an LSM tree that is going to replace
 	 * this one after successful ALTER.
@@ -403,6 +436,11 @@ struct vy_run_recovery_info {
 	int64_t gc_lsn;
 	/** Number of dumps it took to create the run. */
 	uint32_t dump_count;
+	/**
+	 * MsgPack array of IDs of blob files referenced by
+	 * the run or NULL if the run doesn't reference any.
+	 */
+	char *blobs;
 	/**
 	 * True if the run was not committed (there's
 	 * VY_LOG_PREPARE_RUN, but no VY_LOG_CREATE_RUN).
@@ -421,6 +459,20 @@ struct vy_run_recovery_info {
 	void *data;
 };
 
+/** Range tombstone info stored in a recovery context. */
+struct vy_tombstone_recovery_info {
+	/** Link in vy_lsm_recovery_info::tombstones. */
+	struct rlist in_lsm;
+	/** ID of the tombstone. */
+	int64_t id;
+	/** LSN of the WAL row that committed the tombstone. */
+	int64_t lsn;
+	/** Start of the range, stored in MsgPack array. */
+	char *begin;
+	/** End of the range, stored in MsgPack array. */
+	char *end;
+};
+
 /** Slice info stored in a recovery context. */
 struct vy_slice_recovery_info {
 	/** Link in vy_range_recovery_info::slices. */
@@ -596,6 +648,22 @@ enum vy_recovery_flag {
 struct vy_recovery *
 vy_recovery_new(int64_t signature, int flags);
 
+/**
+ * Return the amount of memory used by a recovery context.
+ * Key definitions and blob lists of LSM trees and runs aren't
+ * counted as they are negligible compared to range and slice
+ * boundaries.
+ */
+size_t
+vy_recovery_mem_used(struct vy_recovery *recovery);
+
+/**
+ * Return the amount of memory used by the image of the current
+ * log file kept for log rotation, see vy_log_rotate().
+ */
+size_t
+vy_log_image_mem_used(void);
+
 /**
  * Free a recovery context created by vy_recovery_new().
  */
@@ -712,6 +780,34 @@ vy_log_delete_range(int64_t range_id)
 	vy_log_write(&record);
 }
 
+/** Helper to log a range tombstone insertion. */
+static inline void
+vy_log_insert_tombstone(int64_t lsm_id, int64_t tombstone_id,
+			int64_t tombstone_lsn, const char *begin,
+			const char *end)
+{
+	struct vy_log_record record;
+	vy_log_record_init(&record);
+	record.type = VY_LOG_INSERT_TOMBSTONE;
+	record.lsm_id = lsm_id;
+	record.tombstone_id = tombstone_id;
+	record.tombstone_lsn = tombstone_lsn;
+	record.begin = begin;
+	record.end = end;
+	vy_log_write(&record);
+}
+
+/** Helper to log a range tombstone deletion. */
+static inline void
+vy_log_delete_tombstone(int64_t tombstone_id)
+{
+	struct vy_log_record record;
+	vy_log_record_init(&record);
+	record.type = VY_LOG_DELETE_TOMBSTONE;
+	record.tombstone_id = tombstone_id;
+	vy_log_write(&record);
+}
+
 /** Helper to log a vinyl run file creation. */
 static inline void
 vy_log_prepare_run(int64_t lsm_id, int64_t run_id)
@@ -727,7 +823,7 @@ vy_log_prepare_run(int64_t lsm_id, int64_t run_id)
 /** Helper to log a vinyl run creation. */
 static inline void
 vy_log_create_run(int64_t lsm_id, int64_t run_id,
-		  int64_t dump_lsn, uint32_t dump_count)
+		  int64_t dump_lsn, uint32_t dump_count, const char *blobs)
 {
 	struct vy_log_record record;
 	vy_log_record_init(&record);
@@ -736,6 +832,7 @@ vy_log_create_run(int64_t lsm_id, int64_t run_id,
 	record.run_id = run_id;
 	record.dump_lsn = dump_lsn;
 	record.dump_count = dump_count;
+	record.blobs = blobs;
 	vy_log_write(&record);
 }
 
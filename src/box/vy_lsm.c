@@ -37,6 +37,7 @@
 #include <sys/types.h>
 #include <small/mempool.h>
 
+#include "assoc.h"
 #include "diag.h"
 #include "fiber.h"
 #include "errcode.h"
@@ -52,6 +53,7 @@
 #include "vy_run.h"
 #include "vy_stat.h"
 #include "vy_stmt.h"
+#include "vy_tombstone.h"
 #include "vy_upsert.h"
 #include "vy_history.h"
 #include "vy_read_set.h"
@@ -88,6 +90,7 @@ vy_lsm_env_create(struct vy_lsm_env *env, const char *path,
 	env->upsert_thresh_arg = upsert_thresh_arg;
 	env->too_long_threshold = TIMEOUT_INFINITY;
 	env->lsm_count = 0;
+	memset(env->policy_stat, 0, sizeof(env->policy_stat));
 	mempool_create(&env->history_node_pool, cord_slab_cache(),
 		       sizeof(struct vy_history_node));
 	return 0;
@@ -150,11 +153,12 @@ vy_lsm_new(struct vy_lsm_env *lsm_env, struct vy_cache_env *cache_env,
 
 	lsm->cmp_def = cmp_def;
 	lsm->key_def = key_def;
-	if (index_def->iid == 0) {
+	if (index_def->iid == 0 || index_def->opts.covering) {
 		/*
 		 * Disk tuples can be returned to an user from a
-		 * primary key. And they must have field
-		 * definitions as well as space->format tuples.
+		 * primary key or a covering secondary key. And
+		 * they must have field definitions as well as
+		 * space->format tuples.
 		 */
 		lsm->disk_format = format;
 	} else {
@@ -166,7 +170,8 @@ vy_lsm_new(struct vy_lsm_env *lsm_env, struct vy_cache_env *cache_env,
 		 * up a full tuple in the primary index.
 		 */
 		lsm->disk_format = lsm_env->key_format;
-
+	}
+	if (index_def->iid > 0) {
 		lsm->pk_in_cmp_def = key_def_find_pk_in_cmp_def(lsm->cmp_def,
 								pk->key_def,
 								&fiber()->gc);
@@ -188,14 +193,26 @@ vy_lsm_new(struct vy_lsm_env *lsm_env, struct vy_cache_env *cache_env,
 	if (lsm->mem == NULL)
 		goto fail_mem;
 
+	lsm->blob_hash = mh_i64ptr_new();
+	if (lsm->blob_hash == NULL) {
+		diag_set(OutOfMemory, 0, "mh_i64ptr_new", "blob_hash");
+		goto fail_blob_hash;
+	}
+
 	lsm->id = -1;
 	lsm->dump_lsn = -1;
 	lsm->commit_lsn = -1;
-	vy_cache_create(&lsm->cache, cache_env, cmp_def, index_def->iid == 0);
+	/*
+	 * Tuples read from a covering index aren't shared with
+	 * the primary index cache so account them as well.
+	 */
+	vy_cache_create(&lsm->cache, cache_env, cmp_def,
+			index_def->iid == 0 || index_def->opts.covering);
 	rlist_create(&lsm->sealed);
 	vy_range_tree_new(&lsm->range_tree);
 	vy_range_heap_create(&lsm->range_heap);
 	rlist_create(&lsm->runs);
+	rlist_create(&lsm->tombstones);
 	lsm->pk = pk;
 	if (pk != NULL)
 		vy_lsm_ref(pk);
@@ -213,6 +230,8 @@ vy_lsm_new(struct vy_lsm_env *lsm_env, struct vy_cache_env *cache_env,
 	lsm_env->lsm_count++;
 	return lsm;
 
+fail_blob_hash:
+	vy_mem_delete(lsm->mem);
 fail_mem:
 	histogram_delete(lsm->run_hist);
 fail_run_hist:
@@ -243,6 +262,14 @@ vy_range_tree_free_cb(vy_range_tree_t *t, struct vy_range *range, void *arg)
 	return NULL;
 }
 
+/** Return statistics of the compaction policy used by an LSM tree. */
+static inline struct vy_compaction_policy_stat *
+vy_lsm_policy_stat(struct vy_lsm *lsm)
+{
+	assert(lsm->opts.compaction_policy < index_compaction_policy_MAX);
+	return &lsm->env->policy_stat[lsm->opts.compaction_policy];
+}
+
 void
 vy_lsm_delete(struct vy_lsm *lsm)
 {
@@ -259,6 +286,15 @@ vy_lsm_delete(struct vy_lsm *lsm)
 	if (lsm->index_id == 0)
 		lsm->env->compacted_data_size -=
 			lsm->stat.disk.last_level_count.bytes;
+	/*
+	 * Ranges are freed without removing them from the tree
+	 * so unaccount them right away. Runs are unaccounted by
+	 * vy_lsm_remove_run() below.
+	 */
+	struct vy_compaction_policy_stat *policy_stat = vy_lsm_policy_stat(lsm);
+	policy_stat->range_count -= lsm->range_count;
+	policy_stat->slice_count -= lsm->slice_count;
+	policy_stat->compacted_size -= lsm->stat.disk.last_level_count.bytes;
 	if (lsm->pk != NULL)
 		vy_lsm_unref(lsm->pk);
 
@@ -273,6 +309,13 @@ vy_lsm_delete(struct vy_lsm *lsm)
 
 	vy_range_tree_iter(&lsm->range_tree, NULL, vy_range_tree_free_cb, NULL);
 	vy_range_heap_destroy(&lsm->range_heap);
+
+	struct vy_tombstone *tombstone, *next_tombstone;
+	rlist_foreach_entry_safe(tombstone, &lsm->tombstones, in_lsm,
+				 next_tombstone)
+		vy_tombstone_delete(tombstone);
+	/* Blob files may still be referenced by runs in use. */
+	vy_blob_hash_delete(lsm->blob_hash);
 	tuple_format_unref(lsm->disk_format);
 	key_def_delete(lsm->cmp_def);
 	key_def_delete(lsm->key_def);
@@ -377,6 +420,13 @@ vy_lsm_recover_run(struct vy_lsm *lsm, struct vy_run_recovery_info *run_info,
 		vy_run_unref(run);
 		return NULL;
 	}
+	if (run_info->blobs != NULL &&
+	    (vy_run_blob_decode(run_info->blobs, &run->blobs,
+				&run->blob_count) != 0 ||
+	     vy_lsm_attach_blobs(lsm, run) != 0)) {
+		vy_run_unref(run);
+		return NULL;
+	}
 	vy_lsm_add_run(lsm, run);
 
 	/*
@@ -684,6 +734,21 @@ vy_lsm_recover(struct vy_lsm *lsm, struct vy_recovery *recovery,
 				    (long long)prev->id));
 		return -1;
 	}
+
+	struct vy_tombstone_recovery_info *tombstone_info;
+	rlist_foreach_entry(tombstone_info, &lsm_info->tombstones, in_lsm) {
+		struct vy_tombstone *tombstone;
+		tombstone = vy_tombstone_new(lsm, tombstone_info->id,
+					     tombstone_info->lsn,
+					     lsm->env->key_format,
+					     lsm->cmp_def,
+					     tombstone_info->begin,
+					     tombstone_info->end);
+		if (tombstone == NULL)
+			return -1;
+		rlist_add_tail_entry(&lsm->tombstones, tombstone, in_lsm);
+	}
+	vy_lsm_purge_tombstones(lsm);
 	return 0;
 }
 
@@ -740,10 +805,12 @@ vy_lsm_add_run(struct vy_lsm *lsm, struct vy_run *run)
 	rlist_add_entry(&lsm->runs, run, in_lsm);
 	lsm->run_count++;
 	vy_disk_stmt_counter_add(&lsm->stat.disk.count, &run->count);
+	vy_lsm_policy_stat(lsm)->disk_size += run->count.bytes;
 	vy_stmt_stat_add(&lsm->stat.disk.stmt, &run->info.stmt_stat);
 
 	lsm->bloom_size += bloom_size;
 	lsm->page_index_size += page_index_size;
+	lsm->dict_size += run->info.dict_size;
 
 	env->bloom_size += bloom_size;
 	env->page_index_size += page_index_size;
@@ -755,6 +822,11 @@ vy_lsm_add_run(struct vy_lsm *lsm, struct vy_run *run)
 	env->disk_index_size += bloom_size + page_index_size;
 	if (lsm->index_id > 0)
 		env->disk_index_size += run->count.bytes;
+
+	for (uint32_t i = 0; i < run->blob_count; i++) {
+		assert(run->blobs[i].blob != NULL);
+		run->blobs[i].blob->live_bytes += run->blobs[i].bytes;
+	}
 }
 
 void
@@ -769,10 +841,12 @@ vy_lsm_remove_run(struct vy_lsm *lsm, struct vy_run *run)
 	rlist_del_entry(run, in_lsm);
 	lsm->run_count--;
 	vy_disk_stmt_counter_sub(&lsm->stat.disk.count, &run->count);
+	vy_lsm_policy_stat(lsm)->disk_size -= run->count.bytes;
 	vy_stmt_stat_sub(&lsm->stat.disk.stmt, &run->info.stmt_stat);
 
 	lsm->bloom_size -= bloom_size;
 	lsm->page_index_size -= page_index_size;
+	lsm->dict_size -= run->info.dict_size;
 
 	env->bloom_size -= bloom_size;
 	env->page_index_size -= page_index_size;
@@ -784,6 +858,55 @@ vy_lsm_remove_run(struct vy_lsm *lsm, struct vy_run *run)
 	env->disk_index_size -= bloom_size + page_index_size;
 	if (lsm->index_id > 0)
 		env->disk_index_size -= run->count.bytes;
+
+	for (uint32_t i = 0; i < run->blob_count; i++) {
+		assert(run->blobs[i].blob != NULL);
+		run->blobs[i].blob->live_bytes -= run->blobs[i].bytes;
+	}
+}
+
+int
+vy_lsm_attach_blobs(struct vy_lsm *lsm, struct vy_run *run)
+{
+	assert(rlist_empty(&run->in_lsm));
+	char path[PATH_MAX];
+	for (uint32_t i = 0; i < run->blob_count; i++) {
+		struct vy_run_blob *ref = &run->blobs[i];
+		if (ref->blob != NULL)
+			continue;
+		vy_run_snprint_path(path, sizeof(path), lsm->env->path,
+				    lsm->space_id, lsm->index_id,
+				    ref->id, VY_FILE_BLOB);
+		ref->blob = vy_blob_hash_open(lsm->blob_hash, ref->id, path);
+		if (ref->blob == NULL)
+			goto fail;
+	}
+	return 0;
+fail:
+	for (uint32_t i = 0; i < run->blob_count; i++) {
+		struct vy_run_blob *ref = &run->blobs[i];
+		if (ref->blob != NULL) {
+			vy_blob_unref(ref->blob);
+			ref->blob = NULL;
+		}
+	}
+	return -1;
+}
+
+int
+vy_lsm_load_blob(struct vy_lsm *lsm, struct tuple *stmt, struct tuple **ret)
+{
+	struct vy_blob_extent extent;
+	vy_blob_stmt_extent(stmt, &extent);
+	struct vy_blob *blob = vy_blob_hash_find(lsm->blob_hash,
+						 extent.blob_id);
+	if (blob == NULL) {
+		diag_set(ClientError, ER_INVALID_RUN_FILE,
+			 tt_sprintf("Blob file %lld not found",
+				    (long long)extent.blob_id));
+		return -1;
+	}
+	return vy_blob_load(blob, stmt, ret);
 }
 
 void
@@ -793,6 +916,7 @@ vy_lsm_add_range(struct vy_lsm *lsm, struct vy_range *range)
 	vy_range_heap_insert(&lsm->range_heap, range);
 	vy_range_tree_insert(&lsm->range_tree, range);
 	lsm->range_count++;
+	vy_lsm_policy_stat(lsm)->range_count++;
 }
 
 void
@@ -802,12 +926,15 @@ vy_lsm_remove_range(struct vy_lsm *lsm, struct vy_range *range)
 	vy_range_heap_delete(&lsm->range_heap, range);
 	vy_range_tree_remove(&lsm->range_tree, range);
 	lsm->range_count--;
+	vy_lsm_policy_stat(lsm)->range_count--;
 }
 
 void
 vy_lsm_acct_range(struct vy_lsm *lsm, struct vy_range *range)
 {
 	histogram_collect(lsm->run_hist, range->slice_count);
+	lsm->slice_count += range->slice_count;
+	vy_lsm_policy_stat(lsm)->slice_count += range->slice_count;
 	lsm->sum_dumps_per_compaction += range->dumps_per_compaction;
 	vy_disk_stmt_counter_add(&lsm->stat.disk.compaction.queue,
 				 &range->compaction_queue);
@@ -817,6 +944,7 @@ vy_lsm_acct_range(struct vy_lsm *lsm, struct vy_range *range)
 						struct vy_slice, in_range);
 		vy_disk_stmt_counter_add(&lsm->stat.disk.last_level_count,
 					 &slice->count);
+		vy_lsm_policy_stat(lsm)->compacted_size += slice->count.bytes;
 		if (lsm->index_id == 0)
 			lsm->env->compacted_data_size += slice->count.bytes;
 	}
@@ -826,6 +954,8 @@ void
 vy_lsm_unacct_range(struct vy_lsm *lsm, struct vy_range *range)
 {
 	histogram_discard(lsm->run_hist, range->slice_count);
+	lsm->slice_count -= range->slice_count;
+	vy_lsm_policy_stat(lsm)->slice_count -= range->slice_count;
 	lsm->sum_dumps_per_compaction -= range->dumps_per_compaction;
 	vy_disk_stmt_counter_sub(&lsm->stat.disk.compaction.queue,
 				 &range->compaction_queue);
@@ -835,6 +965,7 @@ vy_lsm_unacct_range(struct vy_lsm *lsm, struct vy_range *range)
 						struct vy_slice, in_range);
 		vy_disk_stmt_counter_sub(&lsm->stat.disk.last_level_count,
 					 &slice->count);
+		vy_lsm_policy_stat(lsm)->compacted_size -= slice->count.bytes;
 		if (lsm->index_id == 0)
 			lsm->env->compacted_data_size -= slice->count.bytes;
 	}
@@ -849,6 +980,8 @@ vy_lsm_acct_dump(struct vy_lsm *lsm, double time,
 	lsm->stat.disk.dump.time += time;
 	vy_stmt_counter_add(&lsm->stat.disk.dump.input, input);
 	vy_disk_stmt_counter_add(&lsm->stat.disk.dump.output, output);
+	vy_lsm_policy_stat(lsm)->dump_input += input->bytes;
+	vy_lsm_policy_stat(lsm)->disk_output += output->bytes;
 }
 
 void
@@ -860,6 +993,30 @@ vy_lsm_acct_compaction(struct vy_lsm *lsm, double time,
 	lsm->stat.disk.compaction.time += time;
 	vy_disk_stmt_counter_add(&lsm->stat.disk.compaction.input, input);
 	vy_disk_stmt_counter_add(&lsm->stat.disk.compaction.output, output);
+	vy_lsm_policy_stat(lsm)->disk_output += output->bytes;
+}
+
+void
+vy_lsm_set_compaction_policy(struct vy_lsm *lsm,
+			     enum index_compaction_policy policy)
+{
+	assert(policy < index_compaction_policy_MAX);
+	struct vy_compaction_policy_stat *old_stat = vy_lsm_policy_stat(lsm);
+	struct vy_compaction_policy_stat *new_stat =
+					&lsm->env->policy_stat[policy];
+	if (old_stat == new_stat)
+		return;
+	int64_t disk_size = lsm->stat.disk.count.bytes;
+	int64_t compacted_size = lsm->stat.disk.last_level_count.bytes;
+	old_stat->slice_count -= lsm->slice_count;
+	old_stat->range_count -= lsm->range_count;
+	old_stat->disk_size -= disk_size;
+	old_stat->compacted_size -= compacted_size;
+	new_stat->slice_count += lsm->slice_count;
+	new_stat->range_count += lsm->range_count;
+	new_stat->disk_size += disk_size;
+	new_stat->compacted_size += compacted_size;
+	lsm->opts.compaction_policy = policy;
 }
 
 int
@@ -1006,11 +1163,12 @@ vy_lsm_commit_upsert(struct vy_lsm *lsm, struct vy_mem *mem,
 
 	/*
 	 * If there are no other mems and runs and n_upserts == 0,
-	 * then we can turn the UPSERT into the REPLACE.
+	 * then we can turn the UPSERT into the REPLACE. Not if
+	 * the older statement may be deleted by a range tombstone.
 	 */
 	if (n_upserts == 0 &&
 	    lsm->stat.memory.count.rows == lsm->mem->count.rows &&
-	    lsm->run_count == 0) {
+	    lsm->run_count == 0 && rlist_empty(&lsm->tombstones)) {
 		older = vy_mem_older_lsn(mem, entry);
 		assert(older.stmt == NULL ||
 		       vy_stmt_type(older.stmt) != IPROTO_UPSERT);
@@ -1170,6 +1328,8 @@ vy_lsm_split_range(struct vy_lsm *lsm, struct vy_range *range)
 				vy_range_add_slice(part, new_slice);
 		}
 		part->needs_compaction = range->needs_compaction;
+		part->needs_purge = range->needs_purge;
+		part->purged_lsn = range->purged_lsn;
 		vy_range_update_compaction_priority(part, &lsm->opts);
 		vy_range_update_dumps_per_compaction(part);
 	}
@@ -1271,6 +1431,7 @@ vy_lsm_coalesce_range(struct vy_lsm *lsm, struct vy_range *range)
 	 * Move run slices of the coalesced ranges to the
 	 * resulting range and delete the former.
 	 */
+	result->purged_lsn = INT64_MAX;
 	it = first;
 	while (it != end) {
 		struct vy_range *next = vy_range_tree_next(&lsm->range_tree, it);
@@ -1281,9 +1442,16 @@ vy_lsm_coalesce_range(struct vy_lsm *lsm, struct vy_range *range)
 		vy_disk_stmt_counter_add(&result->count, &it->count);
 		if (it->needs_compaction)
 			result->needs_compaction = true;
+		if (it->needs_purge)
+			result->needs_purge = true;
+		if (it->slice_count > 0)
+			result->purged_lsn = MIN(result->purged_lsn,
+						 it->purged_lsn);
 		vy_range_delete(it);
 		it = next;
 	}
+	if (result->slice_count == 0)
+		result->purged_lsn = 0;
 	/*
 	 * Even though coalescing increases read amplification,
 	 * we don't need to compact the resulting range as long
@@ -1308,6 +1476,59 @@ fail_range:
 	return false;
 }
 
+void
+vy_lsm_purge_tombstones(struct vy_lsm *lsm)
+{
+	bool needs_update = false;
+	struct vy_tombstone *tombstone, *next_tombstone;
+	rlist_foreach_entry_safe(tombstone, &lsm->tombstones, in_lsm,
+				 next_tombstone) {
+		/*
+		 * Statements deleted by a tombstone that hasn't been
+		 * dumped yet may still be stored in memory.
+		 */
+		if (tombstone->lsn > lsm->dump_lsn)
+			break;
+		bool is_purged = true;
+		struct vy_range *range;
+		struct vy_range_tree_iterator it;
+		vy_range_tree_ifirst(&lsm->range_tree, &it);
+		while ((range = vy_range_tree_inext(&it)) != NULL) {
+			if (range->slice_count == 0 ||
+			    range->purged_lsn >= tombstone->lsn ||
+			    !vy_tombstone_intersects(tombstone, range->begin,
+						     range->end, lsm->cmp_def))
+				continue;
+			is_purged = false;
+			/*
+			 * A range that is being compacted is checked
+			 * again when the compaction completes.
+			 */
+			if (range->needs_purge || vy_range_is_scheduled(range))
+				continue;
+			vy_lsm_unacct_range(lsm, range);
+			range->needs_purge = true;
+			vy_range_update_compaction_priority(range, &lsm->opts);
+			vy_lsm_acct_range(lsm, range);
+			needs_update = true;
+		}
+		if (!is_purged)
+			continue;
+		/*
+		 * All statements deleted by the tombstone have been
+		 * discarded or replaced with DELETEs by compaction
+		 * so it isn't needed anymore.
+		 */
+		vy_log_tx_begin();
+		vy_log_delete_tombstone(tombstone->id);
+		vy_log_tx_try_commit();
+		rlist_del_entry(tombstone, in_lsm);
+		vy_tombstone_delete(tombstone);
+	}
+	if (needs_update)
+		vy_range_heap_update_all(&lsm->range_heap);
+}
+
 void
 vy_lsm_force_compaction(struct vy_lsm *lsm)
 {
@@ -52,6 +52,7 @@ extern "C" {
 #endif /* defined(__cplusplus) */
 
 struct histogram;
+struct mh_i64ptr_t;
 struct tuple;
 struct tuple_format;
 struct vy_lsm;
@@ -124,6 +125,9 @@ struct vy_lsm_env {
 	 * in bytes, without taking into account disk compression.
 	 */
 	int64_t compaction_queue_size;
+	/** Amplification statistics, per compaction policy. */
+	struct vy_compaction_policy_stat
+		policy_stat[index_compaction_policy_MAX];
 	/** Memory pool for vy_history_node allocations. */
 	struct mempool history_node_pool;
 };
@@ -255,6 +259,17 @@ struct vy_lsm {
 	 * linked by vy_run->in_lsm.
 	 */
 	struct rlist runs;
+	/**
+	 * Blob files referenced by runs of this LSM tree,
+	 * vy_blob::id => struct vy_blob. See vy_blob.h.
+	 */
+	struct mh_i64ptr_t *blob_hash;
+	/**
+	 * Range tombstones of the primary index, linked by
+	 * vy_tombstone::in_lsm, sorted by LSN in ascending order.
+	 * Always empty for secondary indexes, see vy_tombstone.h.
+	 */
+	struct rlist tombstones;
 	/** Number of entries in all ranges. */
 	int run_count;
 	/**
@@ -262,10 +277,14 @@ struct vy_lsm {
 	 * have a particular number of runs.
 	 */
 	struct histogram *run_hist;
+	/** Number of slices in all ranges. */
+	int slice_count;
 	/** Size of memory used for bloom filters. */
 	size_t bloom_size;
 	/** Size of memory used for page index. */
 	size_t page_index_size;
+	/** Size of page compression dictionaries of all runs. */
+	size_t dict_size;
 	/**
 	 * Incremented for each change of the mem list,
 	 * to invalidate iterators.
@@ -468,6 +487,24 @@ vy_lsm_add_run(struct vy_lsm *lsm, struct vy_run *run);
 void
 vy_lsm_remove_run(struct vy_lsm *lsm, struct vy_run *run);
 
+/**
+ * Open blob files referenced by a run and attach them to the
+ * run. Must be called before the run is added to the LSM tree.
+ * Returns 0 on success, -1 on error.
+ */
+int
+vy_lsm_attach_blobs(struct vy_lsm *lsm, struct vy_run *run);
+
+/**
+ * Load values referenced by a statement read from a run of
+ * an LSM tree from blob files. The loaded statement is returned
+ * in @a ret and must be unreferenced by the caller.
+ * Returns 0 on success, -1 on error.
+ */
+int
+vy_lsm_load_blob(struct vy_lsm *lsm, struct tuple *stmt,
+		 struct tuple **ret);
+
 /**
  * Add a range to both the range tree and the range heap
  * of an LSM tree.
@@ -519,6 +556,16 @@ vy_lsm_acct_compaction(struct vy_lsm *lsm, double time,
 		       const struct vy_disk_stmt_counter *input,
 		       const struct vy_disk_stmt_counter *output);
 
+/**
+ * Switch an LSM tree to a new compaction policy. Moves the LSM
+ * tree data accounted in per policy statistics accordingly.
+ * Note, it doesn't update the compaction priority of ranges -
+ * it will be recalculated on the next dump.
+ */
+void
+vy_lsm_set_compaction_policy(struct vy_lsm *lsm,
+			     enum index_compaction_policy policy);
+
 /**
  * Allocate a new active in-memory index for an LSM tree while
  * moving the old one to the sealed list. Used by the dump task
@@ -574,6 +621,15 @@ vy_lsm_split_range(struct vy_lsm *lsm, struct vy_range *range);
 bool
 vy_lsm_coalesce_range(struct vy_lsm *lsm, struct vy_range *range);
 
+/**
+ * Drop range tombstones of a primary index that have been
+ * applied to all intersecting ranges by major compaction and
+ * schedule compaction of the ranges that still store statements
+ * deleted by dumped tombstones.
+ */
+void
+vy_lsm_purge_tombstones(struct vy_lsm *lsm);
+
 /**
  * Mark all ranges of an LSM tree for major compaction.
  */
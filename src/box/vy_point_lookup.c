@@ -36,6 +36,7 @@
 
 #include <small/region.h>
 #include <small/rlist.h>
+#include <third_party/qsort_arg.h>
 
 #include "fiber.h"
 
@@ -82,6 +83,7 @@ vy_point_lookup_scan_cache(struct vy_lsm *lsm, const struct vy_read_view **rv,
 	if (entry.stmt == NULL || vy_stmt_lsn(entry.stmt) > (*rv)->vlsn)
 		return 0;
 
+	lsm->cache.stat.hit++;
 	vy_stmt_counter_acct_tuple(&lsm->cache.stat.get, entry.stmt);
 	return vy_history_append_stmt(history, entry);
 }
@@ -184,55 +186,109 @@ vy_point_lookup_scan_slices(struct vy_lsm *lsm, const struct vy_read_view **rv,
 	assert(i == slice_count);
 	int rc = 0;
 	for (i = 0; i < slice_count; i++) {
-		if (rc == 0 && !vy_history_is_terminal(history))
-			rc = vy_point_lookup_scan_slice(lsm, slices[i],
-							rv, key, history);
-		vy_slice_unpin(slices[i]);
+		if (rc != 0 || vy_history_is_terminal(history))
+			break;
+		rc = vy_point_lookup_scan_slice(lsm, slices[i],
+						rv, key, history);
+	}
+	/*
+	 * Load values stored in blob files while the slices are
+	 * still pinned so that the blob files stay open.
+	 */
+	if (rc == 0 && vy_history_is_terminal(history)) {
+		struct vy_history_node *node = rlist_last_entry(
+				&history->stmts, struct vy_history_node, link);
+		struct tuple *loaded;
+		if ((vy_stmt_flags(node->entry.stmt) & VY_STMT_BLOB) != 0) {
+			rc = vy_lsm_load_blob(lsm, node->entry.stmt, &loaded);
+			if (rc == 0) {
+				vy_history_replace_oldest_stmt(history, loaded);
+				tuple_unref(loaded);
+			}
+		}
 	}
+	for (i = 0; i < slice_count; i++)
+		vy_slice_unpin(slices[i]);
 	return rc;
 }
 
-int
-vy_point_lookup(struct vy_lsm *lsm, struct vy_tx *tx,
-		const struct vy_read_view **rv,
-		struct vy_entry key, struct vy_entry *ret)
+/** State of a point lookup of a single key. */
+struct vy_point_lookup_req {
+	/** Key to look up. */
+	struct vy_entry key;
+	/** Statements read from the write set and the cache. */
+	struct vy_history history;
+	/** Statements read from in-memory trees. */
+	struct vy_history mem_history;
+	/** Statements read from runs. */
+	struct vy_history disk_history;
+	/** Version of the active in-memory tree at the time of scan. */
+	uint32_t mem_version;
+	/** Version of the in-memory tree list at the time of scan. */
+	uint32_t mem_list_version;
+};
+
+static void
+vy_point_lookup_req_create(struct vy_point_lookup_req *req,
+			   struct vy_lsm *lsm, struct vy_entry key)
 {
-	/* All key parts must be set for a point lookup. */
-	assert(vy_stmt_is_full_key(key.stmt, lsm->cmp_def));
-	assert(tx == NULL || tx->state == VINYL_TX_READY);
-
-	*ret = vy_entry_none();
-	int rc = 0;
-
-	/* History list */
-	struct vy_history history, mem_history, disk_history;
-	vy_history_create(&history, &lsm->env->history_node_pool);
-	vy_history_create(&mem_history, &lsm->env->history_node_pool);
-	vy_history_create(&disk_history, &lsm->env->history_node_pool);
+	req->key = key;
+	vy_history_create(&req->history, &lsm->env->history_node_pool);
+	vy_history_create(&req->mem_history, &lsm->env->history_node_pool);
+	vy_history_create(&req->disk_history, &lsm->env->history_node_pool);
+	req->mem_version = 0;
+	req->mem_list_version = 0;
+}
 
-	rc = vy_point_lookup_scan_txw(lsm, tx, key, &history);
-	if (rc != 0 || vy_history_is_terminal(&history))
-		goto done;
+/**
+ * Scan the transaction write set, the cache, and in-memory trees
+ * for the key. Never yields. Sets @is_done unless the key history
+ * needs to be completed with vy_point_lookup_scan_disk().
+ */
+static int
+vy_point_lookup_scan_memory(struct vy_lsm *lsm, struct vy_tx *tx,
+			    const struct vy_read_view **rv,
+			    struct vy_point_lookup_req *req, bool *is_done)
+{
+	*is_done = true;
+	int rc = vy_point_lookup_scan_txw(lsm, tx, req->key, &req->history);
+	if (rc != 0 || vy_history_is_terminal(&req->history))
+		return rc;
 
-	rc = vy_point_lookup_scan_cache(lsm, rv, key, &history);
-	if (rc != 0 || vy_history_is_terminal(&history))
-		goto done;
+	rc = vy_point_lookup_scan_cache(lsm, rv, req->key, &req->history);
+	if (rc != 0 || vy_history_is_terminal(&req->history))
+		return rc;
 
-restart:
-	rc = vy_point_lookup_scan_mems(lsm, rv, key, &mem_history);
-	if (rc != 0 || vy_history_is_terminal(&mem_history))
-		goto done;
+	rc = vy_point_lookup_scan_mems(lsm, rv, req->key, &req->mem_history);
+	if (rc != 0 || vy_history_is_terminal(&req->mem_history))
+		return rc;
 
 	/* Save version before yield */
-	uint32_t mem_version = lsm->mem->version;
-	uint32_t mem_list_version = lsm->mem_list_version;
+	req->mem_version = lsm->mem->version;
+	req->mem_list_version = lsm->mem_list_version;
+	*is_done = false;
+	return 0;
+}
 
-	rc = vy_point_lookup_scan_slices(lsm, rv, key, &disk_history);
+/**
+ * Scan runs for the key after vy_point_lookup_scan_memory() failed
+ * to find a terminal statement. May yield, in which case in-memory
+ * trees are rescanned if they were modified.
+ */
+static int
+vy_point_lookup_scan_disk(struct vy_lsm *lsm, struct vy_tx *tx,
+			  const struct vy_read_view **rv,
+			  struct vy_point_lookup_req *req)
+{
+	int rc;
+restart:
+	rc = vy_point_lookup_scan_slices(lsm, rv, req->key,
+					 &req->disk_history);
 	if (rc != 0)
-		goto done;
+		return rc;
 
 	ERROR_INJECT(ERRINJ_VY_POINT_ITER_WAIT, {
-		while (mem_list_version == lsm->mem_list_version)
+		while (req->mem_list_version == lsm->mem_list_version)
 			fiber_sleep(0.01);
 		/* Turn of the injection to avoid infinite loop */
 		errinj(ERRINJ_VY_POINT_ITER_WAIT, ERRINJ_BOOL)->bparam = false;
@@ -247,11 +303,10 @@ restart:
 		 * from dereferencing a destroyed space.
 		 */
 		diag_set(ClientError, ER_TRANSACTION_CONFLICT);
-		rc = -1;
-		goto done;
+		return -1;
 	}
 
-	if (mem_list_version != lsm->mem_list_version) {
+	if (req->mem_list_version != lsm->mem_list_version) {
 		/*
 		 * Mem list was changed during yield. This could be rotation
 		 * or a dump. In case of dump the memory referenced by
@@ -259,41 +314,317 @@ restart:
 		 * This in unnecessary in case of rotation but since we
 		 * cannot distinguish these two cases we always restart.
 		 */
-		vy_history_cleanup(&mem_history);
-		vy_history_cleanup(&disk_history);
+		vy_history_cleanup(&req->mem_history);
+		vy_history_cleanup(&req->disk_history);
+		rc = vy_point_lookup_scan_mems(lsm, rv, req->key,
+					       &req->mem_history);
+		if (rc != 0 || vy_history_is_terminal(&req->mem_history))
+			return rc;
+		req->mem_version = lsm->mem->version;
+		req->mem_list_version = lsm->mem_list_version;
 		goto restart;
 	}
 
-	if (mem_version != lsm->mem->version) {
+	if (req->mem_version != lsm->mem->version) {
 		/*
 		 * Rescan the memory level if its version changed while we
 		 * were reading disk, because there may be new statements
 		 * matching the search key.
 		 */
-		vy_history_cleanup(&mem_history);
-		rc = vy_point_lookup_scan_mems(lsm, rv, key, &mem_history);
+		vy_history_cleanup(&req->mem_history);
+		rc = vy_point_lookup_scan_mems(lsm, rv, req->key,
+					       &req->mem_history);
 		if (rc != 0)
-			goto done;
-		if (vy_history_is_terminal(&mem_history))
-			vy_history_cleanup(&disk_history);
+			return rc;
+		if (vy_history_is_terminal(&req->mem_history))
+			vy_history_cleanup(&req->disk_history);
 	}
+	return 0;
+}
 
-done:
-	vy_history_splice(&history, &mem_history);
-	vy_history_splice(&history, &disk_history);
+/**
+ * Discard statements of the key history deleted by a range
+ * tombstone visible from the read view, see vy_history_cut().
+ */
+static int
+vy_point_lookup_cut(struct vy_lsm *lsm, struct vy_tx *tx,
+		    const struct vy_read_view **rv, struct vy_entry key,
+		    struct vy_history *history)
+{
+	int64_t lsn = vy_tx_tombstone_lsn(tx, lsm, (*rv)->vlsn, key);
+	if (lsn == 0)
+		return 0;
+	return vy_history_cut(history, lsn, lsm->cmp_def,
+			      lsm->env->key_format);
+}
+
+/**
+ * Compute the resultant statement from the history collected
+ * for the key and free the history. @rc is the status of the
+ * history scan: the result is computed only if it is 0.
+ */
+static int
+vy_point_lookup_req_finish(struct vy_lsm *lsm, struct vy_tx *tx,
+			   const struct vy_read_view **rv,
+			   struct vy_point_lookup_req *req,
+			   int rc, struct vy_entry *ret)
+{
+	*ret = vy_entry_none();
+	vy_history_splice(&req->history, &req->mem_history);
+	vy_history_splice(&req->history, &req->disk_history);
 
+	if (rc == 0)
+		rc = vy_point_lookup_cut(lsm, tx, rv, req->key,
+					 &req->history);
 	if (rc == 0) {
 		int upserts_applied;
-		rc = vy_history_apply(&history, lsm->cmp_def,
+		rc = vy_history_apply(&req->history, lsm->cmp_def,
 				      false, &upserts_applied, ret);
 		lsm->stat.upsert.applied += upserts_applied;
 	}
-	vy_history_cleanup(&history);
+	vy_history_cleanup(&req->history);
+	return rc;
+}
 
-	if (rc != 0)
+int
+vy_point_lookup(struct vy_lsm *lsm, struct vy_tx *tx,
+		const struct vy_read_view **rv,
+		struct vy_entry key, struct vy_entry *ret)
+{
+	/* All key parts must be set for a point lookup. */
+	assert(vy_stmt_is_full_key(key.stmt, lsm->cmp_def));
+	assert(tx == NULL || tx->state == VINYL_TX_READY);
+
+	struct vy_point_lookup_req req;
+	vy_point_lookup_req_create(&req, lsm, key);
+
+	bool is_done;
+	int rc = vy_point_lookup_scan_memory(lsm, tx, rv, &req, &is_done);
+	if (rc == 0 && !is_done)
+		rc = vy_point_lookup_scan_disk(lsm, tx, rv, &req);
+
+	return vy_point_lookup_req_finish(lsm, tx, rv, &req, rc, ret);
+}
+
+enum {
+	/** Max number of fibers reading disk for one batch. */
+	VY_POINT_LOOKUP_BATCH_MAX_DEPTH = 16,
+};
+
+/** Batch of point lookups, see vy_point_lookup_batch(). */
+struct vy_point_lookup_batch {
+	/** LSM tree to look up keys in. */
+	struct vy_lsm *lsm;
+	/** Transaction the lookups are done from, may be NULL. */
+	struct vy_tx *tx;
+	/** Read view the lookups are done in. */
+	const struct vy_read_view **rv;
+	/** All requests of the batch, in the order of keys. */
+	struct vy_point_lookup_req *reqs;
+	/** Requests that need to read disk, sorted by key. */
+	struct vy_point_lookup_req **disk_reqs;
+	/** Results, in the order of keys. */
+	struct vy_entry *ret;
+	/** Set if any of the requests failed. */
+	bool is_failed;
+};
+
+/**
+ * Return true if a run of the range containing the key may store
+ * a statement for it according to the run bloom filter.
+ */
+static bool
+vy_point_lookup_may_read_disk(struct vy_lsm *lsm, struct vy_entry key)
+{
+	struct vy_range *range = vy_range_tree_find_by_key(&lsm->range_tree,
+							   ITER_EQ, key);
+	assert(range != NULL);
+	struct vy_slice *slice;
+	rlist_foreach_entry(slice, &range->slices, in_range) {
+		struct tuple_bloom *bloom = slice->run->info.bloom;
+		if (bloom == NULL ||
+		    vy_bloom_maybe_has(bloom, key, lsm->key_def))
+			return true;
+	}
+	return false;
+}
+
+static int
+vy_point_lookup_req_cmp(const void *a_ptr, const void *b_ptr, void *arg)
+{
+	struct vy_point_lookup_req *a =
+		*(struct vy_point_lookup_req **)a_ptr;
+	struct vy_point_lookup_req *b =
+		*(struct vy_point_lookup_req **)b_ptr;
+	struct key_def *cmp_def = arg;
+	return vy_entry_compare(a->key, b->key, cmp_def);
+}
+
+/**
+ * Complete a range of disk requests of a batch one by one.
+ * Runs in a separate fiber so that requests from different
+ * ranges of the batch are read concurrently.
+ *
+ * Each request is finished right after its disk scan, without
+ * yielding, because statements read from in-memory trees may be
+ * freed by dump as soon as we yield. Once the batch has failed,
+ * the remaining requests are finished without reading disk so
+ * that their histories are freed.
+ */
+static int
+vy_point_lookup_batch_read(struct vy_point_lookup_batch *batch,
+			   uint32_t begin, uint32_t end)
+{
+	for (uint32_t i = begin; i < end; i++) {
+		struct vy_point_lookup_req *req = batch->disk_reqs[i];
+		struct vy_entry *ret = &batch->ret[req - batch->reqs];
+		int rc = -1;
+		if (!batch->is_failed)
+			rc = vy_point_lookup_scan_disk(batch->lsm, batch->tx,
+						       batch->rv, req);
+		if (vy_point_lookup_req_finish(batch->lsm, batch->tx,
+					       batch->rv, req, rc, ret) != 0)
+			batch->is_failed = true;
+	}
+	return batch->is_failed ? -1 : 0;
+}
+
+static int
+vy_point_lookup_batch_f(va_list ap)
+{
+	struct vy_point_lookup_batch *batch =
+		va_arg(ap, struct vy_point_lookup_batch *);
+	uint32_t begin = va_arg(ap, uint32_t);
+	uint32_t end = va_arg(ap, uint32_t);
+	return vy_point_lookup_batch_read(batch, begin, end);
+}
+
+int
+vy_point_lookup_batch(struct vy_lsm *lsm, struct vy_tx *tx,
+		      const struct vy_read_view **rv,
+		      const struct vy_entry *keys, uint32_t count,
+		      struct vy_entry *ret)
+{
+	assert(tx == NULL || tx->state == VINYL_TX_READY);
+	double start_time = ev_monotonic_now(loop());
+
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	size_t size;
+	struct vy_point_lookup_req *reqs =
+		region_alloc_array(region, typeof(reqs[0]), count, &size);
+	if (reqs == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc_array", "reqs");
 		return -1;
+	}
+	struct vy_point_lookup_req **disk_reqs =
+		region_alloc_array(region, typeof(disk_reqs[0]), count, &size);
+	if (disk_reqs == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc_array",
+			 "disk_reqs");
+		region_truncate(region, region_svp);
+		return -1;
+	}
+	/*
+	 * First, look up all keys in memory, which doesn't yield,
+	 * and check bloom filters of keys that weren't found there
+	 * so as not to waste I/O slots on keys that are absent on
+	 * disk. Scanning runs for such keys doesn't yield either.
+	 */
+	int rc = 0;
+	uint32_t disk_count = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		struct vy_point_lookup_req *req = &reqs[i];
+		assert(vy_stmt_is_full_key(keys[i].stmt, lsm->cmp_def));
+		vy_point_lookup_req_create(req, lsm, keys[i]);
+		bool is_done = true;
+		if (rc == 0)
+			rc = vy_point_lookup_scan_memory(lsm, tx, rv, req,
+							 &is_done);
+		if (rc == 0 && !is_done) {
+			if (vy_point_lookup_may_read_disk(lsm, req->key)) {
+				disk_reqs[disk_count++] = req;
+				continue;
+			}
+			rc = vy_point_lookup_scan_disk(lsm, tx, rv, req);
+		}
+		/*
+		 * Statements read from in-memory trees may be freed
+		 * by dump once we yield so compute the result now.
+		 */
+		if (vy_point_lookup_req_finish(lsm, tx, rv, req, rc,
+					       &ret[i]) != 0)
+			rc = -1;
+	}
+	/*
+	 * Sort keys that need disk reads and split them in chunks
+	 * of adjacent keys, one per fiber, so that keys stored in
+	 * the same run page are likely to be looked up by the same
+	 * fiber, which will find the page in the page cache, while
+	 * pages of different chunks are read concurrently by
+	 * reader threads.
+	 */
+	struct vy_point_lookup_batch batch;
+	batch.lsm = lsm;
+	batch.tx = tx;
+	batch.rv = rv;
+	batch.reqs = reqs;
+	batch.disk_reqs = disk_reqs;
+	batch.ret = ret;
+	batch.is_failed = rc != 0;
+	uint32_t depth = MIN(disk_count,
+			     (uint32_t)VY_POINT_LOOKUP_BATCH_MAX_DEPTH);
+	if (!batch.is_failed && depth > 0) {
+		qsort_arg(disk_reqs, disk_count, sizeof(disk_reqs[0]),
+			  vy_point_lookup_req_cmp, lsm->cmp_def);
+		struct fiber *workers[VY_POINT_LOOKUP_BATCH_MAX_DEPTH];
+		uint32_t worker_count = 0;
+		uint32_t chunk_size = DIV_ROUND_UP(disk_count, depth);
+		/* The first chunk is processed by the caller. */
+		uint32_t i;
+		for (i = chunk_size; i < disk_count; i += chunk_size) {
+			struct fiber *f = fiber_new("vinyl.lookup",
+						    vy_point_lookup_batch_f);
+			if (f == NULL) {
+				batch.is_failed = true;
+				break;
+			}
+			fiber_set_joinable(f, true);
+			fiber_start(f, &batch, i,
+				    MIN(i + chunk_size, disk_count));
+			workers[worker_count++] = f;
+		}
+		/* Free requests left without a worker. */
+		if (i < disk_count)
+			vy_point_lookup_batch_read(&batch, i, disk_count);
+		vy_point_lookup_batch_read(&batch, 0,
+					   MIN(chunk_size, disk_count));
+		for (i = 0; i < worker_count; i++) {
+			if (fiber_join(workers[i]) != 0)
+				rc = -1;
+		}
+		lsm->stat.batch.io_depth += worker_count + 1;
+	} else {
+		/* Free requests of a batch failed before reading disk. */
+		vy_point_lookup_batch_read(&batch, 0, disk_count);
+	}
+	if (batch.is_failed)
+		rc = -1;
+	if (rc != 0) {
+		for (uint32_t i = 0; i < count; i++) {
+			if (ret[i].stmt != NULL)
+				tuple_unref(ret[i].stmt);
+			ret[i] = vy_entry_none();
+		}
+	}
+	region_truncate(region, region_svp);
 
-	return 0;
+	lsm->stat.batch.count++;
+	lsm->stat.batch.keys += count;
+	lsm->stat.batch.disk_keys += disk_count;
+	latency_collect(&lsm->stat.batch.latency,
+			ev_monotonic_now(loop()) - start_time);
+	return rc;
 }
 
 int
@@ -317,6 +648,8 @@ vy_point_lookup_mem(struct vy_lsm *lsm, const struct vy_read_view **rv,
 	*ret = vy_entry_none();
 	goto out;
 done:
+	if (rc == 0)
+		rc = vy_point_lookup_cut(lsm, NULL, rv, key, &history);
 	if (rc == 0) {
 		int upserts_applied;
 		rc = vy_history_apply(&history, lsm->cmp_def,
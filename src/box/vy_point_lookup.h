@@ -70,6 +70,22 @@ vy_point_lookup(struct vy_lsm *lsm, struct vy_tx *tx,
 		const struct vy_read_view **rv,
 		struct vy_entry key, struct vy_entry *ret);
 
+/**
+ * Look up tuples by an array of full keys. The result for each
+ * key is returned in the corresponding slot of @ret. Works like
+ * calling vy_point_lookup() for each key, but resolves all keys
+ * that can be found in memory or filtered out by bloom filters
+ * first, then reads the rest from disk in several fibers so that
+ * page reads are processed by reader threads concurrently.
+ *
+ * On failure, no tuples are returned.
+ */
+int
+vy_point_lookup_batch(struct vy_lsm *lsm, struct vy_tx *tx,
+		      const struct vy_read_view **rv,
+		      const struct vy_entry *keys, uint32_t count,
+		      struct vy_entry *ret);
+
 /**
  * Look up a tuple by key in memory.
  *
@@ -280,6 +280,10 @@ vy_range_remove_slice(struct vy_range *range, struct vy_slice *slice)
  * compaction is relatively cheap, because of the level size
  * ratio.
  *
+ * If the leveled compaction policy is used, run_count_per_level
+ * only applies to the first level while all subsequent levels
+ * may store at most one run.
+ *
  * Given a range, this function computes the maximal level that needs
  * to be compacted and sets @compaction_priority to the number of runs
  * in this level and all preceding levels.
@@ -294,7 +298,20 @@ vy_range_update_compaction_priority(struct vy_range *range,
 	range->compaction_priority = 0;
 	vy_disk_stmt_counter_reset(&range->compaction_queue);
 
-	if (range->slice_count <= 1) {
+	if (range->slice_count == 0) {
+		/* Nothing to compact. */
+		range->needs_compaction = false;
+		range->needs_purge = false;
+		return;
+	}
+
+	if (range->needs_purge) {
+		range->compaction_priority = range->slice_count;
+		range->compaction_queue = range->count;
+		return;
+	}
+
+	if (range->slice_count == 1) {
 		/* Nothing to compact. */
 		range->needs_compaction = false;
 		return;
@@ -315,6 +332,8 @@ vy_range_update_compaction_priority(struct vy_range *range,
 	uint64_t est_new_run_size = 0;
 	/* The number of runs at the current level. */
 	uint32_t level_run_count = 0;
+	/* The current level number, 0 for the first (newest) level. */
+	uint32_t level = 0;
 	/*
 	 * The target (perfect) size of a run at the current level.
 	 * Calculated recurrently: the size of the next level equals
@@ -364,6 +383,7 @@ vy_range_update_compaction_priority(struct vy_range *range,
 			 * count.
 			 */
 			level_run_count = 1;
+			level++;
 			/*
 			 * If we have already scheduled
 			 * a compaction of an upper level, and
@@ -400,8 +420,21 @@ vy_range_update_compaction_priority(struct vy_range *range,
 		 * value of rand() from the slice creation time.
 		 */
 		uint32_t max_run_count = opts->run_count_per_level;
-		if (slice->seed < RAND_MAX / 10)
+		if (opts->compaction_policy == INDEX_COMPACTION_LEVELED &&
+		    level > 0) {
+			/*
+			 * With the leveled policy, we store at most
+			 * one run at each level except the first one
+			 * so that a key may be found in at most one
+			 * run per level. This trades write amplification
+			 * for read and space amplification: a run
+			 * pushed down to a non-empty level gets merged
+			 * with the run stored there.
+			 */
+			max_run_count = 1;
+		} else if (slice->seed < RAND_MAX / 10) {
 			max_run_count++;
+		}
 		if (level_run_count > max_run_count) {
 			/*
 			 * The number of runs at the current level
@@ -117,6 +117,19 @@ struct vy_range {
 	 * is scheduled for compaction.
 	 */
 	bool needs_compaction;
+	/**
+	 * Set if the range stores statements deleted by a range
+	 * tombstone of the primary index and so must be compacted
+	 * to the last level even if it has only one run. Cleared
+	 * when the range is scheduled for compaction.
+	 */
+	bool needs_purge;
+	/**
+	 * Range tombstones with LSN up to this one have been
+	 * applied to all runs of the range by major compaction,
+	 * see vy_lsm_purge_tombstones().
+	 */
+	int64_t purged_lsn;
 	/** Number of times the range was compacted. */
 	int n_compactions;
 	/**
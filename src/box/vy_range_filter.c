@@ -0,0 +1,428 @@
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "vy_blob.h"
+#include "vy_range_filter.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <msgpuck.h>
+
+#include "diag.h"
+#include "key_def.h"
+#include "tuple.h"
+#include "vy_stmt.h"
+#include "salad/bloom.h"
+#include "trivia/util.h"
+
+enum {
+	/** Number of bucket levels stored in a range filter. */
+	VY_RANGE_FILTER_LEVELS = 4,
+	/** Log2 of the number of children of a bucket. */
+	VY_RANGE_FILTER_FANOUT_LOG = 4,
+	/**
+	 * Max number of top level buckets an interval may span
+	 * for us to bother checking it.
+	 */
+	VY_RANGE_FILTER_MAX_SPAN = 64,
+	/**
+	 * Max number of bloom probes done per interval check.
+	 * If exceeded, we assume the interval may have values.
+	 */
+	VY_RANGE_FILTER_MAX_PROBES = 256,
+	/**
+	 * Max shift of the finest level, chosen so that the shift
+	 * of the top level is still less than 64.
+	 */
+	VY_RANGE_FILTER_MAX_SHIFT = 63 - VY_RANGE_FILTER_FANOUT_LOG *
+				       (VY_RANGE_FILTER_LEVELS - 1),
+};
+
+/** Return the log2 of the width of a bucket at the given level. */
+static inline uint32_t
+vy_range_filter_level_shift(const struct vy_range_filter *filter,
+			    uint32_t level)
+{
+	return filter->shift + level * VY_RANGE_FILTER_FANOUT_LOG;
+}
+
+/** Compute the bloom hash of a bucket at the given level. */
+static inline bloom_hash_t
+vy_range_filter_hash(uint32_t level, uint64_t bucket)
+{
+	/* splitmix64 finalizer */
+	uint64_t h = bucket + (level + 1) * 0x9e3779b97f4a7c15ULL;
+	h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+	h ^= h >> 31;
+	return (bloom_hash_t)(h ^ (h >> 32));
+}
+
+bool
+vy_range_filter_is_supported(struct key_def *key_def)
+{
+	if (key_def->is_multikey || key_def->for_func_index)
+		return false;
+	struct key_part *part = &key_def->parts[0];
+	switch (part->type) {
+	case FIELD_TYPE_UNSIGNED:
+	case FIELD_TYPE_INTEGER:
+		return true;
+	case FIELD_TYPE_STRING:
+		return part->coll == NULL;
+	default:
+		return false;
+	}
+}
+
+bool
+vy_range_filter_is_compatible(const struct vy_range_filter *filter,
+			      struct key_def *key_def)
+{
+	return vy_range_filter_is_supported(key_def) &&
+	       filter->type == key_def->parts[0].type;
+}
+
+/**
+ * Map a MessagePack value to an integer so that the order of
+ * values is preserved. Returns false if the value can't be
+ * mapped.
+ */
+static bool
+vy_range_filter_map_field(const char *field, enum field_type type,
+			  uint64_t *value)
+{
+	if (field == NULL) {
+		/* Absent nullable field is treated as nil. */
+		*value = 0;
+		return true;
+	}
+	switch (mp_typeof(*field)) {
+	case MP_NIL:
+		*value = 0;
+		return true;
+	case MP_UINT: {
+		uint64_t v = mp_decode_uint(&field);
+		if (type == FIELD_TYPE_UNSIGNED)
+			*value = v;
+		else if (v > INT64_MAX)
+			*value = UINT64_MAX;
+		else
+			*value = v ^ (1ULL << 63);
+		return true;
+	}
+	case MP_INT: {
+		int64_t v = mp_decode_int(&field);
+		/* Negative values precede all unsigned values. */
+		*value = type == FIELD_TYPE_UNSIGNED ? 0 :
+			 (uint64_t)v ^ (1ULL << 63);
+		return true;
+	}
+	case MP_STR: {
+		uint32_t len;
+		const char *str = mp_decode_str(&field, &len);
+		uint64_t v = 0;
+		for (uint32_t i = 0; i < 8; i++) {
+			v <<= 8;
+			if (i < len)
+				v |= (unsigned char)str[i];
+		}
+		*value = v;
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+bool
+vy_range_filter_map_key(struct vy_entry entry, struct key_def *key_def,
+			uint64_t *value)
+{
+	struct key_part *part = &key_def->parts[0];
+	const char *field;
+	if (vy_stmt_is_key(entry.stmt)) {
+		field = tuple_data(entry.stmt);
+		if (mp_decode_array(&field) == 0)
+			return false;
+	} else {
+		field = tuple_field_by_part(entry.stmt, part, MULTIKEY_NONE);
+	}
+	return vy_range_filter_map_field(field, part->type, value);
+}
+
+void
+vy_range_filter_builder_create(struct vy_range_filter_builder *builder)
+{
+	builder->values = NULL;
+	builder->count = 0;
+	builder->capacity = 0;
+	builder->is_disabled = false;
+	builder->type = FIELD_TYPE_ANY;
+}
+
+void
+vy_range_filter_builder_destroy(struct vy_range_filter_builder *builder)
+{
+	free(builder->values);
+	vy_range_filter_builder_create(builder);
+}
+
+int
+vy_range_filter_builder_add(struct vy_range_filter_builder *builder,
+			    uint64_t value)
+{
+	if (builder->count > 0) {
+		uint64_t last = builder->values[builder->count - 1];
+		assert(value >= last);
+		if (value == last)
+			return 0;
+	}
+	if (builder->count == builder->capacity) {
+		uint32_t capacity = MAX(builder->capacity * 2, 1024U);
+		uint64_t *values = realloc(builder->values,
+					   capacity * sizeof(*values));
+		if (values == NULL) {
+			diag_set(OutOfMemory, capacity * sizeof(*values),
+				 "realloc", "range filter values");
+			return -1;
+		}
+		builder->values = values;
+		builder->capacity = capacity;
+	}
+	builder->values[builder->count++] = value;
+	return 0;
+}
+
+int
+vy_range_filter_builder_add_entry(struct vy_range_filter_builder *builder,
+				  struct vy_entry entry,
+				  struct key_def *key_def)
+{
+	if (builder->is_disabled)
+		return 0;
+	builder->type = key_def->parts[0].type;
+	uint64_t value;
+	if (!vy_range_filter_map_key(entry, key_def, &value)) {
+		/*
+		 * Skipping the statement would make the filter
+		 * lie so don't build it at all.
+		 */
+		builder->is_disabled = true;
+		return 0;
+	}
+	return vy_range_filter_builder_add(builder, value);
+}
+
+struct vy_range_filter *
+vy_range_filter_new(struct vy_range_filter_builder *builder, double fpr)
+{
+	assert(vy_range_filter_builder_is_ready(builder));
+	struct vy_range_filter *filter = malloc(sizeof(*filter));
+	if (filter == NULL) {
+		diag_set(OutOfMemory, sizeof(*filter),
+			 "malloc", "range filter");
+		return NULL;
+	}
+	const uint64_t *values = builder->values;
+	uint32_t count = builder->count;
+	filter->type = builder->type;
+	filter->min = values[0];
+	filter->max = values[count - 1];
+	/*
+	 * Make the finest buckets a few times narrower than
+	 * the average gap between values so that most empty
+	 * intervals between adjacent values can be detected.
+	 */
+	uint64_t gap = (filter->max - filter->min) / count;
+	uint32_t shift = gap > 0 ? 63 - __builtin_clzll(gap) : 0;
+	shift = shift > 2 ? shift - 2 : 0;
+	filter->shift = MIN(shift, (uint32_t)VY_RANGE_FILTER_MAX_SHIFT);
+	/*
+	 * Count distinct buckets of all levels. Since values
+	 * are sorted, equal buckets are adjacent.
+	 */
+	uint32_t bucket_count = 0;
+	for (uint32_t level = 0; level < VY_RANGE_FILTER_LEVELS; level++) {
+		uint32_t s = vy_range_filter_level_shift(filter, level);
+		for (uint32_t i = 0; i < count; i++) {
+			if (i == 0 || (values[i] >> s) != (values[i - 1] >> s))
+				bucket_count++;
+		}
+	}
+	if (bloom_create(&filter->bloom, bucket_count, fpr) != 0) {
+		diag_set(OutOfMemory, 0, "bloom_create", "range filter");
+		free(filter);
+		return NULL;
+	}
+	for (uint32_t level = 0; level < VY_RANGE_FILTER_LEVELS; level++) {
+		uint32_t s = vy_range_filter_level_shift(filter, level);
+		for (uint32_t i = 0; i < count; i++) {
+			uint64_t bucket = values[i] >> s;
+			if (i == 0 || bucket != (values[i - 1] >> s)) {
+				bloom_add(&filter->bloom,
+					  vy_range_filter_hash(level, bucket));
+			}
+		}
+	}
+	return filter;
+}
+
+void
+vy_range_filter_delete(struct vy_range_filter *filter)
+{
+	bloom_destroy(&filter->bloom);
+	free(filter);
+}
+
+/**
+ * Check if the given bucket may have values lying in the interval
+ * [@a lo, @a hi]. Descends to child buckets until the finest level
+ * is reached. @a probes is the number of bloom probes left.
+ */
+static bool
+vy_range_filter_check_bucket(const struct vy_range_filter *filter,
+			     uint32_t level, uint64_t bucket,
+			     uint64_t lo, uint64_t hi, int *probes)
+{
+	if (--*probes < 0)
+		return true;
+	if (!bloom_maybe_has(&filter->bloom,
+			     vy_range_filter_hash(level, bucket)))
+		return false;
+	if (level == 0)
+		return true;
+	uint32_t s = vy_range_filter_level_shift(filter, level - 1);
+	uint64_t first = MAX(lo >> s, bucket << VY_RANGE_FILTER_FANOUT_LOG);
+	uint64_t last = MIN(hi >> s, (bucket << VY_RANGE_FILTER_FANOUT_LOG) |
+			    ((1 << VY_RANGE_FILTER_FANOUT_LOG) - 1));
+	for (uint64_t child = first; ; child++) {
+		if (vy_range_filter_check_bucket(filter, level - 1, child,
+						 lo, hi, probes))
+			return true;
+		if (child == last)
+			break;
+	}
+	return false;
+}
+
+bool
+vy_range_filter_maybe_has(const struct vy_range_filter *filter,
+			  uint64_t lo, uint64_t hi)
+{
+	lo = MAX(lo, filter->min);
+	hi = MIN(hi, filter->max);
+	if (lo > hi)
+		return false;
+	uint32_t level = VY_RANGE_FILTER_LEVELS - 1;
+	uint32_t s = vy_range_filter_level_shift(filter, level);
+	uint64_t first = lo >> s;
+	uint64_t last = hi >> s;
+	if (last - first >= VY_RANGE_FILTER_MAX_SPAN)
+		return true;
+	int probes = VY_RANGE_FILTER_MAX_PROBES;
+	for (uint64_t bucket = first; bucket <= last; bucket++) {
+		if (vy_range_filter_check_bucket(filter, level, bucket,
+						 lo, hi, &probes))
+			return true;
+	}
+	return false;
+}
+
+size_t
+vy_range_filter_size(const struct vy_range_filter *filter)
+{
+	size_t size = 0;
+	size += mp_sizeof_array(7);
+	size += mp_sizeof_uint(filter->min);
+	size += mp_sizeof_uint(filter->max);
+	size += mp_sizeof_uint(filter->shift);
+	size += mp_sizeof_uint(filter->bloom.table_size);
+	size += mp_sizeof_uint(filter->bloom.hash_count);
+	size += mp_sizeof_bin(bloom_store_size(&filter->bloom));
+	size += mp_sizeof_uint(filter->type);
+	return size;
+}
+
+char *
+vy_range_filter_encode(const struct vy_range_filter *filter, char *buf)
+{
+	buf = mp_encode_array(buf, 7);
+	buf = mp_encode_uint(buf, filter->min);
+	buf = mp_encode_uint(buf, filter->max);
+	buf = mp_encode_uint(buf, filter->shift);
+	buf = mp_encode_uint(buf, filter->bloom.table_size);
+	buf = mp_encode_uint(buf, filter->bloom.hash_count);
+	buf = mp_encode_binl(buf, bloom_store_size(&filter->bloom));
+	buf = bloom_store(&filter->bloom, buf);
+	buf = mp_encode_uint(buf, filter->type);
+	return buf;
+}
+
+struct vy_range_filter *
+vy_range_filter_decode(const char **data)
+{
+	struct vy_range_filter *filter = malloc(sizeof(*filter));
+	if (filter == NULL) {
+		diag_set(OutOfMemory, sizeof(*filter),
+			 "malloc", "range filter");
+		return NULL;
+	}
+	memset(filter, 0, sizeof(*filter));
+	/*
+	 * Filters written before the key part type was stored
+	 * have 6 fields. Leave the type unset for them so that
+	 * they are never used, see vy_range_filter_is_compatible().
+	 */
+	uint32_t field_count = mp_decode_array(data);
+	assert(field_count == 6 || field_count == 7);
+	filter->type = FIELD_TYPE_ANY;
+	filter->min = mp_decode_uint(data);
+	filter->max = mp_decode_uint(data);
+	filter->shift = mp_decode_uint(data);
+	filter->bloom.table_size = mp_decode_uint(data);
+	filter->bloom.hash_count = mp_decode_uint(data);
+	size_t store_size = mp_decode_binl(data);
+	assert(store_size == bloom_store_size(&filter->bloom));
+	if (bloom_load_table(&filter->bloom, *data) != 0) {
+		diag_set(OutOfMemory, store_size, "bloom_load_table",
+			 "range filter");
+		free(filter);
+		return NULL;
+	}
+	*data += store_size;
+	if (field_count > 6)
+		filter->type = mp_decode_uint(data);
+	return filter;
+}
@@ -0,0 +1,214 @@
+#ifndef INCLUDES_TARANTOOL_BOX_VY_RANGE_FILTER_H
+#define INCLUDES_TARANTOOL_BOX_VY_RANGE_FILTER_H
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "salad/bloom.h"
+#include "field_def.h"
+#include "vy_entry.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct key_def;
+
+/**
+ * Range filter of a vinyl run.
+ *
+ * A bloom filter can only tell if a run may store a particular
+ * key. A range filter answers a more general question: may a run
+ * store any key lying in the given interval? It is used by the
+ * read iterator to avoid reading a page from a run that has no
+ * keys between the last returned key and the next key found in
+ * newer sources, see vy_read_iterator_scan_disk().
+ *
+ * The filter only looks at the first key part, which is mapped
+ * to a 64-bit integer in an order-preserving way: a < b implies
+ * map(a) <= map(b), see vy_range_filter_map_key(). Integer values
+ * map to themselves (shifted to be unsigned), strings map to their
+ * first 8 bytes. Other field types aren't supported. Since the
+ * mapping depends on the type of the key part, the type is stored
+ * in the filter, and a filter built for another type is ignored,
+ * see vy_range_filter_is_compatible().
+ *
+ * Mapped values are grouped in buckets of 2^shift adjacent values,
+ * where the shift is chosen by the builder so that buckets are
+ * a few times narrower than the average gap between values. The
+ * buckets are in turn grouped in coarser buckets, 16 per each
+ * bucket of the next level. For each level, the buckets that
+ * have at least one value are stored in a bloom filter.
+ *
+ * To check an interval, we probe the top level buckets covering
+ * it and descend to the children of the buckets that may be
+ * non-empty, much like we would walk a trie, until we find a
+ * non-empty bucket at the finest level. A negative answer is
+ * exact, a positive answer may be false.
+ */
+struct vy_range_filter {
+	/** Type of the first key part the values were mapped as. */
+	enum field_type type;
+	/** Min mapped value stored in the filter. */
+	uint64_t min;
+	/** Max mapped value stored in the filter. */
+	uint64_t max;
+	/** Log2 of the width of a bucket at the finest level. */
+	uint32_t shift;
+	/** Buckets of all levels that have at least one value. */
+	struct bloom bloom;
+};
+
+/**
+ * Range filter builder. Mapped values must be added in
+ * ascending order, see vy_range_filter_map_key().
+ */
+struct vy_range_filter_builder {
+	/** Distinct values added to the builder. */
+	uint64_t *values;
+	/** Number of values stored in @values. */
+	uint32_t count;
+	/** Capacity of @values. */
+	uint32_t capacity;
+	/**
+	 * Set if a statement that can't be mapped was added.
+	 * A filter can't be built then.
+	 */
+	bool is_disabled;
+	/** Type of the first key part the values were mapped as. */
+	enum field_type type;
+};
+
+/**
+ * Return true if a range filter can be built for an index
+ * with the given key definition.
+ */
+bool
+vy_range_filter_is_supported(struct key_def *key_def);
+
+/**
+ * Return true if a range filter may be used for an index with
+ * the given key definition, i.e. the first key part is mapped to
+ * integers the same way as when the filter was built. This may
+ * be false if the index was altered after the filter was built.
+ */
+bool
+vy_range_filter_is_compatible(const struct vy_range_filter *filter,
+			      struct key_def *key_def);
+
+/**
+ * Map the first part of the key of a vinyl statement to an
+ * integer that may be stored in a range filter. Returns false
+ * if the statement is a key without parts, i.e. it doesn't
+ * bound the interval.
+ */
+bool
+vy_range_filter_map_key(struct vy_entry entry, struct key_def *key_def,
+			uint64_t *value);
+
+/** Initialize a range filter builder. */
+void
+vy_range_filter_builder_create(struct vy_range_filter_builder *builder);
+
+/** Free memory allocated by a range filter builder. */
+void
+vy_range_filter_builder_destroy(struct vy_range_filter_builder *builder);
+
+/**
+ * Add a mapped value to a range filter builder.
+ * Returns 0 on success, -1 on OOM.
+ */
+int
+vy_range_filter_builder_add(struct vy_range_filter_builder *builder,
+			    uint64_t value);
+
+/**
+ * Add the key of a vinyl statement to a range filter builder.
+ * Returns 0 on success, -1 on OOM.
+ */
+int
+vy_range_filter_builder_add_entry(struct vy_range_filter_builder *builder,
+				  struct vy_entry entry,
+				  struct key_def *key_def);
+
+/**
+ * Return true if a range filter can be built out of the values
+ * added to a builder.
+ */
+static inline bool
+vy_range_filter_builder_is_ready(struct vy_range_filter_builder *builder)
+{
+	return builder->count > 0 && !builder->is_disabled;
+}
+
+/**
+ * Create a range filter out of the values added to a builder.
+ * @fpr is the false positive rate of each bucket probe.
+ * Returns NULL and sets diag on OOM. The builder must be
+ * ready, see vy_range_filter_builder_is_ready().
+ */
+struct vy_range_filter *
+vy_range_filter_new(struct vy_range_filter_builder *builder, double fpr);
+
+/** Delete a range filter. */
+void
+vy_range_filter_delete(struct vy_range_filter *filter);
+
+/**
+ * Check if a range filter may have a value in the interval
+ * [@a lo, @a hi], both ends inclusive.
+ */
+bool
+vy_range_filter_maybe_has(const struct vy_range_filter *filter,
+			  uint64_t lo, uint64_t hi);
+
+/** Return the size of a range filter when encoded. */
+size_t
+vy_range_filter_size(const struct vy_range_filter *filter);
+
+/** Encode a range filter in MsgPack. */
+char *
+vy_range_filter_encode(const struct vy_range_filter *filter, char *buf);
+
+/**
+ * Decode a range filter from MsgPack.
+ * Returns NULL and sets diag on OOM.
+ */
+struct vy_range_filter *
+vy_range_filter_decode(const char **data);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* INCLUDES_TARANTOOL_BOX_VY_RANGE_FILTER_H */
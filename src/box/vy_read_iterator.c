@@ -56,6 +56,17 @@ struct vy_read_src {
 	uint32_t front_id;
 	/** History of the key the iterator is positioned at. */
 	struct vy_history history;
+	/** Link in vy_read_iterator->disk_heap. */
+	struct heap_node in_heap;
+};
+
+enum {
+	/**
+	 * Min number of disk sources for which the read iterator
+	 * merges them with a heap. With fewer sources a linear
+	 * scan takes less comparisons.
+	 */
+	VY_READ_ITERATOR_HEAP_MIN_SRC = 8,
 };
 
 /**
@@ -188,6 +199,37 @@ vy_read_iterator_cmp_stmt(struct vy_read_iterator *itr,
 		vy_entry_compare(a, b, itr->lsm->cmp_def);
 }
 
+/**
+ * Compare the statements read sources are positioned at.
+ * Sources positioned at the same key are ordered by age,
+ * newest first.
+ */
+static inline bool
+vy_read_src_heap_less(heap_t *heap, struct vy_read_src *a,
+		      struct vy_read_src *b)
+{
+	struct vy_read_iterator *itr = container_of(heap,
+			struct vy_read_iterator, disk_heap);
+	int cmp = vy_read_iterator_cmp_stmt(itr,
+					    vy_history_last_stmt(&a->history),
+					    vy_history_last_stmt(&b->history));
+	if (cmp != 0)
+		return cmp < 0;
+	return a < b;
+}
+
+#define HEAP_NAME vy_read_src_heap
+#define HEAP_LESS(h, l, r) vy_read_src_heap_less(h, l, r)
+#define heap_value_t struct vy_read_src
+#define heap_value_attr in_heap
+
+#include "salad/heap.h"
+
+#undef HEAP_LESS
+#undef HEAP_NAME
+#undef heap_value_attr
+#undef heap_value_t
+
 /**
  * Return true if the statement matches search criteria
  * and older sources don't need to be scanned.
@@ -364,10 +406,27 @@ vy_read_iterator_scan_disk(struct vy_read_iterator *itr, uint32_t disk_src,
 
 	assert(disk_src >= itr->disk_src && disk_src < itr->src_count);
 
-	if (!src->is_started || disk_src >= itr->skipped_src)
+	bool skip = !src->is_started || disk_src >= itr->skipped_src;
+	bool advance = !skip && src->front_id == itr->prev_front_id;
+	if ((skip || advance) &&
+	    !vy_run_iterator_check_range(src_itr, itr->last, *next)) {
+		/*
+		 * The run doesn't have any keys between the last
+		 * returned key and the next key candidate so it
+		 * can't affect the result and hence there's no
+		 * point in reading it. Since 'next' may only move
+		 * closer to 'last' while we scan older sources,
+		 * this holds for the final value of 'next' as well.
+		 * Make the source reposition on the next iteration.
+		 */
+		src->is_started = false;
+		itr->skipped_src = MAX(itr->skipped_src, disk_src + 1);
+		return 0;
+	}
+	if (skip)
 		rc = vy_run_iterator_skip(src_itr, itr->last,
 					  &src->history);
-	else if (src->front_id == itr->prev_front_id)
+	else if (advance)
 		rc = vy_run_iterator_next(src_itr, &src->history);
 	src->is_started = true;
 
@@ -378,12 +437,150 @@ vy_read_iterator_scan_disk(struct vy_read_iterator *itr, uint32_t disk_src,
 	return 0;
 }
 
+/**
+ * Scan disk sources one by one, see vy_read_iterator_scan_disk().
+ * If all disk sources were evaluated and there are many of them,
+ * build a heap out of them so that the following iterations can
+ * use vy_read_iterator_merge_disk() instead.
+ */
+static NODISCARD int
+vy_read_iterator_scan_disk_all(struct vy_read_iterator *itr,
+			       struct vy_entry *next, bool *stop)
+{
+	itr->disk_heap_is_ready = false;
+	for (uint32_t i = itr->disk_src; i < itr->src_count; i++) {
+		if (vy_read_iterator_scan_disk(itr, i, next, stop) != 0)
+			return -1;
+		if (*stop)
+			return 0;
+	}
+	if (itr->src_count - itr->disk_src < VY_READ_ITERATOR_HEAP_MIN_SRC)
+		return 0;
+	for (uint32_t i = itr->disk_src; i < itr->src_count; i++) {
+		/* Skipped by the range filter, not positioned. */
+		if (!itr->src[i].is_started)
+			return 0;
+	}
+	heap_t *heap = &itr->disk_heap;
+	heap->size = 0;
+	for (uint32_t i = itr->disk_src; i < itr->src_count; i++) {
+		/* On OOM, keep scanning sources linearly. */
+		if (vy_read_src_heap_insert(heap, &itr->src[i]) != 0)
+			return 0;
+	}
+	itr->disk_heap_is_ready = true;
+	return 0;
+}
+
+/**
+ * Assign the current front_id to all disk sources positioned
+ * at the given statement, starting from the given heap node.
+ * Since a heap node never precedes its parent, we don't need
+ * to descend into a subtree if its root doesn't match.
+ */
+static void
+vy_read_iterator_mark_disk_front(struct vy_read_iterator *itr,
+				 heap_off_t pos, struct vy_entry entry)
+{
+	heap_t *heap = &itr->disk_heap;
+	if (pos >= heap->size)
+		return;
+	struct vy_read_src *src = container_of(heap->harr[pos],
+					       struct vy_read_src, in_heap);
+	if (vy_read_iterator_cmp_stmt(itr, vy_history_last_stmt(&src->history),
+				      entry) != 0)
+		return;
+	src->front_id = itr->front_id;
+	vy_read_iterator_mark_disk_front(itr, 2 * pos + 1, entry);
+	vy_read_iterator_mark_disk_front(itr, 2 * pos + 2, entry);
+}
+
+/**
+ * Heap-based counterpart of vy_read_iterator_scan_disk_all().
+ * Advances only the disk sources that were used on the previous
+ * iteration and takes the next key from the top of the heap so
+ * that an iteration costs O(log N) comparisons rather than O(N),
+ * where N is the number of disk sources.
+ *
+ * May be used only if all disk sources were evaluated on the
+ * previous iteration, because the rest need to be repositioned
+ * with vy_read_iterator_scan_disk().
+ */
+static NODISCARD int
+vy_read_iterator_merge_disk(struct vy_read_iterator *itr,
+			    struct vy_entry *next)
+{
+	assert(itr->disk_heap_is_ready);
+	assert(itr->skipped_src >= itr->src_count);
+	heap_t *heap = &itr->disk_heap;
+	struct vy_read_src *src;
+	/*
+	 * Sources used on the previous iteration are positioned
+	 * at the minimal key and hence are at the top of the heap.
+	 */
+	while ((src = vy_read_src_heap_top(heap))->front_id ==
+	       itr->prev_front_id) {
+		/* Zero front_id never matches, see advance(). */
+		src->front_id = 0;
+		if (vy_run_iterator_next(&src->run_iterator,
+					 &src->history) != 0) {
+			itr->disk_heap_is_ready = false;
+			return -1;
+		}
+		vy_read_src_heap_update(heap, src);
+	}
+	struct vy_entry entry = vy_history_last_stmt(&src->history);
+	int cmp = vy_read_iterator_cmp_stmt(itr, entry, *next);
+	if (cmp < 0) {
+		assert(entry.stmt != NULL);
+		*next = entry;
+		itr->front_id++;
+	}
+	if (cmp <= 0)
+		vy_read_iterator_mark_disk_front(itr, 0, entry);
+	return 0;
+}
+
 static void
 vy_read_iterator_restore(struct vy_read_iterator *itr);
 
 static void
 vy_read_iterator_next_range(struct vy_read_iterator *itr);
 
+/**
+ * If the next key was found in a run and the statement it
+ * resolves to refers to values stored in blob files, load
+ * them. Must be called while slices are pinned. May yield.
+ */
+static NODISCARD int
+vy_read_iterator_load_blob(struct vy_read_iterator *itr,
+			   struct vy_entry *next)
+{
+	for (uint32_t i = 0; i < itr->src_count; i++) {
+		struct vy_read_src *src = &itr->src[i];
+		if (src->front_id != itr->front_id ||
+		    !vy_history_is_terminal(&src->history))
+			continue;
+		if (i < itr->disk_src)
+			return 0;
+		struct vy_history_node *node = rlist_last_entry(
+				&src->history.stmts,
+				struct vy_history_node, link);
+		struct tuple *stmt = node->entry.stmt;
+		if ((vy_stmt_flags(stmt) & VY_STMT_BLOB) == 0)
+			return 0;
+		struct tuple *loaded;
+		if (vy_lsm_load_blob(itr->lsm, stmt, &loaded) != 0)
+			return -1;
+		vy_history_replace_oldest_stmt(&src->history, loaded);
+		tuple_unref(loaded);
+		if (next->stmt == stmt)
+			next->stmt = loaded;
+		return 0;
+	}
+	return 0;
+}
+
 /**
  * Advance the iterator to the next key.
  * Returns 0 on success, -1 on error.
@@ -439,13 +636,20 @@ restart:
 rescan_disk:
 	/* The following code may yield as it needs to access disk. */
 	vy_read_iterator_pin_slices(itr);
-	for (uint32_t i = itr->disk_src; i < itr->src_count; i++) {
-		if (vy_read_iterator_scan_disk(itr, i, &next, &stop) != 0) {
-			vy_read_iterator_unpin_slices(itr);
-			return -1;
-		}
-		if (stop)
-			break;
+	int rc;
+	if (itr->disk_heap_is_ready && itr->skipped_src >= itr->src_count)
+		rc = vy_read_iterator_merge_disk(itr, &next);
+	else
+		rc = vy_read_iterator_scan_disk_all(itr, &next, &stop);
+	if (rc != 0) {
+		vy_read_iterator_unpin_slices(itr);
+		return -1;
+	}
+	if (next.stmt != NULL &&
+	    !vy_read_iterator_range_is_done(itr, next) &&
+	    vy_read_iterator_load_blob(itr, &next) != 0) {
+		vy_read_iterator_unpin_slices(itr);
+		return -1;
 	}
 	vy_read_iterator_unpin_slices(itr);
 	/*
@@ -622,6 +826,7 @@ vy_read_iterator_cleanup(struct vy_read_iterator *itr)
 	itr->disk_src = UINT32_MAX;
 	itr->skipped_src = UINT32_MAX;
 	itr->src_count = 0;
+	itr->disk_heap_is_ready = false;
 }
 
 void
@@ -638,6 +843,7 @@ vy_read_iterator_open(struct vy_read_iterator *itr, struct vy_lsm *lsm,
 	itr->read_view = rv;
 	itr->last = vy_entry_none();
 	itr->last_cached = vy_entry_none();
+	vy_read_src_heap_create(&itr->disk_heap);
 
 	if (vy_stmt_is_empty_key(key.stmt)) {
 		/*
@@ -736,6 +942,7 @@ vy_read_iterator_next_range(struct vy_read_iterator *itr)
 	}
 	itr->curr_range = range;
 	itr->range_version = range->version;
+	itr->disk_heap_is_ready = false;
 
 	for (uint32_t i = itr->disk_src; i < itr->src_count; i++) {
 		struct vy_read_src *src = &itr->src[i];
@@ -746,6 +953,29 @@ vy_read_iterator_next_range(struct vy_read_iterator *itr)
 	vy_read_iterator_add_disk(itr);
 }
 
+/**
+ * Discard statements of the current key history deleted by
+ * a range tombstone visible from the iterator read view, see
+ * vy_history_cut(). Returns 0 on success, -1 on error.
+ */
+static NODISCARD int
+vy_read_iterator_cut_history(struct vy_read_iterator *itr,
+			     struct vy_history *history)
+{
+	if (rlist_empty(&history->stmts))
+		return 0;
+	struct vy_lsm *lsm = itr->lsm;
+	struct vy_history_node *node = rlist_first_entry(&history->stmts,
+					struct vy_history_node, link);
+	int64_t lsn = vy_tx_tombstone_lsn(itr->tx, lsm,
+					  (**itr->read_view).vlsn,
+					  node->entry);
+	if (lsn == 0)
+		return 0;
+	return vy_history_cut(history, lsn, lsm->cmp_def,
+			      lsm->env->key_format);
+}
+
 /**
  * Get a resultant statement for the current key.
  * Returns 0 on success, -1 on error.
@@ -768,8 +998,10 @@ vy_read_iterator_apply_history(struct vy_read_iterator *itr,
 	}
 
 	int upserts_applied = 0;
-	int rc = vy_history_apply(&history, lsm->cmp_def,
-				  true, &upserts_applied, ret);
+	int rc = vy_read_iterator_cut_history(itr, &history);
+	if (rc == 0)
+		rc = vy_history_apply(&history, lsm->cmp_def,
+				      true, &upserts_applied, ret);
 
 	lsm->stat.upsert.applied += upserts_applied;
 	vy_history_cleanup(&history);
@@ -847,7 +1079,7 @@ next_key:
 void
 vy_read_iterator_cache_add(struct vy_read_iterator *itr, struct vy_entry entry)
 {
-	if ((**itr->read_view).vlsn != INT64_MAX) {
+	if (itr->skip_cache || (**itr->read_view).vlsn != INT64_MAX) {
 		if (itr->last_cached.stmt != NULL)
 			tuple_unref(itr->last_cached.stmt);
 		itr->last_cached = vy_entry_none();
@@ -873,6 +1105,7 @@ vy_read_iterator_close(struct vy_read_iterator *itr)
 	if (itr->last_cached.stmt != NULL)
 		tuple_unref(itr->last_cached.stmt);
 	vy_read_iterator_cleanup(itr);
+	vy_read_src_heap_destroy(&itr->disk_heap);
 	free(itr->src);
 	TRASH(itr);
 }
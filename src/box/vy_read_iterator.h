@@ -37,6 +37,8 @@
 #include "iterator_type.h"
 #include "trivia/util.h"
 #include "vy_entry.h"
+#define HEAP_FORWARD_DECLARATION
+#include "salad/heap.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -70,6 +72,12 @@ struct vy_read_iterator {
 	 * vy_read_iterator_cache_add().
 	 */
 	struct vy_entry last_cached;
+	/**
+	 * Set if statements read by the iterator must not be
+	 * added to the tuple cache, e.g. by a bulk scan that
+	 * would otherwise wash hot tuples out of the cache.
+	 */
+	bool skip_cache;
 	/**
 	 * Copy of lsm->range_tree_version.
 	 * Used for detecting range tree changes.
@@ -118,6 +126,15 @@ struct vy_read_iterator {
 	 * front_id from the previous iteration.
 	 */
 	uint32_t prev_front_id;
+	/**
+	 * Heap of disk sources ordered by the statement each
+	 * of them is positioned at. Used instead of scanning
+	 * all disk sources on each iteration if there are many
+	 * of them. Valid only if disk_heap_is_ready is set.
+	 */
+	heap_t disk_heap;
+	/** Set if disk_heap reflects positions of disk sources. */
+	bool disk_heap_is_ready;
 };
 
 /**
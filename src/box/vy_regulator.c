@@ -39,6 +39,7 @@
 
 #include "fiber.h"
 #include "histogram.h"
+#include "latency.h"
 #include "say.h"
 #include "trivia/util.h"
 
@@ -83,6 +84,25 @@ static const size_t VY_DUMP_SIZE_ACCT_MIN = 1024 * 1024;
  */
 static const int VY_RECENT_DUMP_COUNT = 100;
 
+/**
+ * Min number of disk reads that must be done during a timer
+ * period for the regulator to adjust the compaction rate limit.
+ * Fewer observations aren't representative of the 99th percentile.
+ */
+static const size_t VY_READ_LATENCY_SAMPLES_MIN = 16;
+
+/**
+ * Compaction rate limit is never set below this value so that
+ * LSM trees don't degrade indefinitely under constant load.
+ */
+static const size_t VY_COMPACTION_RATE_LIMIT_MIN = 1024 * 1024;
+
+/**
+ * When the compaction rate limit exceeds this value, compaction
+ * is unthrottled altogether.
+ */
+static const size_t VY_COMPACTION_RATE_LIMIT_MAX = 1024 * 1024 * 1024;
+
 static void
 vy_regulator_trigger_dump(struct vy_regulator *regulator)
 {
@@ -189,6 +209,75 @@ vy_regulator_update_dump_watermark(struct vy_regulator *regulator)
 					quota->limit / 2);
 }
 
+static void
+vy_regulator_set_compaction_rate_limit(struct vy_regulator *regulator,
+				       size_t limit)
+{
+	if (regulator->compaction_rate_limit == limit)
+		return;
+	regulator->compaction_rate_limit = limit;
+	regulator->set_compaction_rate_limit_cb(regulator, limit);
+}
+
+/**
+ * Adjust the compaction rate limit so as to keep disk read latency
+ * below the configured target. Compaction competes with foreground
+ * reads for disk bandwidth so the more bandwidth it takes, the
+ * longer reads have to wait for it. We use a simple AIMD controller
+ * to find the max compaction rate that doesn't violate the target:
+ * whenever the 99th percentile of read latency observed during the
+ * last timer period exceeds the target, the limit is halved, while
+ * on each period without violations, it is increased by 25%. A period
+ * with too few reads to judge counts as one without violations:
+ * there's no read latency to protect then, and otherwise the limit
+ * would never recover once the read load is gone.
+ *
+ * Note, slower compaction also means lower transaction rate limit,
+ * see vy_regulator_update_rate_limit(), so foreground writes are
+ * slowed down accordingly, keeping LSM trees in shape.
+ */
+static void
+vy_regulator_update_compaction_rate_limit(struct vy_regulator *regulator)
+{
+	struct latency *latency = regulator->read_latency;
+	/* Don't count the zero observation added by latency_reset(). */
+	size_t samples = latency->histogram->total - 1;
+	/*
+	 * If there are too few reads to judge, let observations
+	 * accumulate till next time.
+	 */
+	bool is_idle = samples < VY_READ_LATENCY_SAMPLES_MIN;
+	if (!is_idle) {
+		regulator->read_latency_p99 = latency_get(latency, 99);
+		latency_reset(latency);
+	}
+	if (regulator->read_latency_slo == 0)
+		return;
+
+	size_t limit = regulator->compaction_rate_limit;
+	if (!is_idle &&
+	    regulator->read_latency_p99 > regulator->read_latency_slo) {
+		if (limit == 0)
+			limit = VY_COMPACTION_RATE_LIMIT_MAX;
+		limit = MAX(limit / 2, VY_COMPACTION_RATE_LIMIT_MIN);
+	} else if (limit > 0) {
+		limit += limit / 4;
+		if (limit > VY_COMPACTION_RATE_LIMIT_MAX)
+			limit = 0;
+	}
+	if (limit != regulator->compaction_rate_limit && is_idle) {
+		say_info("too few disk reads, compaction rate limit "
+			 "%.1f MB/s", (double)limit / 1024 / 1024);
+	} else if (limit != regulator->compaction_rate_limit) {
+		say_info("read latency p99 %.3f ms, target %.3f ms, "
+			 "compaction rate limit %.1f MB/s",
+			 regulator->read_latency_p99 * 1000,
+			 regulator->read_latency_slo * 1000,
+			 (double)limit / 1024 / 1024);
+	}
+	vy_regulator_set_compaction_rate_limit(regulator, limit);
+}
+
 static void
 vy_regulator_timer_cb(ev_loop *loop, ev_timer *timer, int events)
 {
@@ -200,11 +289,14 @@ vy_regulator_timer_cb(ev_loop *loop, ev_timer *timer, int events)
 	vy_regulator_update_write_rate(regulator);
 	vy_regulator_update_dump_watermark(regulator);
 	vy_regulator_check_dump_watermark(regulator);
+	vy_regulator_update_compaction_rate_limit(regulator);
 }
 
 void
 vy_regulator_create(struct vy_regulator *regulator, struct vy_quota *quota,
-		    vy_trigger_dump_f trigger_dump_cb)
+		    vy_trigger_dump_f trigger_dump_cb,
+		    vy_set_compaction_rate_limit_f set_compaction_rate_limit_cb,
+		    struct latency *read_latency)
 {
 	enum { KB = 1024, MB = KB * KB };
 	static int64_t dump_bandwidth_buckets[] = {
@@ -225,6 +317,8 @@ vy_regulator_create(struct vy_regulator *regulator, struct vy_quota *quota,
 
 	regulator->quota = quota;
 	regulator->trigger_dump_cb = trigger_dump_cb;
+	regulator->set_compaction_rate_limit_cb = set_compaction_rate_limit_cb;
+	regulator->read_latency = read_latency;
 	ev_timer_init(&regulator->timer, vy_regulator_timer_cb, 0,
 		      VY_REGULATOR_TIMER_PERIOD);
 	regulator->timer.data = regulator;
@@ -316,6 +410,15 @@ vy_regulator_reset_dump_bandwidth(struct vy_regulator *regulator, size_t max)
 				regulator->dump_bandwidth);
 }
 
+void
+vy_regulator_set_read_latency_slo(struct vy_regulator *regulator,
+				  double slo)
+{
+	regulator->read_latency_slo = slo;
+	if (slo == 0)
+		vy_regulator_set_compaction_rate_limit(regulator, 0);
+}
+
 void
 vy_regulator_reset_stat(struct vy_regulator *regulator)
 {
@@ -42,12 +42,17 @@ extern "C" {
 #endif /* defined(__cplusplus) */
 
 struct histogram;
+struct latency;
 struct vy_quota;
 struct vy_regulator;
 
 typedef int
 (*vy_trigger_dump_f)(struct vy_regulator *regulator);
 
+typedef void
+(*vy_set_compaction_rate_limit_f)(struct vy_regulator *regulator,
+				  size_t limit);
+
 /**
  * The regulator is supposed to keep track of vinyl memory usage
  * and dump/compaction progress and adjust transaction write rate
@@ -65,6 +70,32 @@ struct vy_regulator {
 	 * memory dump and return 0 on success, -1 on failure.
 	 */
 	vy_trigger_dump_f trigger_dump_cb;
+	/**
+	 * Called when the regulator changes the rate at which
+	 * compaction may write to disk, 0 means unlimited.
+	 */
+	vy_set_compaction_rate_limit_f set_compaction_rate_limit_cb;
+	/**
+	 * Latency of disk reads done on behalf of foreground
+	 * requests. Sampled and reset on each timer tick.
+	 */
+	struct latency *read_latency;
+	/**
+	 * Target 99th percentile of disk read latency, in seconds.
+	 * If set, compaction is throttled whenever it is exceeded.
+	 * 0 disables compaction throttling.
+	 */
+	double read_latency_slo;
+	/**
+	 * 99th percentile of disk read latency observed during
+	 * the last timer period, in seconds.
+	 */
+	double read_latency_p99;
+	/**
+	 * Current compaction rate limit, in bytes per second,
+	 * or 0 if compaction isn't throttled.
+	 */
+	size_t compaction_rate_limit;
 	/**
 	 * Periodic timer that updates the memory watermark
 	 * basing on accumulated statistics.
@@ -128,7 +159,9 @@ struct vy_regulator {
 
 void
 vy_regulator_create(struct vy_regulator *regulator, struct vy_quota *quota,
-		    vy_trigger_dump_f trigger_dump_cb);
+		    vy_trigger_dump_f trigger_dump_cb,
+		    vy_set_compaction_rate_limit_f set_compaction_rate_limit_cb,
+		    struct latency *read_latency);
 
 void
 vy_regulator_start(struct vy_regulator *regulator);
@@ -169,6 +202,15 @@ vy_regulator_set_memory_limit(struct vy_regulator *regulator, size_t limit);
 void
 vy_regulator_reset_dump_bandwidth(struct vy_regulator *regulator, size_t max);
 
+/**
+ * Set target disk read latency. Compaction is throttled as long
+ * as the observed 99th percentile exceeds it. 0 disables it.
+ * Called when box.cfg.vinyl_read_latency_slo is updated.
+ */
+void
+vy_regulator_set_read_latency_slo(struct vy_regulator *regulator,
+				  double slo);
+
 /**
  * Called when global statistics are reset by box.stat.reset().
  */
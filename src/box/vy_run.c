@@ -30,7 +30,9 @@
  */
 #include "vy_run.h"
 
+#include <fcntl.h>
 #include <zstd.h>
+#include <zdict.h>
 
 #include "fiber.h"
 #include "fiber_cond.h"
@@ -69,11 +71,31 @@ const char *vy_file_suffix[] = {
 	"index" inprogress_suffix, 	/* VY_FILE_INDEX_INPROGRESS */
 	"run",				/* VY_FILE_RUN */
 	"run" inprogress_suffix, 	/* VY_FILE_RUN_INPROGRESS */
+	"blob",				/* VY_FILE_BLOB */
 };
 
 /* sync run and index files very 16 MB */
 #define VY_RUN_SYNC_INTERVAL (1 << 24)
 
+/* false positive rate of a bucket probe in a range filter */
+#define VY_RUN_RANGE_FILTER_FPR 0.01
+
+enum {
+	/**
+	 * Amount of data to sample for training a page
+	 * compression dictionary, in dictionary sizes.
+	 * zstd docs recommend about 100 times the size
+	 * of the dictionary.
+	 */
+	VY_RUN_DICT_SAMPLE_RATIO = 100,
+	/**
+	 * Min number of samples to train a dictionary on.
+	 * If a run has fewer statements, it is compressed
+	 * without a dictionary.
+	 */
+	VY_RUN_DICT_MIN_SAMPLES = 100,
+};
+
 /**
  * We read runs in background threads so as not to stall tx.
  * This structure represents such a thread.
@@ -107,10 +129,252 @@ struct vy_page_read_task {
 	uint32_t pos_in_page;
 	/** [out] true if key was found in the page */
 	bool equal_found;
+	/** [out] time spent reading and decoding the page */
+	double read_time;
 	/** [out] resulting vinyl page */
 	struct vy_page *page;
 };
 
+/**
+ * Page read issued by run iterator readahead. Unlike a plain
+ * page read task, the iterator doesn't wait for it to complete
+ * right away: the task is sent to a reader thread, which routes
+ * it back to tx once the page has been read.
+ */
+struct vy_page_prefetch_task {
+	/** parent */
+	struct vy_page_read_task base;
+	/** Link in vy_run_iterator::readahead. */
+	struct rlist in_itr;
+	/** Fiber waiting for the task to complete, if any. */
+	struct fiber *waiter;
+	/** Set when the task has returned to tx. */
+	bool done;
+	/**
+	 * Set if the iterator doesn't need the page anymore,
+	 * in which case the task is freed on completion.
+	 */
+	bool discarded;
+};
+
+static void
+vy_page_delete(struct vy_page *page);
+
+static inline void
+vy_page_ref(struct vy_page *page)
+{
+	assert(page->refs > 0);
+	page->refs++;
+}
+
+static inline void
+vy_page_unref(struct vy_page *page)
+{
+	assert(page->refs > 0);
+	if (--page->refs == 0)
+		vy_page_delete(page);
+}
+
+/** Size of memory occupied by a page. */
+static inline size_t
+vy_page_mem_used(struct vy_page *page)
+{
+	return sizeof(*page) + page->unpacked_size +
+	       page->row_count * sizeof(uint32_t);
+}
+
+/* {{{ vy_page_cache */
+
+struct vy_page_cache_key {
+	int64_t run_id;
+	uint32_t page_no;
+};
+
+static inline uint32_t
+vy_page_cache_hash(int64_t run_id, uint32_t page_no)
+{
+	uint64_t h = (uint64_t)run_id * 0x9e3779b97f4a7c15ULL + page_no;
+	return (uint32_t)(h ^ (h >> 32));
+}
+
+#define mh_name _vy_page
+#define mh_key_t const struct vy_page_cache_key *
+#define mh_node_t struct vy_page *
+#define mh_arg_t void *
+#define mh_hash(a, arg) vy_page_cache_hash((*(a))->run_id, (*(a))->page_no)
+#define mh_hash_key(a, arg) vy_page_cache_hash((a)->run_id, (a)->page_no)
+#define mh_cmp(a, b, arg) ((*(a))->run_id != (*(b))->run_id || \
+			   (*(a))->page_no != (*(b))->page_no)
+#define mh_cmp_key(a, b, arg) ((a)->run_id != (*(b))->run_id || \
+			       (a)->page_no != (*(b))->page_no)
+#define MH_SOURCE 1
+#include "salad/mhash.h"
+
+enum {
+	/**
+	 * Max share of the page cache quota that may be used by
+	 * the protected segment, in percent.
+	 */
+	VY_PAGE_CACHE_PROTECTED_PCT = 80,
+	/**
+	 * Number of times in a row an iterator must switch to
+	 * the next page to be considered doing a range scan.
+	 */
+	VY_RUN_READAHEAD_TRIGGER = 2,
+	/** Max number of pages an iterator may read ahead. */
+	VY_RUN_READAHEAD_MAX_PAGES = 16,
+	/** Max size of memory that may be used by read ahead pages. */
+	VY_RUN_READAHEAD_MEM_MAX = 32 * 1024 * 1024,
+};
+
+static void
+vy_page_cache_create(struct vy_page_cache *cache)
+{
+	memset(cache, 0, sizeof(*cache));
+	rlist_create(&cache->probation);
+	rlist_create(&cache->protected);
+}
+
+/** Remove a page from the cache and drop the cache reference. */
+static void
+vy_page_cache_remove(struct vy_page_cache *cache, struct vy_page *page)
+{
+	assert(page->in_cache);
+	struct vy_page_cache_key key = { page->run_id, page->page_no };
+	mh_int_t k = mh_vy_page_find(cache->hash, &key, NULL);
+	assert(k != mh_end(cache->hash));
+	mh_vy_page_del(cache->hash, k, NULL);
+	size_t size = vy_page_mem_used(page);
+	assert(cache->mem_used >= size);
+	cache->mem_used -= size;
+	if (page->is_protected) {
+		assert(cache->protected_mem_used >= size);
+		cache->protected_mem_used -= size;
+	}
+	rlist_del_entry(page, in_lru);
+	rlist_del_entry(page, in_run);
+	page->in_cache = false;
+	page->is_protected = false;
+	vy_page_unref(page);
+}
+
+/** Evict pages until the cache fits in the given size. */
+static void
+vy_page_cache_evict(struct vy_page_cache *cache, size_t size)
+{
+	while (cache->mem_used > size) {
+		struct rlist *lru = !rlist_empty(&cache->probation) ?
+				    &cache->probation : &cache->protected;
+		struct vy_page *page = rlist_last_entry(lru, struct vy_page,
+							in_lru);
+		vy_page_cache_remove(cache, page);
+		cache->stat.evict++;
+	}
+}
+
+static void
+vy_page_cache_destroy(struct vy_page_cache *cache)
+{
+	vy_page_cache_evict(cache, 0);
+	if (cache->hash != NULL)
+		mh_vy_page_delete(cache->hash);
+}
+
+/**
+ * Look up a page in the cache. Returns NULL if not found.
+ * The caller is supposed to reference the returned page.
+ */
+static struct vy_page *
+vy_page_cache_get(struct vy_page_cache *cache, int64_t run_id,
+		  uint32_t page_no)
+{
+	if (cache->quota == 0)
+		return NULL;
+	cache->stat.lookup++;
+	if (cache->hash == NULL)
+		return NULL;
+	struct vy_page_cache_key key = { run_id, page_no };
+	mh_int_t k = mh_vy_page_find(cache->hash, &key, NULL);
+	if (k == mh_end(cache->hash))
+		return NULL;
+	struct vy_page *page = *mh_vy_page_node(cache->hash, k);
+	cache->stat.hit++;
+	rlist_move_entry(&cache->protected, page, in_lru);
+	if (!page->is_protected) {
+		/*
+		 * The page was hit while on probation, promote it
+		 * and demote least recently used protected pages
+		 * if the protected segment is full.
+		 */
+		page->is_protected = true;
+		cache->protected_mem_used += vy_page_mem_used(page);
+		size_t limit = cache->quota / 100 * VY_PAGE_CACHE_PROTECTED_PCT;
+		while (cache->protected_mem_used > limit) {
+			struct vy_page *victim = rlist_last_entry(
+				&cache->protected, struct vy_page, in_lru);
+			if (victim == page)
+				break;
+			victim->is_protected = false;
+			cache->protected_mem_used -= vy_page_mem_used(victim);
+			rlist_move_entry(&cache->probation, victim, in_lru);
+		}
+	}
+	return page;
+}
+
+/** Add a page just read from disk to the cache. */
+static void
+vy_page_cache_put(struct vy_page_cache *cache, struct vy_run *run,
+		  struct vy_page *page)
+{
+	assert(!page->in_cache);
+	size_t size = vy_page_mem_used(page);
+	if (size > cache->quota)
+		return;
+	if (cache->hash == NULL) {
+		cache->hash = mh_vy_page_new();
+		if (cache->hash == NULL)
+			return;
+	}
+	/*
+	 * Another fiber may have read the same page while we
+	 * were waiting for disk, keep the cached copy then.
+	 */
+	struct vy_page_cache_key key = { page->run_id, page->page_no };
+	if (mh_vy_page_find(cache->hash, &key, NULL) != mh_end(cache->hash))
+		return;
+	if (mh_vy_page_put(cache->hash, &page, NULL, NULL) ==
+	    mh_end(cache->hash))
+		return;
+	vy_page_ref(page);
+	page->in_cache = true;
+	page->is_protected = false;
+	rlist_add_entry(&cache->probation, page, in_lru);
+	rlist_add_entry(&run->cached_pages, page, in_run);
+	cache->mem_used += size;
+	cache->stat.put++;
+	vy_page_cache_evict(cache, cache->quota);
+}
+
+/** Remove all pages of a run from the cache. */
+static void
+vy_page_cache_purge_run(struct vy_page_cache *cache, struct vy_run *run)
+{
+	struct vy_page *page, *tmp;
+	rlist_foreach_entry_safe(page, &run->cached_pages, in_run, tmp)
+		vy_page_cache_remove(cache, page);
+}
+
+void
+vy_run_env_set_page_cache_quota(struct vy_run_env *env, size_t quota)
+{
+	struct vy_page_cache *cache = &env->page_cache;
+	cache->quota = quota;
+	vy_page_cache_evict(cache, quota);
+}
+
+/* }}} vy_page_cache */
+
 /** Destructor for env->zdctx_key thread-local variable */
 static void
 vy_free_zdctx(void *arg)
@@ -119,6 +383,48 @@ vy_free_zdctx(void *arg)
 	ZSTD_freeDStream(arg);
 }
 
+static int
+vy_page_read_cb(struct cbus_call_msg *base);
+
+/**
+ * Process read requests queued to a reader thread.
+ *
+ * Pages are read one by one with blocking pread(), so to keep
+ * the disk busy with more than one request per thread, we first
+ * ask the kernel to start reading all queued pages in background.
+ * By the time we get to a page, it is likely to be already in
+ * the OS page cache.
+ */
+static void
+vy_run_reader_process(struct cbus_endpoint *endpoint)
+{
+	struct stailq queue;
+	stailq_create(&queue);
+	cbus_endpoint_fetch(endpoint, &queue);
+	struct cmsg *msg, *next;
+#ifdef HAVE_POSIX_FADVISE
+	if (stailq_first(&queue) != stailq_last(&queue)) {
+		struct errinj *inj = errinj(ERRINJ_VY_READ_PAGE_HINT_COUNT,
+					    ERRINJ_INT);
+		stailq_foreach_entry(msg, &queue, fifo) {
+			struct cbus_call_msg *call = (struct cbus_call_msg *)msg;
+			if (call->func != vy_page_read_cb)
+				continue;
+			struct vy_page_read_task *task =
+				(struct vy_page_read_task *)call;
+			(void)posix_fadvise(task->run->fd,
+					    task->page_info->offset,
+					    task->page_info->size,
+					    POSIX_FADV_WILLNEED);
+			if (inj != NULL)
+				++inj->iparam;
+		}
+	}
+#endif /* HAVE_POSIX_FADVISE */
+	stailq_foreach_entry_safe(msg, next, &queue, fifo)
+		cmsg_deliver(msg);
+}
+
 /** Run reader thread function. */
 static int
 vy_run_reader_f(va_list ap)
@@ -129,7 +435,12 @@ vy_run_reader_f(va_list ap)
 	cpipe_create(&reader->tx_pipe, "tx_prio");
 	cbus_endpoint_create(&endpoint, cord_name(cord()),
 			     fiber_schedule_cb, fiber());
-	cbus_loop(&endpoint);
+	while (true) {
+		vy_run_reader_process(&endpoint);
+		if (fiber_is_cancelled())
+			break;
+		fiber_yield();
+	}
 	cbus_endpoint_destroy(&endpoint, cbus_process);
 	cpipe_destroy(&reader->tx_pipe);
 	return 0;
@@ -183,6 +494,11 @@ vy_run_env_create(struct vy_run_env *env, int read_threads)
 	tt_pthread_key_create(&env->zdctx_key, vy_free_zdctx);
 	mempool_create(&env->read_task_pool, cord_slab_cache(),
 		       sizeof(struct vy_page_read_task));
+	mempool_create(&env->prefetch_task_pool, cord_slab_cache(),
+		       sizeof(struct vy_page_prefetch_task));
+	vy_page_cache_create(&env->page_cache);
+	if (latency_create(&env->read_latency) != 0)
+		panic("failed to allocate read latency histogram");
 }
 
 /**
@@ -193,6 +509,9 @@ vy_run_env_destroy(struct vy_run_env *env)
 {
 	if (env->reader_pool != NULL)
 		vy_run_env_stop_readers(env);
+	vy_page_cache_destroy(&env->page_cache);
+	latency_destroy(&env->read_latency);
+	mempool_destroy(&env->prefetch_task_pool);
 	mempool_destroy(&env->read_task_pool);
 	tt_pthread_key_delete(env->zdctx_key);
 }
@@ -208,6 +527,17 @@ vy_run_env_enable_coio(struct vy_run_env *env)
 	vy_run_env_start_readers(env);
 }
 
+/** Pick a reader thread to process the next read request. */
+static struct vy_run_reader *
+vy_run_env_next_reader(struct vy_run_env *env)
+{
+	assert(env->reader_pool != NULL);
+	struct vy_run_reader *reader;
+	reader = &env->reader_pool[env->next_reader++];
+	env->next_reader %= env->reader_pool_size;
+	return reader;
+}
+
 /**
  * Execute a task on behalf of a reader thread.
  */
@@ -219,10 +549,7 @@ vy_run_env_coio_call(struct vy_run_env *env, struct cbus_call_msg *msg,
 	if (env->reader_pool == NULL)
 		return func(msg);
 
-	/* Pick a reader thread. */
-	struct vy_run_reader *reader;
-	reader = &env->reader_pool[env->next_reader++];
-	env->next_reader %= env->reader_pool_size;
+	struct vy_run_reader *reader = vy_run_env_next_reader(env);
 
 	/* Post the task to the reader thread. */
 	bool cancellable = fiber_set_cancellable(false);
@@ -286,6 +613,7 @@ vy_run_new(struct vy_run_env *env, int64_t id)
 	run->refs = 1;
 	rlist_create(&run->in_lsm);
 	rlist_create(&run->in_unused);
+	rlist_create(&run->cached_pages);
 	return run;
 }
 
@@ -305,18 +633,53 @@ vy_run_clear(struct vy_run *run)
 		tuple_bloom_delete(run->info.bloom);
 		run->info.bloom = NULL;
 	}
+	if (run->info.range_filter != NULL) {
+		vy_range_filter_delete(run->info.range_filter);
+		run->info.range_filter = NULL;
+	}
 	free(run->info.min_key);
 	run->info.min_key = NULL;
 	free(run->info.max_key);
 	run->info.max_key = NULL;
+	free(run->info.dict);
+	run->info.dict = NULL;
+	run->info.dict_size = 0;
+	ZSTD_freeDDict(run->ddict);
+	run->ddict = NULL;
+}
+
+/**
+ * Create a digested dictionary for decompressing pages of
+ * a run from the dictionary stored in the run info.
+ */
+static int
+vy_run_create_ddict(struct vy_run *run)
+{
+	assert(run->ddict == NULL);
+	if (run->info.dict == NULL)
+		return 0;
+	run->ddict = ZSTD_createDDict(run->info.dict, run->info.dict_size);
+	if (run->ddict == NULL) {
+		diag_set(ClientError, ER_DECOMPRESSION,
+			 "failed to create dictionary");
+		return -1;
+	}
+	return 0;
 }
 
 void
 vy_run_delete(struct vy_run *run)
 {
 	assert(run->refs == 0);
+	if (!rlist_empty(&run->cached_pages))
+		vy_page_cache_purge_run(&run->env->page_cache, run);
 	if (run->fd >= 0 && close(run->fd) < 0)
 		say_syserror("close failed");
+	for (uint32_t i = 0; i < run->blob_count; i++) {
+		if (run->blobs[i].blob != NULL)
+			vy_blob_unref(run->blobs[i].blob);
+	}
+	free(run->blobs);
 	vy_run_clear(run);
 	TRASH(run);
 	free(run);
@@ -325,7 +688,12 @@ vy_run_delete(struct vy_run *run)
 size_t
 vy_run_bloom_size(struct vy_run *run)
 {
-	return run->info.bloom == NULL ? 0 : tuple_bloom_size(run->info.bloom);
+	size_t size = 0;
+	if (run->info.bloom != NULL)
+		size += tuple_bloom_size(run->info.bloom);
+	if (run->info.range_filter != NULL)
+		size += vy_range_filter_size(run->info.range_filter);
+	return size;
 }
 
 /**
@@ -686,6 +1054,21 @@ vy_run_info_decode(struct vy_run_info *run_info,
 		case VY_RUN_INFO_STMT_STAT:
 			vy_stmt_stat_decode(&run_info->stmt_stat, &pos);
 			break;
+		case VY_RUN_INFO_DICT:
+			tmp = mp_decode_bin(&pos, &run_info->dict_size);
+			run_info->dict = malloc(run_info->dict_size);
+			if (run_info->dict == NULL) {
+				diag_set(OutOfMemory, run_info->dict_size,
+					 "malloc", "run dictionary");
+				return -1;
+			}
+			memcpy(run_info->dict, tmp, run_info->dict_size);
+			break;
+		case VY_RUN_INFO_RANGE_FILTER:
+			run_info->range_filter = vy_range_filter_decode(&pos);
+			if (run_info->range_filter == NULL)
+				return -1;
+			break;
 		default:
 			mp_next(&pos); /* unknown key, ignore */
 			break;
@@ -711,6 +1094,9 @@ vy_page_new(const struct vy_page_info *page_info)
 			 "load_page", "page cache");
 		return NULL;
 	}
+	page->refs = 1;
+	page->in_cache = false;
+	page->is_protected = false;
 	page->unpacked_size = page_info->unpacked_size;
 	page->row_count = page_info->row_count;
 	page->row_index = calloc(page_info->row_count, sizeof(uint32_t));
@@ -735,6 +1121,7 @@ vy_page_new(const struct vy_page_info *page_info)
 static void
 vy_page_delete(struct vy_page *page)
 {
+	assert(!page->in_cache);
 	uint32_t *row_index = page->row_index;
 	char *data = page->data;
 #if !defined(NDEBUG)
@@ -822,6 +1209,9 @@ vy_page_find_key(struct vy_page *page, struct vy_entry key,
 	return end;
 }
 
+static void
+vy_run_iterator_cancel_readahead(struct vy_run_iterator *itr);
+
 /**
  * End iteration and free cached data.
  */
@@ -833,11 +1223,12 @@ vy_run_iterator_stop(struct vy_run_iterator *itr)
 		itr->curr = vy_entry_none();
 	}
 	if (itr->curr_page != NULL) {
-		vy_page_delete(itr->curr_page);
+		vy_page_unref(itr->curr_page);
 		if (itr->prev_page != NULL)
-			vy_page_delete(itr->prev_page);
+			vy_page_unref(itr->prev_page);
 		itr->curr_page = itr->prev_page = NULL;
 	}
+	vy_run_iterator_cancel_readahead(itr);
 }
 
 static int
@@ -924,7 +1315,8 @@ vy_page_read(struct vy_page *page, const struct vy_page_info *page_info,
 	const char *data_end = data + readen;
 	char *rows = page->data;
 	char *rows_end = rows + page_info->unpacked_size;
-	if (xlog_tx_decode(data, data_end, rows, rows_end, zdctx) != 0)
+	if (xlog_tx_decode(data, data_end, rows, rows_end, zdctx,
+			   run->ddict) != 0)
 		goto error;
 
 	struct xrow_header xrow;
@@ -984,8 +1376,10 @@ vy_page_read_cb(struct cbus_call_msg *base)
 	ZSTD_DStream *zdctx = vy_env_get_zdctx(task->run->env);
 	if (zdctx == NULL)
 		return -1;
+	double start = ev_monotonic_time();
 	if (vy_page_read(task->page, task->page_info, task->run, zdctx) != 0)
 		return -1;
+	task->read_time = ev_monotonic_time() - start;
 	if (task->key.stmt != NULL) {
 		task->pos_in_page = vy_page_find_key(task->page, task->key,
 						     task->cmp_def, task->format,
@@ -995,6 +1389,256 @@ vy_page_read_cb(struct cbus_call_msg *base)
 	return 0;
 }
 
+/* {{{ vy_run_iterator readahead */
+
+static void
+vy_page_prefetch_task_delete(struct vy_page_prefetch_task *task)
+{
+	struct vy_run *run = task->base.run;
+	struct vy_run_env *env = run->env;
+	struct vy_page *page = task->base.page;
+	if (page != NULL) {
+		assert(env->readahead_mem_used >= vy_page_mem_used(page));
+		env->readahead_mem_used -= vy_page_mem_used(page);
+		vy_page_unref(page);
+	}
+	vy_run_unref(run);
+	mempool_free(&env->prefetch_task_pool, task);
+}
+
+/** Read ahead a page, called in a reader thread. */
+static void
+vy_page_prefetch_read_f(struct cmsg *msg)
+{
+	struct cbus_call_msg *call = (struct cbus_call_msg *)msg;
+	/*
+	 * The error has already been logged by vy_page_read().
+	 * The iterator will retry reading the page synchronously
+	 * and report the error to the user if it happens again.
+	 */
+	call->rc = vy_page_read_cb(call);
+	if (call->rc != 0)
+		diag_clear(diag_get());
+}
+
+/** Complete a readahead request, called in tx. */
+static void
+vy_page_prefetch_complete_f(struct cmsg *msg)
+{
+	struct vy_page_prefetch_task *task =
+		(struct vy_page_prefetch_task *)msg;
+	task->done = true;
+	if (task->discarded) {
+		task->base.run->env->readahead_stat.wasted++;
+		vy_page_prefetch_task_delete(task);
+	} else if (task->waiter != NULL) {
+		fiber_wakeup(task->waiter);
+	}
+}
+
+/**
+ * Send a request to read a page to a reader thread without
+ * waiting for the result. The request is appended to the
+ * iterator readahead list.
+ *
+ * Readahead is just an optimization so this function doesn't
+ * set diag on failure.
+ *
+ * @retval 0 success
+ * @retval -1 out of memory or readahead memory limit reached
+ */
+static int
+vy_run_iterator_prefetch_page(struct vy_run_iterator *itr, uint32_t page_no)
+{
+	struct vy_run *run = itr->slice->run;
+	struct vy_run_env *env = run->env;
+	struct vy_page_info *page_info = vy_run_page_info(run, page_no);
+	if (env->readahead_mem_used + page_info->unpacked_size >
+	    VY_RUN_READAHEAD_MEM_MAX)
+		return -1;
+	struct vy_page_prefetch_task *task =
+		mempool_alloc(&env->prefetch_task_pool);
+	if (task == NULL)
+		return -1;
+	struct vy_page *page = vy_page_new(page_info);
+	if (page == NULL) {
+		diag_clear(diag_get());
+		mempool_free(&env->prefetch_task_pool, task);
+		return -1;
+	}
+	page->run_id = run->id;
+	page->page_no = page_no;
+
+	struct vy_page_read_task *read_task = &task->base;
+	read_task->run = run;
+	read_task->page_info = page_info;
+	read_task->page = page;
+	read_task->key = vy_entry_none();
+	read_task->iterator_type = ITER_GE;
+	read_task->cmp_def = itr->cmp_def;
+	read_task->format = itr->format;
+	read_task->pos_in_page = 0;
+	read_task->equal_found = false;
+	read_task->read_time = 0;
+	task->waiter = NULL;
+	task->done = false;
+	task->discarded = false;
+	vy_run_ref(run);
+
+	struct vy_run_reader *reader = vy_run_env_next_reader(env);
+	struct cbus_call_msg *call = &read_task->base;
+	call->func = vy_page_read_cb;
+	call->rc = 0;
+	call->route[0].f = vy_page_prefetch_read_f;
+	call->route[0].pipe = &reader->tx_pipe;
+	call->route[1].f = vy_page_prefetch_complete_f;
+	call->route[1].pipe = NULL;
+	cmsg_init(&call->msg, call->route);
+	cpipe_push(&reader->reader_pipe, &call->msg);
+
+	rlist_add_tail_entry(&itr->readahead, task, in_itr);
+	itr->readahead_count++;
+	env->readahead_mem_used += vy_page_mem_used(page);
+	env->readahead_stat.pages++;
+	return 0;
+}
+
+/** Remove a page from the iterator readahead list and free it. */
+static void
+vy_run_iterator_discard_prefetch(struct vy_run_iterator *itr,
+				 struct vy_page_prefetch_task *task)
+{
+	assert(itr->readahead_count > 0);
+	rlist_del_entry(task, in_itr);
+	itr->readahead_count--;
+	if (!task->done) {
+		/* Will be freed on completion. */
+		task->discarded = true;
+		return;
+	}
+	task->base.run->env->readahead_stat.wasted++;
+	vy_page_prefetch_task_delete(task);
+}
+
+/** Throw away all pages read ahead by an iterator. */
+static void
+vy_run_iterator_cancel_readahead(struct vy_run_iterator *itr)
+{
+	struct vy_page_prefetch_task *task, *tmp;
+	rlist_foreach_entry_safe(task, &itr->readahead, in_itr, tmp)
+		vy_run_iterator_discard_prefetch(itr, task);
+	assert(itr->readahead_count == 0);
+	itr->seq_count = 0;
+}
+
+/**
+ * Look up a page in the iterator readahead list and remove it
+ * from there, waiting for the read to complete if necessary.
+ * Sets @result to NULL if the page wasn't read ahead or the read
+ * failed, in which case the caller should read it synchronously.
+ *
+ * @retval 0 success
+ * @retval -1 the fiber was cancelled while waiting
+ */
+static int
+vy_run_iterator_take_prefetched(struct vy_run_iterator *itr,
+				uint32_t page_no, struct vy_page **result)
+{
+	*result = NULL;
+	struct vy_page_prefetch_task *task = NULL, *t;
+	rlist_foreach_entry(t, &itr->readahead, in_itr) {
+		if (t->base.page->page_no == page_no) {
+			task = t;
+			break;
+		}
+	}
+	if (task == NULL)
+		return 0;
+
+	if (!task->done) {
+		task->waiter = fiber();
+		while (!task->done && !fiber_is_cancelled())
+			fiber_yield();
+		task->waiter = NULL;
+		if (!task->done) {
+			/* The task will be freed on completion. */
+			vy_run_iterator_discard_prefetch(itr, task);
+			diag_set(FiberIsCancelled);
+			return -1;
+		}
+	}
+	rlist_del_entry(task, in_itr);
+	itr->readahead_count--;
+
+	struct vy_run_env *env = task->base.run->env;
+	if (task->base.base.rc == 0) {
+		struct vy_page *page = task->base.page;
+		struct vy_page_info *page_info = task->base.page_info;
+		task->base.page = NULL;
+		env->readahead_mem_used -= vy_page_mem_used(page);
+		env->readahead_stat.useful++;
+		itr->stat->read_time += task->base.read_time;
+		latency_collect(&env->read_latency, task->base.read_time);
+		/*
+		 * Account the read only when the page is used, so
+		 * that wasted readahead doesn't inflate statistics.
+		 */
+		itr->stat->read.rows += page_info->row_count;
+		itr->stat->read.bytes += page_info->unpacked_size;
+		itr->stat->read.bytes_compressed += page_info->size;
+		itr->stat->read.pages++;
+		*result = page;
+	} else {
+		env->readahead_stat.wasted++;
+	}
+	vy_page_prefetch_task_delete(task);
+	return 0;
+}
+
+/**
+ * Called when a run iterator switches to another page while
+ * iterating. If the iterator has been reading pages one after
+ * another for a while, request the following pages from reader
+ * threads in advance so that they are ready by the time the
+ * iterator gets to them. The longer the scan, the more pages
+ * are read ahead.
+ */
+static void
+vy_run_iterator_readahead(struct vy_run_iterator *itr, uint32_t page_no)
+{
+	struct vy_slice *slice = itr->slice;
+	if (slice->run->env->reader_pool == NULL)
+		return;
+
+	int dir = iterator_direction(itr->iterator_type);
+	if (page_no != itr->seq_page_no + dir) {
+		/* Random access, pages read ahead are useless. */
+		vy_run_iterator_cancel_readahead(itr);
+		itr->seq_page_no = page_no;
+		return;
+	}
+	itr->seq_page_no = page_no;
+	if (++itr->seq_count < VY_RUN_READAHEAD_TRIGGER)
+		return;
+
+	uint32_t shift = MIN(itr->seq_count - VY_RUN_READAHEAD_TRIGGER, 8U);
+	int64_t window = MIN(2U << shift, (uint32_t)VY_RUN_READAHEAD_MAX_PAGES);
+	int64_t next = (int64_t)page_no + dir;
+	if (!rlist_empty(&itr->readahead)) {
+		struct vy_page_prefetch_task *last = rlist_last_entry(
+			&itr->readahead, struct vy_page_prefetch_task, in_itr);
+		next = (int64_t)last->base.page->page_no + dir;
+	}
+	for (; (next - page_no) * dir <= window; next += dir) {
+		if (next < slice->first_page_no || next > slice->last_page_no)
+			break;
+		if (vy_run_iterator_prefetch_page(itr, next) != 0)
+			break;
+	}
+}
+
+/* }}} vy_run_iterator readahead */
+
 /**
  * Read a page from disk given its number.
  * The function caches two most recently read pages.
@@ -1020,6 +1664,23 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 		   itr->prev_page->page_no == page_no) {
 		SWAP(itr->prev_page, itr->curr_page);
 		page = itr->curr_page;
+	} else {
+		if (vy_run_iterator_take_prefetched(itr, page_no, &page) != 0)
+			return -1;
+		if (page != NULL) {
+			vy_page_cache_put(&env->page_cache, slice->run, page);
+		} else {
+			page = vy_page_cache_get(&env->page_cache,
+						 slice->run->id, page_no);
+			if (page != NULL)
+				vy_page_ref(page);
+		}
+		if (page != NULL) {
+			if (itr->prev_page != NULL)
+				vy_page_unref(itr->prev_page);
+			itr->prev_page = itr->curr_page;
+			itr->curr_page = page;
+		}
 	}
 	if (page != NULL) {
 		if (key.stmt != NULL)
@@ -1035,6 +1696,8 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 	page = vy_page_new(page_info);
 	if (page == NULL)
 		return -1;
+	page->run_id = slice->run->id;
+	page->page_no = page_no;
 
 	/* Read page data from the disk */
 	struct vy_page_read_task *task = mempool_alloc(&env->read_task_pool);
@@ -1053,11 +1716,15 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 	task->format = itr->format;
 	task->pos_in_page = 0;
 	task->equal_found = false;
+	task->read_time = 0;
 
 	int rc = vy_run_env_coio_call(env, &task->base, vy_page_read_cb);
 
 	*pos_in_page = task->pos_in_page;
 	*equal_found = task->equal_found;
+	itr->stat->read_time += task->read_time;
+	if (rc == 0)
+		latency_collect(&env->read_latency, task->read_time);
 
 	mempool_free(&env->read_task_pool, task);
 	if (rc != 0) {
@@ -1067,10 +1734,10 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 
 	/* Update cache */
 	if (itr->prev_page != NULL)
-		vy_page_delete(itr->prev_page);
+		vy_page_unref(itr->prev_page);
 	itr->prev_page = itr->curr_page;
 	itr->curr_page = page;
-	page->page_no = page_no;
+	vy_page_cache_put(&env->page_cache, slice->run, page);
 
 	/* Update read statistics. */
 	itr->stat->read.rows += page_info->row_count;
@@ -1482,6 +2149,10 @@ vy_run_iterator_open(struct vy_run_iterator *itr,
 	itr->curr_pos.page_no = slice->run->info.page_count;
 	itr->curr_page = NULL;
 	itr->prev_page = NULL;
+	rlist_create(&itr->readahead);
+	itr->readahead_count = 0;
+	itr->seq_page_no = itr->curr_pos.page_no;
+	itr->seq_count = 0;
 	itr->search_started = false;
 
 	/*
@@ -1518,11 +2189,14 @@ vy_run_iterator_next_key(struct vy_run_iterator *itr, struct vy_entry *ret)
 	do {
 		if (next.stmt != NULL)
 			tuple_unref(next.stmt);
+		uint32_t page_no = itr->curr_pos.page_no;
 		if (vy_run_iterator_next_pos(itr, itr->iterator_type,
 					     &itr->curr_pos) != 0) {
 			vy_run_iterator_stop(itr);
 			return 0;
 		}
+		if (itr->curr_pos.page_no != page_no)
+			vy_run_iterator_readahead(itr, itr->curr_pos.page_no);
 
 		if (vy_run_iterator_read(itr, itr->curr_pos, &next) != 0)
 			return -1;
@@ -1631,6 +2305,56 @@ vy_run_iterator_skip(struct vy_run_iterator *itr, struct vy_entry last,
 	return 0;
 }
 
+bool
+vy_run_iterator_check_range(struct vy_run_iterator *itr,
+			    struct vy_entry last, struct vy_entry next)
+{
+	struct vy_run *run = itr->slice->run;
+	struct vy_range_filter *filter = run->info.range_filter;
+	if (filter == NULL ||
+	    !vy_range_filter_is_compatible(filter, itr->cmp_def))
+		return true;
+	int dir = iterator_direction(itr->iterator_type);
+	/*
+	 * If the iterator is already positioned past the last
+	 * key, skipping to it doesn't need a disk read.
+	 */
+	if (itr->search_started &&
+	    (itr->curr.stmt == NULL || last.stmt == NULL ||
+	     dir * vy_entry_compare(itr->curr, last, itr->cmp_def) > 0))
+		return true;
+	uint64_t lo = 0, hi = UINT64_MAX, value;
+	if (vy_range_filter_map_key(last.stmt != NULL ? last : itr->key,
+				    itr->cmp_def, &value)) {
+		if (dir > 0)
+			lo = value;
+		else
+			hi = value;
+	}
+	if (next.stmt != NULL &&
+	    vy_range_filter_map_key(next, itr->cmp_def, &value)) {
+		if (dir > 0)
+			hi = value;
+		else
+			lo = value;
+	}
+	if (itr->iterator_type == ITER_EQ &&
+	    vy_range_filter_map_key(itr->key, itr->cmp_def, &value)) {
+		lo = MAX(lo, value);
+		hi = MIN(hi, value);
+	}
+	if (lo <= hi && vy_range_filter_maybe_has(filter, lo, hi)) {
+		itr->stat->range_filter_miss++;
+		return true;
+	}
+	itr->stat->range_filter_hit++;
+	if (run->count.pages > 0) {
+		itr->stat->range_filter_saved += run->count.bytes_compressed /
+						 run->count.pages;
+	}
+	return false;
+}
+
 void
 vy_run_iterator_close(struct vy_run_iterator *itr)
 {
@@ -1704,7 +2428,8 @@ vy_run_recover(struct vy_run *run, const char *dir,
 		goto fail_close;
 	}
 
-	if (vy_run_info_decode(&run->info, &xrow, path) != 0)
+	if (vy_run_info_decode(&run->info, &xrow, path) != 0 ||
+	    vy_run_create_ddict(run) != 0)
 		goto fail_close;
 
 	/* Allocate buffer for page info. */
@@ -1783,14 +2508,14 @@ fail:
 static int
 vy_run_dump_stmt(struct vy_entry entry, struct xlog *data_xlog,
 		 struct vy_page_info *info, struct key_def *key_def,
-		 bool is_primary)
+		 bool is_primary, bool is_covering)
 {
 	struct xrow_header xrow;
 	int rc = (is_primary ?
 		  vy_stmt_encode_primary(entry.stmt, key_def, 0, &xrow) :
 		  vy_stmt_encode_secondary(entry.stmt, key_def,
 					   vy_entry_multikey_idx(entry, key_def),
-					   &xrow));
+					   is_covering, &xrow));
 	if (rc != 0)
 		return -1;
 
@@ -1990,6 +2715,10 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 	uint32_t key_count = 6;
 	if (run_info->bloom != NULL)
 		key_count++;
+	if (run_info->dict != NULL)
+		key_count++;
+	if (run_info->range_filter != NULL)
+		key_count++;
 
 	size_t size = mp_sizeof_map(key_count);
 	size += mp_sizeof_uint(VY_RUN_INFO_MIN_KEY) + min_key_size;
@@ -2005,6 +2734,12 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 			tuple_bloom_size(run_info->bloom);
 	size += mp_sizeof_uint(VY_RUN_INFO_STMT_STAT) +
 		vy_stmt_stat_sizeof(&run_info->stmt_stat);
+	if (run_info->dict != NULL)
+		size += mp_sizeof_uint(VY_RUN_INFO_DICT) +
+			mp_sizeof_bin(run_info->dict_size);
+	if (run_info->range_filter != NULL)
+		size += mp_sizeof_uint(VY_RUN_INFO_RANGE_FILTER) +
+			vy_range_filter_size(run_info->range_filter);
 
 	char *pos = region_alloc(&fiber()->gc, size);
 	if (pos == NULL) {
@@ -2033,6 +2768,14 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 	}
 	pos = mp_encode_uint(pos, VY_RUN_INFO_STMT_STAT);
 	pos = vy_stmt_stat_encode(&run_info->stmt_stat, pos);
+	if (run_info->dict != NULL) {
+		pos = mp_encode_uint(pos, VY_RUN_INFO_DICT);
+		pos = mp_encode_bin(pos, run_info->dict, run_info->dict_size);
+	}
+	if (run_info->range_filter != NULL) {
+		pos = mp_encode_uint(pos, VY_RUN_INFO_RANGE_FILTER);
+		pos = vy_range_filter_encode(run_info->range_filter, pos);
+	}
 	xrow->body->iov_len = (void *)pos - xrow->body->iov_base;
 	xrow->bodycnt = 1;
 	xrow->type = VY_INDEX_RUN_INFO;
@@ -2124,6 +2867,11 @@ vy_run_writer_create(struct vy_run_writer *writer, struct vy_run *run,
 	writer->page_size = page_size;
 	writer->bloom_fpr = bloom_fpr;
 	writer->no_compression = no_compression;
+	char path[PATH_MAX];
+	vy_run_snprint_path(path, sizeof(path), dirpath, space_id, iid,
+			    run->id, VY_FILE_BLOB);
+	vy_blob_writer_create(&writer->blob, path, run->id);
+	vy_range_filter_builder_create(&writer->range_filter);
 	if (bloom_fpr < 1) {
 		writer->bloom = tuple_bloom_builder_new(key_def->part_count);
 		if (writer->bloom == NULL)
@@ -2132,6 +2880,11 @@ vy_run_writer_create(struct vy_run_writer *writer, struct vy_run *run,
 	xlog_clear(&writer->data_xlog);
 	ibuf_create(&writer->row_index_buf, &cord()->slabc,
 		    4096 * sizeof(uint32_t));
+	ibuf_create(&writer->dict_stmts, &cord()->slabc,
+		    1024 * sizeof(struct vy_entry));
+	ibuf_create(&writer->dict_samples, &cord()->slabc, 64 * 1024);
+	ibuf_create(&writer->dict_sample_sizes, &cord()->slabc,
+		    1024 * sizeof(size_t));
 	run->info.min_lsn = INT64_MAX;
 	run->info.max_lsn = -1;
 	assert(run->page_info == NULL);
@@ -2217,6 +2970,10 @@ vy_run_writer_write_to_page(struct vy_run_writer *writer, struct vy_entry entry)
 	if (writer->bloom != NULL &&
 	    vy_bloom_builder_add(writer->bloom, entry, writer->key_def) != 0)
 		return -1;
+	if (writer->has_range_filter &&
+	    vy_range_filter_builder_add_entry(&writer->range_filter,
+					      entry, writer->key_def) != 0)
+		return -1;
 	if (writer->last.stmt != NULL)
 		vy_stmt_unref_if_possible(writer->last.stmt);
 	writer->last = entry;
@@ -2231,7 +2988,8 @@ vy_run_writer_write_to_page(struct vy_run_writer *writer, struct vy_entry entry)
 	}
 	*offset = page->unpacked_size;
 	if (vy_run_dump_stmt(entry, &writer->data_xlog, page,
-			     writer->cmp_def, writer->iid == 0) != 0)
+			     writer->cmp_def, writer->iid == 0,
+			     writer->is_covering) != 0)
 		return -1;
 	int64_t lsn = vy_stmt_lsn(entry.stmt);
 	run->info.min_lsn = MIN(run->info.min_lsn, lsn);
@@ -2278,24 +3036,148 @@ vy_run_writer_end_page(struct vy_run_writer *writer)
 	return 0;
 }
 
+/**
+ * Append a statement to the run file.
+ * @param writer Run writer.
+ * @param entry Statement to write.
+ *
+ * @retval -1 Memory or IO error.
+ * @retval  0 Success.
+ */
+static int
+vy_run_writer_write_stmt(struct vy_run_writer *writer, struct vy_entry entry)
+{
+	if (ibuf_used(&writer->row_index_buf) == 0 &&
+	    vy_run_writer_start_page(writer, entry) != 0)
+		return -1;
+	if (vy_run_writer_write_to_page(writer, entry) != 0)
+		return -1;
+	if (obuf_size(&writer->data_xlog.obuf) >= writer->page_size &&
+	    vy_run_writer_end_page(writer) != 0)
+		return -1;
+	return 0;
+}
+
+/**
+ * Train a page compression dictionary on the statements
+ * buffered by the writer and then write them out.
+ *
+ * Failure to train a dictionary isn't an error: it happens
+ * if there are too few statements or they are too small or
+ * too diverse to produce a useful dictionary, in which case
+ * pages are compressed without a dictionary.
+ *
+ * @retval -1 Memory or IO error.
+ * @retval  0 Success.
+ */
+static int
+vy_run_writer_train_dict(struct vy_run_writer *writer)
+{
+	struct vy_run *run = writer->run;
+	size_t dict_capacity = writer->dict_size;
+	size_t sample_count = ibuf_used(&writer->dict_sample_sizes) /
+			      sizeof(size_t);
+	assert(dict_capacity > 0);
+	assert(run->info.dict == NULL);
+	/* Write statements as usual from now on. */
+	writer->dict_size = 0;
+
+	if (sample_count < VY_RUN_DICT_MIN_SAMPLES)
+		goto write;
+	char *dict = malloc(dict_capacity);
+	if (dict == NULL) {
+		diag_set(OutOfMemory, dict_capacity, "malloc",
+			 "run dictionary");
+		return -1;
+	}
+	size_t dict_size = ZDICT_trainFromBuffer(
+			dict, dict_capacity, writer->dict_samples.rpos,
+			(size_t *)writer->dict_sample_sizes.rpos,
+			sample_count);
+	if (ZDICT_isError(dict_size)) {
+		say_verbose("failed to train dictionary for run %lld: %s",
+			    (long long)run->id,
+			    ZDICT_getErrorName(dict_size));
+		free(dict);
+		goto write;
+	}
+	if (xlog_set_dict(&writer->data_xlog, dict, dict_size) != 0) {
+		free(dict);
+		return -1;
+	}
+	run->info.dict = dict;
+	run->info.dict_size = dict_size;
+write:
+	ibuf_reset(&writer->dict_samples);
+	ibuf_reset(&writer->dict_sample_sizes);
+	while (ibuf_used(&writer->dict_stmts) > 0) {
+		size_t region_svp = region_used(&fiber()->gc);
+		struct vy_entry *entry = (struct vy_entry *)
+					 writer->dict_stmts.rpos;
+		int rc = vy_run_writer_write_stmt(writer, *entry);
+		vy_stmt_unref_if_possible(entry->stmt);
+		writer->dict_stmts.rpos += sizeof(*entry);
+		region_truncate(&fiber()->gc, region_svp);
+		if (rc != 0)
+			return -1;
+	}
+	return 0;
+}
+
+/**
+ * Buffer a statement while sampling data for training a page
+ * compression dictionary. Once enough data has been sampled,
+ * train the dictionary and write out all buffered statements.
+ *
+ * @retval -1 Memory or IO error.
+ * @retval  0 Success.
+ */
+static int
+vy_run_writer_sample_stmt(struct vy_run_writer *writer, struct vy_entry entry)
+{
+	uint32_t size;
+	const char *data = tuple_data_range(entry.stmt, &size);
+	void *sample_buf = ibuf_alloc(&writer->dict_samples, size);
+	size_t *size_buf = ibuf_alloc(&writer->dict_sample_sizes,
+				      sizeof(*size_buf));
+	struct vy_entry *entry_buf = ibuf_alloc(&writer->dict_stmts,
+						sizeof(*entry_buf));
+	if (sample_buf == NULL || size_buf == NULL || entry_buf == NULL) {
+		/* Must not leave garbage in the statement buffer. */
+		if (entry_buf != NULL)
+			writer->dict_stmts.wpos -= sizeof(*entry_buf);
+		diag_set(OutOfMemory, size, "ibuf", "dictionary sample");
+		return -1;
+	}
+	memcpy(sample_buf, data, size);
+	*size_buf = size;
+	*entry_buf = entry;
+	vy_stmt_ref_if_possible(entry.stmt);
+	if (ibuf_used(&writer->dict_samples) >=
+	    (size_t)writer->dict_size * VY_RUN_DICT_SAMPLE_RATIO)
+		return vy_run_writer_train_dict(writer);
+	return 0;
+}
+
 int
 vy_run_writer_append_stmt(struct vy_run_writer *writer, struct vy_entry entry)
 {
 	int rc = -1;
 	size_t region_svp = region_used(&fiber()->gc);
+	struct tuple *stmt = entry.stmt;
 	if (!xlog_is_open(&writer->data_xlog) &&
 	    vy_run_writer_create_xlog(writer) != 0)
 		goto out;
-	if (ibuf_used(&writer->row_index_buf) == 0 &&
-	    vy_run_writer_start_page(writer, entry) != 0)
-		goto out;
-	if (vy_run_writer_write_to_page(writer, entry) != 0)
-		goto out;
-	if (obuf_size(&writer->data_xlog.obuf) >= writer->page_size &&
-	    vy_run_writer_end_page(writer) != 0)
+	if (vy_blob_writer_prepare(&writer->blob, entry.stmt,
+				   &entry.stmt) != 0)
 		goto out;
-	rc = 0;
+	if (writer->dict_size > 0)
+		rc = vy_run_writer_sample_stmt(writer, entry);
+	else
+		rc = vy_run_writer_write_stmt(writer, entry);
 out:
+	if (entry.stmt != stmt)
+		tuple_unref(entry.stmt);
 	region_truncate(&fiber()->gc, region_svp);
 	return rc;
 }
@@ -2315,7 +3197,20 @@ vy_run_writer_destroy(struct vy_run_writer *writer, bool reuse_fd)
 		xlog_close(&writer->data_xlog, reuse_fd);
 	if (writer->bloom != NULL)
 		tuple_bloom_builder_delete(writer->bloom);
+	vy_range_filter_builder_destroy(&writer->range_filter);
 	ibuf_destroy(&writer->row_index_buf);
+	while (ibuf_used(&writer->dict_stmts) > 0) {
+		struct vy_entry *entry = (struct vy_entry *)
+					 writer->dict_stmts.rpos;
+		vy_stmt_unref_if_possible(entry->stmt);
+		writer->dict_stmts.rpos += sizeof(*entry);
+	}
+	ibuf_destroy(&writer->dict_stmts);
+	ibuf_destroy(&writer->dict_samples);
+	ibuf_destroy(&writer->dict_sample_sizes);
+	/* On success the blob writer is destroyed by commit. */
+	if (!reuse_fd)
+		vy_blob_writer_abort(&writer->blob);
 }
 
 int
@@ -2324,6 +3219,10 @@ vy_run_writer_commit(struct vy_run_writer *writer)
 	int rc = -1;
 	size_t region_svp = region_used(&fiber()->gc);
 
+	if (writer->dict_size > 0 &&
+	    vy_run_writer_train_dict(writer) != 0)
+		goto out;
+
 	if (ibuf_used(&writer->row_index_buf) != 0 &&
 	    vy_run_writer_end_page(writer) != 0)
 		goto out;
@@ -2366,10 +3265,24 @@ vy_run_writer_commit(struct vy_run_writer *writer)
 		if (run->info.bloom == NULL)
 			goto out;
 	}
+	if (vy_range_filter_builder_is_ready(&writer->range_filter)) {
+		run->info.range_filter = vy_range_filter_new(
+				&writer->range_filter, VY_RUN_RANGE_FILTER_FPR);
+		if (run->info.range_filter == NULL)
+			goto out;
+	}
 	if (vy_run_write_index(run, writer->dirpath,
 			       writer->space_id, writer->iid) != 0)
 		goto out;
 
+	if (vy_run_create_ddict(run) != 0)
+		goto out;
+
+	assert(run->blobs == NULL);
+	if (vy_blob_writer_commit(&writer->blob, &run->blobs,
+				  &run->blob_count) != 0)
+		goto out;
+
 	run->fd = writer->data_xlog.fd;
 	vy_run_writer_destroy(writer, true);
 	rc = 0;
@@ -2413,6 +3326,9 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 	struct tuple *prev_tuple = NULL;
 	char *page_min_key = NULL;
 
+	struct vy_range_filter_builder range_filter_builder;
+	vy_range_filter_builder_create(&range_filter_builder);
+
 	struct tuple_bloom_builder *bloom_builder = NULL;
 	if (opts->bloom_fpr < 1) {
 		bloom_builder = tuple_bloom_builder_new(key_def->part_count);
@@ -2452,6 +3368,15 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 					goto close_err;
 				}
 			}
+			if (opts->range_filter) {
+				struct vy_entry entry = {tuple, HINT_NONE};
+				if (vy_range_filter_builder_add_entry(
+						&range_filter_builder,
+						entry, key_def) != 0) {
+					tuple_unref(tuple);
+					goto close_err;
+				}
+			}
 			key = vy_stmt_is_key(tuple) ? tuple_data(tuple) :
 			      tuple_extract_key(tuple, cmp_def,
 						MULTIKEY_NONE, NULL);
@@ -2516,6 +3441,13 @@ vy_run_rebuild_index(struct vy_run *run, const char *dir,
 		tuple_bloom_builder_delete(bloom_builder);
 		bloom_builder = NULL;
 	}
+	if (vy_range_filter_builder_is_ready(&range_filter_builder)) {
+		run->info.range_filter = vy_range_filter_new(
+				&range_filter_builder, VY_RUN_RANGE_FILTER_FPR);
+		if (run->info.range_filter == NULL)
+			goto close_err;
+	}
+	vy_range_filter_builder_destroy(&range_filter_builder);
 
 	/* New run index is ready for write, unlink old file if exists */
 	vy_run_snprint_path(path, sizeof(path), dir,
@@ -2537,6 +3469,7 @@ close_err:
 		free(page_min_key);
 	if (bloom_builder != NULL)
 		tuple_bloom_builder_delete(bloom_builder);
+	vy_range_filter_builder_destroy(&range_filter_builder);
 	if (xlog_cursor_is_open(&cursor))
 		xlog_cursor_close(&cursor, false);
 	return -1;
@@ -2552,6 +3485,13 @@ vy_run_remove_files(const char *dir, uint32_t space_id,
 	int ret = 0;
 	char path[PATH_MAX];
 	for (int type = 0; type < vy_file_MAX; type++) {
+		/*
+		 * A blob file may be referenced by other runs.
+		 * It is deleted by garbage collection when it
+		 * isn't needed anymore.
+		 */
+		if (type == VY_FILE_BLOB)
+			continue;
 		vy_run_snprint_path(path, sizeof(path), dir,
 				    space_id, iid, run_id, type);
 		if (coio_unlink(path) < 0) {
@@ -2565,6 +3505,23 @@ vy_run_remove_files(const char *dir, uint32_t space_id,
 	return ret;
 }
 
+int
+vy_run_remove_blob_file(const char *dir, uint32_t space_id,
+			uint32_t iid, int64_t blob_id)
+{
+	char path[PATH_MAX];
+	vy_run_snprint_path(path, sizeof(path), dir, space_id, iid,
+			    blob_id, VY_FILE_BLOB);
+	if (coio_unlink(path) < 0) {
+		if (errno == ENOENT)
+			return 0;
+		say_syserror("error while removing %s", path);
+		return -1;
+	}
+	say_info("removed %s", path);
+	return 0;
+}
+
 /**
  * Read a page with stream->page_no from the run and save it in stream->page.
  * Support function of slice stream.
@@ -40,6 +40,8 @@
 #include "vy_stmt_stream.h"
 #include "vy_read_view.h"
 #include "vy_stat.h"
+#include "vy_blob.h"
+#include "vy_range_filter.h"
 #include "index_def.h"
 #include "xlog.h"
 
@@ -51,6 +53,59 @@ extern "C" {
 
 struct vy_history;
 struct vy_run_reader;
+struct mh_vy_page_t;
+
+/** Page cache statistics. */
+struct vy_page_cache_stat {
+	/** Number of lookups in the cache. */
+	int64_t lookup;
+	/** Number of lookups that found the page in the cache. */
+	int64_t hit;
+	/** Number of pages added to the cache. */
+	int64_t put;
+	/** Number of pages evicted from the cache. */
+	int64_t evict;
+};
+
+/**
+ * Cache of decompressed run pages shared by all run iterators.
+ * Pages are looked up by run id and page number.
+ *
+ * To avoid flushing hot pages on a range scan, the cache uses
+ * a segmented LRU policy: a page read from disk is added to the
+ * probationary segment and is moved to the protected segment
+ * only if it is looked up again. Pages are evicted from the tail
+ * of the probationary segment first, while pages overflowing the
+ * protected segment are demoted back to the probationary one.
+ *
+ * The cache is only accessed from the tx thread.
+ */
+struct vy_page_cache {
+	/** Cached pages, hashed by run id and page number. */
+	struct mh_vy_page_t *hash;
+	/** Probationary segment, most recently used pages first. */
+	struct rlist probation;
+	/** Protected segment, most recently used pages first. */
+	struct rlist protected;
+	/** Max size of memory that may be used by cached pages. */
+	size_t quota;
+	/** Size of memory used by cached pages. */
+	size_t mem_used;
+	/** Size of memory used by pages in the protected segment. */
+	size_t protected_mem_used;
+	/** Cache statistics. */
+	struct vy_page_cache_stat stat;
+};
+
+/** Run iterator readahead statistics. */
+struct vy_run_readahead_stat {
+	/** Number of pages requested by readahead. */
+	int64_t pages;
+	/** Number of pages read ahead and then used by an iterator. */
+	int64_t useful;
+	/** Number of pages read ahead and thrown away. */
+	int64_t wasted;
+};
 
 /** Part of vinyl environment for run read/write */
 struct vy_run_env {
@@ -58,6 +113,8 @@ struct vy_run_env {
 	uint64_t snap_io_rate_limit;
 	/** Mempool for struct vy_page_read_task */
 	struct mempool read_task_pool;
+	/** Mempool for struct vy_page_prefetch_task */
+	struct mempool prefetch_task_pool;
 	/** Key for thread-local ZSTD context */
 	pthread_key_t zdctx_key;
 	/** Pool of threads used for reading run files. */
@@ -69,6 +126,21 @@ struct vy_run_env {
 	 * processing the next read request.
 	 */
 	int next_reader;
+	/** Cache of pages read by run iterators. */
+	struct vy_page_cache page_cache;
+	/**
+	 * Size of memory used by pages read ahead by run
+	 * iterators, including pages that are still being read.
+	 */
+	size_t readahead_mem_used;
+	/** Readahead statistics. */
+	struct vy_run_readahead_stat readahead_stat;
+	/**
+	 * Time spent by reader threads on reading pages for run
+	 * iterators. Used by the load regulator as feedback on
+	 * foreground read latency.
+	 */
+	struct latency read_latency;
 };
 
 /**
@@ -89,6 +161,23 @@ struct vy_run_info {
 	struct tuple_bloom *bloom;
 	/** Statement statistics. */
 	struct vy_stmt_stat stmt_stat;
+	/**
+	 * Zstd dictionary that was used for compressing pages
+	 * of the run or NULL. Allocated with malloc().
+	 *
+	 * Note, the dictionary is stored only in the index file
+	 * so a run compressed with a dictionary can't be read
+	 * without it.
+	 */
+	char *dict;
+	/** Size of @dict. */
+	uint32_t dict_size;
+	/**
+	 * Range filter of the first key part of all statements
+	 * stored in the run or NULL if the index was created
+	 * without the range_filter option.
+	 */
+	struct vy_range_filter *range_filter;
 };
 
 /**
@@ -168,6 +257,22 @@ struct vy_run {
 	struct rlist in_unused;
 	/** Link in vy_lsm::runs list. */
 	struct rlist in_lsm;
+	/** List of pages of this run stored in the page cache. */
+	struct rlist cached_pages;
+	/**
+	 * Blob files referenced by statements of this run,
+	 * see vy_blob.h. Allocated with malloc().
+	 */
+	struct vy_run_blob *blobs;
+	/** Number of entries in @blobs. */
+	uint32_t blob_count;
+	/**
+	 * Digested dictionary for decompressing pages, created
+	 * from vy_run_info::dict once the run is loaded. Shared by
+	 * all reader threads so that they don't need to process
+	 * the dictionary on each page read.
+	 */
+	ZSTD_DDict *ddict;
 };
 
 /**
@@ -279,6 +384,23 @@ struct vy_run_iterator {
 	 */
 	struct vy_page *curr_page;
 	struct vy_page *prev_page;
+	/**
+	 * Pages requested from reader threads in advance, in
+	 * the order of iteration, linked by
+	 * vy_page_prefetch_task::in_itr.
+	 */
+	struct rlist readahead;
+	/** Number of pages in the readahead list. */
+	uint32_t readahead_count;
+	/** Page the iterator switched to last time. */
+	uint32_t seq_page_no;
+	/**
+	 * Number of times in a row the iterator switched to
+	 * the page following seq_page_no in the direction of
+	 * iteration. Readahead starts when it exceeds a
+	 * threshold and grows with it.
+	 */
+	uint32_t seq_count;
 	/** Is false until first .._get or .._next_.. method is called */
 	bool search_started;
 };
@@ -287,6 +409,10 @@ struct vy_run_iterator {
  * Vinyl page stored in memory.
  */
 struct vy_page {
+	/** Reference counter. */
+	int refs;
+	/** ID of the run the page belongs to. */
+	int64_t run_id;
 	/** Page position in the run file. */
 	uint32_t page_no;
 	/** Size of page data in memory, i.e. unpacked. */
@@ -297,6 +423,14 @@ struct vy_page {
 	uint32_t *row_index;
 	/** Pointer to the page data. */
 	char *data;
+	/** Set if the page is stored in the page cache. */
+	bool in_cache;
+	/** Set if the page is in the protected cache segment. */
+	bool is_protected;
+	/** Link in a vy_page_cache segment list. */
+	struct rlist in_lru;
+	/** Link in vy_run::cached_pages list. */
+	struct rlist in_run;
 };
 
 /**
@@ -331,7 +465,15 @@ void
 vy_run_env_enable_coio(struct vy_run_env *env);
 
 /**
- * Return the size of a run bloom filter.
+ * Set the max size of memory that may be used by the page cache,
+ * evicting pages if necessary. Zero disables the cache.
+ */
+void
+vy_run_env_set_page_cache_quota(struct vy_run_env *env, size_t quota);
+
+/**
+ * Return the size of a run bloom filter, including
+ * the range filter if the run has one.
  */
 size_t
 vy_run_bloom_size(struct vy_run *run);
@@ -407,6 +549,7 @@ enum vy_file_type {
 	VY_FILE_INDEX_INPROGRESS,
 	VY_FILE_RUN,
 	VY_FILE_RUN_INPROGRESS,
+	VY_FILE_BLOB,
 	vy_file_MAX,
 };
 
@@ -450,6 +593,14 @@ int
 vy_run_remove_files(const char *dir, uint32_t space_id,
 		    uint32_t iid, int64_t run_id);
 
+/**
+ * Remove the blob file with the given id. Return 0 on success
+ * or if the file doesn't exist, -1 if unlink() failed.
+ */
+int
+vy_run_remove_blob_file(const char *dir, uint32_t space_id,
+			uint32_t iid, int64_t blob_id);
+
 /**
  * Allocate a new run slice.
  * This function increments @run->refs.
@@ -542,6 +693,20 @@ NODISCARD int
 vy_run_iterator_skip(struct vy_run_iterator *itr, struct vy_entry last,
 		     struct vy_history *history);
 
+/**
+ * Check if the run may store keys lying between @a last (or
+ * the search key if @a last is NULL) and @a next (or the end
+ * of the run if @a next is NULL), both inclusive, in the
+ * direction of iteration. Returns false if the run range
+ * filter says it doesn't, in which case there's no need to
+ * advance the iterator. Returns true if the run doesn't have
+ * a range filter or the iterator can be advanced past @a last
+ * without reading the disk.
+ */
+bool
+vy_run_iterator_check_range(struct vy_run_iterator *itr,
+			    struct vy_entry last, struct vy_entry next);
+
 /**
  * Close a run iterator.
  */
@@ -627,6 +792,32 @@ struct vy_run_writer {
 	 * of max key of a finished run.
 	 */
 	struct vy_entry last;
+	/** Writer of the blob file of the run. */
+	struct vy_blob_writer blob;
+	/**
+	 * Max size of a zstd dictionary to train for compressing
+	 * pages of the run. While it is greater than 0, statements
+	 * are buffered instead of being written to the run file.
+	 * Once there are enough of them to train the dictionary,
+	 * it is trained, this member is reset, and the buffered
+	 * statements are written out.
+	 */
+	uint32_t dict_size;
+	/** Statements buffered while sampling for a dictionary. */
+	struct ibuf dict_stmts;
+	/** Samples for dictionary training, one per statement. */
+	struct ibuf dict_samples;
+	/** Sizes of samples stored in @dict_samples (size_t). */
+	struct ibuf dict_sample_sizes;
+	/** Set if the writer must build a range filter. */
+	bool has_range_filter;
+	/** Range filter builder, see @has_range_filter. */
+	struct vy_range_filter_builder range_filter;
+	/**
+	 * Set if the run belongs to a covering secondary index
+	 * and hence must store full tuples, not extended keys.
+	 */
+	bool is_covering;
 };
 
 /** Create a run writer to fill a run with statements. */
@@ -647,6 +838,62 @@ vy_run_writer_create(struct vy_run_writer *writer, struct vy_run *run,
 int
 vy_run_writer_append_stmt(struct vy_run_writer *writer, struct vy_entry entry);
 
+/**
+ * Enable key-value separation for a run writer: move values
+ * of statements that are at least @a threshold bytes long to
+ * the blob file of the run. @a map stores blob files referenced
+ * by statements passed to the writer, may be NULL.
+ */
+static inline void
+vy_run_writer_set_blobs(struct vy_run_writer *writer, uint32_t threshold,
+			uint32_t index_field_count, struct vy_blob_map *map)
+{
+	writer->blob.threshold = threshold;
+	writer->blob.index_field_count = index_field_count;
+	writer->blob.map = map;
+}
+
+/**
+ * Max size of a page compression dictionary. The writer keeps
+ * about a hundred times as much data in memory while sampling
+ * for a dictionary so it must be reasonably small.
+ */
+enum { VY_RUN_DICT_SIZE_MAX = 1024 * 1024 };
+
+/**
+ * Compress pages of the run with a zstd dictionary that is at
+ * most @a dict_size bytes long. The dictionary is trained on
+ * the first statements passed to the writer, see
+ * VY_RUN_DICT_SAMPLE_RATIO. 0 disables dictionary compression.
+ * Ignored if the writer was created with compression disabled.
+ */
+static inline void
+vy_run_writer_set_dict(struct vy_run_writer *writer, uint32_t dict_size)
+{
+	if (!writer->no_compression)
+		writer->dict_size = dict_size;
+}
+
+/**
+ * Build a range filter for the run, see vy_range_filter.h.
+ */
+static inline void
+vy_run_writer_set_range_filter(struct vy_run_writer *writer,
+			       bool range_filter)
+{
+	writer->has_range_filter = range_filter;
+}
+
+/**
+ * Store full tuples rather than extended keys in a secondary
+ * index run, see index_opts::covering.
+ */
+static inline void
+vy_run_writer_set_covering(struct vy_run_writer *writer, bool is_covering)
+{
+	writer->is_covering = is_covering;
+}
+
 /**
  * Finalize run writing by writing run index into file. The writer
  * is deleted after call.
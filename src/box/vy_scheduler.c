@@ -37,6 +37,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <small/rlist.h>
+#include <pmatomic.h>
 #include <tarantool_ev.h>
 
 #include "diag.h"
@@ -56,6 +57,7 @@
 #include "vy_mem.h"
 #include "vy_range.h"
 #include "vy_run.h"
+#include "vy_tombstone.h"
 #include "vy_write_iterator.h"
 #include "trivia/util.h"
 
@@ -79,6 +81,7 @@ static const struct cmsg_hop vy_task_complete_route[] = {
 };
 
 struct vy_task;
+struct vy_compaction_group;
 
 /** Vinyl worker thread. */
 struct vy_worker {
@@ -204,6 +207,14 @@ struct vy_task {
 	 */
 	double bloom_fpr;
 	int64_t page_size;
+	uint32_t blob_threshold;
+	uint32_t compression_dict_size;
+	bool range_filter;
+	/**
+	 * Blob files referenced by the compacted runs,
+	 * see vy_blob.h.
+	 */
+	struct vy_blob_map blob_map;
 	/**
 	 * Deferred DELETE handler passed to the write iterator.
 	 * It sends deferred DELETE statements generated during
@@ -212,15 +223,99 @@ struct vy_task {
 	struct vy_deferred_delete_handler deferred_delete_handler;
 	/** Batch of deferred deletes generated by this task. */
 	struct vy_deferred_delete_batch *deferred_delete_batch;
+	/**
+	 * Copies of range tombstones applied by primary index
+	 * compaction, see vy_task_set_tombstones().
+	 */
+	struct vy_tombstone *tombstones;
+	/** Number of entries in @tombstones. */
+	int tombstone_count;
+	/**
+	 * If this is major compaction of a primary index, the
+	 * LSN up to which range tombstones are applied to the
+	 * compacted range, otherwise 0. See vy_range::purged_lsn.
+	 */
+	int64_t purge_lsn;
 	/**
 	 * Number of batches of deferred DELETEs sent to tx
 	 * and not yet processed.
 	 */
 	int deferred_delete_in_progress;
+	/**
+	 * If the range is compacted by several tasks running in
+	 * parallel, this points to the state they share.
+	 */
+	struct vy_compaction_group *group;
+	/**
+	 * Slices of the compacted runs cut by the boundaries of
+	 * the part of the range this task compacts, linked by
+	 * vy_slice::in_range. Only used if the task belongs to
+	 * a compaction group.
+	 */
+	struct rlist part_slices;
 	/** Link in vy_scheduler::processed_tasks. */
 	struct stailq_entry in_processed;
 };
 
+/** Max number of parts a range can be compacted in. */
+enum { VY_SUBCOMPACTION_MAX = 8 };
+
+/**
+ * Min size of compaction input per part for a range to be
+ * compacted in parallel. The effective value is never less
+ * than the target range size.
+ */
+enum { VY_SUBCOMPACTION_PART_SIZE_MIN = 64 * 1024 * 1024 };
+
+/**
+ * Compaction of a big range may take long, while other worker
+ * threads are idle. To speed it up, we split the key space of
+ * such a range by the min keys of pages of the biggest run and
+ * compact each part with a separate task (subcompaction). All
+ * the tasks are executed in parallel and write their own runs.
+ * When all of them are done, the range is replaced with new
+ * ranges, one per each part, in one metadata log transaction.
+ */
+struct vy_compaction_group {
+	/** Number of tasks referencing this object. */
+	int refs;
+	/** Number of parts the range is compacted in. */
+	int part_count;
+	/** Number of tasks that haven't been completed yet. */
+	int in_progress;
+	/** Set if any of the tasks failed. */
+	bool is_failed;
+	/** Time when the compaction was started. */
+	double start_time;
+	/** Pointer to the scheduler. */
+	struct vy_scheduler *scheduler;
+	/** LSM tree the range belongs to. */
+	struct vy_lsm *lsm;
+	/** Range to compact. */
+	struct vy_range *range;
+	/** First (newest) and last (oldest) slices to compact. */
+	struct vy_slice *first_slice, *last_slice;
+	/** Part boundaries: part i spans [keys[i], keys[i + 1]). */
+	struct vy_entry keys[VY_SUBCOMPACTION_MAX + 1];
+	/** Tasks compacting the parts, in key order. */
+	struct vy_task *tasks[VY_SUBCOMPACTION_MAX];
+	/** Runs written by the tasks, in key order. */
+	struct vy_run *new_runs[VY_SUBCOMPACTION_MAX];
+};
+
+static void
+vy_compaction_group_unref(struct vy_compaction_group *group)
+{
+	assert(group->refs > 0);
+	if (--group->refs > 0)
+		return;
+	for (int i = 0; i < (int)lengthof(group->keys); i++) {
+		if (group->keys[i].stmt != NULL)
+			tuple_unref(group->keys[i].stmt);
+	}
+	free(group);
+}
+
 static const struct vy_deferred_delete_handler_iface
 vy_task_deferred_delete_iface;
 
@@ -261,6 +356,9 @@ vy_task_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	vy_lsm_ref(lsm);
 	diag_create(&task->diag);
 	task->deferred_delete_handler.iface = &vy_task_deferred_delete_iface;
+	rlist_create(&task->part_slices);
+	vy_blob_map_create(&task->blob_map,
+			   lsm->mem_format->index_field_count);
 	return task;
 }
 
@@ -270,8 +368,20 @@ vy_task_delete(struct vy_task *task)
 {
 	assert(task->deferred_delete_batch == NULL);
 	assert(task->deferred_delete_in_progress == 0);
+	assert(rlist_empty(&task->part_slices));
+	if (task->group != NULL)
+		vy_compaction_group_unref(task->group);
+	for (int i = 0; i < task->tombstone_count; i++) {
+		struct vy_tombstone *tombstone = &task->tombstones[i];
+		if (tombstone->begin.stmt != NULL)
+			tuple_unref(tombstone->begin.stmt);
+		if (tombstone->end.stmt != NULL)
+			tuple_unref(tombstone->end.stmt);
+	}
+	free(task->tombstones);
 	key_def_delete(task->cmp_def);
 	key_def_delete(task->key_def);
+	vy_blob_map_destroy(&task->blob_map);
 	vy_lsm_unref(task->lsm);
 	diag_destroy(&task->diag);
 	free(task);
@@ -814,6 +924,43 @@ vy_run_discard(struct vy_run *run)
 	vy_log_tx_try_commit();
 }
 
+/**
+ * Open blob files referenced by a run written by a task and
+ * encode their list for the metadata log. The list is set to
+ * NULL if the run doesn't reference any blob files.
+ */
+static int
+vy_run_prepare_blobs(struct vy_lsm *lsm, struct vy_run *run,
+		     const char **blobs)
+{
+	*blobs = NULL;
+	if (run->blob_count == 0)
+		return 0;
+	if (vy_lsm_attach_blobs(lsm, run) != 0)
+		return -1;
+	*blobs = vy_run_blob_encode(run->blobs, run->blob_count);
+	return *blobs != NULL ? 0 : -1;
+}
+
+/**
+ * Add blob files referenced by a compacted run to the blob map
+ * of a compaction task. A blob file is marked as garbage if most
+ * of it isn't referenced by the LSM tree anymore so that the
+ * task rewrites values stored in it.
+ */
+static int
+vy_task_add_run_blobs(struct vy_task *task, struct vy_run *run)
+{
+	for (uint32_t i = 0; i < run->blob_count; i++) {
+		struct vy_blob *blob = run->blobs[i].blob;
+		bool is_garbage = blob->live_bytes <
+				  blob->size * VY_BLOB_GARBAGE_RATIO;
+		if (vy_blob_map_add(&task->blob_map, blob, is_garbage) != 0)
+			return -1;
+	}
+	return 0;
+}
+
 /**
  * Encode and write a single deferred DELETE statement to
  * _vinyl_deferred_delete system space. The rest will be
@@ -897,6 +1044,15 @@ vy_deferred_delete_batch_process_f(struct cmsg *cmsg)
 	 */
 	if (pk->is_dropped)
 		return;
+	/*
+	 * Deferred DELETEs are only needed by secondary indexes,
+	 * see vy_deferred_delete_on_replace(). Don't write them
+	 * to WAL if there's none, as it is the case for tuples
+	 * expired by ttl in a space with the only index.
+	 */
+	struct space *space = space_by_id(pk->space_id);
+	if (space != NULL && space->index_count <= 1)
+		return;
 
 	struct space *deferred_delete_space;
 	deferred_delete_space = space_by_id(BOX_VINYL_DEFERRED_DELETE_ID);
@@ -1049,8 +1205,37 @@ vy_task_deferred_delete_iface = {
 	.destroy = vy_task_deferred_delete_destroy,
 };
 
+/**
+ * Sleep if a compaction task has written more than allowed by
+ * vy_scheduler::compaction_rate_limit since @window_start, then
+ * start a new accounting window. Called every few statements so
+ * that the output rate stays smooth. Yields even if no delay is
+ * needed, like a task that isn't throttled.
+ *
+ * Note, the loop time isn't updated until the fiber yields so
+ * we have to use the real time here.
+ */
+static void
+vy_task_throttle(struct vy_task *task, size_t *window_bytes,
+		 double *window_start)
+{
+	size_t limit = pm_atomic_load(&task->scheduler->compaction_rate_limit);
+	double now = ev_monotonic_time();
+	double delay = 0;
+	if (limit > 0)
+		delay = (double)*window_bytes / limit - (now - *window_start);
+	if (delay > 0) {
+		fiber_sleep(delay);
+		now = ev_monotonic_time();
+	} else {
+		fiber_sleep(0);
+	}
+	*window_bytes = 0;
+	*window_start = now;
+}
+
 static int
-vy_task_write_run(struct vy_task *task, bool no_compression)
+vy_task_write_run(struct vy_task *task, bool no_compression, bool throttle)
 {
 	enum { YIELD_LOOPS = 32 };
 
@@ -1069,11 +1254,20 @@ vy_task_write_run(struct vy_task *task, bool no_compression)
 				 task->page_size, task->bloom_fpr,
 				 no_compression) != 0)
 		goto fail;
+	vy_run_writer_set_blobs(&writer, task->blob_threshold,
+				task->blob_map.index_field_count,
+				task->blob_map.count > 0 ?
+				&task->blob_map : NULL);
+	vy_run_writer_set_dict(&writer, task->compression_dict_size);
+	vy_run_writer_set_range_filter(&writer, task->range_filter);
+	vy_run_writer_set_covering(&writer, lsm->opts.covering);
 
 	if (wi->iface->start(wi) != 0)
 		goto fail_abort_writer;
 	int rc;
 	int loops = 0;
+	size_t window_bytes = 0;
+	double window_start = ev_monotonic_time();
 	struct vy_entry entry = vy_entry_none();
 	while ((rc = wi->iface->next(wi, &entry)) == 0 && entry.stmt != NULL) {
 		struct errinj *inj = errinj(ERRINJ_VY_RUN_WRITE_STMT_TIMEOUT,
@@ -1085,8 +1279,14 @@ vy_task_write_run(struct vy_task *task, bool no_compression)
 		if (rc != 0)
 			break;
 
-		if (++loops % YIELD_LOOPS == 0)
-			fiber_sleep(0);
+		window_bytes += entry.stmt->bsize;
+		if (++loops % YIELD_LOOPS == 0) {
+			if (throttle)
+				vy_task_throttle(task, &window_bytes,
+						 &window_start);
+			else
+				fiber_sleep(0);
+		}
 		if (fiber_is_cancelled()) {
 			diag_set(FiberIsCancelled);
 			rc = -1;
@@ -1117,7 +1317,7 @@ vy_task_dump_execute(struct vy_task *task)
 	 * and smallest runs at the same time and so we would gain
 	 * nothing by compressing them.
 	 */
-	return vy_task_write_run(task, true);
+	return vy_task_write_run(task, true, false);
 }
 
 static int
@@ -1182,11 +1382,16 @@ vy_task_dump_complete(struct vy_task *task)
 		new_slices[i] = slice;
 	}
 
+	const char *blobs;
+	if (vy_run_prepare_blobs(lsm, new_run, &blobs) != 0)
+		goto fail_free_slices;
+
 	/*
 	 * Log change in metadata.
 	 */
 	vy_log_tx_begin();
-	vy_log_create_run(lsm->id, new_run->id, dump_lsn, new_run->dump_count);
+	vy_log_create_run(lsm->id, new_run->id, dump_lsn, new_run->dump_count,
+			  blobs);
 	for (range = begin_range, i = 0; range != end_range;
 	     range = vy_range_tree_next(&lsm->range_tree, range), i++) {
 		assert(i < lsm->range_count);
@@ -1251,6 +1456,8 @@ delete_mems:
 	/* The iterator has been cleaned up in a worker thread. */
 	task->wi->iface->close(task->wi);
 
+	if (lsm->index_id == 0)
+		vy_lsm_purge_tombstones(lsm);
 	lsm->is_dumping = false;
 	vy_scheduler_update_lsm(scheduler, lsm);
 
@@ -1397,6 +1604,10 @@ vy_task_dump_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 	task->wi = wi;
 	task->bloom_fpr = lsm->opts.bloom_fpr;
 	task->page_size = lsm->opts.page_size;
+	task->compression_dict_size = lsm->opts.compression_dict_size;
+	task->range_filter = lsm->opts.range_filter;
+	task->blob_threshold = lsm->index_id == 0 ?
+			       lsm->opts.blob_threshold : 0;
 
 	lsm->is_dumping = true;
 	vy_scheduler_update_lsm(scheduler, lsm);
@@ -1435,7 +1646,7 @@ static int
 vy_task_compaction_execute(struct vy_task *task)
 {
 	ERROR_INJECT_SLEEP(ERRINJ_VY_COMPACTION_DELAY);
-	return vy_task_write_run(task, false);
+	return vy_task_write_run(task, false, true);
 }
 
 static int
@@ -1487,6 +1698,13 @@ vy_task_compaction_complete(struct vy_task *task)
 			break;
 	}
 
+	const char *blobs = NULL;
+	if (new_slice != NULL &&
+	    vy_run_prepare_blobs(lsm, new_run, &blobs) != 0) {
+		vy_slice_delete(new_slice);
+		return -1;
+	}
+
 	/*
 	 * Log change in metadata.
 	 */
@@ -1500,7 +1718,7 @@ vy_task_compaction_complete(struct vy_task *task)
 		vy_log_drop_run(run->id, VY_LOG_GC_LSN_CURRENT);
 	if (new_slice != NULL) {
 		vy_log_create_run(lsm->id, new_run->id, new_run->dump_lsn,
-				  new_run->dump_count);
+				  new_run->dump_count, blobs);
 		vy_log_insert_slice(range->id, new_run->id, new_slice->id,
 				    tuple_data_or_null(new_slice->begin.stmt),
 				    tuple_data_or_null(new_slice->end.stmt));
@@ -1561,6 +1779,7 @@ vy_task_compaction_complete(struct vy_task *task)
 			break;
 	}
 	range->n_compactions++;
+	range->purged_lsn = MAX(range->purged_lsn, task->purge_lsn);
 	vy_range_update_compaction_priority(range, &lsm->opts);
 	vy_range_update_dumps_per_compaction(range);
 	vy_lsm_acct_range(lsm, range);
@@ -1586,6 +1805,7 @@ vy_task_compaction_complete(struct vy_task *task)
 
 	assert(heap_node_is_stray(&range->heap_node));
 	vy_range_heap_insert(&lsm->range_heap, range);
+	vy_lsm_purge_tombstones(lsm);
 	vy_scheduler_update_lsm(scheduler, lsm);
 
 	say_info("%s: completed compacting range %s",
@@ -1615,6 +1835,604 @@ vy_task_compaction_abort(struct vy_task *task)
 	vy_scheduler_update_lsm(scheduler, lsm);
 }
 
+/**
+ * Close the write iterator of a subcompaction task and free
+ * the slices it was reading.
+ */
+static void
+vy_task_subcompaction_cleanup(struct vy_task *task)
+{
+	/* The iterator has been cleaned up in worker. */
+	if (task->wi != NULL)
+		task->wi->iface->close(task->wi);
+
+	struct vy_slice *slice, *next_slice;
+	rlist_foreach_entry_safe(slice, &task->part_slices,
+				 in_range, next_slice)
+		vy_slice_delete(slice);
+	rlist_create(&task->part_slices);
+}
+
+/**
+ * Called when all tasks of a compaction group are done, but
+ * at least one of them failed. Discards all the new runs.
+ */
+static void
+vy_compaction_group_abort(struct vy_compaction_group *group)
+{
+	struct vy_lsm *lsm = group->lsm;
+	struct vy_range *range = group->range;
+
+	for (int i = 0; i < group->part_count; i++)
+		vy_run_discard(group->new_runs[i]);
+
+	assert(heap_node_is_stray(&range->heap_node));
+	vy_range_heap_insert(&lsm->range_heap, range);
+	vy_scheduler_update_lsm(group->scheduler, lsm);
+}
+
+/**
+ * Called when all tasks of a compaction group have succeeded.
+ * Replaces the compacted range with new ranges, one per each
+ * part. Slices of runs that weren't compacted are cut by part
+ * boundaries, while the compacted slices are replaced with
+ * a slice of the run written for the part.
+ */
+static int
+vy_compaction_group_complete(struct vy_compaction_group *group)
+{
+	struct vy_scheduler *scheduler = group->scheduler;
+	struct vy_lsm *lsm = group->lsm;
+	struct vy_range *range = group->range;
+	struct vy_slice *first_slice = group->first_slice;
+	struct vy_slice *last_slice = group->last_slice;
+	double compaction_time = ev_monotonic_now(loop()) - group->start_time;
+	struct vy_disk_stmt_counter compaction_input;
+	struct vy_disk_stmt_counter compaction_output;
+	struct vy_range *parts[VY_SUBCOMPACTION_MAX] = { NULL };
+	int n_parts = group->part_count;
+	struct vy_slice *slice, *new_slice;
+	struct vy_run *run;
+
+	/*
+	 * Allocate new ranges and fill them with slices.
+	 */
+	for (int i = 0; i < n_parts; i++) {
+		struct vy_range *part = vy_range_new(vy_log_next_id(),
+						     group->keys[i],
+						     group->keys[i + 1],
+						     lsm->cmp_def);
+		if (part == NULL)
+			goto fail;
+		parts[i] = part;
+		/*
+		 * vy_range_add_slice() adds a slice to the list head,
+		 * so to preserve the order of the slices list, we have
+		 * to iterate backward.
+		 */
+		bool is_compacted = false;
+		rlist_foreach_entry_reverse(slice, &range->slices, in_range) {
+			if (slice == last_slice)
+				is_compacted = true;
+			if (is_compacted) {
+				if (slice != first_slice)
+					continue;
+				is_compacted = false;
+				run = group->new_runs[i];
+				if (vy_run_is_empty(run))
+					continue;
+				new_slice = vy_slice_new(vy_log_next_id(), run,
+							 vy_entry_none(),
+							 vy_entry_none(),
+							 lsm->cmp_def);
+				if (new_slice == NULL)
+					goto fail;
+				vy_range_add_slice(part, new_slice);
+				continue;
+			}
+			if (vy_slice_cut(slice, vy_log_next_id(), part->begin,
+					 part->end, lsm->cmp_def,
+					 &new_slice) != 0)
+				goto fail;
+			if (new_slice != NULL)
+				vy_range_add_slice(part, new_slice);
+		}
+		part->n_compactions = range->n_compactions + 1;
+		part->purged_lsn = MAX(range->purged_lsn,
+				       group->tasks[i]->purge_lsn);
+		vy_range_update_compaction_priority(part, &lsm->opts);
+		vy_range_update_dumps_per_compaction(part);
+	}
+
+	/*
+	 * Build the list of runs that became unused
+	 * as a result of compaction.
+	 */
+	RLIST_HEAD(unused_runs);
+	for (slice = first_slice; ; slice = rlist_next_entry(slice, in_range)) {
+		slice->run->compacted_slice_count++;
+		if (slice == last_slice)
+			break;
+	}
+	vy_disk_stmt_counter_reset(&compaction_input);
+	for (slice = first_slice; ; slice = rlist_next_entry(slice, in_range)) {
+		run = slice->run;
+		if (run->compacted_slice_count == run->slice_count)
+			rlist_add_entry(&unused_runs, run, in_unused);
+		slice->run->compacted_slice_count = 0;
+		vy_disk_stmt_counter_add(&compaction_input, &slice->count);
+		if (slice == last_slice)
+			break;
+	}
+	vy_disk_stmt_counter_reset(&compaction_output);
+	for (int i = 0; i < n_parts; i++) {
+		vy_disk_stmt_counter_add(&compaction_output,
+					 &group->new_runs[i]->count);
+	}
+	const char *blobs[VY_SUBCOMPACTION_MAX] = { NULL };
+	for (int i = 0; i < n_parts; i++) {
+		run = group->new_runs[i];
+		if (!vy_run_is_empty(run) &&
+		    vy_run_prepare_blobs(lsm, run, &blobs[i]) != 0)
+			goto fail;
+	}
+
+	/*
+	 * Log change in metadata.
+	 */
+	vy_log_tx_begin();
+	rlist_foreach_entry(slice, &range->slices, in_range)
+		vy_log_delete_slice(slice->id);
+	vy_log_delete_range(range->id);
+	rlist_foreach_entry(run, &unused_runs, in_unused)
+		vy_log_drop_run(run->id, VY_LOG_GC_LSN_CURRENT);
+	for (int i = 0; i < n_parts; i++) {
+		run = group->new_runs[i];
+		if (!vy_run_is_empty(run))
+			vy_log_create_run(lsm->id, run->id, run->dump_lsn,
+					  run->dump_count, blobs[i]);
+	}
+	for (int i = 0; i < n_parts; i++) {
+		struct vy_range *part = parts[i];
+		vy_log_insert_range(lsm->id, part->id,
+				    tuple_data_or_null(part->begin.stmt),
+				    tuple_data_or_null(part->end.stmt));
+		rlist_foreach_entry(slice, &part->slices, in_range)
+			vy_log_insert_slice(part->id, slice->run->id, slice->id,
+					    tuple_data_or_null(slice->begin.stmt),
+					    tuple_data_or_null(slice->end.stmt));
+	}
+	if (vy_log_tx_commit() < 0)
+		goto fail;
+
+	/*
+	 * Remove compacted run files that were created after
+	 * the last checkpoint immediately to save disk space,
+	 * see vy_task_compaction_complete().
+	 */
+	rlist_foreach_entry(run, &unused_runs, in_unused) {
+		if (run->dump_lsn > vy_log_signature())
+			vy_run_remove_files(lsm->env->path, lsm->space_id,
+					    lsm->index_id, run->id);
+	}
+
+	/*
+	 * Account the new runs, discard empty ones.
+	 */
+	for (int i = 0; i < n_parts; i++) {
+		run = group->new_runs[i];
+		if (!vy_run_is_empty(run)) {
+			vy_lsm_add_run(lsm, run);
+			/* Drop the reference held by the task. */
+			vy_run_unref(run);
+		} else {
+			vy_run_discard(run);
+		}
+	}
+
+	/*
+	 * Replace the old range in the LSM tree. Note, the range
+	 * was removed from the heap when compaction started.
+	 */
+	vy_lsm_unacct_range(lsm, range);
+	vy_range_heap_insert(&lsm->range_heap, range);
+	vy_lsm_remove_range(lsm, range);
+	for (int i = 0; i < n_parts; i++) {
+		vy_lsm_add_range(lsm, parts[i]);
+		vy_lsm_acct_range(lsm, parts[i]);
+	}
+	lsm->range_tree_version++;
+
+	vy_lsm_acct_compaction(lsm, compaction_time,
+			       &compaction_input, &compaction_output);
+	scheduler->stat.compaction_input += compaction_input.bytes;
+	scheduler->stat.compaction_output += compaction_output.bytes;
+	scheduler->stat.compaction_time += compaction_time;
+
+	rlist_foreach_entry(run, &unused_runs, in_unused)
+		vy_lsm_remove_run(lsm, run);
+	vy_lsm_purge_tombstones(lsm);
+	vy_scheduler_update_lsm(scheduler, lsm);
+
+	say_info("%s: completed compacting range %s in %d parts",
+		 vy_lsm_name(lsm), vy_range_str(range), n_parts);
+
+	rlist_foreach_entry(slice, &range->slices, in_range)
+		vy_slice_wait_pinned(slice);
+	vy_range_delete(range);
+	return 0;
+fail:
+	for (int i = 0; i < n_parts; i++) {
+		if (parts[i] != NULL)
+			vy_range_delete(parts[i]);
+	}
+	return -1;
+}
+
+static int
+vy_task_subcompaction_complete(struct vy_task *task)
+{
+	struct vy_compaction_group *group = task->group;
+
+	vy_task_subcompaction_cleanup(task);
+
+	/* Wait for the rest of the group. */
+	assert(group->in_progress > 0);
+	if (--group->in_progress > 0)
+		return 0;
+
+	if (group->is_failed) {
+		/* The error has already been reported. */
+		vy_compaction_group_abort(group);
+		return 0;
+	}
+	if (vy_compaction_group_complete(group) != 0) {
+		vy_compaction_group_abort(group);
+		return -1;
+	}
+	return 0;
+}
+
+static void
+vy_task_subcompaction_abort(struct vy_task *task)
+{
+	struct vy_compaction_group *group = task->group;
+	struct vy_lsm *lsm = task->lsm;
+
+	struct error *e = diag_last_error(&task->diag);
+	error_log(e);
+	say_error("%s: failed to compact range %s",
+		  vy_lsm_name(lsm), vy_range_str(group->range));
+
+	if (group->in_progress == 0) {
+		/*
+		 * The group failed to complete and has already
+		 * been cleaned up, see vy_task_subcompaction_complete().
+		 */
+		return;
+	}
+	vy_task_subcompaction_cleanup(task);
+	group->is_failed = true;
+	if (--group->in_progress == 0)
+		vy_compaction_group_abort(group);
+}
+
+/**
+ * Make a primary index compaction task discard expired tuples
+ * if the index has TTL configured. Secondary indexes are purged
+ * of expired tuples with deferred DELETEs generated by the task.
+ */
+static void
+vy_task_set_ttl(struct vy_lsm *lsm, struct vy_stmt_stream *wi)
+{
+	if (lsm->index_id == 0 && lsm->opts.ttl > 0) {
+		vy_write_iterator_set_ttl(wi, lsm->opts.ttl_field,
+					  fiber_time() - lsm->opts.ttl);
+	}
+}
+
+/**
+ * Make a primary index compaction task apply range tombstones
+ * that have been dumped. The tombstones are copied, because they
+ * may be dropped while the task is in progress.
+ *
+ * Returns 0 on success, -1 on memory allocation error.
+ */
+static int
+vy_task_set_tombstones(struct vy_task *task, struct vy_stmt_stream *wi,
+		       bool is_last_level)
+{
+	struct vy_lsm *lsm = task->lsm;
+	if (lsm->index_id != 0)
+		return 0;
+	/*
+	 * All statements with LSN up to dump_lsn are stored in
+	 * runs so major compaction applies all tombstones that
+	 * have been dumped to the range.
+	 */
+	if (is_last_level)
+		task->purge_lsn = lsm->dump_lsn;
+	int count = 0;
+	struct vy_tombstone *tombstone;
+	rlist_foreach_entry(tombstone, &lsm->tombstones, in_lsm) {
+		if (tombstone->lsn > lsm->dump_lsn)
+			break;
+		count++;
+	}
+	if (count == 0)
+		return 0;
+	task->tombstones = calloc(count, sizeof(*task->tombstones));
+	if (task->tombstones == NULL) {
+		diag_set(OutOfMemory, count * sizeof(*task->tombstones),
+			 "calloc", "struct vy_tombstone");
+		return -1;
+	}
+	rlist_foreach_entry(tombstone, &lsm->tombstones, in_lsm) {
+		if (task->tombstone_count == count)
+			break;
+		struct vy_tombstone *copy =
+			&task->tombstones[task->tombstone_count++];
+		*copy = *tombstone;
+		rlist_create(&copy->in_lsm);
+		rlist_create(&copy->in_tx);
+		if (copy->begin.stmt != NULL)
+			tuple_ref(copy->begin.stmt);
+		if (copy->end.stmt != NULL)
+			tuple_ref(copy->end.stmt);
+	}
+	vy_write_iterator_set_tombstones(wi, task->tombstones,
+					 task->tombstone_count,
+					 lsm->env->key_format);
+	return 0;
+}
+
+/**
+ * Try to create a group of tasks for compacting a range in
+ * parallel. If the range is too small or there are not enough
+ * idle worker threads, @p_task is left unset and the range is
+ * supposed to be compacted by a single task. Otherwise the first
+ * task of the group is returned in @p_task.
+ *
+ * Returns 0 on success, -1 on failure.
+ */
+static int
+vy_task_subcompaction_new(struct vy_scheduler *scheduler,
+			  struct vy_worker *worker, struct vy_lsm *lsm,
+			  struct vy_range *range, struct vy_task **p_task)
+{
+	static struct vy_task_ops subcompaction_ops = {
+		.execute = vy_task_compaction_execute,
+		.complete = vy_task_subcompaction_complete,
+		.abort = vy_task_subcompaction_abort,
+	};
+
+	/*
+	 * Find the slices to compact, the biggest of them,
+	 * and estimate the amount of work to do.
+	 */
+	struct vy_slice *slice, *biggest = NULL;
+	struct vy_slice *first_slice = NULL, *last_slice = NULL;
+	int64_t dump_lsn = -1;
+	int32_t dump_count = 0;
+	uint64_t input_size = 0;
+	int n = range->compaction_priority;
+	rlist_foreach_entry(slice, &range->slices, in_range) {
+		if (first_slice == NULL)
+			first_slice = slice;
+		last_slice = slice;
+		if (biggest == NULL ||
+		    slice->count.bytes > biggest->count.bytes)
+			biggest = slice;
+		input_size += slice->count.bytes;
+		dump_lsn = MAX(dump_lsn, slice->run->dump_lsn);
+		dump_count += slice->run->dump_count;
+		if (--n == 0)
+			break;
+	}
+	assert(n == 0);
+
+	int64_t part_size = MAX(vy_lsm_range_size(lsm),
+				VY_SUBCOMPACTION_PART_SIZE_MIN);
+	struct errinj *inj = errinj(ERRINJ_VY_SUBCOMPACTION_PART_SIZE,
+				    ERRINJ_INT);
+	if (inj != NULL && inj->iparam > 0)
+		part_size = inj->iparam;
+	int n_parts = MIN(input_size / part_size,
+			  (uint64_t)VY_SUBCOMPACTION_MAX);
+	if (n_parts < 2 || biggest->last_page_no == biggest->first_page_no)
+		return 0;
+
+	/*
+	 * Grab idle workers. Don't bother if there are none,
+	 * the range will be compacted by a single task then.
+	 */
+	struct vy_worker *workers[VY_SUBCOMPACTION_MAX];
+	int n_workers = 1;
+	workers[0] = worker;
+	while (n_workers < n_parts) {
+		worker = vy_worker_pool_get(&scheduler->compaction_pool);
+		if (worker == NULL)
+			break;
+		workers[n_workers++] = worker;
+	}
+	n_parts = n_workers;
+	if (n_parts < 2)
+		return 0;
+
+	struct vy_compaction_group *group = calloc(1, sizeof(*group));
+	if (group == NULL) {
+		diag_set(OutOfMemory, sizeof(*group),
+			 "malloc", "struct vy_compaction_group");
+		goto err_group;
+	}
+	group->refs = 1;
+	group->scheduler = scheduler;
+	group->lsm = lsm;
+	group->range = range;
+	group->first_slice = first_slice;
+	group->last_slice = last_slice;
+	group->start_time = ev_monotonic_now(loop());
+
+	/*
+	 * Split the key space of the range by the min keys of
+	 * evenly spaced pages of the biggest slice.
+	 */
+	struct key_def *cmp_def = lsm->cmp_def;
+	uint32_t page_count = biggest->last_page_no -
+			      biggest->first_page_no + 1;
+	struct vy_entry *keys = group->keys;
+	int key_count = 1;
+	keys[0] = range->begin;
+	if (keys[0].stmt != NULL)
+		tuple_ref(keys[0].stmt);
+	for (int i = 1; i < n_parts; i++) {
+		struct vy_page_info *page = vy_run_page_info(biggest->run,
+				biggest->first_page_no +
+				(uint64_t)page_count * i / n_parts);
+		struct vy_entry prev = keys[key_count - 1];
+		if (prev.stmt != NULL &&
+		    vy_entry_compare_with_raw_key(prev, page->min_key,
+						  page->min_key_hint,
+						  cmp_def) >= 0)
+			continue;
+		if (biggest->begin.stmt != NULL &&
+		    vy_entry_compare_with_raw_key(biggest->begin,
+						  page->min_key,
+						  page->min_key_hint,
+						  cmp_def) >= 0)
+			continue;
+		if (range->end.stmt != NULL &&
+		    vy_entry_compare_with_raw_key(range->end, page->min_key,
+						  page->min_key_hint,
+						  cmp_def) <= 0)
+			break;
+		struct vy_entry key = vy_entry_key_from_msgpack(
+				lsm->env->key_format, cmp_def, page->min_key);
+		if (key.stmt == NULL)
+			goto err_keys;
+		keys[key_count++] = key;
+	}
+	keys[key_count] = range->end;
+	if (keys[key_count].stmt != NULL)
+		tuple_ref(keys[key_count].stmt);
+	group->part_count = n_parts = key_count;
+
+	/* Return the workers we don't need. */
+	for (int i = n_parts; i < n_workers; i++)
+		vy_worker_pool_put(workers[i]);
+	n_workers = n_parts;
+	if (n_parts < 2) {
+		vy_compaction_group_unref(group);
+		return 0;
+	}
+
+	bool is_last_level = (range->compaction_priority == range->slice_count);
+	if (is_last_level)
+		dump_count -= last_slice->run->dump_count;
+	/* See vy_task_compaction_new(). */
+	if (range->needs_compaction)
+		dump_count = last_slice->run->dump_count;
+
+	for (int i = 0; i < n_parts; i++) {
+		struct vy_task *task = vy_task_new(scheduler, workers[i], lsm,
+						   &subcompaction_ops);
+		if (task == NULL)
+			goto err_task;
+		task->group = group;
+		group->refs++;
+		group->tasks[i] = task;
+
+		struct vy_run *new_run = vy_run_prepare(scheduler->run_env,
+							lsm);
+		if (new_run == NULL)
+			goto err_task;
+		new_run->dump_lsn = dump_lsn;
+		new_run->dump_count = dump_count;
+		task->new_run = new_run;
+		group->new_runs[i] = new_run;
+
+		task->wi = vy_write_iterator_new(task->cmp_def,
+					lsm->index_id == 0, is_last_level,
+					scheduler->read_views,
+					lsm->index_id > 0 ? NULL :
+					&task->deferred_delete_handler);
+		if (task->wi == NULL)
+			goto err_task;
+		vy_task_set_ttl(lsm, task->wi);
+		if (vy_task_set_tombstones(task, task->wi,
+					   is_last_level) != 0)
+			goto err_task;
+		for (slice = first_slice; ;
+		     slice = rlist_next_entry(slice, in_range)) {
+			struct vy_slice *part_slice;
+			if (vy_slice_cut(slice, vy_log_next_id(), keys[i],
+					 keys[i + 1], cmp_def,
+					 &part_slice) != 0)
+				goto err_task;
+			if (part_slice != NULL) {
+				rlist_add_tail_entry(&task->part_slices,
+						     part_slice, in_range);
+				if (vy_write_iterator_new_slice(task->wi,
+						part_slice,
+						lsm->disk_format) != 0)
+					goto err_task;
+				if (vy_task_add_run_blobs(task,
+						part_slice->run) != 0)
+					goto err_task;
+			}
+			if (slice == last_slice)
+				break;
+		}
+		if (task->blob_map.count > 0)
+			vy_write_iterator_set_blob_map(task->wi,
+						       &task->blob_map);
+		task->range = range;
+		task->first_slice = first_slice;
+		task->last_slice = last_slice;
+		task->bloom_fpr = lsm->opts.bloom_fpr;
+		task->page_size = lsm->opts.page_size;
+		task->compression_dict_size = lsm->opts.compression_dict_size;
+		task->range_filter = lsm->opts.range_filter;
+		task->blob_threshold = lsm->index_id == 0 ?
+				       lsm->opts.blob_threshold : 0;
+	}
+	group->in_progress = n_parts;
+	range->needs_compaction = false;
+	range->needs_purge = false;
+
+	/*
+	 * Remove the range we are going to compact from the heap
+	 * so that it doesn't get selected again.
+	 */
+	vy_range_heap_delete(&lsm->range_heap, range);
+	vy_scheduler_update_lsm(scheduler, lsm);
+
+	say_info("%s: started compacting range %s, runs %d/%d, in %d parts",
+		 vy_lsm_name(lsm), vy_range_str(range),
+		 range->compaction_priority, range->slice_count, n_parts);
+	*p_task = group->tasks[0];
+	vy_compaction_group_unref(group);
+	return 0;
+
+err_task:
+	for (int i = 0; i < n_parts; i++) {
+		struct vy_task *task = group->tasks[i];
+		if (task == NULL)
+			continue;
+		vy_task_subcompaction_cleanup(task);
+		if (task->new_run != NULL)
+			vy_run_discard(task->new_run);
+		vy_task_delete(task);
+	}
+err_keys:
+	vy_compaction_group_unref(group);
+err_group:
+	/* The first worker is returned by the caller. */
+	for (int i = 1; i < n_workers; i++)
+		vy_worker_pool_put(workers[i]);
+	return -1;
+}
+
 static int
 vy_task_compaction_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 		       struct vy_lsm *lsm, struct vy_task **p_task)
@@ -1627,7 +2445,7 @@ vy_task_compaction_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 
 	struct vy_range *range = vy_range_heap_top(&lsm->range_heap);
 	assert(range != NULL);
-	assert(range->compaction_priority > 1);
+	assert(range->compaction_priority > 0);
 
 	if (vy_lsm_split_range(lsm, range) ||
 	    vy_lsm_coalesce_range(lsm, range)) {
@@ -1635,6 +2453,12 @@ vy_task_compaction_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 		return 0;
 	}
 
+	if (vy_task_subcompaction_new(scheduler, worker, lsm,
+				      range, p_task) != 0)
+		goto err_task;
+	if (*p_task != NULL)
+		return 0;
+
 	struct vy_task *task = vy_task_new(scheduler, worker, lsm,
 					   &compaction_ops);
 	if (task == NULL)
@@ -1652,6 +2476,9 @@ vy_task_compaction_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 				   &task->deferred_delete_handler);
 	if (wi == NULL)
 		goto err_wi;
+	vy_task_set_ttl(lsm, wi);
+	if (vy_task_set_tombstones(task, wi, is_last_level) != 0)
+		goto err_wi_sub;
 
 	struct vy_slice *slice;
 	int32_t dump_count = 0;
@@ -1660,6 +2487,8 @@ vy_task_compaction_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 		if (vy_write_iterator_new_slice(wi, slice,
 						lsm->disk_format) != 0)
 			goto err_wi_sub;
+		if (vy_task_add_run_blobs(task, slice->run) != 0)
+			goto err_wi_sub;
 		new_run->dump_lsn = MAX(new_run->dump_lsn,
 					slice->run->dump_lsn);
 		dump_count += slice->run->dump_count;
@@ -1686,12 +2515,20 @@ vy_task_compaction_new(struct vy_scheduler *scheduler, struct vy_worker *worker,
 		new_run->dump_count = dump_count;
 
 	range->needs_compaction = false;
+	range->needs_purge = false;
+
+	if (task->blob_map.count > 0)
+		vy_write_iterator_set_blob_map(wi, &task->blob_map);
 
 	task->range = range;
 	task->new_run = new_run;
 	task->wi = wi;
 	task->bloom_fpr = lsm->opts.bloom_fpr;
 	task->page_size = lsm->opts.page_size;
+	task->compression_dict_size = lsm->opts.compression_dict_size;
+	task->range_filter = lsm->opts.range_filter;
+	task->blob_threshold = lsm->index_id == 0 ?
+			       lsm->opts.blob_threshold : 0;
 
 	/*
 	 * Remove the range we are going to compact from the heap
@@ -1895,7 +2732,11 @@ retry:
 	struct vy_lsm *lsm = vy_compaction_heap_top(&scheduler->compaction_heap);
 	if (lsm == NULL)
 		goto no_task; /* nothing to do */
-	if (vy_lsm_compaction_priority(lsm) <= 1)
+	/*
+	 * A range with one run is only compacted to purge
+	 * statements deleted by a range tombstone.
+	 */
+	if (vy_lsm_compaction_priority(lsm) == 0)
 		goto no_task; /* nothing to do */
 	if (worker == NULL) {
 		worker = vy_worker_pool_get(&scheduler->compaction_pool);
@@ -1933,7 +2774,10 @@ vy_schedule(struct vy_scheduler *scheduler, struct vy_task **ptask)
 	/* no task to run */
 	return 0;
 found:
-	scheduler->stat.tasks_inprogress++;
+	if ((*ptask)->group != NULL)
+		scheduler->stat.tasks_inprogress += (*ptask)->group->part_count;
+	else
+		scheduler->stat.tasks_inprogress++;
 	return 0;
 fail:
 	assert(!diag_is_empty(diag_get()));
@@ -2030,8 +2874,19 @@ vy_scheduler_f(va_list va)
 		}
 
 		/* Queue the task for execution. */
-		cmsg_init(&task->cmsg, vy_task_execute_route);
-		cpipe_push(&task->worker->worker_pipe, &task->cmsg);
+		if (task->group != NULL) {
+			/* Start all subcompactions at once. */
+			struct vy_compaction_group *group = task->group;
+			for (int i = 0; i < group->part_count; i++) {
+				task = group->tasks[i];
+				cmsg_init(&task->cmsg, vy_task_execute_route);
+				cpipe_push(&task->worker->worker_pipe,
+					   &task->cmsg);
+			}
+		} else {
+			cmsg_init(&task->cmsg, vy_task_execute_route);
+			cpipe_push(&task->worker->worker_pipe, &task->cmsg);
+		}
 
 		fiber_reschedule();
 		continue;
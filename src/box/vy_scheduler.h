@@ -152,6 +152,12 @@ struct vy_scheduler {
 	struct rlist *read_views;
 	/** Context needed for writing runs. */
 	struct vy_run_env *run_env;
+	/**
+	 * Max rate at which a compaction task may write output,
+	 * in bytes per second, 0 if unlimited. Set by the load
+	 * regulator from tx and read by compaction threads.
+	 */
+	size_t compaction_rate_limit;
 };
 
 /**
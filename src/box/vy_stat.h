@@ -101,6 +101,26 @@ struct vy_run_iterator_stat {
 	 * of disk reads.
 	 */
 	struct vy_disk_stmt_counter read;
+	/**
+	 * Time spent reading and decompressing pages in reader
+	 * threads, in seconds.
+	 */
+	double read_time;
+	/**
+	 * Number of times the range filter allowed to skip
+	 * a run when scanning an interval.
+	 */
+	int64_t range_filter_hit;
+	/**
+	 * Number of times the range filter was checked, but
+	 * failed to prevent a disk read.
+	 */
+	int64_t range_filter_miss;
+	/**
+	 * Estimated number of bytes the range filter saved from
+	 * reading, in compressed page sizes.
+	 */
+	int64_t range_filter_saved;
 };
 
 /** TX write set iterator statistics. */
@@ -123,6 +143,23 @@ struct vy_lsm_stat {
 	struct vy_stmt_counter put;
 	/** Read latency. */
 	struct latency latency;
+	/** Batched point lookup statistics. */
+	struct {
+		/** Number of batches. */
+		int64_t count;
+		/** Number of keys looked up in batches. */
+		int64_t keys;
+		/** Number of keys that had to be read from disk. */
+		int64_t disk_keys;
+		/**
+		 * Total number of fibers reading disk for batches.
+		 * Divided by the number of batches, gives the
+		 * average I/O depth.
+		 */
+		int64_t io_depth;
+		/** Batch latency. */
+		struct latency latency;
+	} batch;
 	/** Upsert statistics. */
 	struct {
 		/** How many upsert chains have been squashed. */
@@ -187,10 +224,18 @@ struct vy_cache_stat {
 	struct vy_stmt_counter count;
 	/** Number of lookups in the cache. */
 	int64_t lookup;
+	/** Number of lookups that found a statement in the cache. */
+	int64_t hit;
 	/** Number of reads from the cache. */
 	struct vy_stmt_counter get;
 	/** Number of writes to the cache. */
 	struct vy_stmt_counter put;
+	/**
+	 * Number of statements that were not added to the cache
+	 * by the admission policy, because they are read less
+	 * often than the statements they would evict.
+	 */
+	struct vy_stmt_counter reject;
 	/**
 	 * Number of statements removed from the cache
 	 * due to overwrite.
@@ -242,16 +287,45 @@ struct vy_scheduler_stat {
 	int64_t compaction_output;
 };
 
+/**
+ * Statistics of all LSM trees using the same compaction policy.
+ * Used for estimating write, read, and space amplification.
+ *
+ * All byte counters are given without taking into account
+ * disk compression.
+ */
+struct vy_compaction_policy_stat {
+	/** Number of run slices in all ranges. */
+	int64_t slice_count;
+	/** Number of ranges. */
+	int64_t range_count;
+	/** Size of data stored on disk, in bytes. */
+	int64_t disk_size;
+	/** Size of data stored at the last LSM tree level, in bytes. */
+	int64_t compacted_size;
+	/** Number of bytes dumped from memory. */
+	int64_t dump_input;
+	/** Number of bytes written by dump and compaction tasks. */
+	int64_t disk_output;
+};
+
 static inline int
 vy_lsm_stat_create(struct vy_lsm_stat *stat)
 {
-	return latency_create(&stat->latency);
+	if (latency_create(&stat->latency) != 0)
+		return -1;
+	if (latency_create(&stat->batch.latency) != 0) {
+		latency_destroy(&stat->latency);
+		return -1;
+	}
+	return 0;
 }
 
 static inline void
 vy_lsm_stat_destroy(struct vy_lsm_stat *stat)
 {
 	latency_destroy(&stat->latency);
+	latency_destroy(&stat->batch.latency);
 }
 
 static inline void
@@ -219,29 +219,15 @@ struct tuple *
 vy_stmt_dup_lsregion(struct tuple *stmt, struct lsregion *lsregion,
 		     int64_t alloc_id)
 {
-	enum iproto_type type = vy_stmt_type(stmt);
 	size_t size = tuple_size(stmt);
-	size_t alloc_size = size;
 	struct tuple *mem_stmt;
-	const size_t align = alignof(struct vy_stmt);
-
-	/* Reserve one byte for UPSERT counter. */
-	if (type == IPROTO_UPSERT)
-		alloc_size += align;
-
-	mem_stmt = lsregion_aligned_alloc(lsregion, alloc_size, align,
-					  alloc_id);
+	mem_stmt = lsregion_aligned_alloc(lsregion, size,
+					  alignof(struct vy_stmt), alloc_id);
 	if (mem_stmt == NULL) {
-		diag_set(OutOfMemory, alloc_size, "lsregion_aligned_alloc",
+		diag_set(OutOfMemory, size, "lsregion_aligned_alloc",
 			 "mem_stmt");
 		return NULL;
 	}
-
-	if (type == IPROTO_UPSERT) {
-		memset(mem_stmt, 0, align);
-		mem_stmt = (struct tuple *)((uint8_t *)mem_stmt + align);
-	}
-
 	memcpy(mem_stmt, stmt, size);
 	/*
 	 * Region allocated statements can't be referenced or unreferenced
@@ -251,6 +237,7 @@ vy_stmt_dup_lsregion(struct tuple *stmt, struct lsregion *lsregion,
 	 * will try to unreference this statement.
 	 */
 	mem_stmt->refs = 0;
+	((struct vy_stmt *)mem_stmt)->n_upserts = 0;
 	return mem_stmt;
 }
 
@@ -395,6 +382,26 @@ vy_stmt_new_delete(struct tuple_format *format, const char *tuple_begin,
 				    NULL, 0, IPROTO_DELETE);
 }
 
+struct tuple *
+vy_stmt_new_delete_by_key(struct tuple *stmt, struct key_def *cmp_def,
+			  struct tuple_format *key_format)
+{
+	struct tuple *key = stmt;
+	if (!vy_stmt_is_key(stmt)) {
+		key = vy_stmt_extract_key(stmt, cmp_def, key_format,
+					  MULTIKEY_NONE);
+		if (key == NULL)
+			return NULL;
+	}
+	uint32_t size;
+	const char *data = tuple_data_range(key, &size);
+	struct tuple *delete = vy_stmt_new_delete(key_format, data,
+						  data + size);
+	if (key != stmt)
+		tuple_unref(key);
+	return delete;
+}
+
 struct tuple *
 vy_stmt_replace_from_upsert(struct tuple *upsert)
 {
@@ -676,7 +683,8 @@ vy_stmt_encode_primary(struct tuple *value, struct key_def *key_def,
 
 int
 vy_stmt_encode_secondary(struct tuple *value, struct key_def *cmp_def,
-			 int multikey_idx, struct xrow_header *xrow)
+			 int multikey_idx, bool is_covering,
+			 struct xrow_header *xrow)
 {
 	memset(xrow, 0, sizeof(*xrow));
 	enum iproto_type type = vy_stmt_type(value);
@@ -687,10 +695,15 @@ vy_stmt_encode_secondary(struct tuple *value, struct key_def *cmp_def,
 	memset(&request, 0, sizeof(request));
 	request.type = type;
 	uint32_t size;
-	const char *extracted = vy_stmt_is_key(value) ?
-				tuple_data_range(value, &size) :
-				tuple_extract_key(value, cmp_def,
-						  multikey_idx, &size);
+	const char *extracted;
+	if (vy_stmt_is_key(value) ||
+	    (is_covering && type != IPROTO_DELETE)) {
+		/* Covering indexes store full tuples. */
+		extracted = tuple_data_range(value, &size);
+	} else {
+		extracted = tuple_extract_key(value, cmp_def,
+					      multikey_idx, &size);
+	}
 	if (extracted == NULL)
 		return -1;
 	if (type == IPROTO_REPLACE || type == IPROTO_INSERT) {
@@ -136,11 +136,19 @@ enum {
 	 * compaction. It is never written to disk.
 	 */
 	VY_STMT_UPDATE			= 1 << 2,
+	/**
+	 * This flag is set for primary index statements some
+	 * fields of which were moved to a blob file and replaced
+	 * with blob references, see vy_blob.h. Such statements
+	 * are only stored in run files and must be loaded with
+	 * vy_blob_load() before being returned to the user.
+	 */
+	VY_STMT_BLOB			= 1 << 3,
 	/**
 	 * Bit mask of all statement flags.
 	 */
 	VY_STMT_FLAGS_ALL = (VY_STMT_DEFERRED_DELETE | VY_STMT_SKIP_READ |
-			     VY_STMT_UPDATE),
+			     VY_STMT_UPDATE | VY_STMT_BLOB),
 };
 
 /**
@@ -174,6 +182,12 @@ struct vy_stmt {
 	int64_t lsn;
 	uint8_t  type; /* IPROTO_INSERT/REPLACE/UPSERT/DELETE */
 	uint8_t flags;
+	/**
+	 * Number of UPSERTs squashed in this UPSERT, only used
+	 * for statements allocated on lsregion. Fits in padding,
+	 * so it doesn't increase the size of the header.
+	 */
+	uint8_t n_upserts;
 	/**
 	 * Offsets array concatenated with MessagePack fields
 	 * array.
@@ -232,7 +246,7 @@ vy_stmt_n_upserts(struct tuple *stmt)
 {
 	assert(stmt->refs == 0);
 	assert(vy_stmt_type(stmt) == IPROTO_UPSERT);
-	return *((uint8_t *)stmt - 1);
+	return ((struct vy_stmt *)stmt)->n_upserts;
 }
 
 /**
@@ -244,7 +258,7 @@ vy_stmt_set_n_upserts(struct tuple *stmt, uint8_t n)
 {
 	assert(stmt->refs == 0);
 	assert(vy_stmt_type(stmt) == IPROTO_UPSERT);
-	*((uint8_t *)stmt - 1) = n;
+	((struct vy_stmt *)stmt)->n_upserts = n;
 }
 
 /** Return true if the given format is a key format. */
@@ -519,6 +533,21 @@ struct tuple *
 vy_stmt_new_delete(struct tuple_format *format, const char *tuple_begin,
 		   const char *tuple_end);
 
+/**
+ * Create a DELETE statement for the key of the given statement,
+ * which may be either a tuple or a key. The result uses the key
+ * format, like DELETE statements loaded from disk.
+ * @param stmt Statement to extract the key from.
+ * @param cmp_def Key definition of the index.
+ * @param key_format Format of keys.
+ *
+ * @retval NULL     Memory allocation error.
+ * @retval not NULL Success.
+ */
+struct tuple *
+vy_stmt_new_delete_by_key(struct tuple *stmt, struct key_def *cmp_def,
+			  struct tuple_format *key_format);
+
  /**
  * Create the UPSERT statement from raw MessagePack data.
  * @param tuple_begin MessagePack data that contain an array of fields WITH the
@@ -656,6 +685,7 @@ vy_stmt_encode_primary(struct tuple *value, struct key_def *key_def,
  * @param value statement to encode
  * @param key_def key definition
  * @param multikey_idx multikey index hint
+ * @param is_covering store full tuples rather than keys
  * @param xrow[out] xrow to fill
  *
  * @retval 0 if OK
@@ -663,7 +693,8 @@ vy_stmt_encode_primary(struct tuple *value, struct key_def *key_def,
  */
 int
 vy_stmt_encode_secondary(struct tuple *value, struct key_def *cmp_def,
-			 int multikey_idx, struct xrow_header *xrow);
+			 int multikey_idx, bool is_covering,
+			 struct xrow_header *xrow);
 
 /**
  * Reconstruct vinyl tuple info and data from xrow
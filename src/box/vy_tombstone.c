@@ -0,0 +1,154 @@
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+#include "vy_tombstone.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <msgpuck.h>
+#include <small/rlist.h>
+
+#include "diag.h"
+#include "key_def.h"
+#include "trivia/util.h"
+#include "tuple.h"
+#include "vy_stmt.h"
+
+/**
+ * Create a key entry for a tombstone boundary or return
+ * vy_entry_none() in @ret if the boundary is unset.
+ */
+static int
+vy_tombstone_key_new(struct tuple_format *key_format,
+		     struct key_def *cmp_def, const char *key,
+		     struct vy_entry *ret)
+{
+	*ret = vy_entry_none();
+	if (key == NULL)
+		return 0;
+	const char *data = key;
+	if (mp_decode_array(&data) == 0)
+		return 0;
+	*ret = vy_entry_key_from_msgpack(key_format, cmp_def, key);
+	return ret->stmt != NULL ? 0 : -1;
+}
+
+struct vy_tombstone *
+vy_tombstone_new(struct vy_lsm *lsm, int64_t id, int64_t lsn,
+		 struct tuple_format *key_format, struct key_def *cmp_def,
+		 const char *begin, const char *end)
+{
+	struct vy_tombstone *tombstone = calloc(1, sizeof(*tombstone));
+	if (tombstone == NULL) {
+		diag_set(OutOfMemory, sizeof(*tombstone),
+			 "calloc", "struct vy_tombstone");
+		return NULL;
+	}
+	rlist_create(&tombstone->in_lsm);
+	rlist_create(&tombstone->in_tx);
+	tombstone->lsm = lsm;
+	tombstone->id = id;
+	tombstone->lsn = lsn;
+	if (vy_tombstone_key_new(key_format, cmp_def, begin,
+				 &tombstone->begin) != 0)
+		goto fail;
+	if (vy_tombstone_key_new(key_format, cmp_def, end,
+				 &tombstone->end) != 0)
+		goto fail;
+	return tombstone;
+fail:
+	vy_tombstone_delete(tombstone);
+	return NULL;
+}
+
+void
+vy_tombstone_delete(struct vy_tombstone *tombstone)
+{
+	if (tombstone->begin.stmt != NULL)
+		tuple_unref(tombstone->begin.stmt);
+	if (tombstone->end.stmt != NULL)
+		tuple_unref(tombstone->end.stmt);
+	TRASH(tombstone);
+	free(tombstone);
+}
+
+bool
+vy_tombstone_covers(const struct vy_tombstone *tombstone,
+		    struct vy_entry entry, struct key_def *cmp_def)
+{
+	/*
+	 * Boundaries may be partial keys. A key that has the
+	 * same prefix as the lower bound is covered, one that has
+	 * the same prefix as the upper bound is not.
+	 */
+	if (tombstone->begin.stmt != NULL &&
+	    vy_entry_compare(entry, tombstone->begin, cmp_def) < 0)
+		return false;
+	if (tombstone->end.stmt != NULL &&
+	    vy_entry_compare(entry, tombstone->end, cmp_def) >= 0)
+		return false;
+	return true;
+}
+
+bool
+vy_tombstone_intersects(const struct vy_tombstone *tombstone,
+			struct vy_entry begin, struct vy_entry end,
+			struct key_def *cmp_def)
+{
+	/*
+	 * Keys with the same prefix may fall in both intervals
+	 * so we only treat the intervals as disjoint if the
+	 * boundaries compare strictly.
+	 */
+	if (tombstone->end.stmt != NULL && begin.stmt != NULL &&
+	    vy_entry_compare(tombstone->end, begin, cmp_def) < 0)
+		return false;
+	if (tombstone->begin.stmt != NULL && end.stmt != NULL &&
+	    vy_entry_compare(end, tombstone->begin, cmp_def) < 0)
+		return false;
+	return true;
+}
+
+int64_t
+vy_tombstone_list_lsn(struct rlist *list, int64_t vlsn,
+		      struct vy_entry entry, struct key_def *cmp_def)
+{
+	struct vy_tombstone *tombstone;
+	rlist_foreach_entry_reverse(tombstone, list, in_lsm) {
+		if (tombstone->lsn > vlsn)
+			continue;
+		if (vy_tombstone_covers(tombstone, entry, cmp_def))
+			return tombstone->lsn;
+	}
+	return 0;
+}
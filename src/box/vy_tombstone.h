@@ -0,0 +1,152 @@
+#ifndef INCLUDES_TARANTOOL_BOX_VY_TOMBSTONE_H
+#define INCLUDES_TARANTOOL_BOX_VY_TOMBSTONE_H
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <small/rlist.h>
+
+#include "vy_entry.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct key_def;
+struct tuple_format;
+struct vy_lsm;
+
+/**
+ * Range tombstone.
+ *
+ * A range tombstone is written by index.delete_range() to the
+ * primary index of a vinyl space instead of a DELETE for each
+ * tuple falling in the range. It deletes all statements for keys
+ * k such that begin <= k < end with an LSN less than the LSN of
+ * the tombstone. Statements of the same transaction inserted
+ * after the tombstone have the same LSN and so are not deleted.
+ *
+ * Tombstones aren't stored in runs. Instead, they are kept in
+ * memory in vy_lsm::tombstones and persisted in the metadata
+ * log. Readers (vy_read_iterator, vy_point_lookup) discard
+ * statements covered by a tombstone visible from their read
+ * view. Compaction (vy_write_iterator) replaces them with a
+ * DELETE having the LSN of the tombstone, which also generates
+ * deferred DELETEs for secondary indexes. Once all ranges
+ * intersecting a tombstone have been compacted to the last
+ * level, the tombstone is dropped.
+ */
+struct vy_tombstone {
+	/** Link in vy_lsm::tombstones, set when prepared. */
+	struct rlist in_lsm;
+	/**
+	 * Link in vy_tx::tombstones, set until the transaction
+	 * that created the tombstone ends.
+	 */
+	struct rlist in_tx;
+	/**
+	 * LSM tree of the primary index the tombstone is for.
+	 * Referenced while the tombstone is in vy_tx::tombstones.
+	 */
+	struct vy_lsm *lsm;
+	/** Unique ID of this tombstone, used in the metadata log. */
+	int64_t id;
+	/**
+	 * LSN of the tombstone. INT64_MAX while the transaction
+	 * is in progress, MAX_LSN + psn after it is prepared,
+	 * then the LSN of the WAL row after it is committed.
+	 */
+	int64_t lsn;
+	/** Lower bound (inclusive), vy_entry_none() if unbounded. */
+	struct vy_entry begin;
+	/** Upper bound (exclusive), vy_entry_none() if unbounded. */
+	struct vy_entry end;
+	/**
+	 * Number of the transaction statement that created the
+	 * tombstone. Used to roll it back on statement rollback.
+	 */
+	int stmt_no;
+};
+
+/**
+ * Allocate a range tombstone.
+ * @param lsm LSM tree of the primary index.
+ * @param id Tombstone ID.
+ * @param lsn Tombstone LSN.
+ * @param key_format Format of keys.
+ * @param cmp_def Key definition of the primary index.
+ * @param begin MsgPack array of the lower bound, may be NULL.
+ * @param end MsgPack array of the upper bound, may be NULL.
+ *
+ * An empty or NULL key means that the range is unbounded.
+ *
+ * @retval not NULL The new tombstone.
+ * @retval NULL Memory allocation error.
+ */
+struct vy_tombstone *
+vy_tombstone_new(struct vy_lsm *lsm, int64_t id, int64_t lsn,
+		 struct tuple_format *key_format, struct key_def *cmp_def,
+		 const char *begin, const char *end);
+
+/** Free a range tombstone. */
+void
+vy_tombstone_delete(struct vy_tombstone *tombstone);
+
+/** Return true if a range tombstone covers the given key. */
+bool
+vy_tombstone_covers(const struct vy_tombstone *tombstone,
+		    struct vy_entry entry, struct key_def *cmp_def);
+
+/**
+ * Return true if a range tombstone may cover a key falling in
+ * the interval [begin, end), where an unset boundary means that
+ * the interval is unbounded on that side.
+ */
+bool
+vy_tombstone_intersects(const struct vy_tombstone *tombstone,
+			struct vy_entry begin, struct vy_entry end,
+			struct key_def *cmp_def);
+
+/**
+ * Return the max LSN of tombstones stored in the given list that
+ * cover the given key and are visible from a read view with the
+ * given LSN, or 0 if there's no such tombstone. The list must be
+ * sorted by LSN in ascending order.
+ */
+int64_t
+vy_tombstone_list_lsn(struct rlist *list, int64_t vlsn,
+		      struct vy_entry entry, struct key_def *cmp_def);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* INCLUDES_TARANTOOL_BOX_VY_TOMBSTONE_H */
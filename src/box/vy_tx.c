@@ -56,6 +56,7 @@
 #include "vy_mem.h"
 #include "vy_stat.h"
 #include "vy_stmt.h"
+#include "vy_tombstone.h"
 #include "vy_upsert.h"
 #include "vy_history.h"
 #include "vy_read_set.h"
@@ -331,6 +332,24 @@ vy_tx_create(struct tx_manager *xm, struct vy_tx *tx)
 	tx->psn = 0;
 	rlist_create(&tx->on_destroy);
 	rlist_create(&tx->in_writers);
+	rlist_create(&tx->tombstones);
+	tx->stmt_count = 0;
+}
+
+/**
+ * Drop a range tombstone created by a transaction that is about
+ * to end. The tombstone is freed unless it was committed.
+ */
+static void
+vy_tx_drop_tombstone(struct vy_tombstone *tombstone, bool is_committed)
+{
+	struct vy_lsm *lsm = tombstone->lsm;
+	rlist_del_entry(tombstone, in_tx);
+	if (!is_committed) {
+		rlist_del_entry(tombstone, in_lsm);
+		vy_tombstone_delete(tombstone);
+	}
+	vy_lsm_unref(lsm);
 }
 
 void
@@ -347,6 +366,11 @@ vy_tx_destroy(struct vy_tx *tx)
 
 	vy_tx_read_set_iter(&tx->read_set, NULL, vy_tx_read_set_free_cb, NULL);
 	rlist_del_entry(tx, in_writers);
+
+	struct vy_tombstone *tombstone, *next_tombstone;
+	rlist_foreach_entry_safe(tombstone, &tx->tombstones, in_tx,
+				 next_tombstone)
+		vy_tx_drop_tombstone(tombstone, false);
 }
 
 /** Mark a transaction as aborted and account it in stats. */
@@ -362,7 +386,8 @@ vy_tx_abort(struct vy_tx *tx)
 static bool
 vy_tx_is_ro(struct vy_tx *tx)
 {
-	return write_set_empty(&tx->write_set);
+	return write_set_empty(&tx->write_set) &&
+	       rlist_empty(&tx->tombstones);
 }
 
 /** Return true if the transaction is in read view. */
@@ -400,6 +425,72 @@ vy_tx_send_to_read_view(struct vy_tx *tx, struct txv *v)
 	return 0;
 }
 
+/**
+ * Send to read view all transactions that have read keys
+ * that may be deleted by range tombstone @tombstone created
+ * by transaction @tx.
+ */
+static int
+vy_tx_send_to_read_view_range(struct vy_tx *tx,
+			      struct vy_tombstone *tombstone)
+{
+	struct vy_lsm *lsm = tombstone->lsm;
+	struct vy_read_interval *interval;
+	for (interval = vy_lsm_read_set_first(&lsm->read_set);
+	     interval != NULL;
+	     interval = vy_lsm_read_set_next(&lsm->read_set, interval)) {
+		struct vy_tx *reader = interval->tx;
+		if (reader == tx || reader->state != VINYL_TX_READY ||
+		    vy_tx_is_in_read_view(reader))
+			continue;
+		if (!vy_tombstone_intersects(tombstone, interval->left,
+					     interval->right, lsm->cmp_def))
+			continue;
+		struct vy_read_view *rv = tx_manager_read_view(tx->xm);
+		if (rv == NULL)
+			return -1;
+		reader->read_view = rv;
+	}
+	return 0;
+}
+
+/**
+ * Abort all transactions that have read keys that may be
+ * deleted by range tombstone @tombstone created by @tx.
+ */
+static void
+vy_tx_abort_readers_range(struct vy_tx *tx, struct vy_tombstone *tombstone)
+{
+	struct vy_lsm *lsm = tombstone->lsm;
+	struct vy_read_interval *interval;
+	for (interval = vy_lsm_read_set_first(&lsm->read_set);
+	     interval != NULL;
+	     interval = vy_lsm_read_set_next(&lsm->read_set, interval)) {
+		struct vy_tx *reader = interval->tx;
+		if (reader == tx || reader->state != VINYL_TX_READY)
+			continue;
+		if (vy_tombstone_intersects(tombstone, interval->left,
+					    interval->right, lsm->cmp_def))
+			vy_tx_abort(reader);
+	}
+}
+
+/**
+ * Drop all statements cached for the space a range tombstone
+ * is created for, because any of them may be deleted by it.
+ */
+static void
+vy_tx_invalidate_cache_range(struct vy_tombstone *tombstone)
+{
+	struct vy_lsm *pk = tombstone->lsm;
+	vy_cache_invalidate(&pk->cache);
+	struct space *space = space_by_id(pk->space_id);
+	if (space == NULL)
+		return;
+	for (uint32_t i = 1; i < space->index_count; i++)
+		vy_cache_invalidate(&vy_lsm(space->index[i])->cache);
+}
+
 /**
  * Abort all transaction that are reading key @v modified
  * by transaction @tx.
@@ -713,7 +804,8 @@ vy_tx_prepare(struct vy_tx *tx)
 		}
 		assert(lsm->space_id == current_space_id);
 
-		if (lsm->index_id > 0 && repsert == NULL && delete == NULL) {
+		if (lsm->index_id > 0 && !lsm->opts.covering &&
+		    repsert == NULL && delete == NULL) {
 			/*
 			 * This statement is for a secondary index,
 			 * and the statement corresponding to it in
@@ -725,6 +817,10 @@ vy_tx_prepare(struct vy_tx *tx)
 			 * the corresponding statement never made it
 			 * to the primary index LSM tree. So we must
 			 * skip it for secondary indexes as well.
+			 *
+			 * A covering index must not lag behind the
+			 * primary index so we write all statements
+			 * to it.
 			 */
 			v->is_overwritten = true;
 		}
@@ -785,6 +881,21 @@ vy_tx_prepare(struct vy_tx *tx)
 			return -1;
 		v->region_stmt = *region_stmt;
 	}
+
+	/*
+	 * Make range tombstones visible to the global read view.
+	 * Since the LSM tree has no statement to track the change,
+	 * drop everything cached for the space.
+	 */
+	struct vy_tombstone *tombstone;
+	rlist_foreach_entry(tombstone, &tx->tombstones, in_tx) {
+		if (vy_tx_send_to_read_view_range(tx, tombstone) != 0)
+			return -1;
+		tombstone->lsn = MAX_LSN + tx->psn;
+		rlist_add_tail_entry(&tombstone->lsm->tombstones,
+				     tombstone, in_lsm);
+		vy_tx_invalidate_cache_range(tombstone);
+	}
 	xm->last_prepared_tx = tx;
 	return 0;
 }
@@ -820,6 +931,14 @@ vy_tx_commit(struct vy_tx *tx, int64_t lsn)
 			vy_mem_unpin(v->mem);
 	}
 
+	/* Hand range tombstones over to the primary index. */
+	struct vy_tombstone *tombstone, *next_tombstone;
+	rlist_foreach_entry_safe(tombstone, &tx->tombstones, in_tx,
+				 next_tombstone) {
+		tombstone->lsn = lsn;
+		vy_tx_drop_tombstone(tombstone, true);
+	}
+
 	/* Update read views of dependant transactions. */
 	if (tx->read_view != &xm->global_read_view)
 		tx->read_view->vlsn = lsn;
@@ -873,6 +992,15 @@ vy_tx_rollback_after_prepare(struct vy_tx *tx)
 	while ((v = write_set_inext(&it)) != NULL) {
 		vy_tx_abort_readers(tx, v);
 	}
+
+	struct vy_tombstone *tombstone;
+	rlist_foreach_entry(tombstone, &tx->tombstones, in_tx) {
+		if (rlist_empty(&tombstone->in_lsm))
+			continue;
+		rlist_del_entry(tombstone, in_lsm);
+		vy_tx_abort_readers_range(tx, tombstone);
+		vy_tx_invalidate_cache_range(tombstone);
+	}
 }
 
 void
@@ -898,9 +1026,10 @@ vy_tx_begin_statement(struct vy_tx *tx, struct space *space, void **savepoint)
 	}
 	assert(tx->state == VINYL_TX_READY);
 	tx->last_stmt_space = space;
-	if (stailq_empty(&tx->log))
+	if (stailq_empty(&tx->log) && rlist_empty(&tx->tombstones))
 		rlist_add_entry(&tx->xm->writers, tx, in_writers);
 	*savepoint = stailq_last(&tx->log);
+	tx->stmt_count++;
 	return 0;
 }
 
@@ -928,7 +1057,19 @@ vy_tx_rollback_statement(struct vy_tx *tx, void *svp)
 		tx->write_set_version++;
 		txv_delete(v);
 	}
-	if (stailq_empty(&tx->log))
+	/*
+	 * Statements are rolled back in LIFO order so range
+	 * tombstones of the statement are at the list tail.
+	 */
+	while (!rlist_empty(&tx->tombstones)) {
+		struct vy_tombstone *tombstone = rlist_last_entry(
+			&tx->tombstones, struct vy_tombstone, in_tx);
+		if (tombstone->stmt_no != tx->stmt_count)
+			break;
+		vy_tx_drop_tombstone(tombstone, false);
+	}
+	tx->stmt_count--;
+	if (stailq_empty(&tx->log) && rlist_empty(&tx->tombstones))
 		rlist_del_entry(tx, in_writers);
 	tx->last_stmt_space = NULL;
 }
@@ -1103,7 +1244,8 @@ vy_tx_set_entry(struct vy_tx *tx, struct vy_lsm *lsm, struct vy_entry entry)
 	if (old == NULL && vy_stmt_type(entry.stmt) == IPROTO_INSERT)
 		v->is_first_insert = true;
 
-	if (lsm->index_id > 0 && old != NULL && !old->is_nop) {
+	if (lsm->index_id > 0 && !lsm->opts.covering &&
+	    old != NULL && !old->is_nop) {
 		/*
 		 * In a secondary index write set, DELETE statement purges
 		 * exactly one older statement so REPLACE + DELETE is no-op.
@@ -1113,6 +1255,9 @@ vy_tx_set_entry(struct vy_tx *tx, struct vy_lsm *lsm, struct vy_entry entry)
 		 * Therefore we can zap DELETE + REPLACE as there must be
 		 * an older REPLACE for the same key stored somewhere in the
 		 * index data.
+		 *
+		 * Covering indexes do store full tuples so this doesn't
+		 * apply to them.
 		 */
 		enum iproto_type type = vy_stmt_type(entry.stmt);
 		enum iproto_type old_type = vy_stmt_type(old->entry.stmt);
@@ -1139,6 +1284,56 @@ vy_tx_set(struct vy_tx *tx, struct vy_lsm *lsm, struct tuple *stmt)
 	return 0;
 }
 
+int
+vy_tx_delete_range(struct vy_tx *tx, struct vy_lsm *lsm, int64_t id,
+		   const char *begin, const char *end)
+{
+	assert(tx->state == VINYL_TX_READY);
+	assert(lsm->index_id == 0);
+	struct vy_tombstone *tombstone = vy_tombstone_new(lsm, id, INT64_MAX,
+				lsm->env->key_format, lsm->cmp_def, begin, end);
+	if (tombstone == NULL)
+		return -1;
+	tombstone->stmt_no = tx->stmt_count;
+	vy_lsm_ref(lsm);
+	rlist_add_tail_entry(&tx->tombstones, tombstone, in_tx);
+	return 0;
+}
+
+/**
+ * Return true if a transaction has a range tombstone for
+ * the given LSM tree.
+ */
+static bool
+vy_tx_has_tombstone(struct vy_tx *tx, struct vy_lsm *lsm)
+{
+	struct vy_tombstone *tombstone;
+	rlist_foreach_entry(tombstone, &tx->tombstones, in_tx) {
+		if (tombstone->lsm == lsm)
+			return true;
+	}
+	return false;
+}
+
+int64_t
+vy_tx_tombstone_lsn(struct vy_tx *tx, struct vy_lsm *lsm, int64_t vlsn,
+		    struct vy_entry entry)
+{
+	if (tx != NULL && tx->state == VINYL_TX_READY) {
+		struct vy_tombstone *tombstone;
+		rlist_foreach_entry(tombstone, &tx->tombstones, in_tx) {
+			if (tombstone->lsm == lsm &&
+			    vy_tombstone_covers(tombstone, entry,
+						lsm->cmp_def))
+				return INT64_MAX;
+		}
+	}
+	if (rlist_empty(&lsm->tombstones))
+		return 0;
+	return vy_tombstone_list_lsn(&lsm->tombstones, vlsn, entry,
+				     lsm->cmp_def);
+}
+
 void
 tx_manager_abort_writers_for_ddl(struct tx_manager *xm, struct space *space,
 				 bool *need_wal_sync)
@@ -1160,7 +1355,8 @@ tx_manager_abort_writers_for_ddl(struct tx_manager *xm, struct space *space,
 			continue;
 		if (tx->last_stmt_space == space ||
 		    write_set_search_key(&tx->write_set, lsm,
-					 lsm->env->empty_key) != NULL)
+					 lsm->env->empty_key) != NULL ||
+		    vy_tx_has_tombstone(tx, lsm))
 			vy_tx_abort(tx);
 	}
 }
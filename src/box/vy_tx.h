@@ -200,6 +200,16 @@ struct vy_tx {
 	int64_t psn;
 	/* List of triggers invoked when this transaction ends. */
 	struct rlist on_destroy;
+	/**
+	 * Range tombstones created by this transaction, linked
+	 * by vy_tombstone::in_tx, in the order of creation.
+	 */
+	struct rlist tombstones;
+	/**
+	 * Number of statements started by this transaction.
+	 * Used to find tombstones to drop on statement rollback.
+	 */
+	int stmt_count;
 };
 
 static inline const struct vy_read_view **
@@ -420,6 +430,40 @@ vy_tx_track_point(struct vy_tx *tx, struct vy_lsm *lsm, struct vy_entry entry);
 int
 vy_tx_set(struct vy_tx *tx, struct vy_lsm *lsm, struct tuple *stmt);
 
+/**
+ * Delete all keys falling in the range [begin, end) from
+ * a primary index by inserting a range tombstone into
+ * a transaction.
+ * @param tx           Transaction.
+ * @param lsm          LSM tree of the primary index.
+ * @param id           ID of the new tombstone.
+ * @param begin        MsgPack array of the lower bound, may be NULL.
+ * @param end          MsgPack array of the upper bound, may be NULL.
+ *
+ * Statements inserted by the transaction before the tombstone
+ * aren't deleted by it. The caller has to overwrite them.
+ *
+ * @retval  0 Success
+ * @retval -1 Memory allocation error.
+ */
+int
+vy_tx_delete_range(struct vy_tx *tx, struct vy_lsm *lsm, int64_t id,
+		   const char *begin, const char *end);
+
+/**
+ * Return the LSN of the newest range tombstone covering a key
+ * visible from a read view, INT64_MAX if the key is covered by
+ * a tombstone of the transaction itself, or 0 if it isn't
+ * covered by any tombstone.
+ * @param tx           Transaction, may be NULL.
+ * @param lsm          LSM tree the key is read from.
+ * @param vlsn         LSN of the read view.
+ * @param entry        Key.
+ */
+int64_t
+vy_tx_tombstone_lsn(struct vy_tx *tx, struct vy_lsm *lsm, int64_t vlsn,
+		    struct vy_entry entry);
+
 /**
  * Iterator over the write set of a transaction.
  */
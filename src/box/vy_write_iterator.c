@@ -32,6 +32,8 @@
 #include "vy_mem.h"
 #include "vy_run.h"
 #include "vy_upsert.h"
+#include "vy_blob.h"
+#include "vy_tombstone.h"
 #include "fiber.h"
 
 #define HEAP_FORWARD_DECLARATION
@@ -109,8 +111,13 @@ vy_write_history_new(struct vy_entry entry, struct vy_write_history *next)
 		return NULL;
 	}
 	h->entry = entry;
+	/*
+	 * A DELETE generated for a range tombstone has the same
+	 * LSN as statements written by the same transaction after
+	 * the tombstone, see optimization #7.
+	 */
 	assert(next == NULL || (next->entry.stmt != NULL &&
-	       vy_stmt_lsn(next->entry.stmt) > vy_stmt_lsn(entry.stmt)));
+	       vy_stmt_lsn(next->entry.stmt) >= vy_stmt_lsn(entry.stmt)));
 	h->next = next;
 	vy_stmt_ref_if_possible(entry.stmt);
 	return h;
@@ -189,6 +196,26 @@ struct vy_write_iterator {
 	 * of the old tuple from secondary indexes.
 	 */
 	struct vy_entry deferred_delete;
+	/**
+	 * Blob files referenced by statements of the sources
+	 * or NULL if there's no such statements.
+	 */
+	struct vy_blob_map *blob_map;
+	/** Set if tuples with an expired timestamp are discarded. */
+	bool has_ttl;
+	/** Number of the field storing tuple timestamp. */
+	uint32_t ttl_fieldno;
+	/** Tuples with a timestamp less than this one are expired. */
+	double ttl_deadline;
+	/**
+	 * Range tombstones applied to the output sorted by LSN
+	 * in ascending order, see vy_write_iterator_set_tombstones().
+	 */
+	const struct vy_tombstone *tombstones;
+	/** Number of entries in @tombstones. */
+	int tombstone_count;
+	/** Format of DELETE statements generated for tombstones. */
+	struct tuple_format *key_format;
 	/** Length of the @read_views. */
 	int rv_count;
 	/**
@@ -598,6 +625,129 @@ vy_write_iterator_pop_read_view_stmt(struct vy_write_iterator *stream)
 	return stream->last;
 }
 
+void
+vy_write_iterator_set_blob_map(struct vy_stmt_stream *vstream,
+			       struct vy_blob_map *map)
+{
+	struct vy_write_iterator *stream = (struct vy_write_iterator *)vstream;
+	stream->blob_map = map;
+}
+
+void
+vy_write_iterator_set_ttl(struct vy_stmt_stream *vstream, uint32_t fieldno,
+			  double deadline)
+{
+	struct vy_write_iterator *stream = (struct vy_write_iterator *)vstream;
+	assert(stream->is_primary);
+	stream->has_ttl = true;
+	stream->ttl_fieldno = fieldno;
+	stream->ttl_deadline = deadline;
+}
+
+void
+vy_write_iterator_set_tombstones(struct vy_stmt_stream *vstream,
+				 const struct vy_tombstone *tombstones,
+				 int count, struct tuple_format *key_format)
+{
+	struct vy_write_iterator *stream = (struct vy_write_iterator *)vstream;
+	assert(stream->is_primary);
+	stream->tombstones = tombstones;
+	stream->tombstone_count = count;
+	stream->key_format = key_format;
+}
+
+/**
+ * Return the max LSN of range tombstones covering the given key
+ * or 0 if there's no such tombstone, see optimization #7.
+ */
+static int64_t
+vy_write_iterator_tombstone_lsn(struct vy_write_iterator *stream,
+				struct vy_entry entry)
+{
+	for (int i = stream->tombstone_count - 1; i >= 0; i--) {
+		const struct vy_tombstone *tombstone = &stream->tombstones[i];
+		if (vy_tombstone_covers(tombstone, entry, stream->cmp_def))
+			return tombstone->lsn;
+	}
+	return 0;
+}
+
+/**
+ * Check if a tuple has expired and hence may be discarded,
+ * see vy_write_iterator_set_ttl().
+ */
+static bool
+vy_write_iterator_is_expired(struct vy_write_iterator *stream,
+			     struct tuple *stmt)
+{
+	assert(stream->has_ttl);
+	assert(vy_stmt_type(stmt) == IPROTO_REPLACE ||
+	       vy_stmt_type(stmt) == IPROTO_INSERT);
+	assert(!vy_stmt_is_key(stmt));
+	const char *field = tuple_field(stmt, stream->ttl_fieldno);
+	if (field == NULL)
+		return false;
+	double timestamp;
+	if (mp_read_double(&field, &timestamp) != 0)
+		return false;
+	return timestamp < stream->ttl_deadline;
+}
+
+/**
+ * Load values of a statement stored in blob files. If the
+ * statement doesn't refer to blob files, it is returned as is,
+ * otherwise the returned statement must be unreferenced by the
+ * caller. If @a keys_only is set, values are only loaded if
+ * some of them are indexed.
+ */
+static int
+vy_write_iterator_load_blob(struct vy_write_iterator *stream,
+			    struct vy_entry entry, bool keys_only,
+			    struct vy_entry *ret)
+{
+	*ret = entry;
+	if ((vy_stmt_flags(entry.stmt) & VY_STMT_BLOB) == 0)
+		return 0;
+	assert(stream->blob_map != NULL);
+	return vy_blob_map_load(stream->blob_map, entry.stmt, keys_only,
+				&ret->stmt);
+}
+
+/**
+ * Generate a deferred DELETE for an expired tuple discarded by
+ * optimization #6 so that the tuple is purged from secondary
+ * indexes, like an overwritten tuple.
+ *
+ * The DELETE gets the LSN following the tuple LSN so that it's
+ * newer than the tuple, but can't purge a newer version of the
+ * key written to secondary indexes, because statements with
+ * equal LSNs are merged in favor of a REPLACE, see heap_less().
+ */
+static int
+vy_write_iterator_expire(struct vy_write_iterator *stream,
+			 struct vy_entry entry)
+{
+	struct vy_deferred_delete_handler *handler =
+			stream->deferred_delete_handler;
+	if (handler == NULL)
+		return 0;
+	struct vy_entry old_entry;
+	if (vy_write_iterator_load_blob(stream, entry, true, &old_entry) != 0)
+		return -1;
+	int rc = -1;
+	struct tuple *delete = vy_stmt_dup(old_entry.stmt);
+	if (delete != NULL) {
+		vy_stmt_set_type(delete, IPROTO_DELETE);
+		vy_stmt_set_flags(delete, 0);
+		vy_stmt_set_lsn(delete, vy_stmt_lsn(entry.stmt) + 1);
+		rc = handler->iface->process(handler, old_entry.stmt, delete);
+		tuple_unref(delete);
+	}
+	if (old_entry.stmt != entry.stmt)
+		tuple_unref(old_entry.stmt);
+	return rc;
+}
+
 /**
  * Generate a DELETE statement for the given tuple if its
  * deletion from secondary indexes was deferred.
@@ -628,10 +778,32 @@ vy_write_iterator_deferred_delete(struct vy_write_iterator *stream,
 	if (stream->deferred_delete.stmt != NULL) {
 		struct vy_deferred_delete_handler *handler =
 				stream->deferred_delete_handler;
-		if (handler != NULL && vy_stmt_type(stmt) != IPROTO_DELETE &&
-		    handler->iface->process(handler, stmt,
-					    stream->deferred_delete.stmt) != 0)
-			return -1;
+		if (handler != NULL && vy_stmt_type(stmt) != IPROTO_DELETE) {
+			/*
+			 * The handler needs indexed fields, which may
+			 * be stored in blob files if a secondary index
+			 * was created after the values were moved.
+			 */
+			struct vy_entry old_entry, new_entry;
+			if (vy_write_iterator_load_blob(stream, entry, true,
+							&old_entry) != 0)
+				return -1;
+			if (vy_write_iterator_load_blob(stream,
+					stream->deferred_delete, true,
+					&new_entry) != 0) {
+				if (old_entry.stmt != stmt)
+					tuple_unref(old_entry.stmt);
+				return -1;
+			}
+			int rc = handler->iface->process(handler,
+					old_entry.stmt, new_entry.stmt);
+			if (old_entry.stmt != stmt)
+				tuple_unref(old_entry.stmt);
+			if (new_entry.stmt != stream->deferred_delete.stmt)
+				tuple_unref(new_entry.stmt);
+			if (rc != 0)
+				return -1;
+		}
 		vy_stmt_unref_if_possible(stream->deferred_delete.stmt);
 		stream->deferred_delete = vy_entry_none();
 	}
@@ -708,12 +880,45 @@ vy_write_iterator_build_history(struct vy_write_iterator *stream,
 	int current_rv_i = 0;
 	int64_t current_rv_lsn = vy_write_iterator_get_vlsn(stream, 0);
 	int64_t merge_until_lsn = vy_write_iterator_get_vlsn(stream, 1);
+	/*
+	 * LSN of the range tombstone covering the current key
+	 * and the DELETE generated for it, see optimization #7.
+	 */
+	int64_t tombstone_lsn = 0;
+	if (stream->tombstone_count > 0)
+		tombstone_lsn = vy_write_iterator_tombstone_lsn(stream,
+								src->entry);
+	struct tuple *tombstone_stmt = NULL;
 
 	while (true) {
-		*is_first_insert = vy_stmt_type(src->entry.stmt) == IPROTO_INSERT;
+		struct vy_entry entry = src->entry;
+		if (tombstone_stmt != NULL) {
+			tuple_unref(tombstone_stmt);
+			tombstone_stmt = NULL;
+		}
+		if (vy_stmt_lsn(entry.stmt) < tombstone_lsn) {
+			/*
+			 * This and all older statements are deleted
+			 * by a range tombstone. Insert a DELETE with
+			 * the tombstone LSN before them.
+			 */
+			tombstone_stmt = vy_stmt_new_delete_by_key(entry.stmt,
+					stream->cmp_def, stream->key_format);
+			if (tombstone_stmt == NULL) {
+				rc = -1;
+				break;
+			}
+			vy_stmt_set_lsn(tombstone_stmt, tombstone_lsn);
+			vy_stmt_set_flags(tombstone_stmt,
+					  VY_STMT_DEFERRED_DELETE);
+			entry.stmt = tombstone_stmt;
+			tombstone_lsn = 0;
+		}
+
+		*is_first_insert = vy_stmt_type(entry.stmt) == IPROTO_INSERT;
 
 		if (!stream->is_primary &&
-		    (vy_stmt_flags(src->entry.stmt) & VY_STMT_UPDATE) != 0) {
+		    (vy_stmt_flags(entry.stmt) & VY_STMT_UPDATE) != 0) {
 			/*
 			 * If a REPLACE stored in a secondary index was
 			 * generated by an update operation, it can be
@@ -734,12 +939,12 @@ vy_write_iterator_build_history(struct vy_write_iterator *stream,
 		 */
 		if (stream->is_primary) {
 			rc = vy_write_iterator_deferred_delete(stream,
-							       src->entry);
+							       entry);
 			if (rc != 0)
 				break;
 		}
 
-		if (vy_stmt_lsn(src->entry.stmt) > current_rv_lsn) {
+		if (vy_stmt_lsn(entry.stmt) > current_rv_lsn) {
 			/*
 			 * Skip statements invisible to the current read
 			 * view but older than the previous read view,
@@ -747,10 +952,10 @@ vy_write_iterator_build_history(struct vy_write_iterator *stream,
 			 */
 			goto next_lsn;
 		}
-		while (vy_stmt_lsn(src->entry.stmt) <= merge_until_lsn) {
+		while (vy_stmt_lsn(entry.stmt) <= merge_until_lsn) {
 			/*
 			 * Skip read views which see the same
-			 * version of the key, until src->entry is
+			 * version of the key, until entry is
 			 * between merge_until_lsn and
 			 * current_rv_lsn.
 			 */
@@ -766,13 +971,13 @@ vy_write_iterator_build_history(struct vy_write_iterator *stream,
 		 * @sa vy_write_iterator for details about this
 		 * and other optimizations.
 		 */
-		if (vy_stmt_type(src->entry.stmt) == IPROTO_DELETE &&
+		if (vy_stmt_type(entry.stmt) == IPROTO_DELETE &&
 		    stream->is_last_level && merge_until_lsn < 0) {
 			current_rv_lsn = -1; /* Force skip */
 			goto next_lsn;
 		}
 
-		rc = vy_write_iterator_push_rv(stream, src->entry,
+		rc = vy_write_iterator_push_rv(stream, entry,
 					       current_rv_i);
 		if (rc != 0)
 			break;
@@ -782,9 +987,9 @@ vy_write_iterator_build_history(struct vy_write_iterator *stream,
 		 * Optimization 2: skip statements overwritten
 		 * by a REPLACE or DELETE.
 		 */
-		if (vy_stmt_type(src->entry.stmt) == IPROTO_REPLACE ||
-		    vy_stmt_type(src->entry.stmt) == IPROTO_INSERT ||
-		    vy_stmt_type(src->entry.stmt) == IPROTO_DELETE) {
+		if (vy_stmt_type(entry.stmt) == IPROTO_REPLACE ||
+		    vy_stmt_type(entry.stmt) == IPROTO_INSERT ||
+		    vy_stmt_type(entry.stmt) == IPROTO_DELETE) {
 			current_rv_i++;
 			current_rv_lsn = merge_until_lsn;
 			merge_until_lsn =
@@ -792,6 +997,9 @@ vy_write_iterator_build_history(struct vy_write_iterator *stream,
 							   current_rv_i + 1);
 		}
 next_lsn:
+		/* Proceed to the statement the DELETE was inserted before. */
+		if (entry.stmt == tombstone_stmt)
+			continue;
 		rc = vy_write_iterator_merge_step(stream);
 		if (rc != 0)
 			break;
@@ -801,6 +1009,8 @@ next_lsn:
 		if (src->is_end_of_key)
 			break;
 	}
+	if (tombstone_stmt != NULL)
+		tuple_unref(tombstone_stmt);
 
 	/*
 	 * No point in keeping the last VY_STMT_DEFERRED_DELETE
@@ -875,9 +1085,16 @@ vy_read_view_merge(struct vy_write_iterator *stream, struct vy_entry prev,
 	     vy_stmt_type(prev.stmt) != IPROTO_UPSERT))) {
 		assert(!stream->is_last_level || prev.stmt == NULL ||
 		       vy_stmt_type(prev.stmt) != IPROTO_UPSERT);
+		struct vy_entry base = prev;
+		if (prev.stmt != NULL &&
+		    vy_write_iterator_load_blob(stream, prev, false,
+						&base) != 0)
+			return -1;
 		struct vy_entry applied;
-		applied = vy_entry_apply_upsert(h->entry, prev,
+		applied = vy_entry_apply_upsert(h->entry, base,
 						stream->cmp_def, false);
+		if (base.stmt != prev.stmt)
+			tuple_unref(base.stmt);
 		if (applied.stmt == NULL)
 			return -1;
 		vy_stmt_unref_if_possible(h->entry.stmt);
@@ -886,6 +1103,17 @@ vy_read_view_merge(struct vy_write_iterator *stream, struct vy_entry prev,
 	/* Squash the rest of UPSERTs. */
 	struct vy_write_history *result = h;
 	h = h->next;
+	if (h != NULL) {
+		/* UPSERTs can't be applied to blob references. */
+		struct vy_entry loaded;
+		if (vy_write_iterator_load_blob(stream, result->entry, false,
+						&loaded) != 0)
+			return -1;
+		if (loaded.stmt != result->entry.stmt) {
+			vy_stmt_unref_if_possible(result->entry.stmt);
+			result->entry = loaded;
+		}
+	}
 	while (h != NULL) {
 		assert(h->entry.stmt != NULL &&
 		       vy_stmt_type(h->entry.stmt) == IPROTO_UPSERT);
@@ -1045,6 +1273,26 @@ vy_write_iterator_build_read_views(struct vy_write_iterator *stream, int *count)
 		++*count;
 		prev = rv->entry;
 	}
+	/*
+	 * Optimization 6: discard an expired tuple if it is
+	 * the only version of the key that is left and it is
+	 * visible only to the current read view.
+	 */
+	rv = &stream->read_views[0];
+	if (stream->has_ttl && stream->is_last_level && *count == 1 &&
+	    rv->entry.stmt != NULL &&
+	    (vy_stmt_type(rv->entry.stmt) == IPROTO_REPLACE ||
+	     vy_stmt_type(rv->entry.stmt) == IPROTO_INSERT) &&
+	    vy_write_iterator_is_expired(stream, rv->entry.stmt)) {
+		if (vy_write_iterator_expire(stream, rv->entry) != 0) {
+			rc = -1;
+			goto cleanup;
+		}
+		vy_stmt_unref_if_possible(rv->entry.stmt);
+		rv->entry = vy_entry_none();
+		stream->rv_used_count--;
+		*count = 0;
+	}
 
 cleanup:
 	vy_write_iterator_history_destroy(stream, region, used);
@@ -190,6 +190,52 @@
  * also turn the first INSERT in the resulting key's history to a
  * REPLACE in case the oldest statement among all sources is not
  * an INSERT.
+ *
+ * ---------------------------------------------------------------
+ * Optimization #6: when merging the last level of the LSM tree,
+ * discard an expired tuple (see vy_write_iterator_set_ttl) if it
+ * is the only version of the key left in the output and it isn't
+ * visible to any read view except the current one:
+ *
+ *                 ---------------------------
+ *                 SAME KEY, MAJOR COMPACTION
+ *                 ---------------------------
+ *
+ * 0                          VLSN1          ...         INT64_MAX
+ * |                            |                            |
+ * | LSN1  LSN2   ...   DELETE  | LSNi  ...  EXPIRED REPLACE |
+ * \___________________________/ \___________________________/
+ *            skip                         discard
+ *
+ * Since there's no older version of the key on disk, dropping
+ * the tuple is equivalent to deleting it, but doesn't require
+ * a DELETE statement. The optimization is only applied to the
+ * primary index. Secondary indexes are purged of the tuple with
+ * a deferred DELETE passed to the deferred DELETE handler, like
+ * an overwritten tuple. Until the DELETE is compacted, a stale
+ * secondary index entry is skipped on read, because the tuple
+ * can't be found in the primary index anymore.
+ *
+ * ---------------------------------------------------------------
+ * Optimization #7: when merging a primary index, replace all
+ * statements deleted by a range tombstone (see vy_tombstone.h)
+ * with a DELETE having the tombstone LSN. The DELETE is then
+ * handled as if it was read from a source: it may be skipped by
+ * optimization #1 and it generates deferred DELETEs for secondary
+ * indexes. Statements visible to older read views are preserved.
+ *
+ *                         --------
+ *                         SAME KEY
+ *                         --------
+ *
+ * 0                VLSN1             TOMBSTONE LSN          INT64_MAX
+ * |                  |                     |                     |
+ * | LSN1  ...  LSNi  | LSNi+1  ...  LSNj   | LSNj+1  ...  LSN_N  |
+ * \________________/ \____________________/ \____________________/
+ *       merge          replace with DELETE          merge
+ *
+ * After the major compaction of all ranges intersecting the
+ * tombstone, the tombstone may be dropped.
  */
 
 struct vy_write_iterator;
@@ -199,6 +245,8 @@ struct tuple_format;
 struct tuple;
 struct vy_mem;
 struct vy_slice;
+struct vy_blob_map;
+struct vy_tombstone;
 
 /**
  * Callback invoked by the write iterator for tuples that were
@@ -268,5 +316,38 @@ vy_write_iterator_new_slice(struct vy_stmt_stream *stream,
 			    struct vy_slice *slice,
 			    struct tuple_format *disk_format);
 
+/**
+ * Set the map of blob files referenced by statements of the
+ * slices added to the iterator. It is used to load values of
+ * statements that need to be merged with UPSERTs or passed to
+ * the deferred DELETE handler (see vy_blob.h).
+ */
+void
+vy_write_iterator_set_blob_map(struct vy_stmt_stream *stream,
+			       struct vy_blob_map *map);
+
+/**
+ * Make the iterator discard tuples that have expired by the time
+ * @deadline, i.e. tuples storing a timestamp less than @deadline
+ * in field @fieldno. Tuples that don't have the field or store
+ * a value other than a number there never expire. May only be
+ * used for a primary index. See optimization #6 for details.
+ */
+void
+vy_write_iterator_set_ttl(struct vy_stmt_stream *stream, uint32_t fieldno,
+			  double deadline);
+
+/**
+ * Make the iterator apply range tombstones to the output of
+ * a primary index. The array must be sorted by LSN in ascending
+ * order and stay valid while the iterator is in use. DELETE
+ * statements generated for tombstones use @key_format. See
+ * optimization #7 for details.
+ */
+void
+vy_write_iterator_set_tombstones(struct vy_stmt_stream *stream,
+				 const struct vy_tombstone *tombstones,
+				 int count, struct tuple_format *key_format);
+
 #endif /* INCLUDES_TARANTOOL_BOX_VY_WRITE_STREAM_H */
 
@@ -54,6 +54,13 @@ enum {
 	 * latency. 1 MB seems to be a well balanced choice.
 	 */
 	WAL_FALLOCATE_LEN = 1024 * 1024,
+	/**
+	 * Add an entry to the sparse index of the current WAL
+	 * file every time it grows by this many bytes. The index
+	 * lets relays quickly find the position to start sending
+	 * rows from after a replica reconnects.
+	 */
+	WAL_INDEX_STEP = 1024 * 1024,
 };
 
 const char *wal_mode_STRS[] = { "none", "write", "fsync", NULL };
@@ -66,6 +73,9 @@ wal_write_async(struct journal *, struct journal_entry *);
 static int
 wal_write(struct journal *, struct journal_entry *);
 
+static int
+wal_wait_room(struct journal *);
+
 static int
 wal_write_none_async(struct journal *, struct journal_entry *);
 
@@ -418,9 +428,12 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 		       wall_async_cb,
 		       wal_mode == WAL_NONE ?
 		       wal_write_none : wal_write);
+	if (wal_mode != WAL_NONE)
+		writer->base.wait_room = wal_wait_room;
 
 	struct xlog_opts opts = xlog_opts_default;
 	opts.sync_is_async = true;
+	opts.index_step = WAL_INDEX_STEP;
 	xdir_create(&writer->wal_dir, wal_dirname, XLOG, instance_uuid, &opts);
 	xlog_clear(&writer->current_wal);
 	if (wal_mode == WAL_FSYNC)
@@ -762,6 +775,15 @@ wal_set_checkpoint_threshold(int64_t threshold)
 	fiber_set_cancellable(cancellable);
 }
 
+void
+wal_set_queue_max_len(int64_t max_len)
+{
+	struct wal_writer *writer = &wal_writer_singleton;
+	if (writer->wal_mode == WAL_NONE)
+		return;
+	cpipe_set_max_size(&writer->wal_pipe, max_len);
+}
+
 struct wal_gc_msg
 {
 	struct cbus_call_msg base;
@@ -1083,6 +1105,8 @@ wal_write_to_disk(struct cmsg *msg)
 	writer->checkpoint_wal_size += rc;
 	last_committed = stailq_last(&wal_msg->commit);
 	vclock_merge(&writer->vclock, &vclock_diff);
+	/* All rows written so far are covered by the WAL vclock. */
+	xlog_index_add(l, &writer->vclock);
 
 	/*
 	 * Notify TX if the checkpoint threshold has been exceeded.
@@ -1190,6 +1214,20 @@ wal_writer_f(va_list ap)
 	return 0;
 }
 
+/**
+ * If the WAL queue is bounded, wait until it has room. Called
+ * when a transaction starts rather than in wal_write_async(),
+ * because a transaction can't yield once it is prepared. So
+ * the queue limit is soft: transactions that started before
+ * the queue got full are still written.
+ */
+static int
+wal_wait_room(struct journal *journal)
+{
+	struct wal_writer *writer = (struct wal_writer *) journal;
+	return cpipe_wait_room(&writer->wal_pipe, TIMEOUT_INFINITY);
+}
+
 /**
  * WAL writer main entry point: queue a single request
  * to be written to disk.
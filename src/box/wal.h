@@ -230,6 +230,14 @@ wal_commit_checkpoint(struct wal_checkpoint *checkpoint);
 void
 wal_set_checkpoint_threshold(int64_t threshold);
 
+/**
+ * Limit the number of messages queued for the WAL thread.
+ * New transactions block on start while the queue is full.
+ * Pass 0 to make the queue unbounded.
+ */
+void
+wal_set_queue_max_len(int64_t max_len);
+
 /**
  * Remove WAL files that are not needed by consumers reading
  * rows at @vclock or newer.
@@ -95,6 +95,7 @@ const struct xlog_opts xlog_opts_default = {
 	.free_cache = false,
 	.sync_is_async = false,
 	.no_compression = false,
+	.index_step = 0,
 };
 
 /* {{{ struct xlog_meta */
@@ -653,7 +654,8 @@ xdir_format_filename(struct xdir *dir, int64_t signature,
 	return tt_snprintf(PATH_MAX, "%s/%020lld%s%s",
 			   dir->dirname, (long long) signature,
 			   dir->filename_ext, suffix == INPROGRESS ?
-					      inprogress_suffix : "");
+			   inprogress_suffix : suffix == INDEX ?
+			   index_suffix : "");
 }
 
 static void
@@ -682,10 +684,26 @@ xdir_collect_garbage(struct xdir *dir, int64_t signature, unsigned flags)
 	       vclock_sum(vclock) < signature) {
 		const char *filename =
 			xdir_format_filename(dir, vclock_sum(vclock), NONE);
+		/*
+		 * Removal of a big file may take long, so submit it
+		 * with the lowest priority in order not to delay
+		 * other coio tasks, see enum coio_pri.
+		 */
 		if (flags & XDIR_GC_ASYNC)
-			eio_unlink(filename, 0, xdir_complete_gc, NULL);
+			eio_unlink(filename, EIO_PRI_MIN,
+				   xdir_complete_gc, NULL);
 		else
 			xdir_say_gc(unlink(filename), errno, filename);
+		if (dir->type == XLOG) {
+			/* Remove the sparse index, if any. */
+			filename = xdir_format_filename(dir, vclock_sum(vclock),
+							INDEX);
+			if (flags & XDIR_GC_ASYNC)
+				eio_unlink(filename, EIO_PRI_MIN,
+					   xdir_complete_gc, NULL);
+			else
+				xdir_say_gc(unlink(filename), errno, filename);
+		}
 		vclockset_remove(&dir->index, vclock);
 		free(vclock);
 
@@ -768,6 +786,7 @@ xlog_init(struct xlog *xlog, const struct xlog_opts *opts)
 	xlog->opts = *opts;
 	xlog->sync_time = ev_monotonic_time();
 	xlog->is_autocommit = true;
+	xlog->index_fd = -1;
 	obuf_create(&xlog->obuf, &cord()->slabc, XLOG_TX_AUTOCOMMIT_THRESHOLD);
 	obuf_create(&xlog->zbuf, &cord()->slabc, XLOG_TX_AUTOCOMMIT_THRESHOLD);
 	if (!opts->no_compression) {
@@ -786,6 +805,7 @@ xlog_clear(struct xlog *l)
 {
 	memset(l, 0, sizeof(*l));
 	l->fd = -1;
+	l->index_fd = -1;
 }
 
 static void
@@ -796,8 +816,12 @@ xlog_destroy(struct xlog *xlog)
 	obuf_destroy(&xlog->obuf);
 	obuf_destroy(&xlog->zbuf);
 	ZSTD_freeCCtx(xlog->zctx);
+	ZSTD_freeCDict(xlog->zcdict);
+	if (xlog->index_fd >= 0)
+		close(xlog->index_fd);
 	TRASH(xlog);
 	xlog->fd = -1;
+	xlog->index_fd = -1;
 }
 
 int
@@ -1108,8 +1132,12 @@ xlog_tx_write_zstd(struct xlog *log)
 
 	uint32_t crc32c = 0;
 	struct iovec *iov;
-	/* 3 is compression level. */
-	ZSTD_compressBegin(log->zctx, 3);
+	if (log->zcdict != NULL) {
+		ZSTD_compressBegin_usingCDict(log->zctx, log->zcdict);
+	} else {
+		/* 3 is compression level. */
+		ZSTD_compressBegin(log->zctx, 3);
+	}
 	size_t offset = XLOG_FIXHEADER_SIZE;
 	for (iov = log->obuf.iov; iov->iov_len; ++iov) {
 		/* Estimate max output buffer size. */
@@ -1277,6 +1305,23 @@ xlog_tx_write(struct xlog *log)
 	return written;
 }
 
+int
+xlog_set_dict(struct xlog *log, const void *dict, size_t dict_size)
+{
+	if (log->opts.no_compression)
+		return 0;
+	/* 3 is compression level. */
+	ZSTD_CDict *zcdict = ZSTD_createCDict(dict, dict_size, 3);
+	if (zcdict == NULL) {
+		diag_set(ClientError, ER_COMPRESSION,
+			 "failed to create dictionary");
+		return -1;
+	}
+	ZSTD_freeCDict(log->zcdict);
+	log->zcdict = zcdict;
+	return 0;
+}
+
 /*
  * Add a row to a log and possibly flush the log.
  *
@@ -1392,6 +1437,45 @@ xlog_flush(struct xlog *log)
 	return xlog_tx_write(log);
 }
 
+void
+xlog_index_add(struct xlog *l, const struct vclock *vclock)
+{
+	if (l->opts.index_step == 0 || l->is_inprogress ||
+	    (uint64_t)(l->offset - l->index_offset) < l->opts.index_step)
+		return;
+	if (l->index_fd < 0) {
+		/*
+		 * Truncate the index on open: if the log was
+		 * reopened for appending, it might have been cut
+		 * short after a write error, in which case stale
+		 * entries could point beyond its end.
+		 */
+		char path[PATH_MAX];
+		snprintf(path, sizeof(path), "%s%s", l->filename, index_suffix);
+		l->index_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC |
+				   O_APPEND, 0644);
+		if (l->index_fd < 0) {
+			say_syserror("%s: failed to create index", path);
+			goto fail;
+		}
+	}
+	const char *line = tt_sprintf("%lld %s\n", (long long)l->offset,
+				      vclock_to_string(vclock));
+	if (fio_writen(l->index_fd, line, strlen(line)) < 0) {
+		say_syserror("%s: failed to write index", l->filename);
+		goto fail;
+	}
+	l->index_offset = l->offset;
+	return;
+fail:
+	if (l->index_fd >= 0) {
+		close(l->index_fd);
+		l->index_fd = -1;
+	}
+	/* Don't try again, the index would have holes. */
+	l->opts.index_step = 0;
+}
+
 static int
 sync_cb(eio_req *req)
 {
@@ -1415,7 +1499,7 @@ xlog_sync(struct xlog *l)
 			say_syserror("%s: dup() failed", l->filename);
 			return -1;
 		}
-		eio_fsync(fd, 0, sync_cb, (void *) (intptr_t) fd);
+		eio_fsync(fd, EIO_PRI_MIN, sync_cb, (void *) (intptr_t) fd);
 	} else if (fsync(l->fd) < 0) {
 		say_syserror("%s: fsync failed", l->filename);
 		return -1;
@@ -1488,6 +1572,10 @@ xlog_atfork(struct xlog *xlog)
 	 */
 	close(xlog->fd);
 	xlog->fd = -1;
+	if (xlog->index_fd >= 0) {
+		close(xlog->index_fd);
+		xlog->index_fd = -1;
+	}
 }
 
 /* }}} */
@@ -1663,7 +1751,8 @@ xlog_fixheader_decode(struct xlog_fixheader *fixheader,
 
 int
 xlog_tx_decode(const char *data, const char *data_end,
-	       char *rows, char *rows_end, ZSTD_DStream *zdctx)
+	       char *rows, char *rows_end, ZSTD_DStream *zdctx,
+	       const ZSTD_DDict *ddict)
 {
 	/* Decode fixheader */
 	struct xlog_fixheader fixheader;
@@ -1702,7 +1791,10 @@ xlog_tx_decode(const char *data, const char *data_end,
 
 	/* Decompress zstd rows */
 	assert(fixheader.magic == zrow_marker);
-	ZSTD_initDStream(zdctx);
+	if (ddict != NULL)
+		ZSTD_initDStream_usingDDict(zdctx, ddict);
+	else
+		ZSTD_initDStream(zdctx);
 	int rc = xlog_cursor_decompress(&rows, rows_end, &data, data_end,
 					zdctx);
 	if (rc < 0) {
@@ -1845,6 +1937,99 @@ xlog_cursor_find_tx_magic(struct xlog_cursor *i)
 	return 0;
 }
 
+enum {
+	/** Don't bother loading sparse index files bigger than that. */
+	XLOG_INDEX_SIZE_MAX = 16 * 1024 * 1024,
+};
+
+/**
+ * Look up the offset of the last sparse index entry of the file
+ * opened by the given cursor that is covered by @vclock.
+ * Returns 0 if there's no suitable entry.
+ */
+static off_t
+xlog_cursor_index_lookup(struct xlog_cursor *i, const struct vclock *vclock)
+{
+	char path[PATH_MAX];
+	snprintf(path, sizeof(path), "%s%s", i->name, index_suffix);
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		if (errno != ENOENT)
+			say_syserror("%s: failed to open index", path);
+		return 0;
+	}
+	off_t result = 0;
+	char *buf = NULL;
+	struct stat st;
+	if (fstat(fd, &st) < 0) {
+		say_syserror("%s: failed to stat index", path);
+		goto out;
+	}
+	if (st.st_size == 0 || st.st_size > XLOG_INDEX_SIZE_MAX)
+		goto out;
+	buf = malloc(st.st_size + 1);
+	if (buf == NULL)
+		goto out;
+	ssize_t size = fio_pread(fd, buf, st.st_size, 0);
+	if (size < 0) {
+		say_syserror("%s: failed to read index", path);
+		goto out;
+	}
+	buf[size] = '\0';
+	off_t prev_offset = 0;
+	char *line = buf;
+	char *eol;
+	/* A line without the trailing newline may be torn, skip it. */
+	while ((eol = strchr(line, '\n')) != NULL) {
+		*eol = '\0';
+		char *end;
+		long long offset = strtoll(line, &end, 10);
+		struct vclock entry;
+		vclock_create(&entry);
+		if (end == line || *end != ' ' || offset <= prev_offset ||
+		    vclock_from_string(&entry, end + 1) != 0) {
+			say_warn("%s: invalid index entry '%s'", path, line);
+			break;
+		}
+		/*
+		 * Index entries are written in the order of
+		 * growing vclocks so once an entry isn't covered
+		 * by @vclock, none of the following ones is.
+		 */
+		if (vclock_compare(&entry, vclock) > 0)
+			break;
+		prev_offset = result = offset;
+		line = eol + 1;
+	}
+out:
+	free(buf);
+	close(fd);
+	return result;
+}
+
+void
+xlog_cursor_skip_to(struct xlog_cursor *i, const struct vclock *vclock)
+{
+	if (i->state != XLOG_CURSOR_ACTIVE || i->fd < 0)
+		return;
+	off_t offset = xlog_cursor_index_lookup(i, vclock);
+	if (offset <= xlog_cursor_pos(i))
+		return;
+	/* Make sure the entry does point to a transaction. */
+	log_magic_t magic;
+	if (fio_pread(i->fd, &magic, sizeof(magic), offset) != sizeof(magic) ||
+	    (magic != row_marker && magic != zrow_marker)) {
+		say_warn("%s: index entry points to garbage at offset %lld",
+			 i->name, (long long)offset);
+		return;
+	}
+	say_verbose("%s: skipping %lld bytes covered by %s", i->name,
+		    (long long)(offset - xlog_cursor_pos(i)),
+		    vclock_to_string(vclock));
+	ibuf_reset(&i->rbuf);
+	i->read_offset = offset;
+}
+
 int
 xlog_cursor_next_tx(struct xlog_cursor *i)
 {
@@ -82,6 +82,16 @@ struct xlog_opts {
 	 * to be read frequently, e.g. L1 run files in Vinyl.
 	 */
 	bool no_compression;
+	/**
+	 * If greater than 0, the writer maintains a sparse index
+	 * of the file, adding an entry whenever the file grows
+	 * by this many bytes, see xlog_index_add().
+	 *
+	 * This option is useful for WAL files as it allows
+	 * replication relays to skip rows already received by
+	 * the replica without reading them.
+	 */
+	uint64_t index_step;
 };
 
 extern const struct xlog_opts xlog_opts_default;
@@ -104,13 +114,19 @@ enum xdir_type {
  * The suffix is removed  when the file is finished
  * and closed.
  */
-enum log_suffix { NONE, INPROGRESS };
+enum log_suffix { NONE, INPROGRESS, INDEX };
 
 /**
  * Suffix added to path of inprogress files.
  */
 #define inprogress_suffix ".inprogress"
 
+/**
+ * Suffix added to path of xlog files to get the path of
+ * their sparse index, see xlog_index_add().
+ */
+#define index_suffix ".index"
+
 /**
  * A handle for a data directory with write ahead logs, snapshots,
  * vylogs.
@@ -383,6 +399,11 @@ struct xlog {
 	struct obuf obuf;
 	/** The context of zstd compression */
 	ZSTD_CCtx *zctx;
+	/**
+	 * Digested dictionary used for compression of all
+	 * transactions written after xlog_set_dict(), or NULL.
+	 */
+	ZSTD_CDict *zcdict;
 	/**
 	 * Compressed output buffer
 	 */
@@ -393,6 +414,10 @@ struct xlog {
 	uint64_t synced_size;
 	/** Time when xlog wast synced last time */
 	double sync_time;
+	/** Sparse index file handle, -1 if not open. */
+	int index_fd;
+	/** File offset stored in the last sparse index entry. */
+	off_t index_offset;
 };
 
 /**
@@ -492,6 +517,19 @@ xlog_rename(struct xlog *l);
 ssize_t
 xlog_fallocate(struct xlog *log, size_t size);
 
+/**
+ * Compress all transactions written to the xlog from now on
+ * with the given zstd dictionary. The dictionary is copied.
+ * Does nothing if the xlog was created with compression
+ * disabled. Note, a reader must use the same dictionary to
+ * decode the transactions, see xlog_tx_decode().
+ *
+ * @retval  0 success
+ * @retval -1 error, check diag
+ */
+int
+xlog_set_dict(struct xlog *log, const void *dict, size_t dict_size);
+
 /**
  * Write a row to xlog, 
  *
@@ -530,6 +568,20 @@ xlog_tx_rollback(struct xlog *log);
 ssize_t
 xlog_flush(struct xlog *log);
 
+/**
+ * Add an entry to the sparse index of the file, telling
+ * readers that all rows written before the current end of
+ * the file are covered by @vclock, provided the file has
+ * grown by xlog_opts::index_step bytes since the last entry.
+ *
+ * The index is stored in a separate text file next to the
+ * log, one "<offset> <vclock>" line per entry. It is merely
+ * a hint so errors are logged and disable the index rather
+ * than fail the write.
+ */
+void
+xlog_index_add(struct xlog *l, const struct vclock *vclock);
+
 
 /**
  * Sync a log file. The exact action is defined
@@ -619,13 +671,15 @@ xlog_tx_cursor_pos(struct xlog_tx_cursor *tx_cursor)
  * @param data_end the end of @a data buffer
  * @param[out] rows a buffer to store decoded rows
  * @param[out] rows_end the end of @a rows buffer
+ * @param zdctx decompression context
+ * @param ddict dictionary the tx was compressed with or NULL
  * @retval  0 success
  * @retval -1 error, check diag
  */
 int
 xlog_tx_decode(const char *data, const char *data_end,
 	       char *rows, char *rows_end,
-	       ZSTD_DStream *zdctx);
+	       ZSTD_DStream *zdctx, const ZSTD_DDict *ddict);
 
 /* }}} */
 
@@ -774,6 +828,16 @@ xlog_cursor_next(struct xlog_cursor *cursor,
 int
 xlog_cursor_find_tx_magic(struct xlog_cursor *i);
 
+/**
+ * Use the sparse index of the file, if there's one, to skip
+ * transactions consisting only of rows covered by @vclock.
+ * Must be called before reading the first transaction.
+ * The index is merely a hint: if it's missing or invalid,
+ * the cursor stays where it is.
+ */
+void
+xlog_cursor_skip_to(struct xlog_cursor *i, const struct vclock *vclock);
+
 /**
  * Cursor xlog position
  *
@@ -1223,25 +1223,31 @@ err:
 int
 xrow_encode_register(struct xrow_header *row,
 		     const struct tt_uuid *instance_uuid,
-		     const struct vclock *vclock)
+		     const struct vclock *vclock, bool compression)
 {
 	memset(row, 0, sizeof(*row));
-	size_t size = mp_sizeof_map(2) +
+	size_t size = mp_sizeof_map(3) +
 		      mp_sizeof_uint(IPROTO_INSTANCE_UUID) +
 		      mp_sizeof_str(UUID_STR_LEN) +
 		      mp_sizeof_uint(IPROTO_VCLOCK) +
-		      mp_sizeof_vclock_ignore0(vclock);
+		      mp_sizeof_vclock_ignore0(vclock) +
+		      mp_sizeof_uint(IPROTO_COMPRESSION) +
+		      mp_sizeof_bool(compression);
 	char *buf = (char *) region_alloc(&fiber()->gc, size);
 	if (buf == NULL) {
 		diag_set(OutOfMemory, size, "region_alloc", "buf");
 		return -1;
 	}
 	char *data = buf;
-	data = mp_encode_map(data, 2);
+	data = mp_encode_map(data, compression ? 3 : 2);
 	data = mp_encode_uint(data, IPROTO_INSTANCE_UUID);
 	data = xrow_encode_uuid(data, instance_uuid);
 	data = mp_encode_uint(data, IPROTO_VCLOCK);
 	data = mp_encode_vclock_ignore0(data, vclock);
+	if (compression) {
+		data = mp_encode_uint(data, IPROTO_COMPRESSION);
+		data = mp_encode_bool(data, true);
+	}
 	assert(data <= buf + size);
 	row->body[0].iov_base = buf;
 	row->body[0].iov_len = (data - buf);
@@ -1255,7 +1261,7 @@ xrow_encode_subscribe(struct xrow_header *row,
 		      const struct tt_uuid *replicaset_uuid,
 		      const struct tt_uuid *instance_uuid,
 		      const struct vclock *vclock, bool anon,
-		      uint32_t id_filter)
+		      uint32_t id_filter, bool compression)
 {
 	memset(row, 0, sizeof(*row));
 	size_t size = XROW_BODY_LEN_MAX +
@@ -1267,7 +1273,7 @@ xrow_encode_subscribe(struct xrow_header *row,
 	}
 	char *data = buf;
 	int filter_size = bit_count_u32(id_filter);
-	data = mp_encode_map(data, filter_size != 0 ? 6 : 5);
+	data = mp_encode_map(data, 5 + (filter_size != 0) + compression);
 	data = mp_encode_uint(data, IPROTO_CLUSTER_UUID);
 	data = xrow_encode_uuid(data, replicaset_uuid);
 	data = mp_encode_uint(data, IPROTO_INSTANCE_UUID);
@@ -1289,6 +1295,10 @@ xrow_encode_subscribe(struct xrow_header *row,
 			data = mp_encode_uint(data, id);
 		}
 	}
+	if (compression) {
+		data = mp_encode_uint(data, IPROTO_COMPRESSION);
+		data = mp_encode_bool(data, true);
+	}
 	assert(data <= buf + size);
 	row->body[0].iov_base = buf;
 	row->body[0].iov_len = (data - buf);
@@ -1301,7 +1311,7 @@ int
 xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 		      struct tt_uuid *instance_uuid, struct vclock *vclock,
 		      uint32_t *version_id, bool *anon,
-		      uint32_t *id_filter)
+		      uint32_t *id_filter, bool *compression)
 {
 	if (row->bodycnt == 0) {
 		diag_set(ClientError, ER_INVALID_MSGPACK, "request body");
@@ -1321,6 +1331,8 @@ xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 		*anon = false;
 	if (id_filter)
 		*id_filter = 0;
+	if (compression)
+		*compression = false;
 	d = data;
 	uint32_t map_size = mp_decode_map(&d);
 	for (uint32_t i = 0; i < map_size; i++) {
@@ -1396,6 +1408,16 @@ id_filter_decode_err:		xrow_on_decode_err(data, end, ER_INVALID_MSGPACK,
 				*id_filter |= 1 << val;
 			}
 			break;
+		case IPROTO_COMPRESSION:
+			if (compression == NULL)
+				goto skip;
+			if (mp_typeof(*d) != MP_BOOL) {
+				xrow_on_decode_err(data, end, ER_INVALID_MSGPACK,
+						   "invalid COMPRESSION flag");
+				return -1;
+			}
+			*compression = mp_decode_bool(&d);
+			break;
 		default: skip:
 			mp_next(&d); /* value */
 		}
@@ -1404,7 +1426,8 @@ id_filter_decode_err:		xrow_on_decode_err(data, end, ER_INVALID_MSGPACK,
 }
 
 int
-xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid)
+xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid,
+		 bool compression)
 {
 	memset(row, 0, sizeof(*row));
 
@@ -1415,10 +1438,14 @@ xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid)
 		return -1;
 	}
 	char *data = buf;
-	data = mp_encode_map(data, 1);
+	data = mp_encode_map(data, compression ? 2 : 1);
 	data = mp_encode_uint(data, IPROTO_INSTANCE_UUID);
 	/* Greet the remote replica with our replica UUID */
 	data = xrow_encode_uuid(data, instance_uuid);
+	if (compression) {
+		data = mp_encode_uint(data, IPROTO_COMPRESSION);
+		data = mp_encode_bool(data, true);
+	}
 	assert(data <= buf + size);
 
 	row->body[0].iov_base = buf;
@@ -1428,6 +1455,35 @@ xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid)
 	return 0;
 }
 
+int
+xrow_encode_fetch_snapshot(struct xrow_header *row, bool compression)
+{
+	memset(row, 0, sizeof(*row));
+	row->type = IPROTO_FETCH_SNAPSHOT;
+	/*
+	 * The request body is optional, older masters
+	 * ignore it.
+	 */
+	if (!compression)
+		return 0;
+	size_t size = mp_sizeof_map(1) + mp_sizeof_uint(IPROTO_COMPRESSION) +
+		      mp_sizeof_bool(true);
+	char *buf = (char *) region_alloc(&fiber()->gc, size);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, size, "region_alloc", "buf");
+		return -1;
+	}
+	char *data = buf;
+	data = mp_encode_map(data, 1);
+	data = mp_encode_uint(data, IPROTO_COMPRESSION);
+	data = mp_encode_bool(data, true);
+	assert(data <= buf + size);
+	row->body[0].iov_base = buf;
+	row->body[0].iov_len = (data - buf);
+	row->bodycnt = 1;
+	return 0;
+}
+
 int
 xrow_encode_vclock(struct xrow_header *row, const struct vclock *vclock)
 {
@@ -306,6 +306,7 @@ xrow_encode_vote(struct xrow_header *row);
  * @param[out] Row.
  * @param instance_uuid Instance uuid.
  * @param vclock Replication clock.
+ * @param compression Whether the replica accepts compressed rows.
  *
  * @retval 0 Success.
  * @retval -1 Memory error.
@@ -313,7 +314,7 @@ xrow_encode_vote(struct xrow_header *row);
 int
 xrow_encode_register(struct xrow_header *row,
 		     const struct tt_uuid *instance_uuid,
-		     const struct vclock *vclock);
+		     const struct vclock *vclock, bool compression);
 
 /**
  * Encode SUBSCRIBE command.
@@ -324,6 +325,7 @@ xrow_encode_register(struct xrow_header *row,
  * @param anon Whether it is an anonymous subscribe request or not.
  * @param id_filter A List of replica ids to skip rows from
  *		    when feeding a replica.
+ * @param compression Whether the replica accepts compressed rows.
  *
  * @retval  0 Success.
  * @retval -1 Memory error.
@@ -333,7 +335,7 @@ xrow_encode_subscribe(struct xrow_header *row,
 		      const struct tt_uuid *replicaset_uuid,
 		      const struct tt_uuid *instance_uuid,
 		      const struct vclock *vclock, bool anon,
-		      uint32_t id_filter);
+		      uint32_t id_filter, bool compression);
 
 /**
  * Decode SUBSCRIBE command.
@@ -345,6 +347,8 @@ xrow_encode_subscribe(struct xrow_header *row,
  * @param[out] anon Whether it is an anonymous subscribe.
  * @param[out] id_filter A list of ids to skip rows from when
  *			 feeding a replica.
+ * @param[out] compression Whether the replica accepts compressed
+ *			   rows.
  *
  * @retval  0 Success.
  * @retval -1 Memory or format error.
@@ -353,32 +357,69 @@ int
 xrow_decode_subscribe(struct xrow_header *row, struct tt_uuid *replicaset_uuid,
 		      struct tt_uuid *instance_uuid, struct vclock *vclock,
 		      uint32_t *version_id, bool *anon,
-		      uint32_t *id_filter);
+		      uint32_t *id_filter, bool *compression);
 
 /**
  * Encode JOIN command.
  * @param[out] row Row to encode into.
  * @param instance_uuid.
+ * @param compression Whether the replica accepts compressed rows.
  *
  * @retval  0 Success.
  * @retval -1 Memory error.
  */
 int
-xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid);
+xrow_encode_join(struct xrow_header *row, const struct tt_uuid *instance_uuid,
+		 bool compression);
 
 /**
  * Decode JOIN command.
  * @param row Row to decode.
  * @param[out] instance_uuid.
+ * @param[out] compression Whether the replica accepts compressed
+ *			   rows.
  *
  * @retval  0 Success.
  * @retval -1 Memory or format error.
  */
 static inline int
-xrow_decode_join(struct xrow_header *row, struct tt_uuid *instance_uuid)
+xrow_decode_join(struct xrow_header *row, struct tt_uuid *instance_uuid,
+		 bool *compression)
 {
 	return xrow_decode_subscribe(row, NULL, instance_uuid, NULL, NULL, NULL,
-				     NULL);
+				     NULL, compression);
+}
+
+/**
+ * Encode FETCH_SNAPSHOT command.
+ * @param[out] row Row to encode into.
+ * @param compression Whether the replica accepts compressed rows.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+int
+xrow_encode_fetch_snapshot(struct xrow_header *row, bool compression);
+
+/**
+ * Decode FETCH_SNAPSHOT command.
+ * @param row Row to decode.
+ * @param[out] compression Whether the replica accepts compressed
+ *			   rows.
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory or format error.
+ */
+static inline int
+xrow_decode_fetch_snapshot(struct xrow_header *row, bool *compression)
+{
+	/* Older replicas send FETCH_SNAPSHOT without body. */
+	if (row->bodycnt == 0) {
+		*compression = false;
+		return 0;
+	}
+	return xrow_decode_subscribe(row, NULL, NULL, NULL, NULL, NULL,
+				     NULL, compression);
 }
 
 /**
@@ -386,15 +427,17 @@ xrow_decode_join(struct xrow_header *row, struct tt_uuid *instance_uuid)
  * @param row Row to decode.
  * @param[out] instance_uuid Instance uuid.
  * @param[out] vclock Instance vclock.
+ * @param[out] compression Whether the replica accepts compressed
+ *			   rows.
  * @retval 0 Success.
  * @retval -1 Memory or format error.
  */
 static inline int
 xrow_decode_register(struct xrow_header *row, struct tt_uuid *instance_uuid,
-		     struct vclock *vclock)
+		     struct vclock *vclock, bool *compression)
 {
 	return xrow_decode_subscribe(row, NULL, instance_uuid, vclock, NULL,
-				     NULL, NULL);
+				     NULL, NULL, compression);
 }
 
 /**
@@ -419,7 +462,8 @@ xrow_encode_vclock(struct xrow_header *row, const struct vclock *vclock);
 static inline int
 xrow_decode_vclock(struct xrow_header *row, struct vclock *vclock)
 {
-	return xrow_decode_subscribe(row, NULL, NULL, vclock, NULL, NULL, NULL);
+	return xrow_decode_subscribe(row, NULL, NULL, vclock, NULL, NULL, NULL,
+				     NULL);
 }
 
 /**
@@ -451,7 +495,7 @@ xrow_decode_subscribe_response(struct xrow_header *row,
 			       struct vclock *vclock)
 {
 	return xrow_decode_subscribe(row, replicaset_uuid, NULL, vclock, NULL,
-				     NULL, NULL);
+				     NULL, NULL, NULL);
 }
 
 /**
@@ -815,9 +859,10 @@ xrow_decode_ballot_xc(struct xrow_header *row, struct ballot *ballot)
 static inline void
 xrow_encode_register_xc(struct xrow_header *row,
 		       const struct tt_uuid *instance_uuid,
-		       const struct vclock *vclock)
+		       const struct vclock *vclock, bool compression)
 {
-	if (xrow_encode_register(row, instance_uuid, vclock) != 0)
+	if (xrow_encode_register(row, instance_uuid, vclock,
+				 compression) != 0)
 		diag_raise();
 }
 
@@ -827,10 +872,10 @@ xrow_encode_subscribe_xc(struct xrow_header *row,
 			 const struct tt_uuid *replicaset_uuid,
 			 const struct tt_uuid *instance_uuid,
 			 const struct vclock *vclock, bool anon,
-			 uint32_t id_filter)
+			 uint32_t id_filter, bool compression)
 {
 	if (xrow_encode_subscribe(row, replicaset_uuid, instance_uuid,
-				  vclock, anon, id_filter) != 0)
+				  vclock, anon, id_filter, compression) != 0)
 		diag_raise();
 }
 
@@ -840,37 +885,54 @@ xrow_decode_subscribe_xc(struct xrow_header *row,
 			 struct tt_uuid *replicaset_uuid,
 			 struct tt_uuid *instance_uuid, struct vclock *vclock,
 			 uint32_t *replica_version_id, bool *anon,
-			 uint32_t *id_filter)
+			 uint32_t *id_filter, bool *compression)
 {
 	if (xrow_decode_subscribe(row, replicaset_uuid, instance_uuid,
 				  vclock, replica_version_id, anon,
-				  id_filter) != 0)
+				  id_filter, compression) != 0)
 		diag_raise();
 }
 
 /** @copydoc xrow_encode_join. */
 static inline void
 xrow_encode_join_xc(struct xrow_header *row,
-		    const struct tt_uuid *instance_uuid)
+		    const struct tt_uuid *instance_uuid, bool compression)
 {
-	if (xrow_encode_join(row, instance_uuid) != 0)
+	if (xrow_encode_join(row, instance_uuid, compression) != 0)
 		diag_raise();
 }
 
 /** @copydoc xrow_decode_join. */
 static inline void
-xrow_decode_join_xc(struct xrow_header *row, struct tt_uuid *instance_uuid)
+xrow_decode_join_xc(struct xrow_header *row, struct tt_uuid *instance_uuid,
+		    bool *compression)
+{
+	if (xrow_decode_join(row, instance_uuid, compression) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_encode_fetch_snapshot. */
+static inline void
+xrow_encode_fetch_snapshot_xc(struct xrow_header *row, bool compression)
+{
+	if (xrow_encode_fetch_snapshot(row, compression) != 0)
+		diag_raise();
+}
+
+/** @copydoc xrow_decode_fetch_snapshot. */
+static inline void
+xrow_decode_fetch_snapshot_xc(struct xrow_header *row, bool *compression)
 {
-	if (xrow_decode_join(row, instance_uuid) != 0)
+	if (xrow_decode_fetch_snapshot(row, compression) != 0)
 		diag_raise();
 }
 
 /** @copydoc xrow_decode_register. */
 static inline void
 xrow_decode_register_xc(struct xrow_header *row, struct tt_uuid *instance_uuid,
-			struct vclock *vclock)
+			struct vclock *vclock, bool *compression)
 {
-	if (xrow_decode_register(row, instance_uuid, vclock) != 0)
+	if (xrow_decode_register(row, instance_uuid, vclock, compression) != 0)
 		diag_raise();
 }
 
@@ -0,0 +1,389 @@
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "xrow_compress.h"
+
+#include <msgpuck.h>
+
+#include "coio_task.h"
+#include "fiber.h"
+#include "error.h"
+#include "iproto_constants.h"
+#include "xrow.h"
+
+int
+xrow_compressor_create(struct xrow_compressor *c, int level)
+{
+	memset(c, 0, sizeof(*c));
+	c->zctx = ZSTD_createCStream();
+	if (c->zctx == NULL) {
+		diag_set(OutOfMemory, 0, "ZSTD_createCStream",
+			 "zstd context");
+		return -1;
+	}
+	size_t rc = ZSTD_initCStream(c->zctx, level);
+	if (ZSTD_isError(rc)) {
+		diag_set(ClientError, ER_COMPRESSION, ZSTD_getErrorName(rc));
+		ZSTD_freeCStream(c->zctx);
+		return -1;
+	}
+	return 0;
+}
+
+void
+xrow_compressor_destroy(struct xrow_compressor *c)
+{
+	ZSTD_freeCStream(c->zctx);
+	free(c->buf);
+	TRASH(c);
+}
+
+/**
+ * Make sure there's at least @size bytes available in
+ * the compressor output buffer.
+ */
+static int
+xrow_compressor_reserve(struct xrow_compressor *c, size_t size)
+{
+	if (c->used + size <= c->capacity)
+		return 0;
+	size_t capacity = MAX(c->capacity * 2, c->used + size);
+	char *buf = realloc(c->buf, capacity);
+	if (buf == NULL) {
+		diag_set(OutOfMemory, capacity, "realloc",
+			 "compression buffer");
+		return -1;
+	}
+	c->buf = buf;
+	c->capacity = capacity;
+	return 0;
+}
+
+int
+xrow_compressor_add(struct xrow_compressor *c, const struct xrow_header *row)
+{
+	struct iovec iov[XROW_IOVMAX];
+	int iovcnt = xrow_to_iovec(row, iov);
+	if (iovcnt < 0)
+		return -1;
+	return xrow_compressor_add_iov(c, iov, iovcnt);
+}
+
+int
+xrow_compressor_add_iov(struct xrow_compressor *c, const struct iovec *iov,
+			int iovcnt)
+{
+	/* Discard the data sent on the last flush. */
+	if (c->pending == 0)
+		c->used = 0;
+	for (int i = 0; i < iovcnt; i++) {
+		ZSTD_inBuffer input = {iov[i].iov_base, iov[i].iov_len, 0};
+		while (input.pos < input.size) {
+			if (xrow_compressor_reserve(c,
+					ZSTD_CStreamOutSize()) != 0)
+				return -1;
+			ZSTD_outBuffer output = {c->buf + c->used,
+						 c->capacity - c->used, 0};
+			size_t rc = ZSTD_compressStream(c->zctx, &output,
+							&input);
+			if (ZSTD_isError(rc)) {
+				diag_set(ClientError, ER_COMPRESSION,
+					 ZSTD_getErrorName(rc));
+				return -1;
+			}
+			c->used += output.pos;
+		}
+		c->pending += iov[i].iov_len;
+	}
+	return 0;
+}
+
+int
+xrow_compressor_flush(struct xrow_compressor *c, struct xrow_header *packet)
+{
+	assert(c->pending > 0);
+	size_t rc;
+	do {
+		if (xrow_compressor_reserve(c, ZSTD_CStreamOutSize()) != 0)
+			return -1;
+		ZSTD_outBuffer output = {c->buf + c->used,
+					 c->capacity - c->used, 0};
+		rc = ZSTD_flushStream(c->zctx, &output);
+		if (ZSTD_isError(rc)) {
+			diag_set(ClientError, ER_COMPRESSION,
+				 ZSTD_getErrorName(rc));
+			return -1;
+		}
+		c->used += output.pos;
+	} while (rc > 0);
+
+	char *data = c->body_header;
+	data = mp_encode_map(data, 2);
+	data = mp_encode_uint(data, IPROTO_RAW_LEN);
+	data = mp_encode_uint(data, c->pending);
+	data = mp_encode_uint(data, IPROTO_DATA);
+	data = mp_encode_binl(data, c->used);
+	assert(data <= c->body_header + sizeof(c->body_header));
+
+	memset(packet, 0, sizeof(*packet));
+	packet->type = IPROTO_COMPRESSED_ROWS;
+	packet->body[0].iov_base = c->body_header;
+	packet->body[0].iov_len = data - c->body_header;
+	packet->body[1].iov_base = c->buf;
+	packet->body[1].iov_len = c->used;
+	packet->bodycnt = 2;
+
+	c->raw_bytes += c->pending;
+	c->compressed_bytes += c->used;
+	c->pending = 0;
+	return 0;
+}
+
+void
+xrow_decompressor_create(struct xrow_decompressor *d)
+{
+	memset(d, 0, sizeof(*d));
+	ibuf_create(&d->ibuf, &cord()->slabc, 1024);
+}
+
+void
+xrow_decompressor_destroy(struct xrow_decompressor *d)
+{
+	if (d->zdctx != NULL)
+		ZSTD_freeDStream(d->zdctx);
+	ibuf_destroy(&d->ibuf);
+}
+
+void
+xrow_decompressor_reset(struct xrow_decompressor *d)
+{
+	/*
+	 * A new stream starts with a clean zstd context,
+	 * which will be created on receipt of the first
+	 * compressed chunk.
+	 */
+	if (d->zdctx != NULL) {
+		ZSTD_freeDStream(d->zdctx);
+		d->zdctx = NULL;
+	}
+	ibuf_reinit(&d->ibuf);
+}
+
+/**
+ * Decode the body of an IPROTO_COMPRESSED_ROWS packet.
+ */
+static int
+xrow_decode_compressed_rows(const struct xrow_header *packet,
+			    const char **data, uint32_t *data_len,
+			    uint64_t *raw_len)
+{
+	if (packet->bodycnt == 0)
+		goto error;
+	assert(packet->bodycnt == 1);
+	const char *d = (const char *) packet->body[0].iov_base;
+	if (mp_typeof(*d) != MP_MAP)
+		goto error;
+	*data = NULL;
+	*data_len = 0;
+	*raw_len = 0;
+	uint32_t map_size = mp_decode_map(&d);
+	for (uint32_t i = 0; i < map_size; i++) {
+		if (mp_typeof(*d) != MP_UINT)
+			goto error;
+		uint64_t key = mp_decode_uint(&d);
+		switch (key) {
+		case IPROTO_DATA:
+			if (mp_typeof(*d) != MP_BIN)
+				goto error;
+			*data = mp_decode_bin(&d, data_len);
+			break;
+		case IPROTO_RAW_LEN:
+			if (mp_typeof(*d) != MP_UINT)
+				goto error;
+			*raw_len = mp_decode_uint(&d);
+			break;
+		default:
+			mp_next(&d); /* value */
+		}
+	}
+	if (*data == NULL || *raw_len == 0 ||
+	    *raw_len > IPROTO_BODY_LEN_MAX)
+		goto error;
+	return 0;
+error:
+	diag_set(ClientError, ER_INVALID_MSGPACK, "compressed rows");
+	return -1;
+}
+
+/**
+ * Arguments of a decompression job. The job doesn't touch
+ * anything but the zstd context and the buffers given to it
+ * so it can be executed in any thread.
+ */
+struct xrow_decompress_job {
+	ZSTD_DStream *zdctx;
+	ZSTD_inBuffer input;
+	ZSTD_outBuffer output;
+	/** Error message, set on failure. */
+	const char *errmsg;
+};
+
+static int
+xrow_decompress_job_run(struct xrow_decompress_job *job)
+{
+	while (job->input.pos < job->input.size) {
+		size_t in_pos = job->input.pos;
+		size_t out_pos = job->output.pos;
+		size_t rc = ZSTD_decompressStream(job->zdctx, &job->output,
+						  &job->input);
+		if (ZSTD_isError(rc)) {
+			job->errmsg = ZSTD_getErrorName(rc);
+			return -1;
+		}
+		if (job->input.pos == in_pos && job->output.pos == out_pos) {
+			job->errmsg = "decompressed data is too long";
+			return -1;
+		}
+	}
+	if (job->output.pos != job->output.size) {
+		job->errmsg = "decompressed data is too short";
+		return -1;
+	}
+	return 0;
+}
+
+static ssize_t
+xrow_decompress_job_f(va_list ap)
+{
+	struct xrow_decompress_job *job = va_arg(ap,
+					struct xrow_decompress_job *);
+	return xrow_decompress_job_run(job);
+}
+
+int
+xrow_decompressor_feed(struct xrow_decompressor *d,
+		       const struct xrow_header *packet)
+{
+	assert(packet->type == IPROTO_COMPRESSED_ROWS);
+	const char *data;
+	uint32_t data_len;
+	uint64_t raw_len;
+	if (xrow_decode_compressed_rows(packet, &data, &data_len,
+					&raw_len) != 0)
+		return -1;
+	if (d->zdctx == NULL) {
+		d->zdctx = ZSTD_createDStream();
+		if (d->zdctx == NULL) {
+			diag_set(OutOfMemory, 0, "ZSTD_createDStream",
+				 "zstd context");
+			return -1;
+		}
+		size_t rc = ZSTD_initDStream(d->zdctx);
+		if (ZSTD_isError(rc)) {
+			diag_set(ClientError, ER_DECOMPRESSION,
+				 ZSTD_getErrorName(rc));
+			ZSTD_freeDStream(d->zdctx);
+			d->zdctx = NULL;
+			return -1;
+		}
+	}
+	if (ibuf_used(&d->ibuf) == 0)
+		ibuf_reset(&d->ibuf);
+	/*
+	 * Reserve the output buffer in advance, because ibuf
+	 * uses the slab cache of the calling thread, which must
+	 * not be accessed from a coio thread.
+	 */
+	char *dst = ibuf_reserve(&d->ibuf, raw_len);
+	if (dst == NULL) {
+		diag_set(OutOfMemory, raw_len, "ibuf_reserve",
+			 "decompression buffer");
+		return -1;
+	}
+	struct xrow_decompress_job job;
+	job.zdctx = d->zdctx;
+	job.input.src = data;
+	job.input.size = data_len;
+	job.input.pos = 0;
+	job.output.dst = dst;
+	job.output.size = raw_len;
+	job.output.pos = 0;
+	job.errmsg = NULL;
+	/*
+	 * Decompression of a big chunk takes long enough to stall
+	 * the calling thread, which is usually tx, so do it in
+	 * a coio thread. Small chunks are cheaper to decompress
+	 * in place than to pass to another thread.
+	 */
+	int rc;
+	if (data_len >= XROW_DECOMPRESS_OFFLOAD_SIZE)
+		rc = coio_call(xrow_decompress_job_f, &job);
+	else
+		rc = xrow_decompress_job_run(&job);
+	if (rc != 0) {
+		if (job.errmsg != NULL) {
+			diag_set(ClientError, ER_DECOMPRESSION, job.errmsg);
+		} else {
+			diag_set(OutOfMemory, sizeof(struct coio_task),
+				 "malloc", "struct coio_task");
+		}
+		return -1;
+	}
+	ibuf_alloc(&d->ibuf, raw_len);
+	d->raw_bytes += raw_len;
+	d->compressed_bytes += data_len;
+	return 0;
+}
+
+int
+xrow_decompressor_next(struct xrow_decompressor *d, struct xrow_header *row)
+{
+	struct ibuf *ibuf = &d->ibuf;
+	if (ibuf_used(ibuf) == 0)
+		return 0;
+	const char *pos = ibuf->rpos;
+	const char *end = ibuf->wpos;
+	/*
+	 * A chunk always ends at a row boundary so there's
+	 * no need to wait for more data here.
+	 */
+	if (mp_typeof(*pos) != MP_UINT || mp_check_uint(pos, end) > 0)
+		goto error;
+	uint64_t len = mp_decode_uint(&pos);
+	if (len > (uint64_t)(end - pos))
+		goto error;
+	if (xrow_header_decode(row, &pos, pos + len, true) != 0)
+		return -1;
+	ibuf->rpos = (char *) pos;
+	return 1;
+error:
+	diag_set(ClientError, ER_INVALID_MSGPACK, "packet length");
+	return -1;
+}
@@ -0,0 +1,228 @@
+#ifndef TARANTOOL_BOX_XROW_COMPRESS_H_INCLUDED
+#define TARANTOOL_BOX_XROW_COMPRESS_H_INCLUDED
+/*
+ * Copyright 2010-2020, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <small/ibuf.h>
+#include <zstd.h>
+
+#include "diag.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * Compression of the replication stream.
+ *
+ * A replica that is able to decode compressed data sets
+ * IPROTO_COMPRESSION in its JOIN, FETCH_SNAPSHOT, REGISTER or
+ * SUBSCRIBE request. If the master has box.cfg.replication_compression
+ * set, it feeds all rows it sends to the replica to a zstd stream
+ * and periodically flushes the stream into IPROTO_COMPRESSED_ROWS
+ * packets:
+ *
+ * <= COMPRESSED_ROWS { DATA: bin, RAW_LEN: uint }
+ *
+ * DATA is a chunk of the zstd stream, RAW_LEN is the size of the
+ * chunk after decompression. A chunk always ends at an xrow
+ * boundary, i.e. it decompresses to a sequence of complete
+ * length-prefixed xrow packets, exactly as they would be sent
+ * over the wire without compression. The zstd context persists
+ * for the lifetime of the connection so that each chunk can
+ * refer to data sent in preceding chunks, which gives a much
+ * better compression ratio for a stream of small similar rows
+ * than compressing them one by one.
+ *
+ * Uncompressed packets may be freely interleaved with compressed
+ * chunks, e.g. the end-of-stage markers of JOIN are still sent
+ * as plain packets.
+ */
+enum {
+	/**
+	 * Flush the compression stream as soon as this many
+	 * bytes have been fed to it since the last flush.
+	 */
+	XROW_COMPRESS_CHUNK_SIZE = 128 * 1024,
+	/**
+	 * Chunks bigger than this are decompressed in a coio
+	 * thread rather than in the thread receiving them.
+	 */
+	XROW_DECOMPRESS_OFFLOAD_SIZE = 16 * 1024,
+};
+
+struct xrow_header;
+
+/** Compressing writer of the replication stream. */
+struct xrow_compressor {
+	/** zstd streaming compression context. */
+	ZSTD_CStream *zctx;
+	/**
+	 * Compressed data accumulated since the last flush.
+	 * Allocated with malloc(), because the compressor may
+	 * be used by different threads (one at a time), e.g.
+	 * initial join rows are produced by a separate cord.
+	 */
+	char *buf;
+	/** Size of data stored in buf. */
+	size_t used;
+	/** Size of memory allocated for buf. */
+	size_t capacity;
+	/** Number of raw bytes fed since the last flush. */
+	size_t pending;
+	/** Header of the body of the last flushed chunk. */
+	char body_header[32];
+	/** Total number of bytes fed to the compressor. */
+	uint64_t raw_bytes;
+	/** Total number of compressed bytes produced. */
+	uint64_t compressed_bytes;
+};
+
+/**
+ * Create a compressor with the given zstd compression level.
+ * Returns 0 on success, -1 on memory allocation error.
+ */
+int
+xrow_compressor_create(struct xrow_compressor *c, int level);
+
+void
+xrow_compressor_destroy(struct xrow_compressor *c);
+
+/**
+ * Encode an xrow and feed it to the compressor.
+ * Returns 0 on success, -1 on error.
+ */
+int
+xrow_compressor_add(struct xrow_compressor *c, const struct xrow_header *row);
+
+struct iovec;
+
+/**
+ * Feed xrow packets already encoded with xrow_to_iovec() to
+ * the compressor. Returns 0 on success, -1 on error.
+ */
+int
+xrow_compressor_add_iov(struct xrow_compressor *c, const struct iovec *iov,
+			int iovcnt);
+
+/** Return true if nothing has been fed since the last flush. */
+static inline bool
+xrow_compressor_is_empty(const struct xrow_compressor *c)
+{
+	return c->pending == 0;
+}
+
+/**
+ * Flush the compression stream and encode all data accumulated
+ * since the last flush as an IPROTO_COMPRESSED_ROWS packet.
+ * The packet body refers to the compressor memory and stays
+ * valid until the next call to xrow_compressor_add().
+ * Returns 0 on success, -1 on error.
+ */
+int
+xrow_compressor_flush(struct xrow_compressor *c, struct xrow_header *packet);
+
+/** Decompressing reader of the replication stream. */
+struct xrow_decompressor {
+	/**
+	 * zstd streaming decompression context, created on
+	 * receipt of the first compressed chunk.
+	 */
+	ZSTD_DStream *zdctx;
+	/** Decompressed data that hasn't been decoded yet. */
+	struct ibuf ibuf;
+	/** Total number of decompressed bytes. */
+	uint64_t raw_bytes;
+	/** Total number of compressed bytes received. */
+	uint64_t compressed_bytes;
+};
+
+/** Create a decompressor. Must be called from the tx thread. */
+void
+xrow_decompressor_create(struct xrow_decompressor *d);
+
+void
+xrow_decompressor_destroy(struct xrow_decompressor *d);
+
+/**
+ * Reset the decompressor before reading a new stream, e.g.
+ * on reconnect. Statistics are preserved.
+ */
+void
+xrow_decompressor_reset(struct xrow_decompressor *d);
+
+/**
+ * Decompress an IPROTO_COMPRESSED_ROWS packet. The rows it
+ * contains can be retrieved with xrow_decompressor_next().
+ * May yield if the chunk is big enough to be decompressed in
+ * a coio thread. Returns 0 on success, -1 on error.
+ */
+int
+xrow_decompressor_feed(struct xrow_decompressor *d,
+		       const struct xrow_header *packet);
+
+/**
+ * Decode the next row decompressed from the stream.
+ * The row body points to the decompressor buffer and stays
+ * valid until the next call to xrow_decompressor_feed().
+ *
+ * Returns 1 if a row was decoded, 0 if there are no more rows,
+ * -1 on decode error.
+ */
+int
+xrow_decompressor_next(struct xrow_decompressor *d, struct xrow_header *row);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+
+static inline void
+xrow_decompressor_feed_xc(struct xrow_decompressor *d,
+			  const struct xrow_header *packet)
+{
+	if (xrow_decompressor_feed(d, packet) != 0)
+		diag_raise();
+}
+
+static inline bool
+xrow_decompressor_next_xc(struct xrow_decompressor *d, struct xrow_header *row)
+{
+	int rc = xrow_decompressor_next(d, row);
+	if (rc < 0)
+		diag_raise();
+	return rc > 0;
+}
+
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_XROW_COMPRESS_H_INCLUDED */
@@ -42,3 +42,20 @@ xstream_write(struct xstream *stream, struct xrow_header *row)
 	}
 	return 0;
 }
+
+int
+xstream_write_batch(struct xstream *stream, struct xrow_header *rows,
+		    int count)
+{
+	try {
+		if (stream->write_batch != NULL) {
+			stream->write_batch(stream, rows, count);
+			return 0;
+		}
+		for (int i = 0; i < count; i++)
+			stream->write(stream, &rows[i]);
+	} catch (Exception *e) {
+		return -1;
+	}
+	return 0;
+}
@@ -42,20 +42,38 @@ struct xrow_header;
 struct xstream;
 
 typedef void (*xstream_write_f)(struct xstream *, struct xrow_header *);
+typedef void (*xstream_write_batch_f)(struct xstream *,
+				      struct xrow_header *, int);
 
 struct xstream {
 	xstream_write_f write;
+	/**
+	 * Optional method writing a batch of rows. Unlike write,
+	 * it may be called from several threads at the same time.
+	 */
+	xstream_write_batch_f write_batch;
 };
 
 static inline void
 xstream_create(struct xstream *xstream, xstream_write_f write)
 {
 	xstream->write = write;
+	xstream->write_batch = NULL;
 }
 
 int
 xstream_write(struct xstream *stream, struct xrow_header *row);
 
+/**
+ * Write @count rows to a stream. The rows of a batch are written
+ * contiguously. If the stream implements write_batch, this
+ * function may be called from several threads at the same time,
+ * otherwise the caller must serialize calls.
+ */
+int
+xstream_write_batch(struct xstream *stream, struct xrow_header *rows,
+		    int count);
+
 #if defined(__cplusplus)
 } /* extern C */
 
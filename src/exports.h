@@ -10,6 +10,7 @@ EXPORT(base64_bufsize)
 EXPORT(base64_decode)
 EXPORT(base64_encode)
 EXPORT(box_delete)
+EXPORT(box_delete_range)
 EXPORT(box_error_clear)
 EXPORT(box_error_code)
 EXPORT(box_error_custom_type)
@@ -31,9 +31,16 @@
 #include "cbus.h"
 
 #include <limits.h>
+#include <pmatomic.h>
 #include "fiber.h"
 #include "trigger.h"
 
+/**
+ * How often a fiber waiting for room in a pipe rechecks the
+ * pipe size in case the consumer missed it, in seconds.
+ */
+static const double CPIPE_ROOM_RECHECK_PERIOD = 0.01;
+
 /**
  * Cord interconnect.
  */
@@ -46,6 +53,8 @@ struct cbus {
 	pthread_cond_t cond;
 	/** Connected endpoints */
 	struct rlist endpoints;
+	/** Statistics of all pipes, linked by cpipe_stat::in_cbus. */
+	struct rlist pipe_stats;
 };
 
 /** A singleton for all cords. */
@@ -83,22 +92,235 @@ cbus_find_endpoint(struct cbus *bus, const char *name)
 	return endpoint;
 }
 
+/**
+ * Push a batch of messages to the endpoint queue and clear the
+ * batch. Returns true if the consumer must be woken up, i.e. if
+ * the queue was empty and the consumer wasn't processing messages.
+ */
+static bool
+cbus_endpoint_push(struct cbus_endpoint *endpoint, struct stailq *batch)
+{
+	assert(!stailq_empty(batch));
+	/* The queue stores messages newest first. */
+	struct stailq_entry *last = stailq_first(batch);
+	stailq_reverse(batch);
+	struct stailq_entry *first = stailq_first(batch);
+	struct stailq_entry *head = pm_atomic_load(&endpoint->output);
+	do {
+		last->next = head;
+	} while (!pm_atomic_compare_exchange_weak(&endpoint->output,
+						  &head, first));
+	stailq_create(batch);
+	return head == NULL;
+}
+
+/**
+ * Take all messages from the endpoint queue and append them to
+ * @output in the order they were pushed. The queue is replaced
+ * with @stub, which is either NULL or &endpoint->busy.
+ */
+static void
+cbus_endpoint_take(struct cbus_endpoint *endpoint, struct stailq_entry *stub,
+		   struct stailq *output)
+{
+	struct stailq_entry *item = pm_atomic_exchange(&endpoint->output,
+						       stub);
+	struct stailq batch;
+	stailq_create(&batch);
+	while (item != NULL && item != &endpoint->busy) {
+		struct stailq_entry *next = item->next;
+		stailq_add(&batch, item);
+		item = next;
+	}
+	stailq_concat(output, &batch);
+}
+
+/** Return true if the endpoint queue has no messages. */
+static bool
+cbus_endpoint_is_empty(struct cbus_endpoint *endpoint)
+{
+	struct stailq_entry *head = pm_atomic_load(&endpoint->output);
+	return head == NULL || head == &endpoint->busy;
+}
+
+void
+cbus_endpoint_fetch(struct cbus_endpoint *endpoint, struct stailq *output)
+{
+	cbus_endpoint_take(endpoint, NULL, output);
+}
+
+/* {{{ cpipe_stat */
+
+/**
+ * Add a value to a statistics counter. Every counter is updated
+ * by one thread so an atomic read-modify-write isn't needed, but
+ * the store must be atomic, because the counter may be read by
+ * another thread concurrently.
+ */
+static inline void
+cpipe_stat_add(int64_t *counter, int64_t value)
+{
+	pm_atomic_store_explicit(counter,
+		pm_atomic_load_explicit(counter, pm_memory_order_relaxed) +
+		value, pm_memory_order_relaxed);
+}
+
+static inline int64_t
+cpipe_stat_get(const int64_t *counter)
+{
+	return pm_atomic_load_explicit((int64_t *)counter,
+				       pm_memory_order_relaxed);
+}
+
+/** Account a value in a cpipe_stat histogram. */
+static inline void
+cpipe_stat_hist_collect(int64_t *hist, int64_t value)
+{
+	int bucket = 0;
+	while (value >= 2 && bucket < CPIPE_STAT_HIST_SIZE - 1) {
+		value /= 2;
+		bucket++;
+	}
+	cpipe_stat_add(&hist[bucket], 1);
+}
+
+int64_t
+cpipe_stat_percentile(const int64_t *hist, int pct)
+{
+	int64_t total = 0;
+	for (int i = 0; i < CPIPE_STAT_HIST_SIZE; i++)
+		total += hist[i];
+	int64_t count = 0;
+	for (int i = 0; i < CPIPE_STAT_HIST_SIZE; i++) {
+		count += hist[i];
+		if (count > 0 && count * 100 >= total * pct)
+			return (int64_t)1 << (i + 1);
+	}
+	return 0;
+}
+
+/** Account a batch of messages flushed to the consumer. */
+static void
+cpipe_stat_collect_flush(struct cpipe_stat *stat, int n_msgs)
+{
+	cpipe_stat_add(&stat->pushed, n_msgs);
+	cpipe_stat_hist_collect(stat->batch, n_msgs);
+}
+
+/** Account a message delivered by the consumer. */
+static void
+cpipe_stat_collect_delivery(struct cpipe_stat *stat, double pushed_at)
+{
+	cpipe_stat_add(&stat->delivered, 1);
+	if (pushed_at != 0) {
+		double latency = clock_monotonic() - pushed_at;
+		cpipe_stat_hist_collect(stat->latency, latency * 1e6);
+	}
+	/*
+	 * No fence here: a waiter registered concurrently may be
+	 * missed, but it doesn't sleep longer than
+	 * CPIPE_ROOM_RECHECK_PERIOD, see cpipe_wait_room().
+	 */
+	if (pm_atomic_load_explicit(&stat->room_waiters,
+				    pm_memory_order_relaxed) == 0)
+		return;
+	tt_pthread_mutex_lock(&cbus.mutex);
+	if (stat->producer != NULL)
+		ev_async_send(stat->producer, &stat->room_async);
+	tt_pthread_mutex_unlock(&cbus.mutex);
+}
+
+/** Add statistics of a pipe to the sum of statistics @dst. */
+static void
+cpipe_stat_sum(struct cpipe_stat *dst, const struct cpipe_stat *src)
+{
+	/*
+	 * Read the delivery counter first so that it doesn't
+	 * exceed the push counter.
+	 */
+	dst->delivered += cpipe_stat_get(&src->delivered);
+	dst->pushed += cpipe_stat_get(&src->pushed);
+	dst->waits += cpipe_stat_get(&src->waits);
+	for (int i = 0; i < CPIPE_STAT_HIST_SIZE; i++) {
+		dst->latency[i] += cpipe_stat_get(&src->latency[i]);
+		dst->batch[i] += cpipe_stat_get(&src->batch[i]);
+	}
+}
+
+struct cpipe_stat *
+cbus_pipe_stat(int *count)
+{
+	tt_pthread_mutex_lock(&cbus.mutex);
+	int capacity = 0;
+	struct cpipe_stat *stat;
+	rlist_foreach_entry(stat, &cbus.pipe_stats, in_cbus)
+		capacity++;
+	struct cpipe_stat *result = calloc(MAX(capacity, 1),
+					   sizeof(*result));
+	if (result == NULL) {
+		tt_pthread_mutex_unlock(&cbus.mutex);
+		diag_set(OutOfMemory, MAX(capacity, 1) * sizeof(*result),
+			 "calloc", "cpipe_stat");
+		return NULL;
+	}
+	int n = 0;
+	rlist_foreach_entry(stat, &cbus.pipe_stats, in_cbus) {
+		int i;
+		for (i = 0; i < n; i++) {
+			if (strcmp(result[i].name, stat->name) == 0)
+				break;
+		}
+		if (i == n) {
+			strcpy(result[n].name, stat->name);
+			n++;
+		}
+		cpipe_stat_sum(&result[i], stat);
+	}
+	tt_pthread_mutex_unlock(&cbus.mutex);
+	*count = n;
+	return result;
+}
+
+/* }}} cpipe_stat */
+
 static void
 cpipe_flush_cb(ev_loop * /* loop */, struct ev_async *watcher,
 	       int /* events */);
 
+/** Wake up fibers waiting for room in the pipe. */
+static void
+cpipe_room_cb(ev_loop *loop, struct ev_async *watcher, int events)
+{
+	(void) loop;
+	(void) events;
+	struct cpipe *pipe = (struct cpipe *) watcher->data;
+	fiber_cond_broadcast(&pipe->room_cond);
+}
+
 void
 cpipe_create(struct cpipe *pipe, const char *consumer)
 {
 	stailq_create(&pipe->input);
 
 	pipe->n_input = 0;
+	pipe->n_staged = 0;
 	pipe->max_input = INT_MAX;
+	pipe->max_size = 0;
 	pipe->producer = cord()->loop;
 
 	ev_async_init(&pipe->flush_input, cpipe_flush_cb);
 	pipe->flush_input.data = pipe;
 	rlist_create(&pipe->on_flush);
+	fiber_cond_create(&pipe->room_cond);
+
+	pipe->stat = calloc(1, sizeof(*pipe->stat));
+	if (pipe->stat == NULL)
+		panic("failed to allocate pipe statistics");
+	snprintf(pipe->stat->name, sizeof(pipe->stat->name), "%s->%s",
+		 cord_name(cord()), consumer);
+	pipe->stat->producer = pipe->producer;
+	ev_async_init(&pipe->stat->room_async, cpipe_room_cb);
+	pipe->stat->room_async.data = pipe;
 
 	tt_pthread_mutex_lock(&cbus.mutex);
 	struct cbus_endpoint *endpoint =
@@ -109,23 +331,92 @@ cpipe_create(struct cpipe *pipe, const char *consumer)
 	}
 	pipe->endpoint = endpoint;
 	++pipe->endpoint->n_pipes;
+	rlist_add_tail_entry(&cbus.pipe_stats, pipe->stat, in_cbus);
 	tt_pthread_mutex_unlock(&cbus.mutex);
 }
 
+int64_t
+cpipe_size(struct cpipe *pipe)
+{
+	return pipe->n_staged + pipe->stat->pushed -
+	       cpipe_stat_get(&pipe->stat->delivered);
+}
+
+int
+cpipe_wait_room(struct cpipe *pipe, double timeout)
+{
+	assert(loop() == pipe->producer);
+	struct cpipe_stat *stat = pipe->stat;
+	/* Don't overtake fibers that are already waiting. */
+	if (!cpipe_is_full(pipe) && stat->room_waiters == 0)
+		return 0;
+	cpipe_stat_add(&stat->waits, 1);
+	if (!ev_is_active(&stat->room_async))
+		ev_async_start(pipe->producer, &stat->room_async);
+	/* The pipe can't drain unless staged input is flushed. */
+	cpipe_deliver_now(pipe);
+	double deadline = ev_monotonic_now(loop()) + timeout;
+	int rc = 0;
+	pm_atomic_fetch_add_explicit(&stat->room_waiters, 1,
+				     pm_memory_order_relaxed);
+	/*
+	 * Wait at least once if there are other waiters so that
+	 * they get room first.
+	 */
+	bool wait = stat->room_waiters > 1;
+	while (wait || cpipe_is_full(pipe)) {
+		wait = false;
+		/*
+		 * The consumer checks room_waiters without a fence
+		 * so it may miss our increment and never wake us
+		 * up. Recheck the pipe size periodically.
+		 */
+		double now = ev_monotonic_now(loop());
+		if (now >= deadline) {
+			diag_set(TimedOut);
+			rc = -1;
+			break;
+		}
+		fiber_cond_wait_deadline(&pipe->room_cond,
+					 MIN(deadline, now +
+					     CPIPE_ROOM_RECHECK_PERIOD));
+		if (fiber_is_cancelled()) {
+			diag_set(FiberIsCancelled);
+			rc = -1;
+			break;
+		}
+	}
+	pm_atomic_fetch_sub_explicit(&stat->room_waiters, 1,
+				     pm_memory_order_relaxed);
+	/* Let the next waiter check the room after we push. */
+	if (stat->room_waiters > 0 && !cpipe_is_full(pipe))
+		fiber_cond_signal(&pipe->room_cond);
+	return rc;
+}
+
 struct cmsg_poison {
 	struct cmsg msg;
 	struct cbus_endpoint *endpoint;
+	/** Statistics of the destroyed pipe. */
+	struct cpipe_stat *stat;
 };
 
 static void
 cbus_endpoint_poison_f(struct cmsg *msg)
 {
-	struct cbus_endpoint *endpoint = ((struct cmsg_poison *)msg)->endpoint;
+	struct cmsg_poison *poison = (struct cmsg_poison *)msg;
+	struct cbus_endpoint *endpoint = poison->endpoint;
 	tt_pthread_mutex_lock(&cbus.mutex);
 	assert(endpoint->n_pipes > 0);
 	--endpoint->n_pipes;
+	rlist_del_entry(poison->stat, in_cbus);
 	tt_pthread_mutex_unlock(&cbus.mutex);
 	fiber_cond_signal(&endpoint->cond);
+	/*
+	 * All messages of the pipe have been delivered by now
+	 * so nobody can access its statistics.
+	 */
+	free(poison->stat);
 	free(msg);
 }
 
@@ -140,6 +431,16 @@ cpipe_destroy(struct cpipe *pipe)
 	tt_pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old_cancel_state);
 
 	ev_async_stop(pipe->producer, &pipe->flush_input);
+	/*
+	 * The consumer may still be delivering messages of the
+	 * pipe, but it must not wake up the producer loop, which
+	 * may be gone by then.
+	 */
+	tt_pthread_mutex_lock(&cbus.mutex);
+	pipe->stat->producer = NULL;
+	tt_pthread_mutex_unlock(&cbus.mutex);
+	ev_async_stop(pipe->producer, &pipe->stat->room_async);
+	fiber_cond_destroy(&pipe->room_cond);
 
 	static const struct cmsg_hop route[1] = {
 		{cbus_endpoint_poison_f, NULL}
@@ -150,17 +451,20 @@ cpipe_destroy(struct cpipe *pipe)
 	struct cmsg_poison *poison = malloc(sizeof(struct cmsg_poison));
 	cmsg_init(&poison->msg, route);
 	poison->endpoint = pipe->endpoint;
+	poison->stat = pipe->stat;
+	if (pipe->n_staged > 0)
+		cpipe_stat_collect_flush(pipe->stat, pipe->n_staged);
 	/*
 	 * Avoid the general purpose cpipe_push_input() since
 	 * we want to control the way the poison message is
 	 * delivered.
 	 */
 	tt_pthread_mutex_lock(&endpoint->mutex);
-	/* Flush input */
-	stailq_concat(&endpoint->output, &pipe->input);
+	/* Flush input with the pipe shutdown message as the last one. */
+	stailq_add_tail_entry(&pipe->input, poison, msg.fifo);
+	cbus_endpoint_push(endpoint, &pipe->input);
 	pipe->n_input = 0;
-	/* Add the pipe shutdown message as the last one. */
-	stailq_add_tail_entry(&endpoint->output, poison, msg.fifo);
+	pipe->n_staged = 0;
 	/* Count statistics */
 	rmean_collect(cbus.stats, CBUS_STAT_EVENTS, 1);
 	/*
@@ -190,6 +494,7 @@ cbus_create(struct cbus *bus)
 	(void) tt_pthread_cond_init(&bus->cond, NULL);
 
 	rlist_create(&bus->endpoints);
+	rlist_create(&bus->pipe_stats);
 }
 
 static void
@@ -227,7 +532,7 @@ cbus_endpoint_create(struct cbus_endpoint *endpoint, const char *name,
 	endpoint->n_pipes = 0;
 	fiber_cond_create(&endpoint->cond);
 	tt_pthread_mutex_init(&endpoint->mutex, NULL);
-	stailq_create(&endpoint->output);
+	endpoint->output = NULL;
 	ev_async_init(&endpoint->async,
 		      (void (*)(ev_loop *, struct ev_async *, int)) fetch_cb);
 	endpoint->async.data = fetch_data;
@@ -261,14 +566,14 @@ cbus_endpoint_destroy(struct cbus_endpoint *endpoint,
 	while (true) {
 		if (process_cb)
 			process_cb(endpoint);
-		if (endpoint->n_pipes == 0 && stailq_empty(&endpoint->output))
+		if (endpoint->n_pipes == 0 && cbus_endpoint_is_empty(endpoint))
 			break;
 		 fiber_cond_wait(&endpoint->cond);
 	}
 
 	/*
-	 * Pipe flush func can still lock mutex, so just lock and unlock
-	 * it.
+	 * cpipe_destroy() can still hold the mutex, so just lock
+	 * and unlock it.
 	 */
 	tt_pthread_mutex_lock(&endpoint->mutex);
 	tt_pthread_mutex_unlock(&endpoint->mutex);
@@ -290,8 +595,6 @@ cpipe_flush_cb(ev_loop *loop, struct ev_async *watcher, int events)
 		return;
 
 	trigger_run(&pipe->on_flush, pipe);
-	/* Trigger task processing when the queue becomes non-empty. */
-	bool output_was_empty;
 
 	/*
 	 * We need to set a thread cancellation guard, because
@@ -304,14 +607,12 @@ cpipe_flush_cb(ev_loop *loop, struct ev_async *watcher, int events)
 	int old_cancel_state;
 	tt_pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old_cancel_state);
 
-	tt_pthread_mutex_lock(&endpoint->mutex);
-	output_was_empty = stailq_empty(&endpoint->output);
-	/** Flush input */
-	stailq_concat(&endpoint->output, &pipe->input);
-	tt_pthread_mutex_unlock(&endpoint->mutex);
-
+	/* Trigger task processing when the queue becomes non-empty. */
+	cpipe_stat_collect_flush(pipe->stat, pipe->n_staged);
+	bool need_wakeup = cbus_endpoint_push(endpoint, &pipe->input);
 	pipe->n_input = 0;
-	if (output_was_empty) {
+	pipe->n_staged = 0;
+	if (need_wakeup) {
 		/* Count statistics */
 		rmean_collect(cbus.stats, CBUS_STAT_EVENTS, 1);
 
@@ -372,6 +673,10 @@ cmsg_deliver(struct cmsg *msg)
 	 * on the last hop.
 	 */
 	struct cpipe *pipe = msg->hop->pipe;
+	if (msg->pipe_stat != NULL) {
+		cpipe_stat_collect_delivery(msg->pipe_stat, msg->pushed_at);
+		msg->pipe_stat = NULL;
+	}
 	msg->hop->f(msg);
 	cmsg_dispatch(pipe, msg);
 }
@@ -431,6 +736,14 @@ cbus_call(struct cpipe *callee, struct cpipe *caller, struct cbus_call_msg *msg,
 	msg->free_cb = free_cb;
 	msg->rc = 0;
 
+	double start = ev_monotonic_now(loop());
+	if (cpipe_wait_room(callee, timeout) != 0) {
+		if (free_cb != NULL)
+			free_cb(msg);
+		return -1;
+	}
+	timeout -= ev_monotonic_now(loop()) - start;
+
 	cpipe_push(callee, cmsg(msg));
 
 	fiber_yield_timeout(timeout);
@@ -651,10 +964,23 @@ cbus_process(struct cbus_endpoint *endpoint)
 {
 	struct stailq output;
 	stailq_create(&output);
-	cbus_endpoint_fetch(endpoint, &output);
+	/*
+	 * Producers don't wake us up while we are delivering
+	 * messages, see cbus_endpoint::busy.
+	 */
+	cbus_endpoint_take(endpoint, &endpoint->busy, &output);
 	struct cmsg *msg, *msg_next;
 	stailq_foreach_entry_safe(msg, msg_next, &output, fifo)
 		cmsg_deliver(msg);
+	struct stailq_entry *busy = &endpoint->busy;
+	if (!pm_atomic_compare_exchange_strong(&endpoint->output,
+					       &busy, NULL)) {
+		/*
+		 * More messages were pushed while we were busy.
+		 * Nobody notified us so do it ourselves.
+		 */
+		ev_async_send(endpoint->consumer, &endpoint->async);
+	}
 }
 
 void
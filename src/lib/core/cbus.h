@@ -32,6 +32,7 @@
  */
 #include "fiber.h"
 #include "fiber_cond.h"
+#include "clock.h"
 #include "rmean.h"
 #include "small/rlist.h"
 #include "salad/stailq.h"
@@ -44,6 +45,7 @@ extern "C" {
 
 struct cmsg;
 struct cpipe;
+struct cpipe_stat;
 typedef void (*cmsg_f)(struct cmsg *);
 
 enum cbus_stat_name {
@@ -88,6 +90,16 @@ struct cmsg {
 	const struct cmsg_hop *route;
 	/** The current hop the message is at. */
 	const struct cmsg_hop *hop;
+	/**
+	 * Statistics of the pipe the message is currently in
+	 * or NULL if the message isn't accounted.
+	 */
+	struct cpipe_stat *pipe_stat;
+	/**
+	 * Time when the message was pushed to the pipe or 0 if
+	 * the message isn't sampled for latency statistics.
+	 */
+	double pushed_at;
 };
 
 static inline struct cmsg *cmsg(void *ptr) { return (struct cmsg *) ptr; }
@@ -101,6 +113,7 @@ cmsg_init(struct cmsg *msg, const struct cmsg_hop *route)
 	 * msg->hop thus points to the second hop.
 	 */
 	msg->hop = msg->route = route;
+	msg->pipe_stat = NULL;
 }
 
 /**
@@ -109,16 +122,88 @@ cmsg_init(struct cmsg *msg, const struct cmsg_hop *route)
 void
 cmsg_deliver(struct cmsg *msg);
 
+/** Number of buckets in cpipe_stat histograms. */
+enum { CPIPE_STAT_HIST_SIZE = 24 };
+
+/**
+ * Only every CPIPE_STAT_SAMPLE_RATE-th message pushed to a pipe
+ * is timestamped for the latency histogram, so as not to query
+ * the clock on every push and delivery.
+ */
+enum { CPIPE_STAT_SAMPLE_RATE = 16 };
+
+/**
+ * Statistics of a pipe.
+ *
+ * Every counter is updated by one thread only, either by the
+ * producer or by the consumer, but may be read by any thread,
+ * see cbus_pipe_stat(). The object is freed by the consumer
+ * when it receives the last message of a destroyed pipe, so
+ * it is safe to account messages on delivery.
+ */
+struct cpipe_stat {
+	/** Link in the list of all pipe statistics. */
+	struct rlist in_cbus;
+	/** Pipe name: "<producer cord>-><consumer endpoint>". */
+	char name[2 * FIBER_NAME_MAX + 2];
+	/** Number of messages flushed to the consumer. */
+	int64_t pushed;
+	/** Number of messages delivered by the consumer. */
+	int64_t delivered;
+	/** Number of times a producer had to wait for room. */
+	int64_t waits;
+	/**
+	 * Number of producer fibers waiting for room in the pipe.
+	 * The consumer wakes them up with room_async when it
+	 * delivers a message. It reads the counter without a
+	 * fence so a waiter may be missed, in which case it
+	 * notices the room on its own, see cpipe_wait_room().
+	 */
+	int room_waiters;
+	/**
+	 * The event loop of the producer cord or NULL if the pipe
+	 * has been destroyed. Protected by the cbus mutex.
+	 */
+	struct ev_loop *producer;
+	/** Signaled by the consumer to wake up room waiters. */
+	struct ev_async room_async;
+	/**
+	 * Histogram of message latencies, from push to delivery,
+	 * sampled at CPIPE_STAT_SAMPLE_RATE. Bucket i counts
+	 * messages delivered in [2^i, 2^(i+1)) microseconds.
+	 */
+	int64_t latency[CPIPE_STAT_HIST_SIZE];
+	/**
+	 * Histogram of flushed batch sizes. Bucket i counts
+	 * flushes of [2^i, 2^(i+1)) messages.
+	 */
+	int64_t batch[CPIPE_STAT_HIST_SIZE];
+};
+
+/**
+ * Return the upper bound of the @pct-th percentile of a
+ * cpipe_stat histogram, e.g. in microseconds for latency.
+ */
+int64_t
+cpipe_stat_percentile(const int64_t *hist, int pct);
+
 /** A  uni-directional FIFO queue from one cord to another. */
 struct cpipe {
 	/** Staging area for pushed messages */
 	struct stailq input;
 	/** Counters are useful for finer-grained scheduling. */
 	int n_input;
+	/**
+	 * Number of staged messages. Unlike n_input, which a
+	 * producer may inflate to get its input flushed sooner,
+	 * this is the exact number of messages.
+	 */
+	int n_staged;
 	/**
 	 * When pushing messages, keep the staged input size under
 	 * this limit (speeds up message delivery and reduces
-	 * latency, while still keeping the bus mutex cold enough).
+	 * latency, while still keeping the number of consumer
+	 * wakeups low enough).
 	 */
 	int max_input;
 	/**
@@ -140,6 +225,17 @@ struct cpipe {
 	 * is not empty.
 	 */
 	struct rlist on_flush;
+	/**
+	 * Max number of messages queued in the pipe, including
+	 * staged input, or 0 if the pipe is unbounded. Producers
+	 * should call cpipe_wait_room() or check cpipe_is_full()
+	 * before pushing a message to a bounded pipe.
+	 */
+	int64_t max_size;
+	/** Producer fibers waiting for room, see cpipe_wait_room(). */
+	struct fiber_cond room_cond;
+	/** Pipe statistics. */
+	struct cpipe_stat *stat;
 };
 
 /**
@@ -166,7 +262,7 @@ cpipe_destroy(struct cpipe *pipe);
  * Otherwise, the messages flushed once per event loop iteration.
  *
  * @todo: collect bus stats per second and adjust max_input once
- * a second to keep the mutex cold regardless of the message load,
+ * a second to keep the wakeup rate low regardless of the message load,
  * while still keeping the latency low if there are few
  * long-to-process messages.
  */
@@ -176,6 +272,42 @@ cpipe_set_max_input(struct cpipe *pipe, int max_input)
 	pipe->max_input = max_input;
 }
 
+/**
+ * Limit the number of messages queued in the pipe.
+ * Pass 0 to make the pipe unbounded, which is the default.
+ */
+static inline void
+cpipe_set_max_size(struct cpipe *pipe, int64_t max_size)
+{
+	pipe->max_size = max_size;
+	/* The new limit may leave room for the waiters. */
+	fiber_cond_broadcast(&pipe->room_cond);
+}
+
+/**
+ * Return the number of messages pushed to the pipe, but not
+ * delivered to the consumer yet.
+ */
+int64_t
+cpipe_size(struct cpipe *pipe);
+
+/** Return true if the pipe is bounded and has no room. */
+static inline bool
+cpipe_is_full(struct cpipe *pipe)
+{
+	return pipe->max_size > 0 && cpipe_size(pipe) >= pipe->max_size;
+}
+
+/**
+ * Block the current fiber until the pipe has room for a new
+ * message. Waiters are woken up by the consumer as it delivers
+ * messages and get room in the order they started waiting.
+ * Returns 0 on success, -1 on timeout or if the fiber is
+ * cancelled (diag is set).
+ */
+int
+cpipe_wait_room(struct cpipe *pipe, double timeout);
+
 static inline void
 cpipe_deliver_now(struct cpipe *pipe)
 {
@@ -223,8 +355,15 @@ cpipe_push_input(struct cpipe *pipe, struct cmsg *msg)
 {
 	assert(loop() == pipe->producer);
 
+	msg->pipe_stat = pipe->stat;
+	if ((pipe->stat->pushed + pipe->n_staged) %
+	    CPIPE_STAT_SAMPLE_RATE == 0)
+		msg->pushed_at = clock_monotonic();
+	else
+		msg->pushed_at = 0;
 	stailq_add_tail_entry(&pipe->input, msg, fifo);
 	pipe->n_input++;
+	pipe->n_staged++;
 	if (pipe->n_input >= pipe->max_input)
 		ev_invoke(pipe->producer, &pipe->flush_input, EV_CUSTOM);
 }
@@ -258,10 +397,27 @@ struct cbus_endpoint {
 	char name[FIBER_NAME_MAX];
 	/** Member of cbus->endpoints */
 	struct rlist in_cbus;
-	/** The lock around the pipe. */
+	/**
+	 * The lock taken by cpipe_destroy() while sending the
+	 * last message to the endpoint so that the endpoint isn't
+	 * destroyed under its feet. Message passing doesn't use it.
+	 */
 	pthread_mutex_t mutex;
-	/** A queue with incoming messages. */
-	struct stailq output;
+	/**
+	 * A lock-free queue with incoming messages, linked via
+	 * cmsg::fifo. Producers push batches of messages to the
+	 * head with compare-and-swap while the consumer takes
+	 * all of them at once with exchange, so the messages are
+	 * stored newest first and reversed on fetch.
+	 *
+	 * The list is terminated either by NULL or by @busy.
+	 * The latter means that the consumer is processing
+	 * messages and will check the queue again when it's
+	 * done so producers don't need to wake it up.
+	 */
+	struct stailq_entry *output;
+	/** Terminator of @output used while the consumer is busy. */
+	struct stailq_entry busy;
 	/** Consumer cord loop */
 	ev_loop *consumer;
 	/** Async to notify the consumer */
@@ -273,15 +429,12 @@ struct cbus_endpoint {
 };
 
 /**
- * Fetch incomming messages to output
+ * Fetch incoming messages and append them to output in the
+ * order they were pushed. The next message pushed to the
+ * endpoint will wake up the consumer.
  */
-static inline void
-cbus_endpoint_fetch(struct cbus_endpoint *endpoint, struct stailq *output)
-{
-	tt_pthread_mutex_lock(&endpoint->mutex);
-	stailq_concat(output, &endpoint->output);
-	tt_pthread_mutex_unlock(&endpoint->mutex);
-}
+void
+cbus_endpoint_fetch(struct cbus_endpoint *endpoint, struct stailq *output);
 
 /** Initialize the global singleton bus. */
 void
@@ -330,6 +483,15 @@ int
 cbus_endpoint_destroy(struct cbus_endpoint *endpoint,
 		      void (*process_cb)(struct cbus_endpoint *));
 
+/**
+ * Get statistics of all pipes. Statistics of pipes with the same
+ * name are summed. On success, returns an array allocated with
+ * malloc() and stores its size in @count. Returns NULL and sets
+ * diag on OOM.
+ */
+struct cpipe_stat *
+cbus_pipe_stat(int *count);
+
 /**
  * A helper method to invoke a function on the other side of the
  * bus.
@@ -350,6 +512,9 @@ cbus_endpoint_destroy(struct cbus_endpoint *endpoint,
  * If the argument function sets an error in the called cord, this
  * error is safely transferred to the caller cord's diagnostics
  * area.
+ *
+ * If the callee pipe is bounded, the caller waits for room in it
+ * before pushing the message, see cpipe_wait_room().
 */
 struct cbus_call_msg;
 typedef int (*cbus_call_f)(struct cbus_call_msg *);
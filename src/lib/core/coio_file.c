@@ -37,6 +37,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <dirent.h>
+#include <sys/time.h>
 
 /**
  * A context of libeio request for any
@@ -47,8 +48,54 @@ struct coio_file_task {
 	int errorno;
 	struct fiber *fiber;
 	bool done;
+	/** Function executed in a worker thread. */
+	void (*func)(eio_req *req);
+	/** Task accounting. */
+	struct coio_stamp stamp;
 
 	union {
+		struct {
+			const char *pathname;
+			int flags;
+			mode_t mode;
+		} open;
+
+		struct {
+			int fd;
+		} fd;
+
+		struct {
+			const char *oldpath;
+			const char *newpath;
+		} rename;
+
+		struct {
+			const char *pathname;
+		} path;
+
+		struct {
+			int fd;
+			const char *pathname;
+			off_t length;
+		} truncate;
+
+		struct {
+			const char *pathname;
+			uid_t owner;
+			gid_t group;
+		} chown;
+
+		struct {
+			const char *pathname;
+			mode_t mode;
+		} chmod;
+
+		struct {
+			const char *pathname;
+			double atime;
+			double mtime;
+		} utime;
+
 		struct {
 			int fd;
 			struct stat *buf;
@@ -76,12 +123,14 @@ struct coio_file_task {
 			int fd;
 			const void *buf;
 			size_t count;
+			off_t offset;
 		} write;
 
 		struct {
 			int fd;
 			void *buf;
 			size_t count;
+			off_t offset;
 		} read;
 
 		struct {
@@ -106,10 +155,11 @@ struct coio_file_task {
 	};
 };
 
-#define INIT_COEIO_FILE(name)			\
+#define INIT_COEIO_FILE(name, task_type)	\
 	struct coio_file_task name;		\
 	memset(&name, 0, sizeof(name));		\
 	name.fiber = fiber();			\
+	name.stamp.type = task_type;		\
 
 /** A callback invoked by eio when a task is complete. */
 static int
@@ -117,6 +167,7 @@ coio_complete(eio_req *req)
 {
 	struct coio_file_task *eio = (struct coio_file_task *)req->data;
 
+	coio_stamp_complete(&eio->stamp);
 	eio->errorno = req->errorno;
 	eio->done = true;
 	eio->result = req->result;
@@ -125,14 +176,32 @@ coio_complete(eio_req *req)
 	return 0;
 }
 
+/** Execute a task in a worker thread. */
+static void
+coio_feed(eio_req *req)
+{
+	struct coio_file_task *eio = (struct coio_file_task *)req->data;
+	coio_stamp_start(&eio->stamp);
+	eio->func(req);
+	/* eio_execute() sets req->errorno from errno. */
+	int save_errno = errno;
+	coio_stamp_finish(&eio->stamp);
+	errno = save_errno;
+}
+
 /**
- * Synchronously (from cooperative multitasking point of view)
- * wait for task completion.
+ * Submit a task executing @func to the coio thread pool and
+ * synchronously (from cooperative multitasking point of view)
+ * wait for its completion.
  */
 static ssize_t
-coio_wait_done(eio_req *req, struct coio_file_task *eio)
+coio_submit(struct coio_file_task *eio, void (*func)(eio_req *req))
 {
+	eio->func = func;
+	int pri = coio_stamp_submit(&eio->stamp);
+	eio_req *req = eio_custom(coio_feed, pri, coio_complete, eio);
 	if (!req) {
+		coio_stamp_complete(&eio->stamp);
 		errno = ENOMEM;
 		return -1;
 	}
@@ -144,41 +213,65 @@ coio_wait_done(eio_req *req, struct coio_file_task *eio)
 	return eio->result;
 }
 
+static void
+coio_do_open(eio_req *req)
+{
+	struct coio_file_task *eio = (struct coio_file_task *)req->data;
+	req->result = open(eio->open.pathname, eio->open.flags,
+			   eio->open.mode);
+}
+
 int
 coio_file_open(const char *path, int flags, mode_t mode)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_open(path, flags, mode, 0,
-				coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_META);
+	eio.open.pathname = path;
+	eio.open.flags = flags;
+	eio.open.mode = mode;
+	return coio_submit(&eio, coio_do_open);
+}
+
+static void
+coio_do_close(eio_req *req)
+{
+	struct coio_file_task *eio = (struct coio_file_task *)req->data;
+	req->result = close(eio->fd.fd);
 }
 
 int
 coio_file_close(int fd)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_close(fd, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_META);
+	eio.fd.fd = fd;
+	return coio_submit(&eio, coio_do_close);
+}
+
+static void
+coio_do_pwrite(eio_req *req)
+{
+	struct coio_file_task *eio = (struct coio_file_task *)req->data;
+	req->result = pwrite(eio->write.fd, eio->write.buf,
+			     eio->write.count, eio->write.offset);
 }
 
 ssize_t
 coio_pwrite(int fd, const void *buf, size_t count, off_t offset)
 {
 	ssize_t left = count, pos = 0, res, chunk;
-	eio_req *req;
 
 	while (left > 0) {
-		INIT_COEIO_FILE(eio);
+		INIT_COEIO_FILE(eio, COIO_TASK_FILE_WRITE);
 		chunk = left;
 
 		ERROR_INJECT(ERRINJ_COIO_WRITE_CHUNK, {
 			chunk = 1;
 		});
 
-		req = eio_write(fd, (char *)buf + pos, chunk,
-				offset + pos, EIO_PRI_DEFAULT,
-				coio_complete, &eio);
-		res = coio_wait_done(req, &eio);
+		eio.write.fd = fd;
+		eio.write.buf = (char *)buf + pos;
+		eio.write.count = chunk;
+		eio.write.offset = offset + pos;
+		res = coio_submit(&eio, coio_do_pwrite);
 		if (res < 0) {
 			pos = -1;
 			break;
@@ -190,13 +283,23 @@ coio_pwrite(int fd, const void *buf, size_t count, off_t offset)
 	return pos;
 }
 
+static void
+coio_do_pread(eio_req *req)
+{
+	struct coio_file_task *eio = (struct coio_file_task *)req->data;
+	req->result = pread(eio->read.fd, eio->read.buf,
+			    eio->read.count, eio->read.offset);
+}
+
 ssize_t
 coio_pread(int fd, void *buf, size_t count, off_t offset)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_read(fd, buf, count,
-				offset, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_READ);
+	eio.read.fd = fd;
+	eio.read.buf = buf;
+	eio.read.count = count;
+	eio.read.offset = offset;
+	return coio_submit(&eio, coio_do_pread);
 }
 
 ssize_t
@@ -234,18 +337,15 @@ ssize_t
 coio_write(int fd, const void *buf, size_t count)
 {
 	ssize_t left = count, pos = 0, res;
-	eio_req *req;
 
 	while (left > 0) {
-		INIT_COEIO_FILE(eio);
+		INIT_COEIO_FILE(eio, COIO_TASK_FILE_WRITE);
 
 		eio.write.buf	= (char *)buf + pos;
 		eio.write.count	= left;
 		eio.write.fd	= fd;
 
-		req = eio_custom(coio_do_write, EIO_PRI_DEFAULT,
-				 coio_complete, &eio);
-		res = coio_wait_done(req, &eio);
+		res = coio_submit(&eio, coio_do_write);
 		if (res < 0) {
 			pos = -1;
 			break;
@@ -268,13 +368,11 @@ coio_do_read(eio_req *req)
 ssize_t
 coio_read(int fd, void *buf, size_t count)
 {
-	INIT_COEIO_FILE(eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_READ);
 	eio.read.buf = buf;
 	eio.read.count = count;
 	eio.read.fd = fd;
-	eio_req *req = eio_custom(coio_do_read, 0,
-				  coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_submit(&eio, coio_do_read);
 }
 
 
@@ -290,15 +388,13 @@ coio_do_lseek(eio_req *req)
 off_t
 coio_lseek(int fd, off_t offset, int whence)
 {
-	INIT_COEIO_FILE(eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_META);
 
 	eio.lseek.whence = whence;
 	eio.lseek.offset = offset;
 	eio.lseek.fd = fd;
 
-	eio_req *req = eio_custom(coio_do_lseek, 0,
-				  coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_submit(&eio, coio_do_lseek);
 }
 
 static void
@@ -312,12 +408,10 @@ coio_do_lstat(eio_req *req)
 int
 coio_lstat(const char *pathname, struct stat *buf)
 {
-	INIT_COEIO_FILE(eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_META);
 	eio.lstat.pathname = pathname;
 	eio.lstat.buf = buf;
-	eio_req *req = eio_custom(coio_do_lstat, 0,
-				  coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_submit(&eio, coio_do_lstat);
 }
 
 static void
@@ -331,12 +425,10 @@ coio_do_stat(eio_req *req)
 int
 coio_stat(const char *pathname, struct stat *buf)
 {
-	INIT_COEIO_FILE(eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_META);
 	eio.lstat.pathname = pathname;
 	eio.lstat.buf = buf;
-	eio_req *req = eio_custom(coio_do_stat, 0,
-				  coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_submit(&eio, coio_do_stat);
 }
 
 static void
@@ -350,47 +442,75 @@ coio_do_fstat(eio_req *req)
 int
 coio_fstat(int fd, struct stat *stat)
 {
-	INIT_COEIO_FILE(eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_META);
 	eio.fstat.fd = fd;
 	eio.fstat.buf = stat;
 
-	eio_req *req = eio_custom(coio_do_fstat, 0,
-				  coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_submit(&eio, coio_do_fstat);
+}
+
+static void
+coio_do_rename(eio_req *req)
+{
+	struct coio_file_task *eio = (struct coio_file_task *)req->data;
+	req->result = rename(eio->rename.oldpath, eio->rename.newpath);
 }
 
 int
 coio_rename(const char *oldpath, const char *newpath)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_rename(oldpath, newpath, 0,
-				  coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_META);
+	eio.rename.oldpath = oldpath;
+	eio.rename.newpath = newpath;
+	return coio_submit(&eio, coio_do_rename);
+}
 
+static void
+coio_do_unlink(eio_req *req)
+{
+	struct coio_file_task *eio = (struct coio_file_task *)req->data;
+	req->result = unlink(eio->path.pathname);
 }
 
 int
 coio_unlink(const char *pathname)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_unlink(pathname, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_REMOVE);
+	eio.path.pathname = pathname;
+	return coio_submit(&eio, coio_do_unlink);
+}
+
+static void
+coio_do_ftruncate(eio_req *req)
+{
+	struct coio_file_task *eio = (struct coio_file_task *)req->data;
+	req->result = ftruncate(eio->truncate.fd, eio->truncate.length);
 }
 
 int
 coio_ftruncate(int fd, off_t length)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_ftruncate(fd, length, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_WRITE);
+	eio.truncate.fd = fd;
+	eio.truncate.length = length;
+	return coio_submit(&eio, coio_do_ftruncate);
+}
+
+static void
+coio_do_truncate(eio_req *req)
+{
+	struct coio_file_task *eio = (struct coio_file_task *)req->data;
+	req->result = truncate(eio->truncate.pathname,
+			       eio->truncate.length);
 }
 
 int
 coio_truncate(const char *path, off_t length)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_truncate(path, length, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_WRITE);
+	eio.truncate.pathname = path;
+	eio.truncate.length = length;
+	return coio_submit(&eio, coio_do_truncate);
 }
 
 static void
@@ -407,64 +527,109 @@ coio_glob(const char *pattern, int flags,
 		int (*errfunc) (const char *epath, int eerrno),
 		glob_t *pglob)
 {
-	INIT_COEIO_FILE(eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_META);
 	eio.glob.pattern = pattern;
 	eio.glob.flags = flags;
 	eio.glob.errfunc = errfunc;
 	eio.glob.pglob = pglob;
-	eio_req *req =
-		eio_custom(coio_do_glob, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_submit(&eio, coio_do_glob);
+}
+
+static void
+coio_do_chown(eio_req *req)
+{
+	struct coio_file_task *eio = (struct coio_file_task *)req->data;
+	req->result = chown(eio->chown.pathname, eio->chown.owner,
+			    eio->chown.group);
 }
 
 int
 coio_chown(const char *path, uid_t owner, gid_t group)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req =
-		eio_chown(path, owner, group, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_META);
+	eio.chown.pathname = path;
+	eio.chown.owner = owner;
+	eio.chown.group = group;
+	return coio_submit(&eio, coio_do_chown);
+}
+
+static void
+coio_do_chmod(eio_req *req)
+{
+	struct coio_file_task *eio = (struct coio_file_task *)req->data;
+	req->result = chmod(eio->chmod.pathname, eio->chmod.mode);
 }
 
 int
 coio_chmod(const char *path, mode_t mode)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_chmod(path, mode, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_META);
+	eio.chmod.pathname = path;
+	eio.chmod.mode = mode;
+	return coio_submit(&eio, coio_do_chmod);
+}
+
+static void
+coio_do_mkdir(eio_req *req)
+{
+	struct coio_file_task *eio = (struct coio_file_task *)req->data;
+	req->result = mkdir(eio->chmod.pathname, eio->chmod.mode);
 }
 
 int
 coio_mkdir(const char *pathname, mode_t mode)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_mkdir(pathname, mode, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_META);
+	eio.chmod.pathname = pathname;
+	eio.chmod.mode = mode;
+	return coio_submit(&eio, coio_do_mkdir);
+}
+
+static void
+coio_do_rmdir(eio_req *req)
+{
+	struct coio_file_task *eio = (struct coio_file_task *)req->data;
+	req->result = rmdir(eio->path.pathname);
 }
 
 int
 coio_rmdir(const char *pathname)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_rmdir(pathname, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_REMOVE);
+	eio.path.pathname = pathname;
+	return coio_submit(&eio, coio_do_rmdir);
+}
+
+static void
+coio_do_link(eio_req *req)
+{
+	struct coio_file_task *eio = (struct coio_file_task *)req->data;
+	req->result = link(eio->rename.oldpath, eio->rename.newpath);
 }
 
 int
 coio_link(const char *oldpath, const char *newpath)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_link(oldpath, newpath, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_META);
+	eio.rename.oldpath = oldpath;
+	eio.rename.newpath = newpath;
+	return coio_submit(&eio, coio_do_link);
+}
+
+static void
+coio_do_symlink(eio_req *req)
+{
+	struct coio_file_task *eio = (struct coio_file_task *)req->data;
+	req->result = symlink(eio->rename.oldpath, eio->rename.newpath);
 }
 
 int
 coio_symlink(const char *target, const char *linkpath)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req =
-		eio_symlink(target, linkpath, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_META);
+	eio.rename.oldpath = target;
+	eio.rename.newpath = linkpath;
+	return coio_submit(&eio, coio_do_symlink);
 }
 
 static void
@@ -479,13 +644,11 @@ coio_do_readlink(eio_req *req)
 int
 coio_readlink(const char *pathname, char *buf, size_t bufsize)
 {
-	INIT_COEIO_FILE(eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_META);
 	eio.readlink.pathname = pathname;
 	eio.readlink.buf = buf;
 	eio.readlink.bufsize = bufsize;
-	eio_req *req = eio_custom(coio_do_readlink, 0,
-				  coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_submit(&eio, coio_do_readlink);
 }
 
 static void
@@ -504,7 +667,7 @@ coio_do_tempdir(eio_req *req)
 int
 coio_tempdir(char *path, size_t path_len)
 {
-	INIT_COEIO_FILE(eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_META);
 
 	const char *tmpdir = getenv("TMPDIR");
 	if (tmpdir == NULL)
@@ -517,33 +680,51 @@ coio_tempdir(char *path, size_t path_len)
 		return -1;
 	}
 	eio.tempdir.tpl = path;
-	eio_req *req =
-		eio_custom(coio_do_tempdir, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_submit(&eio, coio_do_tempdir);
+}
+
+static void
+coio_do_sync(eio_req *req)
+{
+	sync();
+	req->result = 0;
 }
 
 int
 coio_sync()
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_sync(0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_SYNC);
+	return coio_submit(&eio, coio_do_sync);
+}
+
+static void
+coio_do_fsync(eio_req *req)
+{
+	struct coio_file_task *eio = (struct coio_file_task *)req->data;
+	req->result = fsync(eio->fd.fd);
 }
 
 int
 coio_fsync(int fd)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_fsync(fd, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_SYNC);
+	eio.fd.fd = fd;
+	return coio_submit(&eio, coio_do_fsync);
+}
+
+static void
+coio_do_fdatasync(eio_req *req)
+{
+	struct coio_file_task *eio = (struct coio_file_task *)req->data;
+	req->result = fdatasync(eio->fd.fd);
 }
 
 int
 coio_fdatasync(int fd)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_fdatasync(fd, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_SYNC);
+	eio.fd.fd = fd;
+	return coio_submit(&eio, coio_do_fdatasync);
 }
 
 static void
@@ -604,11 +785,10 @@ error:
 int
 coio_readdir(const char *dir_path, char **buf)
 {
-	INIT_COEIO_FILE(eio)
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_META);
 	eio.readdir.bufp = buf;
 	eio.readdir.pathname = dir_path;
-	eio_req *req = eio_custom(coio_do_readdir, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_submit(&eio, coio_do_readdir);
 }
 
 static void
@@ -668,17 +848,35 @@ error:
 int
 coio_copyfile(const char *source, const char *dest)
 {
-	INIT_COEIO_FILE(eio)
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_COPY);
 	eio.copyfile.source = source;
 	eio.copyfile.dest = dest;
-	eio_req *req = eio_custom(coio_do_copyfile, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	return coio_submit(&eio, coio_do_copyfile);
+}
+
+static void
+coio_do_utime(eio_req *req)
+{
+	struct coio_file_task *eio = (struct coio_file_task *)req->data;
+	struct timeval tv[2];
+	struct timeval *times = NULL;
+	/* Like eio_utime(), use the current time if both are -1. */
+	if (eio->utime.atime != -1. || eio->utime.mtime != -1.) {
+		tv[0].tv_sec = eio->utime.atime;
+		tv[0].tv_usec = (eio->utime.atime - tv[0].tv_sec) * 1e6;
+		tv[1].tv_sec = eio->utime.mtime;
+		tv[1].tv_usec = (eio->utime.mtime - tv[1].tv_sec) * 1e6;
+		times = tv;
+	}
+	req->result = utimes(eio->utime.pathname, times);
 }
 
 int
 coio_utime(const char *pathname, double atime, double mtime)
 {
-	INIT_COEIO_FILE(eio);
-	eio_req *req = eio_utime(pathname, atime, mtime, 0, coio_complete, &eio);
-	return coio_wait_done(req, &eio);
+	INIT_COEIO_FILE(eio, COIO_TASK_FILE_META);
+	eio.utime.pathname = pathname;
+	eio.utime.atime = atime;
+	eio.utime.mtime = mtime;
+	return coio_submit(&eio, coio_do_utime);
 }
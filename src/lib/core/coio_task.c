@@ -37,8 +37,10 @@
 #include <unistd.h>
 #include <netdb.h>
 #include <sys/socket.h>
+#include <pmatomic.h>
 
 #include "fiber.h"
+#include "fiber_cond.h"
 #include "third_party/tarantool_ev.h"
 
 /*
@@ -64,16 +66,172 @@
  *
  * See for details:
  * http://pod.tst.eu/http://cvs.schmorp.de/libeio/eio.pod
+ *
+ * All threads share the same libeio thread pool. To keep long
+ * file operations from delaying name resolution and short
+ * calls, every task is assigned a priority class, which maps to
+ * a libeio request priority, and bulk tasks submitted by one
+ * thread may occupy at most coio_bulk_threads worker threads.
 */
 
 struct coio_manager {
 	ev_loop *loop;
 	ev_idle coio_idle;
 	ev_async coio_async;
+	/** Number of bulk tasks submitted by this thread in flight. */
+	int bulk_count;
+	/** Signalled when a bulk task completes. */
+	struct fiber_cond bulk_cond;
 };
 
 static __thread struct coio_manager coio_manager;
 
+/** Max number of bulk tasks a thread may have in flight. */
+static int coio_bulk_threads = 2;
+
+const char *coio_task_type_strs[] = {
+	[COIO_TASK_CALL]		= "call",
+	[COIO_TASK_GETADDRINFO]		= "getaddrinfo",
+	[COIO_TASK_FILE_READ]		= "file_read",
+	[COIO_TASK_FILE_WRITE]		= "file_write",
+	[COIO_TASK_FILE_SYNC]		= "file_sync",
+	[COIO_TASK_FILE_META]		= "file_meta",
+	[COIO_TASK_FILE_REMOVE]		= "file_remove",
+	[COIO_TASK_FILE_COPY]		= "file_copy",
+};
+
+static_assert(lengthof(coio_task_type_strs) == coio_task_type_MAX,
+	      "coio_task_type_strs does not match coio_task_type");
+
+/** Priority class of each task type. */
+static const enum coio_pri coio_task_type_pri[] = {
+	[COIO_TASK_CALL]		= COIO_PRI_DEFAULT,
+	[COIO_TASK_GETADDRINFO]		= COIO_PRI_HIGH,
+	[COIO_TASK_FILE_READ]		= COIO_PRI_DEFAULT,
+	[COIO_TASK_FILE_WRITE]		= COIO_PRI_BULK,
+	[COIO_TASK_FILE_SYNC]		= COIO_PRI_BULK,
+	[COIO_TASK_FILE_META]		= COIO_PRI_DEFAULT,
+	[COIO_TASK_FILE_REMOVE]		= COIO_PRI_BULK,
+	[COIO_TASK_FILE_COPY]		= COIO_PRI_BULK,
+};
+
+static_assert(lengthof(coio_task_type_pri) == coio_task_type_MAX,
+	      "coio_task_type_pri does not match coio_task_type");
+
+/** libeio request priority of each priority class. */
+static const int coio_pri_eio[] = {
+	[COIO_PRI_HIGH]			= EIO_PRI_MAX,
+	[COIO_PRI_DEFAULT]		= EIO_PRI_DEFAULT,
+	[COIO_PRI_BULK]			= EIO_PRI_MIN,
+};
+
+static_assert(lengthof(coio_pri_eio) == coio_pri_MAX,
+	      "coio_pri_eio does not match coio_pri");
+
+/** Statistics of each task type, updated by all threads. */
+static struct coio_task_stat coio_task_stats[coio_task_type_MAX];
+
+/* {{{ coio_task_stat */
+
+static inline void
+coio_task_stat_add(int64_t *counter, int64_t value)
+{
+	pm_atomic_fetch_add_explicit(counter, value, pm_memory_order_relaxed);
+}
+
+/** Account a value in a coio_task_stat histogram. */
+static inline void
+coio_task_stat_hist_collect(int64_t *hist, int64_t value)
+{
+	int bucket = 0;
+	while (value >= 2 && bucket < COIO_TASK_STAT_HIST_SIZE - 1) {
+		value /= 2;
+		bucket++;
+	}
+	coio_task_stat_add(&hist[bucket], 1);
+}
+
+int64_t
+coio_task_stat_percentile(const int64_t *hist, int pct)
+{
+	int64_t total = 0;
+	for (int i = 0; i < COIO_TASK_STAT_HIST_SIZE; i++)
+		total += hist[i];
+	int64_t count = 0;
+	for (int i = 0; i < COIO_TASK_STAT_HIST_SIZE; i++) {
+		count += hist[i];
+		if (count > 0 && count * 100 >= total * pct)
+			return (int64_t)1 << (i + 1);
+	}
+	return 0;
+}
+
+void
+coio_task_stat_get(enum coio_task_type type, struct coio_task_stat *stat)
+{
+	assert(type < coio_task_type_MAX);
+	struct coio_task_stat *src = &coio_task_stats[type];
+	stat->count = pm_atomic_load_explicit(&src->count,
+					      pm_memory_order_relaxed);
+	for (int i = 0; i < COIO_TASK_STAT_HIST_SIZE; i++) {
+		stat->wait[i] = pm_atomic_load_explicit(&src->wait[i],
+						pm_memory_order_relaxed);
+		stat->exec[i] = pm_atomic_load_explicit(&src->exec[i],
+						pm_memory_order_relaxed);
+	}
+}
+
+/* }}} coio_task_stat */
+
+void
+coio_set_bulk_threads(int count)
+{
+	assert(count > 0);
+	pm_atomic_store_explicit(&coio_bulk_threads, count,
+				 pm_memory_order_relaxed);
+	/* Let tasks waiting for the old limit proceed. */
+	fiber_cond_broadcast(&coio_manager.bulk_cond);
+}
+
+int
+coio_stamp_submit(struct coio_stamp *stamp)
+{
+	assert(stamp->type < coio_task_type_MAX);
+	enum coio_pri pri = coio_task_type_pri[stamp->type];
+	if (pri == COIO_PRI_BULK) {
+		while (coio_manager.bulk_count >=
+		       pm_atomic_load_explicit(&coio_bulk_threads,
+					       pm_memory_order_relaxed))
+			fiber_cond_wait(&coio_manager.bulk_cond);
+		coio_manager.bulk_count++;
+	}
+	stamp->submitted = clock_monotonic();
+	stamp->started = 0;
+	stamp->finished = 0;
+	return coio_pri_eio[pri];
+}
+
+void
+coio_stamp_complete(struct coio_stamp *stamp)
+{
+	assert(stamp->type < coio_task_type_MAX);
+	if (coio_task_type_pri[stamp->type] == COIO_PRI_BULK) {
+		assert(coio_manager.bulk_count > 0);
+		coio_manager.bulk_count--;
+		fiber_cond_signal(&coio_manager.bulk_cond);
+	}
+	if (stamp->started == 0) {
+		/* The request failed to be queued or was cancelled. */
+		return;
+	}
+	struct coio_task_stat *stat = &coio_task_stats[stamp->type];
+	coio_task_stat_add(&stat->count, 1);
+	coio_task_stat_hist_collect(stat->wait,
+			(stamp->started - stamp->submitted) * 1e6);
+	coio_task_stat_hist_collect(stat->exec,
+			(stamp->finished - stamp->started) * 1e6);
+}
+
 static void
 coio_idle_cb(ev_loop *loop, struct ev_idle *w, int events)
 {
@@ -148,6 +306,9 @@ coio_enable(void)
 	ev_async_init(&coio_manager.coio_async, coio_async_cb);
 
 	ev_async_start(loop(), &coio_manager.coio_async);
+
+	coio_manager.bulk_count = 0;
+	fiber_cond_create(&coio_manager.bulk_cond);
 }
 
 void
@@ -160,9 +321,11 @@ static void
 coio_on_feed(eio_req *req)
 {
 	struct coio_task *task = (struct coio_task *) req;
+	coio_stamp_start(&task->stamp);
 	req->result = task->task_cb(task);
 	if (req->result)
 		diag_move(diag_get(), &task->diag);
+	coio_stamp_finish(&task->stamp);
 }
 
 /**
@@ -173,6 +336,7 @@ static int
 coio_on_finish(eio_req *req)
 {
 	struct coio_task *task = (struct coio_task *) req;
+	coio_stamp_complete(&task->stamp);
 	if (task->fiber == NULL) {
 		/*
 		 * Timed out. Resources will be freed by coio_on_destroy.
@@ -212,13 +376,14 @@ coio_task_create(struct coio_task *task,
 	task->base.feed = coio_on_feed;
 	task->base.finish = coio_on_finish;
 	task->base.destroy = coio_on_destroy;
-	/* task->base.pri = 0; */
+	/* task->base.pri is set on submission. */
 
 	task->fiber = fiber();
 	task->task_cb = func;
 	task->timeout_cb = on_timeout;
 	task->complete = 0;
 	diag_create(&task->diag);
+	task->stamp.type = COIO_TASK_CALL;
 }
 
 void
@@ -232,6 +397,7 @@ coio_task_post(struct coio_task *task)
 {
 	assert(task->base.type == EIO_CUSTOM);
 	assert(task->fiber == fiber());
+	task->base.pri = coio_stamp_submit(&task->stamp);
 	eio_submit(&task->base);
 	task->fiber = NULL;
 }
@@ -242,6 +408,7 @@ coio_task_execute(struct coio_task *task, double timeout)
 	assert(task->base.type == EIO_CUSTOM);
 	assert(task->fiber == fiber());
 
+	task->base.pri = coio_stamp_submit(&task->stamp);
 	eio_submit(&task->base);
 	fiber_yield_timeout(timeout);
 	if (!task->complete) {
@@ -260,9 +427,13 @@ static void
 coio_on_call(eio_req *req)
 {
 	struct coio_task *task = (struct coio_task *) req;
+	coio_stamp_start(&task->stamp);
 	req->result = task->call_cb(task->ap);
 	if (req->result)
 		diag_move(diag_get(), &task->diag);
+	int save_errno = errno;
+	coio_stamp_finish(&task->stamp);
+	errno = save_errno;
 }
 
 ssize_t
@@ -276,14 +447,15 @@ coio_call(ssize_t (*func)(va_list ap), ...)
 	task->base.feed = coio_on_call;
 	task->base.finish = coio_on_finish;
 	/* task->base.destroy = NULL; */
-	/* task->base.pri = 0; */
 
 	task->fiber = fiber();
 	task->call_cb = func;
 	task->complete = 0;
 	diag_create(&task->diag);
+	task->stamp.type = COIO_TASK_CALL;
 
 	va_start(task->ap, func);
+	task->base.pri = coio_stamp_submit(&task->stamp);
 	eio_submit(&task->base);
 
 	do {
@@ -371,6 +543,7 @@ coio_getaddrinfo(const char *host, const char *port,
 	}
 
 	coio_task_create(&task->base, getaddrinfo_cb, getaddrinfo_free_cb);
+	coio_task_set_type(&task->base, COIO_TASK_GETADDRINFO);
 
 	/*
 	 * getaddrinfo() on osx upto osx 10.8 crashes when AI_NUMERICSERV is
@@ -35,9 +35,11 @@
 
 #include <sys/types.h> /* ssize_t */
 #include <stdarg.h>
+#include <stdint.h>
 
 #include "third_party/tarantool_eio.h"
 #include "diag.h"
+#include "clock.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -53,6 +55,129 @@ void coio_init(void);
 void coio_enable(void);
 void coio_shutdown(void);
 
+/**
+ * Priority class of a coio task. Worker threads pick queued
+ * tasks of a higher class first.
+ */
+enum coio_pri {
+	/** Latency-sensitive tasks, e.g. name resolution. */
+	COIO_PRI_HIGH,
+	/** Short calls and file operations. */
+	COIO_PRI_DEFAULT,
+	/**
+	 * Long file operations: writes, syncs, removals, copying.
+	 * The number of worker threads they may occupy at the
+	 * same time is limited, see coio_set_bulk_threads().
+	 */
+	COIO_PRI_BULK,
+	coio_pri_MAX,
+};
+
+/** Type of a coio task, used for accounting. */
+enum coio_task_type {
+	/** coio_call() or a generic coio_task. */
+	COIO_TASK_CALL,
+	/** coio_getaddrinfo(). */
+	COIO_TASK_GETADDRINFO,
+	/** File read. */
+	COIO_TASK_FILE_READ,
+	/** File write or truncation. */
+	COIO_TASK_FILE_WRITE,
+	/** fsync() and friends. */
+	COIO_TASK_FILE_SYNC,
+	/** open(), stat(), rename() and other metadata operations. */
+	COIO_TASK_FILE_META,
+	/** File or directory removal. */
+	COIO_TASK_FILE_REMOVE,
+	/** File copying. */
+	COIO_TASK_FILE_COPY,
+	coio_task_type_MAX,
+};
+
+extern const char *coio_task_type_strs[];
+
+/** Number of buckets in coio_task_stat histograms. */
+enum { COIO_TASK_STAT_HIST_SIZE = 24 };
+
+/** Statistics of coio tasks of one type. */
+struct coio_task_stat {
+	/** Number of completed tasks. */
+	int64_t count;
+	/**
+	 * Histogram of time the tasks spent in the queue before
+	 * a worker thread picked them up, in microseconds. Bucket
+	 * i counts values in range [2^i, 2^(i+1)).
+	 */
+	int64_t wait[COIO_TASK_STAT_HIST_SIZE];
+	/** Histogram of task execution time, in microseconds. */
+	int64_t exec[COIO_TASK_STAT_HIST_SIZE];
+};
+
+/** Get statistics of coio tasks of the given type. */
+void
+coio_task_stat_get(enum coio_task_type type, struct coio_task_stat *stat);
+
+/**
+ * Return an upper bound of the @pct-th percentile of values
+ * accounted in a coio_task_stat histogram, in microseconds.
+ */
+int64_t
+coio_task_stat_percentile(const int64_t *hist, int pct);
+
+/**
+ * Set the max number of worker threads that bulk tasks
+ * submitted by one thread may occupy at the same time.
+ * Bulk tasks exceeding the limit wait before being queued.
+ */
+void
+coio_set_bulk_threads(int count);
+
+/**
+ * Accounting context of a libeio request submitted by coio.
+ */
+struct coio_stamp {
+	/** Task type. */
+	enum coio_task_type type;
+	/** Time when the task was submitted. */
+	double submitted;
+	/** Time when a worker thread started executing the task. */
+	double started;
+	/** Time when the worker thread finished the task. */
+	double finished;
+};
+
+/**
+ * Prepare to submit a libeio request of the type stored in
+ * @stamp: wait until a bulk task may be queued, if the task is
+ * bulk, and remember the submission time. Returns the libeio
+ * priority to submit the request with. Must be paired with
+ * coio_stamp_complete().
+ */
+int
+coio_stamp_submit(struct coio_stamp *stamp);
+
+/** Called by a worker thread before executing a request. */
+static inline void
+coio_stamp_start(struct coio_stamp *stamp)
+{
+	stamp->started = clock_monotonic();
+}
+
+/** Called by a worker thread after executing a request. */
+static inline void
+coio_stamp_finish(struct coio_stamp *stamp)
+{
+	stamp->finished = clock_monotonic();
+}
+
+/**
+ * Account a request completion in coio statistics. Must be
+ * called by the thread that submitted the request, even if it
+ * failed to be queued.
+ */
+void
+coio_stamp_complete(struct coio_stamp *stamp);
+
 struct coio_task;
 
 typedef ssize_t (*coio_call_cb)(va_list ap);
@@ -84,6 +209,8 @@ struct coio_task {
 	int complete;
 	/** Task diag **/
 	struct diag diag;
+	/** Task accounting, see coio_task_set_type(). */
+	struct coio_stamp stamp;
 };
 
 /**
@@ -97,6 +224,17 @@ void
 coio_task_create(struct coio_task *task, coio_task_cb func,
 		 coio_task_cb on_timeout);
 
+/**
+ * Set the type of a coio task, COIO_TASK_CALL by default.
+ * The type determines the task priority and the statistics
+ * the task is accounted in.
+ */
+static inline void
+coio_task_set_type(struct coio_task *task, enum coio_task_type type)
+{
+	task->stamp.type = type;
+}
+
 /**
  * Destroy coio task.
  *
@@ -361,6 +361,7 @@ typedef uint32_t bps_tree_block_id_t;
 #define bps_tree_insert_get_iterator _api_name(insert_get_iterator)
 #define bps_tree_delete _api_name(delete)
 #define bps_tree_delete_value _api_name(delete_value)
+#define bps_tree_delete_range _api_name(delete_range)
 #define bps_tree_size _api_name(size)
 #define bps_tree_mem_used _api_name(mem_used)
 #define bps_tree_random _api_name(random)
@@ -447,6 +448,7 @@ typedef uint32_t bps_tree_block_id_t;
 #define bps_tree_process_insert_inner _bps_tree(process_insert_inner)
 #define bps_tree_process_delete_leaf _bps_tree(process_delete_leaf)
 #define bps_tree_process_delete_inner _bps_tree(process_delete_inner)
+#define bps_tree_process_delete_whole_leaf _bps_tree(process_delete_whole_leaf)
 #define bps_tree_debug_find_max_elem _bps_tree(debug_find_max_elem)
 #define bps_tree_debug_check_block _bps_tree(debug_check_block)
 #define bps_tree_print_indent _bps_tree(print_indent)
@@ -643,6 +645,22 @@ bps_tree_insert_get_iterator(struct bps_tree *tree, bps_tree_elem_t new_elem,
 static inline int
 bps_tree_delete(struct bps_tree *tree, bps_tree_elem_t elem);
 
+/**
+ * @brief Delete all elements that are not less than first and
+ *  not greater than last from a tree. Leaves that lie entirely
+ *  within the range are unlinked from the tree as a whole, so
+ *  the deletion takes O(log(N) * (K / B + B)) rather than
+ *  O(K * log(N)), where K is the number of deleted elements and
+ *  B is the capacity of a leaf.
+ * @param tree - pointer to a tree
+ * @param first - the lower bound of the range
+ * @param last - the upper bound of the range
+ * @return - the number of deleted elements
+ */
+static inline size_t
+bps_tree_delete_range(struct bps_tree *tree, bps_tree_elem_t first,
+		      bps_tree_elem_t last);
+
 /**
  * @brief Get size of tree, i.e. count of elements in tree
  * @param tree - pointer to a tree
@@ -4550,6 +4568,108 @@ bps_tree_delete_value(struct bps_tree *tree, bps_tree_elem_t elem,
 	return 0;
 }
 
+/**
+ * @brief Unlink a leaf from a tree with all its elements. The leaf
+ *  is found by its first element. The siblings of the leaf are not
+ *  touched, so the leaf is only unlinked if they are guaranteed to
+ *  be full, i.e. if its parent has more than two children; it's up
+ *  to the caller to delete the elements of the leaf one by one
+ *  otherwise.
+ * @param tree - pointer to a tree
+ * @param elem - the first element of the leaf
+ * @return - the number of deleted elements
+ */
+static inline bps_tree_pos_t
+bps_tree_process_delete_whole_leaf(struct bps_tree *tree,
+				   bps_tree_elem_t elem)
+{
+	struct bps_inner_path_elem path[BPS_TREE_MAX_DEPTH];
+	struct bps_leaf_path_elem leaf_path_elem;
+	bool exact;
+	bps_tree_collect_path(tree, elem, path, &leaf_path_elem, &exact);
+	assert(exact);
+	struct bps_leaf *leaf = leaf_path_elem.block;
+	bps_tree_pos_t count = leaf->header.size;
+	if (leaf_path_elem.parent == NULL) {
+		assert(tree->depth == 1);
+		assert(tree->size == (size_t)count);
+		tree->root_id = (bps_tree_block_id_t)(-1);
+		tree->depth = 0;
+		tree->size = 0;
+		tree->first_id = (bps_tree_block_id_t)(-1);
+		tree->last_id = (bps_tree_block_id_t)(-1);
+		bps_tree_dispose_leaf(tree, leaf, leaf_path_elem.block_id);
+		return count;
+	}
+	if (leaf_path_elem.parent->block->header.size <= 2)
+		return 0;
+
+	bps_tree_touch_path(tree, &leaf_path_elem);
+
+	if (leaf->prev_id == (bps_tree_block_id_t)(-1)) {
+		tree->first_id = leaf->next_id;
+	} else {
+		struct bps_leaf *prev_block = (struct bps_leaf *)
+			bps_tree_touch_block(tree, leaf->prev_id);
+		prev_block->next_id = leaf->next_id;
+	}
+	if (leaf->next_id == (bps_tree_block_id_t)(-1)) {
+		tree->last_id = leaf->prev_id;
+	} else {
+		struct bps_leaf *next_block = (struct bps_leaf *)
+			bps_tree_touch_block(tree, leaf->next_id);
+		next_block->prev_id = leaf->prev_id;
+	}
+	tree->size -= count;
+
+	bps_tree_dispose_leaf(tree, leaf, leaf_path_elem.block_id);
+	/*
+	 * If the leaf was the last child of its parent, the parent's
+	 * copy of the max element is updated by delete_from_inner.
+	 */
+	bps_tree_process_delete_inner(tree, leaf_path_elem.parent);
+	return count;
+}
+
+static inline size_t
+bps_tree_delete_range(struct bps_tree *tree, bps_tree_elem_t first,
+		      bps_tree_elem_t last)
+{
+	size_t deleted = 0;
+	if (BPS_TREE_COMPARE(first, last, tree->arg) > 0)
+		return 0;
+
+	/* Unlink the leaves that lie entirely within the range. */
+	struct bps_tree_iterator itr =
+		bps_tree_lower_bound_elem(tree, first, NULL);
+	struct bps_leaf *leaf = bps_tree_get_leaf_safe(tree, &itr);
+	bps_tree_block_id_t id = (bps_tree_block_id_t)(-1);
+	if (leaf != NULL)
+		id = itr.pos == 0 ? itr.block_id : leaf->next_id;
+	while (id != (bps_tree_block_id_t)(-1)) {
+		leaf = (struct bps_leaf *)bps_tree_restore_block(tree, id);
+		if (BPS_TREE_COMPARE(leaf->elems[leaf->header.size - 1],
+				     last, tree->arg) > 0)
+			break;
+		/* Leaves are not relocated by deletion from inners. */
+		id = leaf->next_id;
+		deleted += bps_tree_process_delete_whole_leaf(tree,
+							      leaf->elems[0]);
+	}
+
+	/* Delete what is left element by element. */
+	while (true) {
+		itr = bps_tree_lower_bound_elem(tree, first, NULL);
+		bps_tree_elem_t *elem = bps_tree_iterator_get_elem(tree, &itr);
+		if (elem == NULL ||
+		    BPS_TREE_COMPARE(*elem, last, tree->arg) > 0)
+			break;
+		bps_tree_delete(tree, *elem);
+		deleted++;
+	}
+	return deleted;
+}
+
 /**
  * @brief Recursively find a maximum element in subtree.
  * Used only for debug purposes
@@ -6,7 +6,7 @@ local socket = require('socket')
 local fio = require('fio')
 local uuid = require('uuid')
 local msgpack = require('msgpack')
-test:plan(108)
+test:plan(112)
 
 --------------------------------------------------------------------------------
 -- Invalid values
@@ -35,6 +35,10 @@ invalid('replication_sync_timeout', 0)
 invalid('replication_connect_timeout', -1)
 invalid('replication_connect_timeout', 0)
 invalid('replication_connect_quorum', -1)
+invalid('replication_compression', -1)
+invalid('replication_compression', 100)
+invalid('replication_join_workers', 0)
+invalid('replication_join_workers', 1000)
 invalid('wal_mode', 'invalid')
 invalid('listen', '//!')
 invalid('log', ':')
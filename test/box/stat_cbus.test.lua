@@ -0,0 +1,41 @@
+--
+-- Statistics of cbus pipes.
+--
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+
+st = box.stat.cbus()
+st['main->wal'] ~= nil
+st['wal->tx_prio'] ~= nil
+pushed = st['main->wal'].pushed
+delivered = st['main->wal'].delivered
+
+for i = 1, 10 do s:replace{i} end
+
+st = box.stat.cbus()['main->wal']
+st.pushed >= pushed + 10
+st.delivered >= delivered + 10
+st.delivered <= st.pushed
+st.queue >= 0
+st.waits
+st.latency.p50 > 0
+st.latency.p50 <= st.latency.p90
+st.latency.p90 <= st.latency.p99
+st.batch.p50 >= 1
+st.batch.p50 <= st.batch.p99
+
+--
+-- wal_queue_max_len bounds the tx->wal pipe.
+--
+box.cfg{wal_queue_max_len = -1}
+box.cfg{wal_queue_max_len = 1}
+fiber = require('fiber')
+waits = box.stat.cbus()['main->wal'].waits
+ch = fiber.channel(10)
+for i = 11, 20 do fiber.create(function() s:replace{i} ch:put(true) end) end
+for i = 11, 20 do ch:get() end
+s:count()
+box.stat.cbus()['main->wal'].waits > waits
+box.cfg{wal_queue_max_len = 0}
+
+s:drop()
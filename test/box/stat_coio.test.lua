@@ -0,0 +1,58 @@
+test_run = require('test_run').new()
+fio = require('fio')
+fiber = require('fiber')
+socket = require('socket')
+
+--
+-- Statistics of coio tasks.
+--
+st = box.stat.coio()
+st.getaddrinfo ~= nil
+st.file_write ~= nil
+write_count = st.file_write.count
+meta_count = st.file_meta.count
+remove_count = st.file_remove.count
+dns_count = st.getaddrinfo.count
+
+path = fio.pathjoin(fio.cwd(), 'stat_coio.txt')
+f = fio.open(path, {'O_CREAT', 'O_WRONLY'}, tonumber('644', 8))
+f:write('test')
+f:close()
+fio.unlink(path)
+_ = socket.getaddrinfo('localhost', 80)
+
+st = box.stat.coio()
+st.file_write.count > write_count
+st.file_meta.count >= meta_count + 2
+st.file_remove.count > remove_count
+st.getaddrinfo.count > dns_count
+st.file_write.wait.p50 <= st.file_write.wait.p90
+st.file_write.wait.p90 <= st.file_write.wait.p99
+st.file_write.exec.p50 > 0
+st.file_write.exec.p50 <= st.file_write.exec.p99
+
+--
+-- Limit on the number of worker threads bulk tasks may occupy.
+--
+box.cfg{worker_pool_bulk_threads = 0}
+box.cfg{worker_pool_bulk_threads = 1}
+box.cfg.worker_pool_bulk_threads
+
+done = 0
+test_run:cmd("setopt delimiter ';'")
+for i = 1, 10 do
+    fiber.create(function()
+        local p = path .. i
+        local f = fio.open(p, {'O_CREAT', 'O_WRONLY'}, tonumber('644', 8))
+        f:write(string.rep('x', 1024))
+        f:fsync()
+        f:close()
+        fio.unlink(p)
+        done = done + 1
+    end)
+end;
+test_run:cmd("setopt delimiter ''");
+test_run:wait_cond(function() return done == 10 end)
+box.stat.coio().file_sync.count >= 10
+
+box.cfg{worker_pool_bulk_threads = 2}
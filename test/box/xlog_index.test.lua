@@ -0,0 +1,82 @@
+test_run = require('test_run').new()
+fio = require('fio')
+digest = require('digest')
+
+--
+-- WAL files are supplied with a sparse index mapping file
+-- offsets to vclocks, which is used to skip rows that have
+-- already been recovered or sent to a replica.
+--
+box.snapshot()
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 300 do s:insert{i, digest.urandom(10000)} end
+
+indexes = fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog.index'))
+table.sort(indexes)
+#indexes > 0
+wal = indexes[#indexes]:gsub('%.index$', '')
+f = fio.open(indexes[#indexes])
+data = f:read()
+f:close()
+lines = data:split('\n')
+#lines > 1
+lines[#lines]
+valid = true
+prev = 0
+test_run:cmd("setopt delimiter ';'")
+for i = 1, #lines - 1 do
+    local offset = tonumber(lines[i]:match('^(%d+) {.*}$'))
+    if offset == nil or offset <= prev or offset > fio.stat(wal).size then
+        valid = false
+    end
+    prev = offset or prev
+end;
+test_run:cmd("setopt delimiter ''");
+valid
+
+test_run:cmd('restart server default')
+test_run = require('test_run').new()
+fio = require('fio')
+digest = require('digest')
+s = box.space.test
+s:count()
+s:get(300)[1]
+s:drop()
+
+--
+-- The relay uses the index to skip rows the replica already
+-- has when the replica reconnects.
+--
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+test_run:cmd('create server replica with rpl_master=default, script="replication/replica.lua"')
+test_run:cmd('start server replica')
+for i = 1, 300 do s:insert{i, digest.urandom(10000)} end
+test_run:wait_lsn('replica', 'default')
+test_run:cmd('stop server replica')
+_ = s:insert{301}
+log_level = box.cfg.log_level
+box.cfg{log_level = 6}
+test_run:cmd('start server replica')
+test_run:wait_log('default', 'skipping %d+ bytes covered by', nil, 10) ~= nil
+test_run:wait_lsn('replica', 'default')
+test_run:cmd('switch replica')
+box.space.test:count()
+test_run:cmd('switch default')
+box.cfg{log_level = log_level}
+test_run:cmd('stop server replica')
+test_run:cmd('cleanup server replica')
+test_run:cmd('delete server replica')
+test_run:cleanup_cluster()
+s:drop()
+box.schema.user.revoke('guest', 'replication')
+
+-- The index is removed along with the WAL.
+box.snapshot()
+box.space._schema:replace{'xlog_index'}
+box.snapshot()
+box.space._schema:delete{'xlog_index'}
+box.snapshot()
+test_run:wait_cond(function() return #fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog.index')) == 0 end)
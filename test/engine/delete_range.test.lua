@@ -0,0 +1,86 @@
+test_run = require('test_run').new()
+engine = test_run:get_cfg('engine')
+
+s = box.schema.space.create('test', {engine = engine})
+pk = s:create_index('pk', {parts = {1, 'unsigned', 2, 'unsigned'}})
+sk = s:create_index('sk', {parts = {3, 'string'}, unique = false})
+for i = 1, 10 do for j = 1, 3 do s:replace{i, j, tostring(i * j)} end end
+s:count()
+
+-- The deletion is logged as a single row.
+lsn = box.info.lsn
+pk:delete_range({3}, {5})
+box.info.lsn - lsn
+pk:select({2}, {iterator = 'ge', limit = 8})
+sk:count()
+
+-- Partial keys, lower bound is inclusive, upper bound is exclusive.
+pk:delete_range({1, 2}, {2, 2})
+pk:select({}, {limit = 5})
+
+-- Empty range.
+lsn = box.info.lsn
+pk:delete_range({5}, {5})
+pk:delete_range({9}, {6})
+box.info.lsn - lsn
+s:count()
+
+-- Unbounded ranges.
+pk:delete_range({9}, {})
+pk:delete_range({}, {6})
+pk:select()
+sk:select()
+
+-- Rollback.
+box.begin() pk:delete_range({}, {}) c = s:count() box.rollback()
+c
+s:count()
+sk:count()
+box.begin() s:replace{8, 1, 'x'} pk:delete_range({7}, {8, 2}) box.commit()
+pk:select()
+
+-- The deletion survives restart.
+test_run:cmd('restart server default')
+test_run = require('test_run').new()
+s = box.space.test
+s:select()
+s.index.sk:select()
+
+-- Errors.
+s.index.pk:delete_range({'a'}, {})
+s.index.pk:delete_range({}, {1, 2, 3})
+s.index.sk:delete_range({}, {})
+t = s:on_replace(function() end)
+s.index.pk:delete_range({}, {})
+s:on_replace(nil, t)
+box.space._space.index.primary:delete_range({}, {})
+
+s.index.pk:delete_range({}, {})
+s:count()
+s:drop()
+
+--
+-- Triggers are only checked for local requests: a replica
+-- applies a range deletion to a space with triggers.
+--
+engine = test_run:get_cfg('engine')
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test', {engine = engine})
+_ = s:create_index('pk')
+for i = 1, 10 do s:replace{i} end
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+test_run:cmd("switch replica")
+t = box.space.test:on_replace(function() end)
+test_run:cmd("switch default")
+s.index.pk:delete_range({3}, {9})
+test_run:wait_lsn('replica', 'default')
+test_run:cmd("switch replica")
+box.space.test:select()
+box.info.replication[1].upstream.status
+test_run:cmd("switch default")
+test_run:cmd("stop server replica")
+_ = test_run:cmd("cleanup server replica")
+_ = test_run:cmd("delete server replica")
+s:drop()
+box.schema.user.revoke('guest', 'replication')
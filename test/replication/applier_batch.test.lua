@@ -0,0 +1,56 @@
+test_run = require('test_run').new()
+
+--
+-- The applier coalesces transactions received in a row into
+-- one WAL request, but must preserve their boundaries.
+--
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+
+test_run:cmd('create server replica with rpl_master=default, script="replication/replica.lua"')
+test_run:cmd('start server replica')
+test_run:cmd('stop server replica')
+
+-- Let the replica catch up with lots of small transactions.
+for i = 1, 1000 do s:insert{i} end
+for i = 1001, 2000, 2 do box.begin() s:insert{i} s:insert{i + 1} box.commit() end
+
+test_run:cmd('start server replica')
+_ = test_run:wait_vclock('replica', box.info.vclock)
+test_run:cmd('switch replica')
+box.space.test:count()
+-- 1500 transactions were written with much fewer WAL requests.
+box.stat.cbus()['main->wal'].pushed < 1500 / 10
+box.snapshot()
+
+xlog = require('xlog')
+fio = require('fio')
+files = fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog'))
+table.sort(files)
+count, broken = 0, 0
+last = nil
+for _, file in ipairs(files) do                                 \
+    for _, row in xlog.pairs(file) do                           \
+        local h = row.HEADER                                    \
+        if h.replica_id == 1 and h.type == 'INSERT' and         \
+           row.BODY.tuple[1] > 1000 then                        \
+            count = count + 1                                   \
+            local first = row.BODY.tuple[1] % 2 == 1            \
+            if first then last = h.tsn end                      \
+            if h.tsn ~= last or h.tsn == nil or                 \
+               (h.commit == true) == first then                 \
+                broken = broken + 1                             \
+            end                                                 \
+        end                                                     \
+    end                                                         \
+end
+count
+broken
+
+test_run:cmd('switch default')
+test_run:cmd('stop server replica')
+test_run:cmd('cleanup server replica')
+test_run:cmd('delete server replica')
+s:drop()
+box.schema.user.revoke('guest', 'replication')
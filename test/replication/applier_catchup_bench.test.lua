@@ -0,0 +1,33 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+log = require('log')
+
+--
+-- Replica catch-up speed with lots of small transactions. The
+-- duration and the number of WAL requests it took are written
+-- to the log, the test only checks that all data is applied.
+--
+box.schema.user.grant('guest', 'replication')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+
+test_run:cmd('create server replica with rpl_master=default, script="replication/replica.lua"')
+test_run:cmd('start server replica')
+test_run:cmd('stop server replica')
+
+for i = 1, 200000 do s:insert{i, i} end
+
+start = fiber.clock()
+test_run:cmd('start server replica')
+_ = test_run:wait_vclock('replica', box.info.vclock)
+duration = fiber.clock() - start
+count = test_run:eval('replica', 'box.space.test:count()')[1]
+pushed = test_run:eval('replica', "box.stat.cbus()['main->wal'].pushed")[1]
+log.info('applier_catchup_bench: %d transactions in %.3f sec, %d WAL requests', count, duration, pushed)
+count
+
+test_run:cmd('stop server replica')
+test_run:cmd('cleanup server replica')
+test_run:cmd('delete server replica')
+s:drop()
+box.schema.user.revoke('guest', 'replication')
@@ -0,0 +1,46 @@
+test_run = require('test_run').new()
+
+--
+-- Compression of the replication stream.
+--
+box.schema.user.grant('guest', 'replication')
+box.cfg{replication_compression = 3}
+
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 1000 do s:insert{i, string.rep('x', 100)} end
+
+-- The initial data is received compressed.
+test_run:cmd('create server replica with rpl_master=default, script="replication/replica.lua"')
+test_run:cmd('start server replica')
+test_run:cmd('switch replica')
+box.space.test:count()
+u = box.info.replication[1].upstream
+u.compression ~= nil and u.compression.raw_bytes > u.compression.compressed_bytes or u
+
+-- So are the rows sent by the subscribe relay.
+test_run:cmd('switch default')
+for i = 1001, 2000 do s:insert{i, string.rep('x', 100)} end
+test_run:wait_cond(function()                                   \
+    local d = box.info.replication[2].downstream                \
+    return d.compression ~= nil and                             \
+           d.compression.raw_bytes > d.compression.compressed_bytes \
+end, 10)
+test_run:cmd('switch replica')
+test_run:wait_cond(function() return box.space.test:count() == 2000 end, 10)
+
+-- Compression can be disabled; it takes effect on reconnect.
+test_run:cmd('switch default')
+box.cfg{replication_compression = 0}
+test_run:cmd('restart server replica')
+box.info.replication[2].downstream.compression
+test_run:cmd('switch replica')
+box.info.replication[1].upstream.compression
+box.space.test:count()
+
+test_run:cmd('switch default')
+test_run:cmd('stop server replica')
+test_run:cmd('cleanup server replica')
+test_run:cmd('delete server replica')
+s:drop()
+box.schema.user.revoke('guest', 'replication')
@@ -0,0 +1,38 @@
+test_run = require('test_run').new()
+
+--
+-- Initial join with several workers sending spaces in parallel.
+--
+box.schema.user.grant('guest', 'replication')
+box.cfg{replication_join_workers = 4}
+
+for i = 1, 4 do                                                 \
+    local s = box.schema.space.create('memtx' .. i)             \
+    s:create_index('pk')                                        \
+    s:create_index('sk', {parts = {2, 'unsigned'}})             \
+    for j = 1, 1000 do s:insert{j, 1000 - j} end                \
+end
+v = box.schema.space.create('vinyl', {engine = 'vinyl'})
+_ = v:create_index('pk')
+for j = 1, 1000 do v:insert{j} end
+box.snapshot()
+for j = 1001, 2000 do v:insert{j} end
+
+test_run:cmd('create server replica with rpl_master=default, script="replication/replica.lua"')
+test_run:cmd('start server replica')
+test_run:cmd('switch replica')
+box.space.memtx1:count(), box.space.memtx2:count(), box.space.memtx3:count(), box.space.memtx4:count()
+box.space.memtx4.index.sk:get(0)
+box.space.vinyl:count()
+box.space.vinyl:max()
+
+test_run:cmd('switch default')
+-- The master logs how long it took to send the initial data.
+test_run:grep_log('default', 'initial data sent: %d+ rows in') ~= nil
+test_run:cmd('stop server replica')
+test_run:cmd('cleanup server replica')
+test_run:cmd('delete server replica')
+for i = 1, 4 do box.space['memtx' .. i]:drop() end
+v:drop()
+box.cfg{replication_join_workers = 1}
+box.schema.user.revoke('guest', 'replication')
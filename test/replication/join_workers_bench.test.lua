@@ -0,0 +1,54 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+log = require('log')
+
+--
+-- Initial join time with one and several join workers. The
+-- durations are written to the log, the test only checks that
+-- both joins transfer all the data.
+--
+box.schema.user.grant('guest', 'replication')
+
+for i = 1, 8 do                                                 \
+    local s = box.schema.space.create('memtx' .. i)             \
+    s:create_index('pk')                                        \
+    s:create_index('sk', {parts = {2, 'string'}})               \
+    box.begin()                                                 \
+    for j = 1, 50000 do                                         \
+        s:insert{j, string.rep(tostring(j), 10)}                \
+        if j % 1000 == 0 then box.commit() box.begin() end      \
+    end                                                         \
+    box.commit()                                                \
+end
+v = box.schema.space.create('vinyl', {engine = 'vinyl'})
+_ = v:create_index('pk', {range_size = 1024 * 1024})
+for j = 1, 100000, 1000 do                                      \
+    box.begin()                                                 \
+    for k = j, j + 999 do v:insert{k, string.rep('x', 100)} end \
+    box.commit()                                                \
+end
+box.snapshot()
+
+test_run:cmd("setopt delimiter ';'")
+function join(workers)
+    box.cfg{replication_join_workers = workers}
+    test_run:cmd('create server replica with rpl_master=default, script="replication/replica.lua"')
+    local start = fiber.clock()
+    test_run:cmd('start server replica')
+    local duration = fiber.clock() - start
+    local count = test_run:eval('replica', 'box.space.memtx8:count() + box.space.vinyl:count()')[1]
+    test_run:cmd('stop server replica')
+    test_run:cmd('cleanup server replica')
+    test_run:cmd('delete server replica')
+    log.info('join_workers_bench: %d workers: %.3f sec', workers, duration)
+    return count
+end;
+test_run:cmd("setopt delimiter ''");
+
+join(1)
+join(4)
+
+for i = 1, 8 do box.space['memtx' .. i]:drop() end
+v:drop()
+box.cfg{replication_join_workers = 1}
+box.schema.user.revoke('guest', 'replication')
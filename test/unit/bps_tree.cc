@@ -858,6 +858,59 @@ delete_value_check()
 	footer();
 }
 
+static void
+delete_range_check()
+{
+	header();
+	srand(0);
+
+	test tree;
+	test_create(&tree, 0, extent_alloc, extent_free, &extents_count);
+
+	const int rounds = 1000;
+	const int elem_limit = 2048;
+	bool present[elem_limit];
+
+	for (int i = 0; i < rounds; i++) {
+		memset(present, 0, sizeof(present));
+		size_t count = 0;
+		int fill = rand() % elem_limit;
+		for (int j = 0; j < fill; j++) {
+			type_t v = rand() % elem_limit;
+			if (!present[v])
+				count++;
+			present[v] = true;
+			test_insert(&tree, v, 0);
+		}
+		type_t first = rand() % elem_limit;
+		type_t last = first + rand() % (elem_limit - first);
+		size_t expected = 0;
+		for (type_t v = first; v <= last; v++) {
+			if (present[v])
+				expected++;
+			present[v] = false;
+		}
+		if (test_delete_range(&tree, first, last) != expected)
+			fail("deleted count mismatch", "true");
+		if (test_size(&tree) != count - expected)
+			fail("tree count mismatch", "true");
+		if (test_debug_check(&tree)) {
+			test_print(&tree, TYPE_F);
+			fail("debug check nonzero", "true");
+		}
+		for (type_t v = 0; v < elem_limit; v++) {
+			if ((test_find(&tree, v) != NULL) != present[v])
+				fail("trees identity", "false");
+		}
+		for (type_t v = 0; v < elem_limit; v++)
+			test_delete(&tree, v);
+	}
+
+	test_destroy(&tree);
+
+	footer();
+}
+
 int
 main(void)
 {
@@ -873,4 +926,5 @@ main(void)
 		fail("memory leak!", "true");
 	insert_get_iterator();
 	delete_value_check();
+	delete_range_check();
 }
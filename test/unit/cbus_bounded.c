@@ -0,0 +1,150 @@
+#include <string.h>
+
+#include "memory.h"
+#include "fiber.h"
+#include "cbus.h"
+#include "unit.h"
+
+/** Worker thread, which receives messages from the main thread. */
+static struct cord worker;
+/** Queue of messages from the main to the worker thread. */
+static struct cpipe pipe_to_worker;
+/** Queue of messages from the worker to the main thread. */
+static struct cpipe pipe_to_main;
+/** Locked by the main thread to stall the worker thread. */
+static pthread_mutex_t stall_mutex;
+
+static int
+worker_f(va_list ap)
+{
+	(void) ap;
+	cpipe_create(&pipe_to_main, "main");
+	struct cbus_endpoint endpoint;
+	cbus_endpoint_create(&endpoint, "worker", fiber_schedule_cb, fiber());
+	cbus_loop(&endpoint);
+	cbus_endpoint_destroy(&endpoint, cbus_process);
+	cpipe_destroy(&pipe_to_main);
+	return 0;
+}
+
+static void
+do_nothing(struct cmsg *m)
+{
+	(void) m;
+}
+
+/** Block the worker until the main thread unlocks the mutex. */
+static void
+do_stall(struct cmsg *m)
+{
+	(void) m;
+	tt_pthread_mutex_lock(&stall_mutex);
+	tt_pthread_mutex_unlock(&stall_mutex);
+}
+
+/** Look up statistics of the pipe with the given name. */
+static bool
+find_pipe_stat(const char *name, struct cpipe_stat *result)
+{
+	int count;
+	struct cpipe_stat *stats = cbus_pipe_stat(&count);
+	fail_if(stats == NULL);
+	bool found = false;
+	for (int i = 0; i < count; i++) {
+		if (strcmp(stats[i].name, name) == 0) {
+			*result = stats[i];
+			found = true;
+		}
+	}
+	free(stats);
+	return found;
+}
+
+static void
+test_bounded_pipe(void)
+{
+	static struct cmsg_hop stall_route[] = {{ do_stall, NULL }};
+	static struct cmsg_hop nothing_route[] = {{ do_nothing, NULL }};
+	static struct cmsg stall_msg;
+	static struct cmsg msgs[3];
+
+	cpipe_set_max_size(&pipe_to_worker, 3);
+	is(cpipe_size(&pipe_to_worker), 0, "empty pipe size");
+	ok(!cpipe_is_full(&pipe_to_worker), "empty pipe isn't full");
+
+	tt_pthread_mutex_lock(&stall_mutex);
+	cmsg_init(&stall_msg, stall_route);
+	cpipe_push(&pipe_to_worker, &stall_msg);
+	for (int i = 0; i < 3; i++) {
+		cmsg_init(&msgs[i], nothing_route);
+		cpipe_push(&pipe_to_worker, &msgs[i]);
+	}
+	ok(cpipe_is_full(&pipe_to_worker), "pipe is full");
+	is(cpipe_wait_room(&pipe_to_worker, 0.01), -1,
+	   "wait for room times out while the consumer is stalled");
+	ok(cpipe_size(&pipe_to_worker) >= 3, "messages are queued");
+
+	tt_pthread_mutex_unlock(&stall_mutex);
+	is(cpipe_wait_room(&pipe_to_worker, TIMEOUT_INFINITY), 0,
+	   "wait for room succeeds when the consumer resumes");
+	ok(cpipe_size(&pipe_to_worker) < 3, "pipe has room");
+	cbus_flush(&pipe_to_worker, &pipe_to_main, cbus_process);
+	is(cpipe_size(&pipe_to_worker), 0, "all messages are delivered");
+
+	struct cpipe_stat stat;
+	ok(find_pipe_stat("main->worker", &stat), "pipe statistics");
+	/* 4 messages pushed by the test + 1 pushed by cbus_flush(). */
+	is(stat.pushed, 5, "pushed messages");
+	is(stat.delivered, 5, "delivered messages");
+	ok(stat.waits >= 1, "waits for room");
+	int64_t latency_count = 0;
+	for (int i = 0; i < CPIPE_STAT_HIST_SIZE; i++)
+		latency_count += stat.latency[i];
+	/* Only the first message is sampled for latency. */
+	is(latency_count, 1, "latency histogram is sampled");
+}
+
+static int
+main_f(va_list ap)
+{
+	(void) ap;
+	struct cbus_endpoint endpoint;
+	cbus_endpoint_create(&endpoint, "main", fiber_schedule_cb, fiber());
+	fail_if(cord_costart(&worker, "worker", worker_f, NULL) != 0);
+	cpipe_create(&pipe_to_worker, "worker");
+
+	test_bounded_pipe();
+
+	cbus_stop_loop(&pipe_to_worker);
+	cpipe_destroy(&pipe_to_worker);
+	fail_if(cord_join(&worker) != 0);
+	cbus_endpoint_destroy(&endpoint, cbus_process);
+	ev_break(loop(), EVBREAK_ALL);
+	return 0;
+}
+
+int
+main()
+{
+	header();
+	plan(13);
+
+	memory_init();
+	fiber_init(fiber_c_invoke);
+	cbus_init();
+	tt_pthread_mutex_init(&stall_mutex, NULL);
+
+	struct fiber *main_fiber = fiber_new("main", main_f);
+	assert(main_fiber != NULL);
+	fiber_wakeup(main_fiber);
+	ev_run(loop(), 0);
+
+	tt_pthread_mutex_destroy(&stall_mutex);
+	cbus_free();
+	fiber_free();
+	memory_free();
+
+	int rc = check_plan();
+	footer();
+	return rc;
+}
@@ -8,6 +8,7 @@
 #include "memory.h"
 #include "fiber.h"
 #include "cbus.h"
+#include "clock.h"
 #include "unit.h"
 
 /*
@@ -325,6 +326,243 @@ thread_func(va_list ap)
 	return 0;
 }
 
+/* {{{ Benchmark */
+
+/*
+ * Number of producer threads in the benchmark.
+ *
+ * Each producer thread sends messages to the consumer thread,
+ * which returns them back so that they can be sent again. This
+ * loads the pipes the same way as iproto and WAL load tx.
+ */
+static const int bench_producer_count = 4;
+
+/* Number of messages each producer may have in flight. */
+static const int bench_window = 512;
+
+/*
+ * Number of messages sent by each producer. May be overridden
+ * with the command line argument, see main().
+ */
+static int bench_msg_count = 20000;
+
+/* Print benchmark results if set. */
+static bool bench_verbose = false;
+
+struct bench_msg;
+
+/* Benchmark producer thread. */
+struct bench_producer {
+	/* Name of endpoint hosted by this thread. */
+	char name[32];
+	/* Cord corresponding to this thread. */
+	struct cord cord;
+	/* Pipe from this thread to the consumer. */
+	struct cpipe to;
+	/* Pipe from the consumer to this thread. */
+	struct cpipe from;
+	/* Route of messages sent by this thread. */
+	struct cmsg_hop route[2];
+	/* Messages sent by this thread, bench_window of them. */
+	struct bench_msg *msgs;
+	/* Number of messages sent/returned back by this thread. */
+	int sent, returned;
+	/*
+	 * Sequence number of the next message the consumer
+	 * expects from this thread and the number of messages
+	 * delivered out of order. Accessed only by the consumer.
+	 */
+	int expected_seq, reordered;
+};
+
+struct bench_msg {
+	struct cmsg cmsg;
+	/* Thread that sent this message. */
+	struct bench_producer *producer;
+	/* Sequence number of this message. */
+	int seq;
+	/* Time when this message was pushed to the pipe. */
+	double sent_at;
+};
+
+/* Consumer thread. */
+static struct cord bench_consumer;
+
+/* Number of buckets in the latency histogram. */
+enum { BENCH_HIST_SIZE = 24 };
+
+/*
+ * Latency statistics collected by the consumer thread.
+ * Bucket i of the histogram counts messages delivered in
+ * [2^i, 2^(i+1)) microseconds.
+ */
+static int bench_delivered;
+static double bench_latency_sum, bench_latency_max;
+static int bench_latency_hist[BENCH_HIST_SIZE];
+
+static void
+bench_msg_deliver_cb(struct cmsg *cmsg)
+{
+	struct bench_msg *msg = container_of(cmsg, struct bench_msg, cmsg);
+	struct bench_producer *p = msg->producer;
+	if (msg->seq != p->expected_seq)
+		p->reordered++;
+	p->expected_seq = msg->seq + 1;
+
+	double latency = clock_monotonic() - msg->sent_at;
+	bench_delivered++;
+	bench_latency_sum += latency;
+	if (latency > bench_latency_max)
+		bench_latency_max = latency;
+	int bucket = 0;
+	for (double usec = latency * 1e6; usec >= 2 &&
+	     bucket < BENCH_HIST_SIZE - 1; usec /= 2)
+		bucket++;
+	bench_latency_hist[bucket]++;
+}
+
+/* Send a message to the consumer. */
+static void
+bench_send(struct bench_producer *p, struct bench_msg *msg)
+{
+	cmsg_init(&msg->cmsg, p->route);
+	msg->producer = p;
+	msg->seq = p->sent++;
+	msg->sent_at = clock_monotonic();
+	cpipe_push_input(&p->to, &msg->cmsg);
+}
+
+static void
+bench_msg_return_cb(struct cmsg *cmsg)
+{
+	struct bench_msg *msg = container_of(cmsg, struct bench_msg, cmsg);
+	struct bench_producer *p = msg->producer;
+	p->returned++;
+	if (p->sent < bench_msg_count)
+		bench_send(p, msg);
+}
+
+static int
+bench_producer_f(va_list ap)
+{
+	struct bench_producer *p = va_arg(ap, struct bench_producer *);
+
+	struct cbus_endpoint endpoint;
+	cbus_endpoint_create(&endpoint, p->name, fiber_schedule_cb, fiber());
+	cbus_pair("bench_consumer", p->name, &p->to, &p->from,
+		  NULL, NULL, cbus_process);
+
+	p->route[0].f = bench_msg_deliver_cb;
+	p->route[0].pipe = &p->from;
+	p->route[1].f = bench_msg_return_cb;
+	p->route[1].pipe = NULL;
+	for (int i = 0; i < bench_window && p->sent < bench_msg_count; i++)
+		bench_send(p, &p->msgs[i]);
+	/*
+	 * Messages pushed in one event loop iteration are flushed
+	 * to the consumer in one batch.
+	 */
+	while (p->returned < bench_msg_count) {
+		cpipe_flush_input(&p->to);
+		fiber_yield();
+		cbus_process(&endpoint);
+	}
+
+	cbus_unpair(&p->to, &p->from, NULL, NULL, cbus_process);
+	cbus_endpoint_destroy(&endpoint, cbus_process);
+	return 0;
+}
+
+static int
+bench_consumer_f(va_list ap)
+{
+	(void)ap;
+	struct cbus_endpoint endpoint;
+	cbus_endpoint_create(&endpoint, "bench_consumer",
+			     fiber_schedule_cb, fiber());
+	cbus_loop(&endpoint);
+	cbus_endpoint_destroy(&endpoint, cbus_process);
+	return 0;
+}
+
+/*
+ * Return the upper bound of the given latency percentile,
+ * in microseconds.
+ */
+static int
+bench_latency_percentile(double pct)
+{
+	int count = 0;
+	for (int i = 0; i < BENCH_HIST_SIZE; i++) {
+		count += bench_latency_hist[i];
+		if (count >= bench_delivered * pct / 100)
+			return 1 << (i + 1);
+	}
+	return 1 << BENCH_HIST_SIZE;
+}
+
+/*
+ * Measure throughput and latency of message passing from
+ * many producers to one consumer.
+ */
+static void
+bench_run(void)
+{
+	if (cord_costart(&bench_consumer, "bench_consumer",
+			 bench_consumer_f, NULL) != 0)
+		unreachable();
+	struct cpipe consumer_pipe;
+	cpipe_create(&consumer_pipe, "bench_consumer");
+
+	struct bench_producer *producers = calloc(bench_producer_count,
+						  sizeof(*producers));
+	assert(producers != NULL);
+
+	double start = clock_monotonic();
+	for (int i = 0; i < bench_producer_count; i++) {
+		struct bench_producer *p = &producers[i];
+		snprintf(p->name, sizeof(p->name), "bench_producer_%d", i);
+		p->msgs = calloc(bench_window, sizeof(*p->msgs));
+		assert(p->msgs != NULL);
+		if (cord_costart(&p->cord, p->name, bench_producer_f, p) != 0)
+			unreachable();
+	}
+	for (int i = 0; i < bench_producer_count; i++) {
+		if (cord_join(&producers[i].cord) != 0)
+			unreachable();
+	}
+	double elapsed = clock_monotonic() - start;
+
+	cbus_stop_loop(&consumer_pipe);
+	cpipe_destroy(&consumer_pipe);
+	if (cord_join(&bench_consumer) != 0)
+		unreachable();
+
+	int reordered = 0;
+	for (int i = 0; i < bench_producer_count; i++) {
+		struct bench_producer *p = &producers[i];
+		fail_unless(p->sent == bench_msg_count);
+		fail_unless(p->returned == bench_msg_count);
+		reordered += p->reordered;
+		free(p->msgs);
+	}
+	fail_unless(reordered == 0);
+	fail_unless(bench_delivered == bench_producer_count * bench_msg_count);
+	free(producers);
+
+	if (!bench_verbose)
+		return;
+	printf("producers: %d, messages: %d, window: %d\n",
+	       bench_producer_count, bench_delivered, bench_window);
+	printf("throughput: %.0f msg/s\n", bench_delivered / elapsed);
+	printf("latency: avg %.1f us, p50 < %d us, p99 < %d us, "
+	       "max %.1f us\n", bench_latency_sum / bench_delivered * 1e6,
+	       bench_latency_percentile(50), bench_latency_percentile(99),
+	       bench_latency_max * 1e6);
+}
+
+/* }}} Benchmark */
+
 static int
 main_func(va_list ap)
 {
@@ -358,14 +596,26 @@ main_func(va_list ap)
 	free(threads);
 	threads = NULL;
 
+	bench_run();
+
 	ev_break(loop(), EVBREAK_ALL);
 
 	return 0;
 }
 
+/*
+ * Usage: cbus_stress.test [N]
+ *
+ * If N is given, each benchmark producer sends N messages and
+ * the benchmark results are printed.
+ */
 int
-main()
+main(int argc, char **argv)
 {
+	if (argc > 1) {
+		bench_msg_count = atoi(argv[1]);
+		bench_verbose = true;
+	}
 	srand(time(NULL));
 
 	memory_init();
@@ -0,0 +1,92 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "trivia/util.h"
+#include "unit.h"
+#include "vy_range_filter.h"
+
+enum {
+	VALUE_COUNT = 1000,
+	VALUE_STEP = 1024,
+	VALUE_BASE = 1 << 20,
+};
+
+static uint64_t
+value(int i)
+{
+	return VALUE_BASE + (uint64_t)i * VALUE_STEP;
+}
+
+static struct vy_range_filter *
+build_filter(void)
+{
+	struct vy_range_filter_builder builder;
+	vy_range_filter_builder_create(&builder);
+	for (int i = 0; i < VALUE_COUNT; i++) {
+		/* Duplicates must be ignored. */
+		vy_range_filter_builder_add(&builder, value(i));
+		vy_range_filter_builder_add(&builder, value(i));
+	}
+	struct vy_range_filter *filter = vy_range_filter_new(&builder, 0.01);
+	vy_range_filter_builder_destroy(&builder);
+	return filter;
+}
+
+int
+main()
+{
+	header();
+	plan(7);
+
+	struct vy_range_filter *filter = build_filter();
+
+	bool no_false_negatives = true;
+	for (int i = 0; i < VALUE_COUNT; i++) {
+		uint64_t v = value(i);
+		if (!vy_range_filter_maybe_has(filter, v, v) ||
+		    !vy_range_filter_maybe_has(filter, v - 100, v + 100))
+			no_false_negatives = false;
+	}
+	ok(no_false_negatives, "no false negatives");
+
+	ok(!vy_range_filter_maybe_has(filter, 0, VALUE_BASE - 1),
+	   "interval below min");
+	ok(!vy_range_filter_maybe_has(filter, value(VALUE_COUNT - 1) + 1,
+				      UINT64_MAX), "interval above max");
+	ok(vy_range_filter_maybe_has(filter, 0, UINT64_MAX),
+	   "interval spanning all values");
+
+	int false_positives = 0;
+	for (int i = 0; i < VALUE_COUNT - 1; i++) {
+		uint64_t v = value(i);
+		if (vy_range_filter_maybe_has(filter, v + VALUE_STEP / 8,
+					      v + VALUE_STEP - 1))
+			false_positives++;
+	}
+	ok(false_positives < VALUE_COUNT / 5, "false positive rate");
+
+	size_t size = vy_range_filter_size(filter);
+	char *buf = malloc(size);
+	char *end = vy_range_filter_encode(filter, buf);
+	const char *data = buf;
+	struct vy_range_filter *decoded = vy_range_filter_decode(&data);
+	ok(end == buf + size && data == end, "encode/decode");
+
+	bool same_answers = true;
+	for (int i = 0; i < VALUE_COUNT - 1; i++) {
+		uint64_t lo = value(i) + i % VALUE_STEP;
+		uint64_t hi = lo + i;
+		if (vy_range_filter_maybe_has(filter, lo, hi) !=
+		    vy_range_filter_maybe_has(decoded, lo, hi))
+			same_answers = false;
+	}
+	ok(same_answers, "decoded filter gives the same answers");
+
+	vy_range_filter_delete(decoded);
+	vy_range_filter_delete(filter);
+	free(buf);
+
+	footer();
+	return check_plan();
+}
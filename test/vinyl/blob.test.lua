@@ -0,0 +1,140 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+fio = require('fio')
+
+--
+-- Check validation of the blob_threshold index option.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+s:create_index('pk', {blob_threshold = -1})
+_ = s:create_index('pk', {blob_threshold = 1000})
+s.index.pk.options.blob_threshold
+s:create_index('sk', {parts = {2, 'unsigned'}, blob_threshold = 1000})
+s.index.pk:alter{blob_threshold = 0}
+s.index.pk.options.blob_threshold
+s:drop()
+
+--
+-- Check that big values are moved to blob files on dump and
+-- loaded back transparently on read, upsert, and compaction.
+--
+box.cfg{checkpoint_count = 1}
+
+-- Temporary space for bumping lsn.
+temp = box.schema.space.create('temp')
+_ = temp:create_index('pk')
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {blob_threshold = 1000, run_count_per_level = 10, range_size = 16 * 1024 * 1024})
+_ = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+
+path = fio.pathjoin(box.cfg.vinyl_dir, tostring(s.id), tostring(s.index.pk.id))
+
+test_run:cmd("setopt delimiter ';'")
+function ls_blobs()
+    return #fio.glob(fio.pathjoin(path, '*.blob'))
+end;
+function gc()
+    temp:auto_increment{}
+    box.snapshot()
+end;
+-- Keys greater than 10 have small values, which are never
+-- moved to blob files.
+function value(i)
+    if i > 10 then
+        return 'x'
+    end
+    return string.rep(string.char(string.byte('a') + i), 2000)
+end;
+-- Return {key, counter} pairs stored in an index and check
+-- that all values have been loaded.
+function check(index)
+    local result = {}
+    for _, t in index:pairs() do
+        if t[3] ~= value(t[1]) then
+            return 'invalid value for key ' .. t[1]
+        end
+        table.insert(result, {t[1], t[4]})
+    end
+    return result
+end;
+test_run:cmd("setopt delimiter ''");
+
+for i = 1, 12 do s:replace{i, i % 3, value(i), 0} end
+box.snapshot()
+ls_blobs()
+check(s.index.pk)
+check(s.index.sk)
+
+s:upsert({1, 1, value(1), 0}, {{'+', 4, 1}})
+_ = s:update(2, {{'=', 2, 5}, {'+', 4, 1}})
+s:delete(3)
+check(s.index.pk)
+check(s.index.sk)
+box.snapshot()
+ls_blobs()
+check(s.index.pk)
+check(s.index.sk)
+
+for i = 4, 10 do s:replace{i, i % 3, value(i), 2} end
+box.snapshot()
+ls_blobs()
+check(s.index.pk)
+check(s.index.sk)
+
+-- Compaction carries blob references over to the new run.
+-- The blob file written on the first dump isn't referenced
+-- anymore and so is deleted by garbage collection.
+s.index.pk:compact()
+test_run:wait_cond(function() return s.index.pk:stat().run_count == 1 end)
+gc()
+ls_blobs()
+check(s.index.pk)
+check(s.index.sk)
+
+-- Check that blob references are recovered.
+test_run:cmd('restart server default')
+
+fio = require('fio')
+box.cfg{checkpoint_count = 1}
+s = box.space.test
+temp = box.space.temp
+path = fio.pathjoin(box.cfg.vinyl_dir, tostring(s.id), tostring(s.index.pk.id))
+
+test_run:cmd("setopt delimiter ';'")
+function ls_blobs()
+    return #fio.glob(fio.pathjoin(path, '*.blob'))
+end;
+function gc()
+    temp:auto_increment{}
+    box.snapshot()
+end;
+function value(i)
+    if i > 10 then
+        return 'x'
+    end
+    return string.rep(string.char(string.byte('a') + i), 2000)
+end;
+function check(index)
+    local result = {}
+    for _, t in index:pairs() do
+        if t[3] ~= value(t[1]) then
+            return 'invalid value for key ' .. t[1]
+        end
+        table.insert(result, {t[1], t[4]})
+    end
+    return result
+end;
+test_run:cmd("setopt delimiter ''");
+
+ls_blobs()
+check(s.index.pk)
+check(s.index.sk)
+
+-- Check that blob files are deleted along with the space.
+s:drop()
+gc()
+#fio.glob(fio.pathjoin(path, '*'))
+
+temp:drop()
+box.cfg{checkpoint_count = 2}
@@ -0,0 +1,59 @@
+test_run = require('test_run').new()
+
+--
+-- Check that a scan over cold keys can't wash frequently read
+-- tuples out of the tuple cache.
+--
+vinyl_cache = box.cfg.vinyl_cache
+box.cfg{vinyl_cache = 20 * 1024}
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+pad = string.rep('x', 1000)
+for i = 1, 200 do s:replace{i, pad} end
+box.snapshot()
+
+-- Make the first 18 keys hot. They fill the cache.
+for i = 1, 18 do s:get{i} end
+for i = 1, 18 do s:get{i} end
+st = s.index.pk:stat().cache
+st.rows
+st.hit
+
+-- Cold keys are rejected by the admission policy.
+st1 = s.index.pk:stat().cache
+#s:select({100}, {iterator = 'GE'})
+st2 = s.index.pk:stat().cache
+st2.put.rows - st1.put.rows
+st2.reject.rows - st1.reject.rows
+st2.evict.rows - st1.evict.rows
+st2.rows
+
+-- Hot keys are still cached.
+st1 = s.index.pk:stat().cache
+for i = 1, 18 do s:get{i} end
+st2 = s.index.pk:stat().cache
+st2.hit - st1.hit
+
+--
+-- Check that the 'cache' option of select and pairs disables
+-- populating the cache with tuples read by the request.
+--
+for i = 1, 200 do s:replace{i, pad} end
+st1 = s.index.pk:stat().cache
+#s:select({}, {cache = false})
+n = 0
+for _ in s:pairs({100}, {iterator = 'GE', cache = false}) do n = n + 1 end
+n
+st2 = s.index.pk:stat().cache
+st2.put.rows - st1.put.rows
+st2.reject.rows - st1.reject.rows
+st2.rows
+
+#s:select({}, {limit = 5})
+st3 = s.index.pk:stat().cache
+st3.put.rows - st2.put.rows
+st3.rows
+
+s:drop()
+box.cfg{vinyl_cache = vinyl_cache}
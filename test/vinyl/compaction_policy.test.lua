@@ -0,0 +1,114 @@
+test_run = require('test_run').new()
+
+--
+-- Check validation of the compaction_policy index option.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+s:create_index('pk', {compaction_policy = 'foo'})
+s:create_index('pk', {compaction_policy = 1})
+_ = s:create_index('pk')
+s.index.pk.options.compaction_policy
+s.index.pk:alter{compaction_policy = 'leveled'}
+s.index.pk.options.compaction_policy
+s.index.pk:alter{compaction_policy = 'tiered'}
+s.index.pk.options.compaction_policy
+s:drop()
+
+--
+-- Compare the tiered and leveled compaction policies.
+-- Use a separate server, because amplification statistics
+-- are accounted per compaction policy for all indexes.
+--
+test_run:cmd('create server test with script = "vinyl/stat.lua"')
+test_run:cmd('start server test')
+test_run:cmd('switch test')
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+-- The primary index uses the tiered policy while the secondary
+-- index uses the leveled policy. Both get the same data.
+pk = s:create_index('pk', {run_count_per_level = 10, range_size = 16 * 1024 * 1024})
+sk = s:create_index('sk', {parts = {2, 'unsigned'}, run_count_per_level = 10, range_size = 16 * 1024 * 1024, compaction_policy = 'leveled'})
+
+test_run:cmd("setopt delimiter ';'")
+function dump(first, count)
+    for i = first, first + count - 1 do
+        s:replace{i, i, string.rep('x', 100)}
+    end
+    box.snapshot()
+end;
+test_run:cmd("setopt delimiter ''");
+
+-- Create runs of 1000, 100, 100, and 10 statements.
+-- The 100-statement runs fall into the same level.
+-- The tiered policy tolerates up to run_count_per_level
+-- runs at this level while the leveled policy compacts
+-- them along with the upper level.
+dump(1000, 1000)
+dump(2000, 100)
+dump(2100, 100)
+dump(2200, 10)
+test_run:wait_cond(function() return sk:stat().disk.compaction.count > 0 end)
+test_run:wait_cond(function() return sk:stat().disk.compaction.queue.bytes == 0 end)
+
+pk:stat().run_count
+sk:stat().run_count
+pk:stat().disk.compaction.count
+sk:stat().disk.compaction.count
+
+amp = box.stat.vinyl().amplification
+amp.tiered.read
+amp.leveled.read
+amp.leveled.write > amp.tiered.write
+
+s:count()
+sk:max()[2]
+
+-- Switching the policy back moves the index in statistics.
+sk:alter{compaction_policy = 'tiered'}
+amp = box.stat.vinyl().amplification
+amp.tiered.read
+amp.leveled.read
+
+s:drop()
+
+--
+-- Read amplification is accounted per range: a run spanning
+-- many ranges adds a slice to each of them. Restart to drop
+-- statistics of the space above.
+--
+test_run:cmd('switch default')
+test_run:cmd('restart server test')
+test_run:cmd('switch test')
+
+test_run = require('test_run').new()
+fiber = require('fiber')
+s = box.schema.space.create('test', {engine = 'vinyl'})
+pk = s:create_index('pk', {page_size = 256, range_size = 2048, run_count_per_level = 1, run_size_ratio = 1000})
+
+-- Rewrite the space until it is split into several ranges.
+test_run:cmd("setopt delimiter ';'")
+iter = 0
+while pk:stat().range_count < 4 do
+    iter = iter + 1
+    for k = 1, 200 do s:replace{k, iter, string.rep('x', 32)} end
+    box.snapshot()
+    fiber.sleep(0.01)
+end;
+test_run:cmd("setopt delimiter ''");
+-- Wait until every range is compacted into one slice.
+test_run:wait_cond(function() return pk:stat().disk.compaction.queue.bytes == 0 end)
+box.stat.vinyl().amplification.tiered.read
+
+-- Dump a run spanning all ranges and don't let it be compacted.
+pk:alter{run_count_per_level = 10}
+s:replace{1, 0}
+s:replace{200, 0}
+box.snapshot()
+pk:stat().run_histogram == '[2]:' .. pk:stat().range_count
+box.stat.vinyl().amplification.tiered.read
+
+s:drop()
+
+test_run:cmd('switch default')
+test_run:cmd('stop server test')
+test_run:cmd('cleanup server test')
@@ -0,0 +1,105 @@
+test_run = require('test_run').new()
+
+--
+-- Check validation of the compression_dict_size index option.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+s:create_index('pk', {compression_dict_size = -1})
+s:create_index('pk', {compression_dict_size = 2 * 1024 * 1024})
+_ = s:create_index('pk', {compression_dict_size = 4096})
+s.index.pk.options.compression_dict_size
+s.index.pk:alter{compression_dict_size = 0}
+s.index.pk.options.compression_dict_size
+s:drop()
+
+--
+-- Check that pages written by compaction are compressed with
+-- a dictionary trained on the run data.
+--
+s1 = box.schema.space.create('test1', {engine = 'vinyl'})
+_ = s1:create_index('pk', {page_size = 1024, run_count_per_level = 10, compression_dict_size = 4096})
+s2 = box.schema.space.create('test2', {engine = 'vinyl'})
+_ = s2:create_index('pk', {page_size = 1024, run_count_per_level = 10})
+
+test_run:cmd("setopt delimiter ';'")
+function value(i)
+    return string.format('{"name": "user%d", "email": "user%d@example.com", ' ..
+                         '"active": %s, "score": %d}', i, i,
+                         i % 2 == 0 and 'true' or 'false', i * 7 % 100)
+end;
+function fill(s, n)
+    for i = 1, 2000 do
+        s:replace{i, value(i + n)}
+    end
+    box.snapshot()
+end;
+function check(s)
+    local count = 0
+    for _, t in s:pairs() do
+        if t[2] ~= value(t[1] + 1) then
+            return 'invalid value for key ' .. t[1]
+        end
+        count = count + 1
+    end
+    return count
+end;
+function compact(s)
+    s.index.pk:compact()
+    test_run:wait_cond(function()
+        return s.index.pk:stat().run_count == 1
+    end)
+end;
+test_run:cmd("setopt delimiter ''");
+
+fill(s1, 0)
+fill(s1, 1)
+fill(s2, 0)
+fill(s2, 1)
+
+-- Dumped runs aren't compressed.
+s1.index.pk:stat().disk.dict_size
+
+compact(s1)
+compact(s2)
+
+s1.index.pk:stat().disk.dict_size > 0
+s2.index.pk:stat().disk.dict_size
+s1.index.pk:stat().disk.bytes_compressed < s2.index.pk:stat().disk.bytes_compressed
+
+check(s1)
+check(s2)
+
+-- Check that the dictionary is recovered.
+test_run:cmd('restart server default')
+
+test_run = require('test_run').new()
+s1 = box.space.test1
+s2 = box.space.test2
+
+test_run:cmd("setopt delimiter ';'")
+function value(i)
+    return string.format('{"name": "user%d", "email": "user%d@example.com", ' ..
+                         '"active": %s, "score": %d}', i, i,
+                         i % 2 == 0 and 'true' or 'false', i * 7 % 100)
+end;
+function check(s)
+    local count = 0
+    for _, t in s:pairs() do
+        if t[2] ~= value(t[1] + 1) then
+            return 'invalid value for key ' .. t[1]
+        end
+        count = count + 1
+    end
+    return count
+end;
+test_run:cmd("setopt delimiter ''");
+
+s1.index.pk:stat().disk.dict_size > 0
+check(s1)
+check(s2)
+
+-- Time spent reading pages is accounted.
+s1.index.pk:stat().disk.iterator.read_time > 0
+
+s1:drop()
+s2:drop()
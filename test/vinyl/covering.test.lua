@@ -0,0 +1,82 @@
+test_run = require('test_run').new()
+
+--
+-- Check validation of the covering index option.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+s:create_index('pk', {covering = 1})
+s:create_index('pk', {covering = true})
+_ = s:create_index('pk')
+s:create_index('sk', {parts = {{field = 2, type = 'unsigned', path = '[*]'}}, covering = true})
+_ = s:create_index('sk', {parts = {2, 'unsigned'}, covering = true})
+s.index.sk.options.covering
+s:drop()
+
+--
+-- Covering indexes can't be used along with ttl, because they
+-- would return expired tuples.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+pk = s:create_index('pk', {ttl = 3600, ttl_field = 2})
+s:create_index('sk', {parts = {3, 'unsigned'}, covering = true})
+pk:alter{ttl = 0}
+_ = s:create_index('sk', {parts = {3, 'unsigned'}, covering = true})
+pk:alter{ttl = 3600, ttl_field = 2}
+pk.options.ttl
+s.index.sk:alter{covering = false}
+pk:alter{ttl = 3600, ttl_field = 2}
+pk.options.ttl
+s.index.sk:alter{covering = true}
+s.index.sk.options.covering
+s:drop()
+
+--
+-- Check that reads from a covering index don't look up
+-- the primary index and return up-to-date tuples.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+_ = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false, covering = true})
+for i = 1, 10 do s:replace{i, i % 3, 'x' .. i} end
+box.snapshot()
+pk_lookups = s.index.pk:stat().lookup
+s.index.sk:select(1)
+s.index.pk:stat().lookup - pk_lookups
+
+-- UPDATE that doesn't change the secondary key.
+s:update(4, {{'=', 3, 'y4'}})
+s.index.sk:select(1)
+box.snapshot()
+s.index.sk:select(1)
+
+-- REPLACE and DELETE must not be deferred.
+s:replace{7, 2, 'z7'}
+s.index.sk:select(1)
+s.index.sk:select(2)
+s:delete(10)
+s.index.sk:select(1)
+
+-- Statements overwritten in the same transaction.
+box.begin() s:update(1, {{'=', 3, 'a'}}) s:update(1, {{'=', 3, 'b'}}) s:delete(1) box.commit()
+s.index.sk:select(1)
+box.begin() s:replace{2, 1, 'c'} s:replace{2, 0, 'd'} box.commit()
+s.index.sk:select(1)
+s.index.sk:select(0)
+s.index.sk:select(2)
+
+-- Full tuples are stored in runs.
+box.snapshot()
+test_run:cmd('restart server default')
+s = box.space.test
+s.index.sk.options.covering
+pk_lookups = s.index.pk:stat().lookup
+s.index.sk:select()
+s.index.pk:stat().lookup - pk_lookups
+
+-- Switching the option off rebuilds the index.
+s.index.sk:alter{covering = false}
+s.index.sk.options.covering
+pk_lookups = s.index.pk:stat().lookup
+s.index.sk:select(1)
+s.index.pk:stat().lookup - pk_lookups
+s:drop()
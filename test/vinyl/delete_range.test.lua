@@ -0,0 +1,70 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+txn_proxy = require('txn_proxy')
+
+--
+-- delete_range() writes a range tombstone to the primary index
+-- instead of a DELETE for each tuple falling in the range.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+pk = s:create_index('pk', {run_count_per_level = 10})
+sk = s:create_index('sk', {run_count_per_level = 10, parts = {2, 'unsigned'}, unique = false})
+for i = 1, 10 do s:replace{i, i * 10} end
+box.snapshot()
+
+pk:delete_range({3}, {8})
+pk:stat().memory.rows -- 0
+sk:stat().memory.rows -- 0
+pk:select()
+sk:select()
+pk:get(5)
+sk:select({50})
+s:count()
+
+-- Statements inserted by the same transaction after the tombstone
+-- aren't deleted while those inserted before it are.
+box.begin() s:replace{4, 41} s:replace{5, 51} pk:delete_range({5}, {6}) s:replace{6, 61} box.commit()
+pk:select()
+sk:select()
+
+-- A transaction that read the range is sent to a read view.
+c = txn_proxy.new()
+c:begin()
+c("s:get(9)")
+pk:delete_range({9}, {})
+c("s:get(9)")
+c("s:replace{9, 91}")
+c:commit()
+pk:select()
+
+-- The tombstone is replayed from WAL on restart.
+test_run:cmd('restart server default')
+fiber = require('fiber')
+s = box.space.test
+pk = s.index.pk
+sk = s.index.sk
+pk:select()
+sk:select()
+
+-- Once the tombstone is dumped, the primary index is compacted
+-- automatically and covered statements are replaced with DELETEs,
+-- which generate DELETEs for the secondary index.
+box.snapshot()
+test_run:wait_cond(function() return pk:stat().disk.compaction.count > 0 end)
+pk:stat().disk.rows -- 1, 2, 4, 6, 8
+pk:select()
+sk:select()
+box.snapshot()
+sk:compact()
+test_run:wait_cond(function() return sk:stat().disk.compaction.count > 0 end)
+sk:stat().disk.rows -- 5
+sk:select()
+
+-- The tombstone is loaded from the metadata log on restart.
+pk:delete_range({}, {4})
+box.snapshot()
+test_run:cmd('restart server default')
+s = box.space.test
+s.index.pk:select()
+s.index.sk:select()
+s:drop()
@@ -0,0 +1,49 @@
+--
+-- index:get_many() looks up a batch of keys at once.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {run_count_per_level = 10})
+_ = s:create_index('sk', {parts = {2, 'unsigned'}})
+_ = s:create_index('nu', {parts = {2, 'unsigned'}, unique = false})
+
+for i = 1, 100, 2 do s:replace{i, i * 10} end
+box.snapshot()
+for i = 1, 100, 3 do s:replace{i, i * 10} end
+box.snapshot()
+for i = 1, 100, 5 do s:delete{i} end
+s:replace{1000, 10000}
+
+s.index.pk:get_many({})
+s.index.pk:get_many({1, 2, 3, 4, 5, 6, 7, {1000}, 1001})
+s.index.sk:get_many({30, 40, 60, 10000})
+
+-- The result is consistent with index:get().
+keys = {}
+for i = 1, 120 do table.insert(keys, i) end
+result = s.index.pk:get_many(keys)
+ok = true
+for i = 1, 120 do if tostring(result[i]) ~= tostring(s:get(i)) then ok = false end end
+ok
+
+-- Batch statistics. Lookups of full tuples in the primary index
+-- done by sk:get_many() are batched, too.
+st = s.index.pk:stat().batch
+st.count
+st.keys
+st.disk_keys <= st.keys
+st.io_depth <= 16
+s.index.pk:stat().lookup >= st.keys
+
+-- Errors.
+s.index.pk:get_many(1)
+s.index.pk:get_many({{1, 2}})
+s.index.nu:get_many({10})
+
+-- get_many() is tracked by transactions.
+box.begin()
+s.index.pk:get_many({3, 5})
+_ = s:replace{3, 300}
+s.index.pk:get_many({3, 5})
+box.rollback()
+
+s:drop()
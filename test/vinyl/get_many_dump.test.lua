@@ -0,0 +1,26 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+errinj = box.error.injection
+
+--
+-- index:get_many() doesn't access statements read from in-memory
+-- trees after they are freed by a dump completed while the batch
+-- is reading disk.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {run_count_per_level = 10})
+for i = 1, 100 do s:replace{i, 0} end
+box.snapshot()
+for i = 1, 100 do s:upsert({i, 0}, {{'+', 2, i}}) end
+
+keys = {}
+for i = 10, 100, 10 do table.insert(keys, i) end
+errinj.set('ERRINJ_VY_READ_PAGE_DELAY', true)
+ch = fiber.channel(1)
+_ = fiber.create(function() ch:put(s.index.pk:get_many(keys)) end)
+fiber.sleep(0.01)
+box.snapshot()
+errinj.set('ERRINJ_VY_READ_PAGE_DELAY', false)
+ch:get()
+
+s:drop()
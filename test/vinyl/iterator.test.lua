@@ -816,6 +816,61 @@ box.commit()
 
 s:drop()
 
+--
+-- Check that the read iterator merges many runs correctly.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {run_count_per_level = 100})
+expected = {}
+test_run:cmd("setopt delimiter ';'")
+for r = 1, 12 do
+    for k = 1, 200 do
+        if (k * 7 + r) % 5 == 0 then
+            s:replace{k, r}
+            expected[k] = {k, r}
+        elseif (k + r) % 11 == 0 then
+            s:delete{k}
+            expected[k] = nil
+        end
+    end
+    box.snapshot()
+end;
+function check(iterator, key)
+    local keys = {}
+    for k, _ in pairs(expected) do table.insert(keys, k) end
+    local dir = (iterator == 'LE' or iterator == 'LT') and -1 or 1
+    table.sort(keys, function(a, b) return a * dir < b * dir end)
+    local result = {}
+    for _, k in ipairs(keys) do
+        if key == nil or
+           (iterator == 'GE' and k >= key) or
+           (iterator == 'GT' and k > key) or
+           (iterator == 'LE' and k <= key) or
+           (iterator == 'LT' and k < key) then
+            table.insert(result, expected[k])
+        end
+    end
+    local tuples = s:select(key, {iterator = iterator})
+    if #tuples ~= #result then
+        return false
+    end
+    for i, t in ipairs(tuples) do
+        if t[1] ~= result[i][1] or t[2] ~= result[i][2] then
+            return false
+        end
+    end
+    return true
+end;
+test_run:cmd("setopt delimiter ''");
+s.index.pk:stat().run_count -- 12
+check('GE')
+check('LE')
+check('GT', 50)
+check('LT', 150)
+check('GE', 77)
+check('LE', 133)
+s:drop()
+
 -- Collect all iterators to make sure no read views are left behind,
 -- as they might disrupt the following test run.
 collectgarbage()
@@ -0,0 +1,53 @@
+test_run = require('test_run').new()
+
+--
+-- Page cache.
+--
+vinyl_cache = box.cfg.vinyl_cache
+box.cfg{vinyl_cache = 0, vinyl_page_cache = 1024 * 1024}
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {run_count_per_level = 10})
+for i = 1, 100 do s:replace{i, string.rep('x', 100)} end
+box.snapshot()
+
+function pages() return s.index.pk:stat().disk.iterator.read.pages end
+function cache() return box.stat.vinyl().page_cache end
+
+-- The first lookup reads the page from disk.
+box.stat.reset()
+s:get(50)
+pages() > 0
+cache().put > 0
+cache().used > 0
+cache().hit
+
+-- The second lookup finds the page in the cache.
+p = pages()
+s:get(50)
+pages() == p
+cache().hit > 0
+
+-- The cached page is shared by iterators.
+#s:select({40}, {iterator = 'ge', limit = 20})
+
+-- Cached pages are dropped along with their run.
+s.index.pk:compact()
+test_run:wait_cond(function() return s.index.pk:stat().disk.compaction.count > 0 end)
+test_run:wait_cond(function() return cache().used == 0 end)
+
+-- Pages are evicted when the cache is shrunk.
+s:get(50)
+cache().used > 0
+box.cfg{vinyl_page_cache = 0}
+cache().used
+cache().evict > 0
+
+-- The cache is bypassed when disabled.
+box.stat.reset()
+s:get(50)
+cache().lookup
+cache().put
+
+s:drop()
+box.cfg{vinyl_cache = vinyl_cache, vinyl_page_cache = 0}
@@ -0,0 +1,114 @@
+test_run = require('test_run').new()
+
+--
+-- Check validation of the range_filter index option.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+s:create_index('pk', {range_filter = 1})
+s:create_index('pk', {parts = {1, 'number'}, range_filter = true})
+s:create_index('pk', {parts = {{1, 'string', collation = 'unicode_ci'}}, range_filter = true})
+_ = s:create_index('pk', {range_filter = true})
+s.index.pk.options.range_filter
+_ = s:create_index('sk', {parts = {2, 'string'}, range_filter = true})
+s.index.sk.options.range_filter
+s.index.pk:alter{range_filter = false}
+s.index.pk.options.range_filter
+s:drop()
+
+--
+-- Check that short range scans skip runs that don't have
+-- keys in the scanned interval and still return correct
+-- results. Space test2 is the same as test1, but without
+-- range filters.
+--
+s1 = box.schema.space.create('test1', {engine = 'vinyl'})
+_ = s1:create_index('pk', {run_count_per_level = 10, range_filter = true})
+_ = s1:create_index('sk', {parts = {2, 'integer'}, unique = false, run_count_per_level = 10, range_filter = true})
+s2 = box.schema.space.create('test2', {engine = 'vinyl'})
+_ = s2:create_index('pk', {run_count_per_level = 10})
+_ = s2:create_index('sk', {parts = {2, 'integer'}, unique = false, run_count_per_level = 10})
+
+test_run:cmd("setopt delimiter ';'")
+function fill(s)
+    for i = 0, 4 do
+        for j = 1, 100 do
+            s:replace{i * 1000 + j, j % 10 - 5}
+        end
+        box.snapshot()
+    end
+end;
+function keys(index, key, it)
+    local result = {}
+    for _, t in ipairs(index:select(key, {iterator = it, limit = 10})) do
+        table.insert(result, t[1])
+    end
+    return table.concat(result, ',')
+end;
+function check()
+    for _, it in ipairs({'EQ', 'REQ', 'GE', 'GT', 'LE', 'LT'}) do
+        for i = 0, 5 do
+            local key = i * 1000 + 50
+            if keys(s1.index.pk, key, it) ~= keys(s2.index.pk, key, it) then
+                return string.format('pk %s %d', it, key)
+            end
+        end
+        for key = -6, 5 do
+            if keys(s1.index.sk, key, it) ~= keys(s2.index.sk, key, it) then
+                return string.format('sk %s %d', it, key)
+            end
+        end
+    end
+    return true
+end;
+test_run:cmd("setopt delimiter ''");
+
+fill(s1)
+fill(s2)
+
+s1.index.pk:stat().run_count
+s1.index.pk:stat().disk.bloom_size > s2.index.pk:stat().disk.bloom_size
+check()
+
+st = s1.index.pk:stat().disk.iterator.range_filter
+st.hit > 0
+st.saved > 0
+s2.index.pk:stat().disk.iterator.range_filter.hit
+
+-- Range filters are stored in run index files.
+test_run:cmd('restart server default')
+test_run = require('test_run').new()
+s1 = box.space.test1
+s2 = box.space.test2
+s1.index.pk:stat().disk.iterator.range_filter.hit
+s1:select(3050, {iterator = 'GE', limit = 3})
+s1.index.pk:stat().disk.iterator.range_filter.hit > 0
+
+-- Check a run that stores a few clusters of keys.
+s1.index.pk:compact()
+test_run:wait_cond(function() return s1.index.pk:stat().run_count == 1 end)
+_ = s1:replace{500, 0}
+st = s1.index.pk:stat().disk.iterator.range_filter
+s1:select(150, {iterator = 'GE', limit = 1})
+s1.index.pk:stat().disk.iterator.range_filter.hit - st.hit
+
+s1:drop()
+s2:drop()
+
+--
+-- Check that a range filter built for one key part type isn't
+-- used after the index is altered to a type that is mapped to
+-- integers differently.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {range_filter = true})
+for i = 1, 10 do s:replace{i} end
+box.snapshot()
+s.index.pk:alter{parts = {1, 'integer'}}
+s:select(5, {iterator = 'GE', limit = 2})
+s:select(-1, {iterator = 'GE', limit = 1})
+s:select(20, {iterator = 'LE', limit = 1})
+s.index.pk:stat().disk.iterator.range_filter.hit
+_ = s:replace{-1}
+box.snapshot()
+s:select(-5, {iterator = 'GE', limit = 2})
+s:drop()
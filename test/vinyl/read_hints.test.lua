@@ -0,0 +1,27 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+errinj = box.error.injection
+
+--
+-- Reader threads hint the kernel about all queued page reads
+-- before reading them one by one.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {page_size = 128})
+pad = string.rep('x', 100)
+for i = 1, 100 do s:replace{i, pad} end
+box.snapshot()
+
+hints = errinj.get('ERRINJ_VY_READ_PAGE_HINT_COUNT')
+errinj.set('ERRINJ_VY_READ_PAGE_DELAY', true)
+ch = fiber.channel(10)
+for i = 1, 10 do fiber.create(function() ch:put(s:get(i * 10)) end) end
+fiber.sleep(0.01)
+errinj.set('ERRINJ_VY_READ_PAGE_DELAY', false)
+result = {}
+for i = 1, 10 do table.insert(result, ch:get()[1]) end
+table.sort(result)
+result
+errinj.get('ERRINJ_VY_READ_PAGE_HINT_COUNT') > hints
+
+s:drop()
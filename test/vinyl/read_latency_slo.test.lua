@@ -0,0 +1,43 @@
+test_run = require('test_run').new()
+
+--
+-- Compaction throttling driven by disk read latency.
+--
+vinyl_cache = box.cfg.vinyl_cache
+box.cfg{vinyl_cache = 0}
+
+box.cfg.vinyl_read_latency_slo
+st = box.stat.vinyl().regulator
+st.read_latency_slo
+st.compaction_rate_limit
+
+box.cfg{vinyl_read_latency_slo = -1}
+box.cfg.vinyl_read_latency_slo
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+for i = 1, 100 do s:replace{i, string.rep('x', 100)} end
+box.snapshot()
+
+-- Set an unreachable target so that compaction gets throttled.
+box.cfg{vinyl_read_latency_slo = 1e-9}
+box.stat.vinyl().regulator.read_latency_slo
+function read() for i = 1, 100 do s:get(i) end end
+test_run:wait_cond(function() read() return box.stat.vinyl().regulator.compaction_rate_limit > 0 end)
+box.stat.vinyl().regulator.read_latency > 0
+
+-- The limit keeps dropping while the target is exceeded.
+limit = box.stat.vinyl().regulator.compaction_rate_limit
+test_run:wait_cond(function() read() return box.stat.vinyl().regulator.compaction_rate_limit < limit end)
+
+-- Once reads stop, the limit recovers till compaction is unthrottled.
+limit = box.stat.vinyl().regulator.compaction_rate_limit
+test_run:wait_cond(function() return box.stat.vinyl().regulator.compaction_rate_limit > limit end)
+test_run:wait_cond(function() return box.stat.vinyl().regulator.compaction_rate_limit == 0 end)
+
+-- Disabling the target unthrottles compaction.
+box.cfg{vinyl_read_latency_slo = 0}
+box.stat.vinyl().regulator.compaction_rate_limit
+
+s:drop()
+box.cfg{vinyl_cache = vinyl_cache}
@@ -0,0 +1,43 @@
+test_run = require('test_run').new()
+
+--
+-- Run iterator readahead.
+--
+vinyl_cache = box.cfg.vinyl_cache
+box.cfg{vinyl_cache = 0}
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {page_size = 1024, range_size = 1024 * 1024})
+for i = 1, 1000 do s:replace{i, string.rep('x', 100)} end
+box.snapshot()
+
+function readahead() return box.stat.vinyl().readahead end
+
+-- Point lookups don't trigger readahead.
+box.stat.reset()
+for i = 1, 1000, 100 do s:get(i) end
+readahead().pages
+
+-- A range scan does.
+#s:select({}, {iterator = 'ge'})
+readahead().pages > 0
+readahead().useful > 0
+readahead().used
+
+-- So does a reverse range scan.
+box.stat.reset()
+#s:select({}, {iterator = 'le'})
+readahead().pages > 0
+readahead().useful > 0
+readahead().used
+
+-- Pages read ahead but not used are accounted as wasted.
+box.stat.reset()
+#s:select({}, {iterator = 'ge', limit = 200})
+test_run:wait_cond(function() return readahead().used == 0 end)
+readahead().pages == readahead().useful + readahead().wasted
+-- Only pages that were used are accounted as read from disk.
+s.index.pk:stat().disk.iterator.read.rows < 300
+
+s:drop()
+box.cfg{vinyl_cache = vinyl_cache}
@@ -71,12 +71,22 @@ end;
 -- so we just filter it out.
 --
 -- Filter dump/compaction time as we need error injection to
--- test them properly.
+-- test them properly. Page read time and compression dictionary
+-- statistics are checked in vinyl/compression_dict.test.lua.
+-- Cache hit and admission statistics are checked in
+-- vinyl/cache_admission.test.lua. Range filter statistics
+-- are checked in vinyl/range_filter.test.lua.
 function istat()
     local st = box.space.test.index.pk:stat()
     st.latency = nil
+    st.batch = nil
     st.disk.dump.time = nil
     st.disk.compaction.time = nil
+    st.disk.iterator.read_time = nil
+    st.disk.dict_size = nil
+    st.disk.iterator.range_filter = nil
+    st.cache.hit = nil
+    st.cache.reject = nil
     return st
 end;
 
@@ -87,9 +97,16 @@ end;
 --
 -- Filter dump/compaction time as we need error injection to
 -- test them properly.
+--
+-- Filter the size of the vylog image as it depends on the state
+-- of all vinyl objects, not only those created by this test.
 function gstat()
     local st = box.stat.vinyl()
+    st.memory.vylog = nil
     st.regulator = nil
+    st.page_cache = nil
+    st.readahead = nil
+    st.amplification = nil
     st.scheduler.dump_time = nil
     st.scheduler.compaction_time = nil
     return st
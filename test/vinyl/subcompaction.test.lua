@@ -0,0 +1,51 @@
+test_run = require('test_run').new()
+errinj = box.error.injection
+
+--
+-- A big range is compacted in parallel by several tasks,
+-- each of which processes its own part of the range.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {run_count_per_level = 100, page_size = 1024, range_size = 1024 * 1024})
+for i = 1, 1000 do s:replace{i, string.rep('x', 100)} end
+box.snapshot()
+for i = 1, 1000, 2 do s:replace{i, string.rep('y', 100)} end
+box.snapshot()
+s.index.pk:stat().range_count
+s.index.pk:stat().run_count
+
+errinj.set('ERRINJ_VY_SUBCOMPACTION_PART_SIZE', 1000)
+
+-- Failure of a part aborts compaction of the whole range.
+errinj.set('ERRINJ_VY_SCHED_TIMEOUT', 0.01)
+errinj.set('ERRINJ_VY_RUN_WRITE', true)
+tasks_failed = box.stat.vinyl().scheduler.tasks_failed
+s.index.pk:compact()
+test_run:wait_cond(function() return box.stat.vinyl().scheduler.tasks_failed >= tasks_failed + 2 end)
+s.index.pk:stat().range_count
+s.index.pk:stat().run_count
+errinj.set('ERRINJ_VY_RUN_WRITE', false)
+
+-- The range is split in as many parts as there are compaction
+-- threads (vinyl_write_threads = 3 leaves two of them).
+test_run:wait_cond(function() return s.index.pk:stat().disk.compaction.count > 0 end)
+errinj.set('ERRINJ_VY_SCHED_TIMEOUT', 0)
+errinj.set('ERRINJ_VY_SUBCOMPACTION_PART_SIZE', -1)
+s.index.pk:stat().range_count
+s.index.pk:stat().run_count
+test_run:grep_log('default', 'completed compacting range .* in 2 parts') ~= nil
+
+s:count()
+s:get(1)[2] == string.rep('y', 100)
+s:get(2)[2] == string.rep('x', 100)
+
+-- Check that the new ranges are recovered.
+test_run:cmd('restart server default')
+s = box.space.test
+s.index.pk:stat().range_count
+s.index.pk:stat().run_count
+s:count()
+s:get(999)[2] == string.rep('y', 100)
+s:get(1000)[2] == string.rep('x', 100)
+
+s:drop()
@@ -0,0 +1,102 @@
+test_run = require('test_run').new()
+fiber = require('fiber')
+
+--
+-- Check validation of the ttl index options.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+s:format({{'id', 'unsigned'}, {'ts', 'unsigned'}})
+s:create_index('pk', {ttl = -1, ttl_field = 2})
+s:create_index('pk', {ttl = 3600, ttl_field = 'foo'})
+pk = s:create_index('pk', {ttl = 3600, ttl_field = 'ts'})
+pk.options.ttl
+pk.options.ttl_field
+s:create_index('sk', {parts = {2, 'unsigned'}, ttl = 3600, ttl_field = 2})
+pk:alter{ttl = 0}
+pk.options.ttl
+pk:alter{ttl = 3600, ttl_field = 2}
+pk.options.ttl
+pk.options.ttl_field
+
+--
+-- Check that expired tuples are dropped by compaction.
+--
+-- Primary index compaction generates deferred DELETEs for
+-- expired tuples, which purge them from secondary indexes.
+-- Until the DELETEs are compacted, secondary indexes skip
+-- stale entries on read.
+--
+sk = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false})
+name = s:create_index('name', {parts = {3, 'string'}})
+
+now = math.floor(fiber.time())
+for i = 1, 10 do s:replace{i, i % 2 == 0 and now or now - 7200, 'n' .. i} end
+box.snapshot()
+
+test_run:cmd("setopt delimiter ';'")
+function compact(index)
+    index:compact()
+    test_run:wait_cond(function()
+        return index:stat().disk.compaction.count > 0
+    end)
+end;
+function keys(index)
+    local ret = {}
+    for _, t in index:pairs() do table.insert(ret, t[1]) end
+    table.sort(ret)
+    return ret
+end;
+test_run:cmd("setopt delimiter ''");
+
+-- Expired tuples are visible until compaction.
+keys(pk)
+
+compact(pk)
+pk:stat().disk.rows
+sk:stat().memory.rows
+name:stat().memory.rows
+keys(pk)
+keys(sk)
+keys(name)
+s:get(1)
+name:get('n1')
+
+box.snapshot()
+compact(sk)
+sk:stat().disk.rows
+compact(name)
+name:stat().disk.rows
+keys(sk)
+keys(name)
+
+-- An expired tuple can be inserted again.
+_ = s:insert{1, now, 'n1'}
+keys(pk)
+
+s:drop()
+
+--
+-- Check that a tuple visible to an open read view isn't dropped.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+pk = s:create_index('pk', {ttl = 3600, ttl_field = 2})
+now = math.floor(fiber.time())
+_ = s:replace{1, now - 7200}
+_ = s:replace{2, now}
+
+c = fiber.channel(1)
+_ = fiber.create(function() box.begin() s:select() c:get() box.commit() end)
+_ = s:replace{3, now - 7200}
+box.snapshot()
+compact(pk)
+pk:stat().disk.rows
+c:put(true)
+keys(pk)
+
+-- Once the read view is closed, the tuple is dropped, too.
+box.snapshot()
+pk:compact()
+test_run:wait_cond(function() return pk:stat().disk.rows == 1 end)
+keys(pk)
+
+s:drop()
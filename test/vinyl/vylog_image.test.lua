@@ -0,0 +1,76 @@
+test_run = require('test_run').new()
+json = require('json')
+
+--
+-- Check that the vylog written by rotation from the in-memory
+-- log image describes the same state of vinyl objects as the one
+-- loaded from disk.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {run_count_per_level = 10})
+_ = s:create_index('sk', {parts = {2, 'unsigned'}, unique = false, run_count_per_level = 10})
+state = box.schema.space.create('state')
+_ = state:create_index('pk')
+
+-- The image isn't built on restart, because the log has to be
+-- loaded for recovery anyway. The load time is reported.
+test_run:cmd('restart server default')
+test_run = require('test_run').new()
+json = require('json')
+s = box.space.test
+state = box.space.state
+box.stat.vinyl().memory.vylog
+test_run:grep_log('default', 'vylog loaded in') ~= nil
+
+-- Rotate the log twice, changing the state in between.
+for i = 1, 100 do s:replace{i, i % 10} end
+box.snapshot()
+-- The image is built on the first rotation.
+box.stat.vinyl().memory.vylog > 0
+for i = 1, 100, 2 do s:delete{i} end
+tmp = box.schema.space.create('tmp', {engine = 'vinyl'})
+_ = tmp:create_index('pk')
+_ = tmp:replace{1}
+box.snapshot()
+tmp:drop()
+s.index.pk:compact()
+test_run:wait_cond(function() return s.index.pk:stat().run_count == 1 end)
+box.snapshot()
+test_run:cmd("setopt delimiter ';'")
+function get_state()
+    local result = {}
+    for _, index in ipairs({s.index.pk, s.index.sk}) do
+        local st = index:stat()
+        table.insert(result, {st.run_count, st.range_count,
+                              st.disk.rows, st.disk.bytes,
+                              index:select()})
+    end
+    return json.encode(result)
+end;
+test_run:cmd("setopt delimiter ''");
+_ = state:replace{1, get_state()}
+
+-- Restart and compare the state.
+test_run:cmd('restart server default')
+test_run = require('test_run').new()
+json = require('json')
+s = box.space.test
+state = box.space.state
+test_run:cmd("setopt delimiter ';'")
+function get_state()
+    local result = {}
+    for _, index in ipairs({s.index.pk, s.index.sk}) do
+        local st = index:stat()
+        table.insert(result, {st.run_count, st.range_count,
+                              st.disk.rows, st.disk.bytes,
+                              index:select()})
+    end
+    return json.encode(result)
+end;
+test_run:cmd("setopt delimiter ''");
+get_state() == state:get(1)[2]
+s:count()
+box.stat.vinyl().memory.vylog
+
+s:drop()
+state:drop()